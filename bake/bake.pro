@@ -0,0 +1,20 @@
+TEMPLATE = app
+TARGET = gl-lnl-bake
+CONFIG += c++14
+CONFIG += console
+CONFIG -= app_bundle
+QT += concurrent
+
+# src.pro runs the tool from here while building the viewer, unless a
+# cross build hands it a host-built one as BAKE.
+DESTDIR = $$OUT_PWD
+
+include(../src/src.pri)
+INCLUDEPATH += ../src
+
+HEADERS += ../src/ModelTools.h
+HEADERS += ../src/TextureAtlas.h
+
+SOURCES += ../src/ModelTools.cpp
+SOURCES += ../src/TextureAtlas.cpp
+SOURCES += main.cpp
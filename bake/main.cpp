@@ -0,0 +1,175 @@
+#include <QCoreApplication>
+#include <QFile>
+#include <QImage>
+#include <QStringList>
+#include <QTextStream>
+
+#include "ModelTools.h"
+#include "Ply/PlyModel.h"
+#include "TextureAtlas.h"
+#include "TextureResidency.h"
+
+namespace {
+    // The grid is GRID_SIZE squares on a side, two units each.
+    constexpr int GRID_SIZE = 10;
+
+    //=========================================================================
+    // Prints enough digits for the value to read back exactly.
+    QString floatLiteral(float value)
+    {
+        QString text = QString::number(value, 'g', 9);
+        if(!text.contains('.') && !text.contains('e')) text += ".0";
+        return text + 'f';
+    }
+
+    //=========================================================================
+    QString doubleLiteral(double value)
+    {
+        QString text = QString::number(value, 'g', 17);
+        if(!text.contains('.') && !text.contains('e')) text += ".0";
+        return text;
+    }
+
+    //=========================================================================
+    void writeArray(QTextStream& out, const char *type, const char *name,
+            const float *values_p, int count, int perLine)
+    {
+        out << "constexpr " << type << " " << name << "[] = {\n";
+        for(int i = 0; i < count; i += perLine) {
+            QStringList line;
+            for(int j = i; j < qMin(i + perLine, count); ++j) {
+                line.append(floatLiteral(values_p[j]));
+            }
+            out << "    " << line.join(", ")
+                << (i + perLine < count ? ",\n" : "\n");
+        }
+        out << "};\n\n";
+    }
+
+    //=========================================================================
+    void writeRect(QTextStream& out, const char *name, const QRectF& rect)
+    {
+        out << "constexpr double " << name << "[] = { "
+            << doubleLiteral(rect.x()) << ", "
+            << doubleLiteral(rect.y()) << ", "
+            << doubleLiteral(rect.width()) << ", "
+            << doubleLiteral(rect.height()) << " };\n";
+    }
+
+    //=========================================================================
+    bool readPly(const QString& path, PlyModel *ply_p, QString *error_p)
+    {
+        QFile file(path);
+        if(!file.open(QIODevice::ReadOnly)) {
+            *error_p = QString("Could not open \"%1\"").arg(path);
+            return false;
+        }
+        QTextStream stream(&file);
+        *ply_p = PlyModel::parse(stream);
+        if(!ply_p->isValid()) {
+            *error_p = QString("\"%1\" is not a valid PLY file").arg(path);
+            return false;
+        }
+        return true;
+    }
+}
+
+//=============================================================================
+// Converts the built-in ornaments into a header of GPU-ready vertices, so
+// the viewer uploads them without parsing anything at startup.  The qmake
+// step in src.pro runs this with the generated header's path, arrow.ply,
+// grid-texture.png and arrow-texture.png.  The images are packed into an
+// atlas here exactly as the viewer packs them, and the vertices come out
+// with atlas texture coordinates.
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QTextStream err(stderr);
+
+    const QStringList args = app.arguments();
+    if(args.count() != 5) {
+        err << "Usage: gl-lnl-bake <header> <arrow.ply> "
+                "<grid-texture.png> <arrow-texture.png>\n";
+        return 1;
+    }
+    const QString headerPath = args[1];
+
+    // ==== Geometry ====
+    QString error;
+    PlyModel ply;
+    if(!readPly(args[2], &ply, &error)) {
+        err << error << "\n";
+        return 1;
+    }
+    QVector<GLfloat> arrow = convertPly(ply);
+    QVector<GLfloat> grid = makeGrid(GRID_SIZE, GRID_SIZE);
+
+    // ==== Atlas ====
+    // Added in the same order as GlWidget::loadOrnaments adds them.
+    TextureAtlas atlas;
+    const QImage gridImage = QImage(args[3]).mirrored();
+    const QImage arrowImage = QImage(args[4]).mirrored();
+    if(gridImage.isNull() || arrowImage.isNull()) {
+        err << "Could not read the ornament textures\n";
+        return 1;
+    }
+    const int gridIndex = atlas.add(gridImage);
+    const int arrowIndex = atlas.add(arrowImage);
+    if(!atlas.build()) {
+        err << "Could not pack the ornament textures\n";
+        return 1;
+    }
+    const QRectF gridRect = atlas.textureRect(gridIndex);
+    const QRectF arrowRect = atlas.textureRect(arrowIndex);
+    remapTextureCoords(grid, gridRect);
+    remapTextureCoords(arrow, arrowRect);
+
+    float gridMin[3];
+    float gridMax[3];
+    computeBounds(grid, gridMin, gridMax);
+    const float uvDensity = TextureResidency::uvDensity(grid.constData(),
+            grid.count() / NUM_VERTEX_VALUES, NUM_VERTEX_VALUES,
+            TEXTURE_COORD_OFFSET / sizeof(GLfloat));
+
+    // ==== Header ====
+    QFile header(headerPath);
+    if(!header.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        err << "Could not write \"" << headerPath << "\"\n";
+        return 1;
+    }
+    QTextStream out(&header);
+    const QVector<GLfloat> vertices = grid + arrow;
+
+    out << "// Generated by gl-lnl-bake; do not edit.\n"
+        << "#pragma once\n\n"
+        << "namespace BakedOrnaments {\n\n"
+        << "constexpr int VERTEX_VALUES = " << NUM_VERTEX_VALUES << ";\n"
+        << "constexpr int GRID_FIRST = 0;\n"
+        << "constexpr int GRID_VERTEX_COUNT = "
+        << grid.count() / NUM_VERTEX_VALUES << ";\n"
+        << "constexpr int ARROW_FIRST = GRID_VERTEX_COUNT;\n"
+        << "constexpr int ARROW_VERTEX_COUNT = "
+        << arrow.count() / NUM_VERTEX_VALUES << ";\n\n";
+
+    writeArray(out, "float", "GRID_MIN", gridMin, 3, 3);
+    writeArray(out, "float", "GRID_MAX", gridMax, 3, 3);
+    out << "constexpr float UV_DENSITY = " << floatLiteral(uvDensity)
+        << ";\n\n";
+
+    // The viewer checks these against the atlas it packs at startup.
+    writeRect(out, "GRID_RECT", gridRect);
+    writeRect(out, "ARROW_RECT", arrowRect);
+    out << "\n";
+
+    // Grid, then arrow.
+    writeArray(out, "float", "VERTICES", vertices.constData(),
+            vertices.count(), NUM_VERTEX_VALUES);
+
+    out << "}\n";
+    out.flush();
+    if(header.error() != QFile::NoError) {
+        err << "Could not write \"" << headerPath << "\"\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstddef>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+
+extern "C" {
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *pointer_p, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void *pointer_p);
+}
+#endif
+
+namespace {
+    std::atomic<qint64> g_currentBytes(0);
+    std::atomic<qint64> g_peakBytes(0);
+    std::atomic<qint64> g_allocations(0);
+
+    //=========================================================================
+    void added(void *pointer_p)
+    {
+#if defined(__GLIBC__)
+        if(!pointer_p) return;
+        const qint64 size = malloc_usable_size(pointer_p);
+        const qint64 current = (g_currentBytes += size);
+        ++g_allocations;
+
+        qint64 peak = g_peakBytes.load(std::memory_order_relaxed);
+        while(current > peak &&
+                !g_peakBytes.compare_exchange_weak(peak, current)) {
+        }
+#else
+        Q_UNUSED(pointer_p);
+#endif
+    }
+
+    //=========================================================================
+    void removed(void *pointer_p)
+    {
+#if defined(__GLIBC__)
+        if(!pointer_p) return;
+        g_currentBytes -= (qint64)malloc_usable_size(pointer_p);
+#else
+        Q_UNUSED(pointer_p);
+#endif
+    }
+}
+
+#if defined(__GLIBC__)
+extern "C" {
+    //=========================================================================
+    void *malloc(size_t size)
+    {
+        void *pointer_p = __libc_malloc(size);
+        added(pointer_p);
+        return pointer_p;
+    }
+
+    //=========================================================================
+    void *calloc(size_t count, size_t size)
+    {
+        void *pointer_p = __libc_calloc(count, size);
+        added(pointer_p);
+        return pointer_p;
+    }
+
+    //=========================================================================
+    void *realloc(void *pointer_p, size_t size)
+    {
+        removed(pointer_p);
+        void *result_p = __libc_realloc(pointer_p, size);
+        // A failed realloc leaves the old block in place.
+        added((result_p || !size) ? result_p : pointer_p);
+        return result_p;
+    }
+
+    //=========================================================================
+    void *memalign(size_t alignment, size_t size)
+    {
+        void *pointer_p = __libc_memalign(alignment, size);
+        added(pointer_p);
+        return pointer_p;
+    }
+
+    //=========================================================================
+    void *aligned_alloc(size_t alignment, size_t size)
+    {
+        return memalign(alignment, size);
+    }
+
+    //=========================================================================
+    int posix_memalign(void **pointer_pp, size_t alignment, size_t size)
+    {
+        void *pointer_p = memalign(alignment, size);
+        if(!pointer_p) return 12; // ENOMEM
+        *pointer_pp = pointer_p;
+        return 0;
+    }
+
+    //=========================================================================
+    void free(void *pointer_p)
+    {
+        removed(pointer_p);
+        __libc_free(pointer_p);
+    }
+}
+#endif
+
+//=============================================================================
+bool AllocationCounter::isAvailable()
+{
+#if defined(__GLIBC__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+//=============================================================================
+void AllocationCounter::reset()
+{
+    g_peakBytes = g_currentBytes.load();
+    g_allocations = 0;
+}
+
+//=============================================================================
+qint64 AllocationCounter::currentBytes()
+{
+    return g_currentBytes;
+}
+
+//=============================================================================
+qint64 AllocationCounter::peakBytes()
+{
+    return g_peakBytes;
+}
+
+//=============================================================================
+qint64 AllocationCounter::allocations()
+{
+    return g_allocations;
+}
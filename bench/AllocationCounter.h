@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QtGlobal>
+
+//=============================================================================
+// Counts heap use of the whole process by wrapping malloc and friends.  Qt
+// containers allocate through malloc rather than operator new, so this is
+// the only place that sees both.  Only available with glibc; elsewhere
+// isAvailable() is false and the counts stay at zero.
+namespace AllocationCounter
+{
+    bool isAvailable();
+
+    // Starts a new measurement: the peak is reset to the current usage.
+    void reset();
+
+    qint64 currentBytes();
+    qint64 peakBytes();
+    qint64 allocations();
+}
@@ -0,0 +1,155 @@
+#include "ArrowTransformBench.h"
+
+#include <QMatrix4x4>
+#include <QQuaternion>
+#include <QRandomGenerator>
+#include <QtTest>
+#include <cmath>
+
+#include "ModelTools.h"
+
+namespace {
+    //=========================================================================
+    // The per-vertex QMatrix4x4 version that loadNormals used to run.
+    void quaternionArrowTransforms(const QVector<GLfloat>& data,
+            QList<QMatrix4x4>& smoothArrows, QList<QMatrix4x4>& facetedArrows)
+    {
+        const int vertexCount = data.count() / NUM_VERTEX_VALUES;
+        for(int i = 0; i < vertexCount; ++i) {
+            auto v = data.constData() + (i * NUM_VERTEX_VALUES);
+            QVector3D position(v[0], v[1], v[2]);
+
+            const QVector3D up(0.0f, 0.0f, 1.0f);
+
+            QVector3D smoothNormal(v[3], v[4], v[5]);
+            QMatrix4x4 smoothTransform;
+            smoothTransform.translate(position);
+            smoothTransform.rotate(QQuaternion::rotationTo(up, smoothNormal));
+            smoothArrows.append(smoothTransform);
+
+            auto t = data.constData() + (i - i % 3) * NUM_VERTEX_VALUES;
+            const QVector3D p1(t[0], t[1], t[2]);
+            t += NUM_VERTEX_VALUES;
+            const QVector3D p2(t[0], t[1], t[2]);
+            t += NUM_VERTEX_VALUES;
+            const QVector3D p3(t[0], t[1], t[2]);
+            QVector3D facetedNormal =
+                    QVector3D::crossProduct(p2 - p1, p3 - p2);
+            QMatrix4x4 facetedTransform;
+            facetedTransform.translate(position);
+            facetedTransform.rotate(
+                    QQuaternion::rotationTo(up, facetedNormal));
+            facetedArrows.append(facetedTransform);
+        }
+    }
+
+    //=========================================================================
+    // Rounded up to whole triangles, which the face normals come from.
+    QVector<GLfloat> randomVertices(int vertexCount)
+    {
+        vertexCount += (3 - vertexCount % 3) % 3;
+        QRandomGenerator generator(1234);
+        auto random = [&generator]() {
+            return (float)generator.generateDouble() * 2 - 1;
+        };
+
+        QVector<GLfloat> data;
+        data.reserve(vertexCount * NUM_VERTEX_VALUES);
+        for(int i = 0; i < vertexCount; ++i) {
+            for(int j = 0; j < NUM_VERTEX_VALUES; ++j) {
+                data.append(random());
+            }
+        }
+
+        // Make sure the degenerate cases are covered.
+        if(vertexCount >= 3) {
+            GLfloat *v = data.data();
+            v[3] = 0.0f; v[4] = 0.0f; v[5] = 1.0f;
+            v += NUM_VERTEX_VALUES;
+            v[3] = 0.0f; v[4] = 0.0f; v[5] = -1.0f;
+            v += NUM_VERTEX_VALUES;
+            v[3] = 0.0f; v[4] = 0.0f; v[5] = -2.5f;
+        }
+        return data;
+    }
+
+    //=========================================================================
+    void addVertexCounts()
+    {
+        QTest::addColumn<int>("vertexCount");
+        QTest::newRow("1K") << 1000;
+        QTest::newRow("100K") << 100000;
+        QTest::newRow("1M") << 1000000;
+    }
+}
+
+//=============================================================================
+void ArrowTransformBench::transformsMatchQuaternionVersion()
+{
+    const QVector<GLfloat> data = randomVertices(1000);
+
+    QList<QMatrix4x4> smoothArrows;
+    QList<QMatrix4x4> facetedArrows;
+    quaternionArrowTransforms(data, smoothArrows, facetedArrows);
+
+    const QVector<GLfloat> smooth = buildArrowTransforms(data, NORMAL_OFFSET);
+    const QVector<GLfloat> faceted =
+            buildArrowTransforms(data, FACE_NORMALS);
+    QCOMPARE(smooth.count(), smoothArrows.count() * ARROW_TRANSFORM_VALUES);
+    QCOMPARE(faceted.count(), facetedArrows.count() * ARROW_TRANSFORM_VALUES);
+
+    auto compare = [](const QList<QMatrix4x4>& expected,
+            const QVector<GLfloat>& actual) {
+        for(int i = 0; i < expected.count(); ++i) {
+            for(int row = 0; row < 3; ++row) {
+                for(int column = 0; column < 4; ++column) {
+                    const float a = actual.at(i * ARROW_TRANSFORM_VALUES +
+                            row * 4 + column);
+                    const float e = expected.at(i)(row, column);
+                    if(std::abs(a - e) > 1e-4f) return false;
+                }
+            }
+        }
+        return true;
+    };
+    QVERIFY(compare(smoothArrows, smooth));
+    QVERIFY(compare(facetedArrows, faceted));
+}
+
+//=============================================================================
+void ArrowTransformBench::quaternionVersion_data()
+{
+    addVertexCounts();
+}
+
+//=============================================================================
+void ArrowTransformBench::quaternionVersion()
+{
+    QFETCH(int, vertexCount);
+    const QVector<GLfloat> data = randomVertices(vertexCount);
+
+    QBENCHMARK {
+        QList<QMatrix4x4> smoothArrows;
+        QList<QMatrix4x4> facetedArrows;
+        quaternionArrowTransforms(data, smoothArrows, facetedArrows);
+    }
+}
+
+//=============================================================================
+void ArrowTransformBench::batchedVersion_data()
+{
+    addVertexCounts();
+}
+
+//=============================================================================
+void ArrowTransformBench::batchedVersion()
+{
+    QFETCH(int, vertexCount);
+    const QVector<GLfloat> data = randomVertices(vertexCount);
+
+    QBENCHMARK {
+        QVector<GLfloat> smooth = buildArrowTransforms(data, NORMAL_OFFSET);
+        QVector<GLfloat> faceted =
+                buildArrowTransforms(data, FACE_NORMALS);
+    }
+}
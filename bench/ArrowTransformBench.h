@@ -0,0 +1,13 @@
+#include <QObject>
+
+class ArrowTransformBench : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void transformsMatchQuaternionVersion();
+    void quaternionVersion_data();
+    void quaternionVersion();
+    void batchedVersion_data();
+    void batchedVersion();
+};
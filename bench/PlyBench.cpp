@@ -0,0 +1,278 @@
+#include "PlyBench.h"
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QtTest>
+#include <cmath>
+
+#include "AllocationCounter.h"
+#include "ModelTools.h"
+
+namespace {
+    enum class Encoding
+    {
+        ASCII,
+        BINARY
+    };
+
+    //=========================================================================
+    // A rolling heightfield of columns x rows quads, two faces per quad, with
+    // every property convertPly needs.  The shape is fixed, so the same face
+    // count always produces the same bytes.
+    QByteArray makeMesh(int faceCount, Encoding encoding,
+            int *faces_p = nullptr)
+    {
+        const int columns =
+                qMax(1, (int)std::ceil(std::sqrt(faceCount / 2.0)));
+        const int rows = qMax(1, (faceCount / 2 + columns - 1) / columns);
+        const int vertexCount = (columns + 1) * (rows + 1);
+        const int faces = columns * rows * 2;
+        if(faces_p) *faces_p = faces;
+
+        QByteArray bytes;
+        QTextStream text(&bytes);
+        text.setRealNumberPrecision(7);
+        text << "ply\n"
+               << (encoding == Encoding::ASCII ?
+                   "format ascii 1.0\n" : "format binary_little_endian 1.0\n")
+               << "element vertex " << vertexCount << "\n"
+               << "property float x\n"
+               << "property float y\n"
+               << "property float z\n"
+               << "property float nx\n"
+               << "property float ny\n"
+               << "property float nz\n"
+               << "property float s\n"
+               << "property float t\n"
+               << "element face " << faces << "\n"
+               << "property list uchar int vertex_indices\n"
+               << "end_header\n";
+        text.flush();
+
+        QDataStream binary(&bytes, QIODevice::Append);
+        binary.setByteOrder(QDataStream::LittleEndian);
+        binary.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+        for(int y = 0; y <= rows; ++y) {
+            for(int x = 0; x <= columns; ++x) {
+                const float z =
+                        0.25f * std::sin(x * 0.1f) * std::cos(y * 0.1f);
+                const float values[] = {
+                    (float)x, (float)y, z,
+                    0.0f, 0.0f, 1.0f,
+                    (float)x / columns, (float)y / rows
+                };
+                if(encoding == Encoding::ASCII) {
+                    for(int i = 0; i < 8; ++i) {
+                        text << values[i] << (i < 7 ? " " : "\n");
+                    }
+                } else {
+                    for(float value : values) binary << value;
+                }
+            }
+        }
+
+        for(int y = 0; y < rows; ++y) {
+            for(int x = 0; x < columns; ++x) {
+                const int a = y * (columns + 1) + x;
+                const int b = a + 1;
+                const int c = a + columns + 2;
+                const int d = a + columns + 1;
+                if(encoding == Encoding::ASCII) {
+                    text << "3 " << a << " " << b << " " << c << "\n"
+                         << "3 " << a << " " << c << " " << d << "\n";
+                } else {
+                    binary << (quint8)3 << (qint32)a << (qint32)b << (qint32)c
+                           << (quint8)3 << (qint32)a << (qint32)c << (qint32)d;
+                }
+            }
+        }
+        text.flush();
+        return bytes;
+    }
+
+    //=========================================================================
+    // 10M faces needs several GB with the current PlyModel, so that size is
+    // opt-in through GL_LNL_BENCH_LARGE=1.
+    QList<int> faceCounts()
+    {
+        QList<int> counts = { 1000, 10000, 100000, 1000000 };
+        if(qEnvironmentVariableIntValue("GL_LNL_BENCH_LARGE")) {
+            counts.append(10000000);
+        }
+        return counts;
+    }
+
+    //=========================================================================
+    QString sizeName(int faceCount)
+    {
+        if(faceCount >= 1000000) {
+            return QString("%1M").arg(faceCount / 1000000);
+        }
+        return QString("%1K").arg(faceCount / 1000);
+    }
+
+    //=========================================================================
+    void addMeshRows(bool withBinary)
+    {
+        QTest::addColumn<int>("faceCount");
+        QTest::addColumn<int>("encoding");
+        for(int faceCount : faceCounts()) {
+            const QString name = sizeName(faceCount);
+            QTest::newRow(qPrintable(name + " ascii"))
+                    << faceCount << (int)Encoding::ASCII;
+            if(withBinary) {
+                QTest::newRow(qPrintable(name + " binary"))
+                        << faceCount << (int)Encoding::BINARY;
+            }
+        }
+    }
+
+    //=========================================================================
+    // QBENCHMARK reports time per iteration; this adds the rates that are
+    // easier to compare across mesh sizes.  Peak is heap growth above the
+    // usage at the start of the measurement.
+    class Throughput
+    {
+    public:
+        Throughput() : m_iterations(0)
+        {
+            AllocationCounter::reset();
+            m_baseBytes = AllocationCounter::currentBytes();
+            m_timer.start();
+        }
+
+        void iteration() { ++m_iterations; }
+
+        void report(qint64 bytes, qint64 faces)
+        {
+            const double seconds =
+                    m_timer.nsecsElapsed() / 1e9 / qMax(m_iterations, 1);
+            QString line =
+                    QString("%1 faces/s").arg(faces / seconds, 0, 'g', 4);
+            if(bytes > 0) {
+                line.prepend(QString("%1 MB/s, ")
+                        .arg(bytes / seconds / 1e6, 0, 'f', 1));
+            }
+            if(AllocationCounter::isAvailable()) {
+                line.append(QString(", peak %1 MB in %2 allocations")
+                        .arg((AllocationCounter::peakBytes() - m_baseBytes) /
+                                1e6, 0, 'f', 1)
+                        .arg(AllocationCounter::allocations() /
+                                qMax(m_iterations, 1)));
+            }
+            qInfo().noquote() << QTest::currentDataTag() << line;
+        }
+
+    private:
+        QElapsedTimer m_timer;
+        qint64 m_baseBytes;
+        int m_iterations;
+    };
+
+    //=========================================================================
+    PlyModel parseMesh(const QByteArray& bytes)
+    {
+        QTextStream stream(bytes);
+        return PlyModel::parse(stream);
+    }
+}
+
+//=============================================================================
+void PlyBench::parse_data()
+{
+    addMeshRows(true);
+}
+
+//=============================================================================
+void PlyBench::parse()
+{
+    QFETCH(int, faceCount);
+    QFETCH(int, encoding);
+    int faces = 0;
+    const QByteArray bytes = makeMesh(faceCount, (Encoding)encoding, &faces);
+    if(!parseMesh(bytes).isValid()) {
+        QSKIP("PlyModel::parse does not accept this encoding");
+    }
+
+    Throughput throughput;
+    QBENCHMARK {
+        PlyModel model = parseMesh(bytes);
+        throughput.iteration();
+    }
+    throughput.report(bytes.size(), faces);
+}
+
+//=============================================================================
+void PlyBench::convertPly_data()
+{
+    addMeshRows(false);
+}
+
+//=============================================================================
+void PlyBench::convertPly()
+{
+    QFETCH(int, faceCount);
+    QFETCH(int, encoding);
+    int faces = 0;
+    const PlyModel model =
+            parseMesh(makeMesh(faceCount, (Encoding)encoding, &faces));
+    QVERIFY(model.isValid());
+
+    Throughput throughput;
+    QBENCHMARK {
+        QVector<GLfloat> data = ::convertPly(model);
+        throughput.iteration();
+    }
+    throughput.report(0, faces);
+}
+
+//=============================================================================
+void PlyBench::makeGrid_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::newRow("10x10") << 10;
+    QTest::newRow("100x100") << 100;
+    QTest::newRow("1000x1000") << 1000;
+}
+
+//=============================================================================
+void PlyBench::makeGrid()
+{
+    QFETCH(int, size);
+
+    Throughput throughput;
+    QBENCHMARK {
+        QVector<GLfloat> data = ::makeGrid(size, size);
+        throughput.iteration();
+    }
+    throughput.report(0, (qint64)size * size * 2);
+}
+
+//=============================================================================
+void PlyBench::loadNormals_data()
+{
+    addMeshRows(false);
+}
+
+//=============================================================================
+void PlyBench::loadNormals()
+{
+    QFETCH(int, faceCount);
+    QFETCH(int, encoding);
+    int faces = 0;
+    const QVector<GLfloat> data = ::convertPly(
+            parseMesh(makeMesh(faceCount, (Encoding)encoding, &faces)));
+    QVERIFY(!data.isEmpty());
+
+    // The same work GlWidget::loadNormals does after each model load.
+    Throughput throughput;
+    QBENCHMARK {
+        QVector<GLfloat> smooth = buildArrowTransforms(data, NORMAL_OFFSET);
+        QVector<GLfloat> faceted =
+                buildArrowTransforms(data, FACE_NORMALS);
+        throughput.iteration();
+    }
+    throughput.report(0, faces);
+}
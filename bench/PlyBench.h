@@ -0,0 +1,16 @@
+#include <QObject>
+
+class PlyBench : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void parse_data();
+    void parse();
+    void convertPly_data();
+    void convertPly();
+    void makeGrid_data();
+    void makeGrid();
+    void loadNormals_data();
+    void loadNormals();
+};
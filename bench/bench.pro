@@ -0,0 +1,19 @@
+TEMPLATE = app
+TARGET = gl-lnl-bench
+CONFIG += c++14
+QT += concurrent
+QT += testlib
+
+include(../src/src.pri)
+INCLUDEPATH += ../src
+
+HEADERS += ../src/ModelTools.h
+HEADERS += AllocationCounter.h
+HEADERS += ArrowTransformBench.h
+HEADERS += PlyBench.h
+
+SOURCES += ../src/ModelTools.cpp
+SOURCES += AllocationCounter.cpp
+SOURCES += ArrowTransformBench.cpp
+SOURCES += main.cpp
+SOURCES += PlyBench.cpp
@@ -0,0 +1,18 @@
+#include <QTest>
+
+#include "ArrowTransformBench.h"
+#include "PlyBench.h"
+
+int main(int argc, char **argv)
+{
+    int result = 0;
+    auto runBench = [&](QObject *bench_p) {
+        result |= QTest::qExec(bench_p, argc, argv);
+        delete bench_p;
+    };
+
+    runBench(new ArrowTransformBench());
+    runBench(new PlyBench());
+
+    return result;
+}
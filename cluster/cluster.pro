@@ -0,0 +1,13 @@
+TEMPLATE = app
+TARGET = gl-lnl-cluster
+CONFIG += c++14
+CONFIG += console
+CONFIG -= app_bundle
+QT += concurrent
+
+include(../src/src.pri)
+INCLUDEPATH += ../src
+
+HEADERS += ../src/ModelTools.h
+
+SOURCES += main.cpp
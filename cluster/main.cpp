@@ -0,0 +1,284 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QStringList>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QVector>
+
+#include "ModelTools.h"
+#include "Scene/ClusterFile.h"
+#include "Scene/ClusterWriter.h"
+
+namespace {
+    struct Element
+    {
+        QString name;
+        qint64 count = 0;
+        QStringList properties;
+        QVector<bool> lists;
+    };
+
+    //=========================================================================
+    // The same header PlyModel::parse accepts.
+    bool readHeader(QTextStream& stream, QVector<Element> *elements_p)
+    {
+        if(stream.readLine() != "ply") return false;
+        if(stream.readLine() != "format ascii 1.0") return false;
+
+        while(true) {
+            const QString line = stream.readLine();
+            if(line.isNull()) return false;
+            const QStringList words =
+                    line.simplified().split(' ', QString::SkipEmptyParts);
+            if(words.isEmpty()) return false;
+
+            const QString& command = words.first();
+            if(command == "end_header") {
+                return true;
+            } else if(command == "element") {
+                if(words.count() != 3) return false;
+                Element element;
+                element.name = words[1];
+                bool ok = false;
+                element.count = words[2].toLongLong(&ok);
+                if(!ok || element.count < 0) return false;
+                elements_p->append(element);
+            } else if(command == "property") {
+                if(elements_p->isEmpty() || words.count() < 3) return false;
+                const bool list = (words[1] == "list");
+                if(list && words.count() < 5) return false;
+                elements_p->last().properties.append(words.last());
+                elements_p->last().lists.append(list);
+            } else if(command != "comment") {
+                return false;
+            }
+        }
+    }
+
+    //=========================================================================
+    // Splits one element line into its property values.  A list property's
+    // values go in lists_p; its slot in scalars_p is left at zero.
+    bool splitLine(const QString& line, const Element& element,
+            QVector<double> *scalars_p, QVector<QVector<double>> *lists_p)
+    {
+        const QStringList words =
+                line.simplified().split(' ', QString::SkipEmptyParts);
+        int word = 0;
+        auto next = [&words, &word](double *value_p) {
+            if(word >= words.count()) return false;
+            bool ok = false;
+            *value_p = words[word++].toDouble(&ok);
+            return ok;
+        };
+
+        scalars_p->fill(0.0, element.properties.count());
+        lists_p->fill(QVector<double>(), element.properties.count());
+        for(int p = 0; p < element.properties.count(); ++p) {
+            double value = 0.0;
+            if(!next(&value)) return false;
+            if(!element.lists[p]) {
+                (*scalars_p)[p] = value;
+                continue;
+            }
+            QVector<double>& list = (*lists_p)[p];
+            for(int i = 0; i < (int)value; ++i) {
+                double item = 0.0;
+                if(!next(&item)) return false;
+                list.append(item);
+            }
+        }
+        return true;
+    }
+
+    //=========================================================================
+    // Writes every vertex in the ModelTools layout.  Only x, y and z are
+    // required; the rest fall back to the defaults convertPlyVertices uses.
+    bool spillVertices(QTextStream& stream, const Element& element,
+            QIODevice& spill)
+    {
+        const char *names[NUM_VERTEX_VALUES] = {
+            "x", "y", "z", "nx", "ny", "nz", "s", "t"
+        };
+        const float defaults[NUM_VERTEX_VALUES] = {
+            0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f
+        };
+        int columns[NUM_VERTEX_VALUES];
+        for(int i = 0; i < NUM_VERTEX_VALUES; ++i) {
+            columns[i] = element.properties.indexOf(names[i]);
+            if(columns[i] >= 0 && element.lists[columns[i]]) return false;
+        }
+        if(columns[0] < 0 || columns[1] < 0 || columns[2] < 0) return false;
+
+        QVector<double> scalars;
+        QVector<QVector<double>> lists;
+        float vertex[NUM_VERTEX_VALUES];
+        for(qint64 v = 0; v < element.count; ++v) {
+            if(!splitLine(stream.readLine(), element, &scalars, &lists)) {
+                return false;
+            }
+            for(int i = 0; i < NUM_VERTEX_VALUES; ++i) {
+                vertex[i] = columns[i] >= 0 ?
+                        (float)scalars[columns[i]] : defaults[i];
+            }
+            if(spill.write(reinterpret_cast<const char *>(vertex),
+                    sizeof(vertex)) != sizeof(vertex)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //=========================================================================
+    // Hands the triangles to the writer DEFAULT_CHUNK_FACES at a time.  The
+    // vertices are read through a mapping of their spill file, so the
+    // system pages them in and out as the faces need them.
+    bool addFaces(QTextStream& stream, const Element& element,
+            const float *vertices_p, qint64 vertexCount,
+            ClusterWriter *writer_p, QString *error_p)
+    {
+        const int column = element.properties.indexOf("vertex_indices");
+        if(column < 0 || !element.lists[column]) {
+            *error_p = "The faces have no vertex_indices list";
+            return false;
+        }
+
+        QVector<double> scalars;
+        QVector<QVector<double>> lists;
+        QVector<float> chunk;
+        chunk.reserve(DEFAULT_CHUNK_FACES * 3 * NUM_VERTEX_VALUES);
+        for(qint64 f = 0; f < element.count; ++f) {
+            if(!splitLine(stream.readLine(), element, &scalars, &lists)) {
+                *error_p = QString("Face %1 could not be read").arg(f);
+                return false;
+            }
+            const QVector<double>& indices = lists[column];
+            if(indices.count() != 3) {
+                *error_p = QString("Face %1 is not a triangle").arg(f);
+                return false;
+            }
+            for(double index : indices) {
+                const qint64 v = (qint64)index;
+                if(v < 0 || v >= vertexCount) {
+                    *error_p = QString("Face %1 uses vertex %2, which does "
+                            "not exist").arg(f).arg(v);
+                    return false;
+                }
+                const float *vertex_p = vertices_p + v * NUM_VERTEX_VALUES;
+                for(int i = 0; i < NUM_VERTEX_VALUES; ++i) {
+                    chunk.append(vertex_p[i]);
+                }
+            }
+
+            if(chunk.count() == DEFAULT_CHUNK_FACES * 3 * NUM_VERTEX_VALUES ||
+                    f + 1 == element.count) {
+                if(!writer_p->addTriangles(chunk.constData(),
+                        chunk.count() / NUM_VERTEX_VALUES)) {
+                    *error_p = "Could not spill the triangles";
+                    return false;
+                }
+                chunk.clear();
+            }
+        }
+        return true;
+    }
+}
+
+//=============================================================================
+// Converts a PLY model into a clustered mesh (.glc) without holding it in
+// memory, for models too large for the viewer's "Export Clusters...".  The
+// vertices are spilled to a temporary file and mapped, the triangles go
+// through a ClusterWriter, and the file that comes out is the one the
+// viewer would have written.
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+            "Converts a PLY model into a gl-lnl clustered mesh.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("model", "The .ply file to convert.");
+    parser.addPositionalArgument("output", "The .glc file to write.");
+    parser.addOption({ "cluster-triangles", "Triangles per cluster.",
+            "count",
+            QString::number(ClusterFile::DEFAULT_CLUSTER_TRIANGLES) });
+    parser.addOption({ "run-triangles",
+            "Triangles sorted in memory at a time.", "count",
+            QString::number(ClusterWriter::DEFAULT_RUN_TRIANGLES) });
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    const QStringList args = parser.positionalArguments();
+    if(args.count() != 2) parser.showHelp(1);
+    const QString modelPath = args[0];
+    const QString outputPath = args[1];
+
+    QFile model(modelPath);
+    if(!model.open(QIODevice::ReadOnly)) {
+        err << "Could not open \"" << modelPath << "\"\n";
+        return 1;
+    }
+    QTextStream stream(&model);
+    QVector<Element> elements;
+    if(!readHeader(stream, &elements)) {
+        err << "\"" << modelPath << "\" is not a valid PLY file\n";
+        return 1;
+    }
+
+    // ==== Elements, in file order ====
+    ClusterWriter writer(NUM_VERTEX_VALUES,
+            parser.value("cluster-triangles").toInt(),
+            parser.value("run-triangles").toInt());
+    QTemporaryFile vertexSpill;
+    qint64 vertexCount = -1;
+    for(const auto& element : elements) {
+        if(element.name == "vertex") {
+            if(!vertexSpill.open() ||
+                    !spillVertices(stream, element, vertexSpill) ||
+                    !vertexSpill.flush()) {
+                err << "Could not read the vertices of \"" << modelPath
+                    << "\"\n";
+                return 1;
+            }
+            vertexCount = element.count;
+        } else if(element.name == "face") {
+            if(vertexCount < 0) {
+                err << "The faces of \"" << modelPath
+                    << "\" come before its vertices\n";
+                return 1;
+            }
+            const float *vertices_p = nullptr;
+            if(vertexCount > 0) {
+                vertices_p = reinterpret_cast<const float *>(
+                        vertexSpill.map(0, vertexSpill.size()));
+                if(!vertices_p) {
+                    err << "Could not map the vertices\n";
+                    return 1;
+                }
+            }
+            QString error;
+            if(!addFaces(stream, element, vertices_p, vertexCount, &writer,
+                    &error)) {
+                err << error << " in \"" << modelPath << "\"\n";
+                return 1;
+            }
+        } else {
+            for(qint64 i = 0; i < element.count; ++i) {
+                (void)stream.readLine();
+            }
+        }
+    }
+
+    // ==== Clusters ====
+    QFile output(outputPath);
+    if(!output.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+            !writer.write(output)) {
+        err << "Could not write \"" << outputPath << "\"\n";
+        return 1;
+    }
+    out << "Wrote " << writer.triangleCount() << " triangles to \""
+        << outputPath << "\"\n";
+    return 0;
+}
@@ -1,4 +1,12 @@
 TEMPLATE = subdirs
 
+# A cross build passes a host-built tool as BAKE instead (see src/src.pro).
+isEmpty(BAKE): SUBDIRS += bake
 SUBDIRS += src
 SUBDIRS += test
+SUBDIRS += bench
+SUBDIRS += replay
+SUBDIRS += cluster
+
+# The viewer compiles in ornaments that the bake tool generates.
+isEmpty(BAKE): src.depends = bake
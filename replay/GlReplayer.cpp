@@ -0,0 +1,452 @@
+#include "GlReplayer.h"
+
+#include <QFile>
+#include <QImage>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLShaderProgram>
+
+using GlCapture::Command;
+using GlCapture::Op;
+
+namespace {
+    //=========================================================================
+    // Names the piece of state a command sets, or returns an empty string
+    // for commands that are not simple state changes.  Uniforms are left
+    // out because captures only contain the ones that changed.
+    QString stateKey(const Command& command, qint64 activeTexture)
+    {
+        const qint64 first = command.ints.value(0);
+        switch(command.op) {
+        case Op::BIND_BUFFER:
+            return QString("buffer %1").arg(first);
+        case Op::ENABLE:
+        case Op::DISABLE:
+            return QString("capability %1").arg(first);
+        case Op::ENABLE_ATTRIB_ARRAY:
+        case Op::DISABLE_ATTRIB_ARRAY:
+            return QString("attribute %1").arg(first);
+        case Op::BIND_TEXTURE:
+            return QString("texture %1 %2").arg(activeTexture).arg(first);
+        case Op::USE_PROGRAM:
+        case Op::DEPTH_MASK:
+        case Op::CULL_FACE:
+        case Op::FRONT_FACE:
+        case Op::BLEND_FUNC:
+        case Op::CLEAR_COLOR:
+        case Op::VIEWPORT:
+        case Op::ACTIVE_TEXTURE:
+        case Op::BIND_FRAMEBUFFER:
+            return GlCapture::opName(command.op);
+        default:
+            return QString();
+        }
+    }
+
+    //=========================================================================
+    QByteArray stateValue(const Command& command)
+    {
+        QByteArray value(1, (char)command.op);
+        value.append(reinterpret_cast<const char *>(command.ints.constData()),
+                command.ints.count() * sizeof(qint64));
+        value.append(
+                reinterpret_cast<const char *>(command.floats.constData()),
+                command.floats.count() * sizeof(float));
+        return value;
+    }
+}
+
+//=============================================================================
+GlReplayer::GlReplayer() :
+        m_opStats((int)Op::COUNT),
+        m_target_p(nullptr),
+        m_program(0),
+        m_placeholderTexture(0),
+        m_skippedDraws(0),
+        m_initialized(false)
+{
+}
+
+//=============================================================================
+GlReplayer::~GlReplayer()
+{
+    release();
+}
+
+//=============================================================================
+bool GlReplayer::load(const QString& path, QString *error_p)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        *error_p = QString("Could not open \"%1\"").arg(path);
+        return false;
+    }
+
+    GlCapture::Reader reader;
+    if(!reader.begin(&file)) {
+        *error_p = QString("\"%1\" is not a GL capture").arg(path);
+        return false;
+    }
+
+    m_setup.clear();
+    m_frames.clear();
+    Command command;
+    while(reader.next(&command)) {
+        if(command.op == Op::FRAME) m_frames.append(QVector<Command>());
+        if(m_frames.isEmpty()) {
+            m_setup.append(command);
+        } else {
+            m_frames.last().append(command);
+        }
+    }
+    if(reader.hasError()) {
+        *error_p = QString("\"%1\" is damaged").arg(path);
+        return false;
+    }
+
+    analyze();
+    return true;
+}
+
+//=============================================================================
+int GlReplayer::setupCommandCount() const
+{
+    return m_setup.count();
+}
+
+//=============================================================================
+int GlReplayer::frameCount() const
+{
+    return m_frames.count();
+}
+
+//=============================================================================
+const QVector<GlReplayer::OpStats>& GlReplayer::opStats() const
+{
+    return m_opStats;
+}
+
+//=============================================================================
+bool GlReplayer::initialize(const QSize& size, QString *error_p)
+{
+    release();
+    initializeOpenGLFunctions();
+    m_size = size;
+
+    m_target_p = new QOpenGLFramebufferObject(size,
+            QOpenGLFramebufferObject::CombinedDepthStencil);
+    if(!m_target_p->isValid()) {
+        *error_p = "Could not create the replay framebuffer";
+        delete m_target_p;
+        m_target_p = nullptr;
+        return false;
+    }
+
+    // Grey so textured geometry stays visible, transparent so composited
+    // layers do not hide what is under them.
+    const GLubyte texel[] = { 128, 128, 128, 0 };
+    glGenTextures(1, &m_placeholderTexture);
+    glBindTexture(GL_TEXTURE_2D, m_placeholderTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA,
+            GL_UNSIGNED_BYTE, texel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_initialized = true;
+    bindFramebuffer(0);
+    for(const auto& command : m_setup) execute(command);
+    return true;
+}
+
+//=============================================================================
+void GlReplayer::replayFrame(int frame)
+{
+    if(!m_initialized || frame < 0 || frame >= m_frames.count()) return;
+    for(const auto& command : m_frames[frame]) execute(command);
+}
+
+//=============================================================================
+int GlReplayer::skippedDraws() const
+{
+    return m_skippedDraws;
+}
+
+//=============================================================================
+QImage GlReplayer::image() const
+{
+    return m_target_p ? m_target_p->toImage() : QImage();
+}
+
+//=============================================================================
+void GlReplayer::release()
+{
+    if(!m_initialized) return;
+    m_initialized = false;
+
+    for(auto& program : m_programs) delete program.program_p;
+    m_programs.clear();
+    m_program = 0;
+    for(GLuint name : m_buffers) glDeleteBuffers(1, &name);
+    m_buffers.clear();
+    qDeleteAll(m_framebuffers);
+    m_framebuffers.clear();
+    delete m_target_p;
+    m_target_p = nullptr;
+    glDeleteTextures(1, &m_placeholderTexture);
+    m_placeholderTexture = 0;
+    m_skippedDraws = 0;
+}
+
+//=============================================================================
+// Counts calls and redundant state changes over one pass of the frames,
+// starting from the state the setup commands leave behind.  Every frame
+// starts on the default framebuffer with a fresh viewport, the way
+// QOpenGLWidget hands it to paintGL().
+void GlReplayer::analyze()
+{
+    m_opStats = QVector<OpStats>((int)Op::COUNT);
+
+    QHash<QString, QByteArray> state;
+    qint64 activeTexture = GL_TEXTURE0;
+    auto track = [&](const Command& command, bool count) {
+        if(command.op == Op::ACTIVE_TEXTURE) {
+            activeTexture = command.ints.value(0);
+        }
+        const QString key = stateKey(command, activeTexture);
+        bool redundant = false;
+        if(!key.isEmpty()) {
+            const QByteArray value = stateValue(command);
+            auto current = state.find(key);
+            redundant = (current != state.end() && *current == value);
+            state.insert(key, value);
+        }
+        if(count) {
+            OpStats& stats = m_opStats[(int)command.op];
+            ++stats.calls;
+            if(redundant) ++stats.redundant;
+        }
+    };
+
+    for(const auto& command : m_setup) track(command, false);
+    for(const auto& frame : m_frames) {
+        Command bind;
+        bind.op = Op::BIND_FRAMEBUFFER;
+        bind.ints << 0;
+        state.insert(stateKey(bind, activeTexture), stateValue(bind));
+        state.remove(GlCapture::opName(Op::VIEWPORT));
+        for(const auto& command : frame) track(command, true);
+    }
+}
+
+//=============================================================================
+void GlReplayer::execute(const Command& command)
+{
+    const QVector<qint64>& i = command.ints;
+    const QVector<float>& f = command.floats;
+
+    switch(command.op) {
+    case Op::FRAME:
+        bindFramebuffer(0);
+        glViewport(0, 0, m_size.width(), m_size.height());
+        break;
+    case Op::PROGRAM:
+        createProgram(command);
+        break;
+    case Op::USE_PROGRAM: {
+        m_program = i.value(0);
+        const Program program = m_programs.value(m_program);
+        if(program.program_p) {
+            program.program_p->bind();
+        } else {
+            glUseProgram(0);
+        }
+        break;
+    }
+    case Op::UNIFORM:
+        setUniform(command);
+        break;
+    case Op::BIND_BUFFER:
+        glBindBuffer(i.value(0), buffer(i.value(1)));
+        break;
+    case Op::BUFFER_DATA:
+        glBufferData(i.value(0), i.value(1),
+                command.data.isEmpty() ? nullptr : command.data.constData(),
+                i.value(2));
+        break;
+    case Op::BUFFER_SUB_DATA:
+        glBufferSubData(i.value(0), i.value(1), command.data.size(),
+                command.data.constData());
+        break;
+    case Op::DELETE_BUFFER: {
+        const GLuint name = m_buffers.take(i.value(0));
+        if(name) glDeleteBuffers(1, &name);
+        break;
+    }
+    case Op::VERTEX_ATTRIB_POINTER:
+        glVertexAttribPointer(i.value(0), i.value(1), i.value(2),
+                (GLboolean)i.value(3), i.value(4),
+                reinterpret_cast<const void *>((quintptr)i.value(5)));
+        break;
+    case Op::ENABLE_ATTRIB_ARRAY:
+        glEnableVertexAttribArray(i.value(0));
+        break;
+    case Op::DISABLE_ATTRIB_ARRAY:
+        glDisableVertexAttribArray(i.value(0));
+        break;
+    case Op::ENABLE:
+        glEnable(i.value(0));
+        break;
+    case Op::DISABLE:
+        glDisable(i.value(0));
+        break;
+    case Op::DEPTH_MASK:
+        glDepthMask((GLboolean)i.value(0));
+        break;
+    case Op::CULL_FACE:
+        glCullFace(i.value(0));
+        break;
+    case Op::FRONT_FACE:
+        glFrontFace(i.value(0));
+        break;
+    case Op::BLEND_FUNC:
+        glBlendFuncSeparate(i.value(0), i.value(1), i.value(2), i.value(3));
+        break;
+    case Op::CLEAR_COLOR:
+        glClearColor(f.value(0), f.value(1), f.value(2), f.value(3));
+        break;
+    case Op::CLEAR:
+        glClear(i.value(0));
+        break;
+    case Op::VIEWPORT:
+        glViewport(i.value(0), i.value(1), i.value(2), i.value(3));
+        break;
+    case Op::ACTIVE_TEXTURE:
+        glActiveTexture(i.value(0));
+        break;
+    case Op::BIND_TEXTURE:
+        glBindTexture(i.value(0), i.value(1) ? m_placeholderTexture : 0);
+        break;
+    case Op::BIND_FRAMEBUFFER:
+        bindFramebuffer(i.value(0));
+        break;
+    case Op::DRAW_ARRAYS:
+        if(m_programs.value(m_program).program_p) {
+            glDrawArrays(i.value(0), i.value(1), i.value(2));
+        } else {
+            ++m_skippedDraws;
+        }
+        break;
+    case Op::COUNT:
+        break;
+    }
+}
+
+//=============================================================================
+void GlReplayer::createProgram(const Command& command)
+{
+    const QVector<qint64>& ints = command.ints;
+    const QStringList& strings = command.strings;
+    const qint64 id = ints.value(0);
+    const int attributes = ints.value(1);
+    const int uniforms = strings.count() - 2 - attributes;
+    if(attributes < 0 || uniforms < 0 ||
+            ints.count() != 2 + attributes + uniforms) {
+        return;
+    }
+
+    Program program = m_programs.take(id);
+    delete program.program_p;
+    program = Program();
+
+    // Programs the recorder has no sources for stay empty and their draws
+    // are skipped.
+    if(!strings[0].isEmpty() && !strings[1].isEmpty()) {
+        auto program_p = new QOpenGLShaderProgram();
+        bool ok = program_p->addShaderFromSourceCode(
+                QOpenGLShader::Vertex, strings[0]) &&
+                program_p->addShaderFromSourceCode(
+                QOpenGLShader::Fragment, strings[1]);
+        for(int a = 0; ok && a < attributes; ++a) {
+            program_p->bindAttributeLocation(strings[2 + a], ints[2 + a]);
+        }
+        if(ok && program_p->link()) {
+            program.program_p = program_p;
+            for(int u = 0; u < uniforms; ++u) {
+                program.uniformLocations.insert(ints[2 + attributes + u],
+                        program_p->uniformLocation(
+                        strings[2 + attributes + u]));
+            }
+        } else {
+            qWarning("Program %lld did not build: %s", id,
+                    qPrintable(program_p->log()));
+            delete program_p;
+        }
+    }
+    m_programs.insert(id, program);
+}
+
+//=============================================================================
+void GlReplayer::setUniform(const Command& command)
+{
+    const Program program = m_programs.value(m_program);
+    if(!program.program_p || command.ints.count() < 2) return;
+    const int location =
+            program.uniformLocations.value(command.ints[0], -1);
+    if(location < 0) return;
+
+    // Padded so damaged commands cannot read past their values.
+    QVector<GLfloat> floats = command.floats;
+    floats.resize(16);
+    const GLfloat *f = floats.constData();
+    QVector<GLint> ints;
+    for(int i = 2; i < command.ints.count(); ++i) ints << command.ints[i];
+    ints.resize(4);
+
+    switch(command.ints[1]) {
+    case GL_FLOAT: glUniform1fv(location, 1, f); break;
+    case GL_FLOAT_VEC2: glUniform2fv(location, 1, f); break;
+    case GL_FLOAT_VEC3: glUniform3fv(location, 1, f); break;
+    case GL_FLOAT_VEC4: glUniform4fv(location, 1, f); break;
+    case GL_FLOAT_MAT2: glUniformMatrix2fv(location, 1, GL_FALSE, f); break;
+    case GL_FLOAT_MAT3: glUniformMatrix3fv(location, 1, GL_FALSE, f); break;
+    case GL_FLOAT_MAT4: glUniformMatrix4fv(location, 1, GL_FALSE, f); break;
+    case GL_INT_VEC2:
+    case GL_BOOL_VEC2: glUniform2iv(location, 1, ints.constData()); break;
+    case GL_INT_VEC3:
+    case GL_BOOL_VEC3: glUniform3iv(location, 1, ints.constData()); break;
+    case GL_INT_VEC4:
+    case GL_BOOL_VEC4: glUniform4iv(location, 1, ints.constData()); break;
+    default: glUniform1iv(location, 1, ints.constData()); break;
+    }
+}
+
+//=============================================================================
+GLuint GlReplayer::buffer(qint64 recorded)
+{
+    if(!recorded) return 0;
+    auto name = m_buffers.find(recorded);
+    if(name == m_buffers.end()) {
+        GLuint created = 0;
+        glGenBuffers(1, &created);
+        name = m_buffers.insert(recorded, created);
+    }
+    return *name;
+}
+
+//=============================================================================
+// Framebuffers the viewer rendered into besides its own are stood in for by
+// targets of the replay size.
+void GlReplayer::bindFramebuffer(qint64 recorded)
+{
+    if(!recorded) {
+        m_target_p->bind();
+        return;
+    }
+    auto framebuffer_p = m_framebuffers.value(recorded);
+    if(!framebuffer_p) {
+        framebuffer_p = new QOpenGLFramebufferObject(m_size,
+                QOpenGLFramebufferObject::Depth);
+        m_framebuffers.insert(recorded, framebuffer_p);
+    }
+    framebuffer_p->bind();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QHash>
+#include <QOpenGLFunctions>
+#include <QSize>
+#include <QVector>
+
+#include "GlCapture.h"
+
+class QImage;
+class QOpenGLFramebufferObject;
+class QOpenGLShaderProgram;
+
+//=============================================================================
+// Plays a GlCapture file back into an offscreen framebuffer.  Commands
+// before the first frame marker are run once by initialize(); frames can
+// then be replayed in any order and as often as needed.  Recorded object
+// names are mapped to objects created here, programs are rebuilt from their
+// sources with the recorded attribute locations, and textures, which
+// captures do not contain, are replaced by a placeholder.
+//
+// load() also walks the command stream once to count the calls of every
+// kind and the state changes that set what was already set.
+class GlReplayer : protected QOpenGLFunctions
+{
+public:
+    struct OpStats
+    {
+        int calls = 0;
+        int redundant = 0;
+    };
+
+    GlReplayer();
+    ~GlReplayer();
+
+    bool load(const QString& path, QString *error_p);
+
+    int setupCommandCount() const;
+    int frameCount() const;
+
+    // Indexed by GlCapture::Op; covers one pass over all frames.
+    const QVector<OpStats>& opStats() const;
+
+    // The current context is used from here on.
+    bool initialize(const QSize& size, QString *error_p);
+    void replayFrame(int frame);
+    int skippedDraws() const;
+    QImage image() const;
+    void release();
+
+private:
+    struct Program
+    {
+        QOpenGLShaderProgram *program_p = nullptr;
+        QHash<qint64, int> uniformLocations;
+    };
+
+    void analyze();
+    void execute(const GlCapture::Command& command);
+    void createProgram(const GlCapture::Command& command);
+    void setUniform(const GlCapture::Command& command);
+    GLuint buffer(qint64 recorded);
+    void bindFramebuffer(qint64 recorded);
+
+    QVector<GlCapture::Command> m_setup;
+    QVector<QVector<GlCapture::Command>> m_frames;
+    QVector<OpStats> m_opStats;
+
+    QSize m_size;
+    QOpenGLFramebufferObject *m_target_p;
+    QHash<qint64, QOpenGLFramebufferObject *> m_framebuffers;
+    QHash<qint64, GLuint> m_buffers;
+    QHash<qint64, Program> m_programs;
+    qint64 m_program;
+    GLuint m_placeholderTexture;
+    int m_skippedDraws;
+    bool m_initialized;
+};
@@ -0,0 +1,157 @@
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QImage>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QTextStream>
+#include <algorithm>
+#include <cstring>
+
+#include "GlReplayer.h"
+
+namespace {
+    //=========================================================================
+    // Has to be decided before the application object picks a GL driver.
+    bool wantsSoftware(int argc, char **argv)
+    {
+        for(int i = 1; i < argc; ++i) {
+            if(std::strcmp(argv[i], "--software") == 0) return true;
+        }
+        return false;
+    }
+
+    //=========================================================================
+    QSize parseSize(const QString& text)
+    {
+        const QStringList parts = text.split('x');
+        if(parts.count() != 2) return QSize();
+        return QSize(parts[0].toInt(), parts[1].toInt());
+    }
+}
+
+//=============================================================================
+// Replays a capture written by the viewer's "Capture GL Frames..." button
+// and reports per-frame timings and call counts.  --software forces Mesa's
+// llvmpipe so results can be compared on machines without a GPU; combine
+// it with -platform offscreen when there is no display.
+int main(int argc, char **argv)
+{
+    if(wantsSoftware(argc, argv)) {
+        qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+        QCoreApplication::setAttribute(Qt::AA_UseSoftwareOpenGL);
+    }
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a gl-lnl GL capture.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("capture", "The .glcap file to replay.");
+    parser.addOption({ "software", "Use the software rasterizer." });
+    parser.addOption({ "repeat", "Replay all frames <count> times.",
+            "count", "10" });
+    parser.addOption({ "size", "Framebuffer size, default 1280x720.",
+            "WxH", "1280x720" });
+    parser.addOption({ "output", "Save the last frame to <image>.",
+            "image" });
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    if(parser.positionalArguments().count() != 1) parser.showHelp(1);
+    const QString path = parser.positionalArguments().first();
+    const int repeat = qMax(parser.value("repeat").toInt(), 1);
+    const QSize size = parseSize(parser.value("size"));
+    if(size.isEmpty()) {
+        err << "Invalid size \"" << parser.value("size") << "\"\n";
+        return 1;
+    }
+
+    GlReplayer replayer;
+    QString error;
+    if(!replayer.load(path, &error)) {
+        err << error << "\n";
+        return 1;
+    }
+    if(replayer.frameCount() == 0) {
+        err << "\"" << path << "\" has no frames\n";
+        return 1;
+    }
+
+    // ==== Context ====
+    QOpenGLContext context;
+    if(!context.create()) {
+        err << "Could not create a GL context\n";
+        return 1;
+    }
+    QOffscreenSurface surface;
+    surface.setFormat(context.format());
+    surface.create();
+    if(!context.makeCurrent(&surface)) {
+        err << "Could not make the GL context current\n";
+        return 1;
+    }
+    QOpenGLFunctions *gl_p = context.functions();
+
+    if(!replayer.initialize(size, &error)) {
+        err << error << "\n";
+        return 1;
+    }
+
+    // ==== Replay ====
+    QVector<double> frameMs;
+    QElapsedTimer timer;
+    for(int pass = 0; pass < repeat; ++pass) {
+        for(int frame = 0; frame < replayer.frameCount(); ++frame) {
+            timer.start();
+            replayer.replayFrame(frame);
+            gl_p->glFinish();
+            frameMs.append(timer.nsecsElapsed() / 1.0e6);
+        }
+    }
+
+    // ==== Report ====
+    std::sort(frameMs.begin(), frameMs.end());
+    double total = 0.0;
+    for(double ms : frameMs) total += ms;
+
+    out << "Renderer: "
+        << reinterpret_cast<const char *>(gl_p->glGetString(GL_RENDERER))
+        << "\n";
+    out << "Capture: " << replayer.frameCount() << " frames, "
+        << replayer.setupCommandCount() << " setup commands\n";
+    out << QString("Frame ms over %1 frames: min %2, median %3, "
+            "mean %4, max %5\n")
+            .arg(frameMs.count())
+            .arg(frameMs.first(), 0, 'f', 3)
+            .arg(frameMs[frameMs.count() / 2], 0, 'f', 3)
+            .arg(total / frameMs.count(), 0, 'f', 3)
+            .arg(frameMs.last(), 0, 'f', 3);
+    if(replayer.skippedDraws() > 0) {
+        out << "Skipped draws without a program: "
+            << replayer.skippedDraws() << "\n";
+    }
+
+    out << "\nCalls per frame (redundant):\n";
+    const double frames = replayer.frameCount();
+    for(int op = 0; op < (int)GlCapture::Op::COUNT; ++op) {
+        const GlReplayer::OpStats& stats = replayer.opStats()[op];
+        if(stats.calls == 0) continue;
+        out << QString("  %1 %2 (%3)\n")
+                .arg(GlCapture::opName((GlCapture::Op)op), -26)
+                .arg(stats.calls / frames, 8, 'f', 1)
+                .arg(stats.redundant / frames, 0, 'f', 1);
+    }
+
+    if(parser.isSet("output")) {
+        const QString image = parser.value("output");
+        if(!replayer.image().save(image)) {
+            err << "Could not save \"" << image << "\"\n";
+        }
+    }
+
+    replayer.release();
+    context.doneCurrent();
+    return 0;
+}
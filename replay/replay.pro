@@ -0,0 +1,13 @@
+TEMPLATE = app
+TARGET = gl-lnl-replay
+CONFIG += c++14
+CONFIG += console
+QT += concurrent
+
+include(../src/src.pri)
+INCLUDEPATH += ../src
+
+HEADERS += GlReplayer.h
+
+SOURCES += GlReplayer.cpp
+SOURCES += main.cpp
@@ -0,0 +1,255 @@
+#include "ClusterCache.h"
+
+#include <QSet>
+#include <QVector4D>
+#include <QtConcurrent>
+#include <algorithm>
+
+#include "Scene/ClusterFile.h"
+
+namespace {
+    //=========================================================================
+    // Gribb/Hartmann plane extraction; the planes point into the frustum.
+    void frustumPlanes(const QMatrix4x4& m, QVector4D *planes_p)
+    {
+        const QVector4D w = m.row(3);
+        for(int i = 0; i < 3; ++i) {
+            planes_p[2 * i] = w + m.row(i);
+            planes_p[2 * i + 1] = w - m.row(i);
+        }
+    }
+
+    //=========================================================================
+    bool boxInFrustum(const QVector4D *planes_p, const float *min_p,
+            const float *max_p)
+    {
+        for(int p = 0; p < 6; ++p) {
+            const QVector4D& plane = planes_p[p];
+            const float x = plane.x() >= 0.0f ? max_p[0] : min_p[0];
+            const float y = plane.y() >= 0.0f ? max_p[1] : min_p[1];
+            const float z = plane.z() >= 0.0f ? max_p[2] : min_p[2];
+            if(plane.x() * x + plane.y() * y + plane.z() * z + plane.w() <
+                    0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+//=============================================================================
+ClusterCache::ClusterCache(qint64 budget) :
+        m_budget(budget),
+        m_frame(0),
+        m_residentBytes(0),
+        m_initialized(false)
+{
+}
+
+//=============================================================================
+void ClusterCache::initialize()
+{
+    initializeOpenGLFunctions();
+    m_initialized = true;
+}
+
+//=============================================================================
+void ClusterCache::release()
+{
+    setFile(QSharedPointer<ClusterFile>());
+}
+
+//=============================================================================
+void ClusterCache::setFile(const QSharedPointer<ClusterFile>& file_p)
+{
+    // Outstanding reads keep their own reference to the old file and are
+    // simply ignored.
+    m_loads.clear();
+    if(m_initialized) {
+        for(const auto& resident : m_residents) {
+            glDeleteBuffers(1, &resident.buffer);
+        }
+    }
+    m_residents.clear();
+    m_residentBytes = 0;
+    m_stats = Stats();
+    m_file_p = file_p;
+}
+
+//=============================================================================
+bool ClusterCache::hasFile() const
+{
+    return !m_file_p.isNull();
+}
+
+//=============================================================================
+void ClusterCache::setBudget(qint64 bytes)
+{
+    m_budget = qMax(bytes, (qint64)0);
+}
+
+//=============================================================================
+qint64 ClusterCache::budget() const
+{
+    return m_budget;
+}
+
+//=============================================================================
+QVector<ClusterCache::DrawItem> ClusterCache::update(
+        const QMatrix4x4& modelViewProjection)
+{
+    QVector<DrawItem> items;
+    if(!m_initialized || !m_file_p) return items;
+    ++m_frame;
+    m_stats.evicted = 0;
+
+    // ==== Cull, nearest first ====
+    QVector4D planes[6];
+    frustumPlanes(modelViewProjection, planes);
+
+    struct Candidate
+    {
+        int index;
+        float depth;
+    };
+    QVector<Candidate> visible;
+    QSet<int> visibleSet;
+    for(int i = 0; i < m_file_p->clusterCount(); ++i) {
+        const ClusterFile::Cluster& cluster = m_file_p->cluster(i);
+        if(!boxInFrustum(planes, cluster.min, cluster.max)) continue;
+        const QVector4D center(0.5f * (cluster.min[0] + cluster.max[0]),
+                0.5f * (cluster.min[1] + cluster.max[1]),
+                0.5f * (cluster.min[2] + cluster.max[2]), 1.0f);
+        visible.append({ i, (modelViewProjection * center).w() });
+        visibleSet.insert(i);
+    }
+    std::sort(visible.begin(), visible.end(),
+            [](const Candidate& a, const Candidate& b) {
+        return a.depth < b.depth;
+    });
+
+    for(const auto& candidate : visible) {
+        auto resident = m_residents.find(candidate.index);
+        if(resident != m_residents.end()) resident->lastUsed = m_frame;
+    }
+
+    // ==== Upload finished reads ====
+    qint64 uploaded = 0;
+    for(auto load = m_loads.begin(); load != m_loads.end(); ) {
+        if(!load->isFinished() || uploaded >= UPLOAD_BYTES_PER_FRAME) {
+            ++load;
+            continue;
+        }
+        const int index = load.key();
+        const QVector<float> vertices = load->result();
+        load = m_loads.erase(load);
+
+        const qint64 bytes = vertices.count() * sizeof(float);
+        const bool wanted = visibleSet.contains(index);
+        if(vertices.isEmpty()) continue;
+        if(wanted ? !makeRoom(bytes) : m_residentBytes + bytes > m_budget) {
+            continue;
+        }
+
+        Resident resident;
+        resident.bytes = bytes;
+        resident.lastUsed = m_frame;
+        glGenBuffers(1, &resident.buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, resident.buffer);
+        glBufferData(GL_ARRAY_BUFFER, bytes, vertices.constData(),
+                GL_STATIC_DRAW);
+        m_residents.insert(index, resident);
+        m_residentBytes += bytes;
+        uploaded += bytes;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // ==== Request what is visible but missing, within the budget ====
+    qint64 committed = 0;
+    for(auto load = m_loads.cbegin(); load != m_loads.cend(); ++load) {
+        committed += clusterBytes(load.key());
+    }
+    for(const auto& candidate : visible) {
+        const int index = candidate.index;
+        if(m_loads.contains(index)) continue;
+        committed += clusterBytes(index);
+        if(committed > m_budget) break;
+        if(m_residents.contains(index)) continue;
+        if(m_loads.count() >= MAX_LOADS_IN_FLIGHT) continue;
+
+        const QSharedPointer<ClusterFile> file_p = m_file_p;
+        m_loads.insert(index, QtConcurrent::run([file_p, index]() {
+            return file_p->read(index);
+        }));
+    }
+
+    // ==== Draw list ====
+    for(const auto& candidate : visible) {
+        auto resident = m_residents.constFind(candidate.index);
+        if(resident == m_residents.cend()) continue;
+        items.append({ resident->buffer,
+                m_file_p->cluster(candidate.index).vertexCount });
+    }
+
+    m_stats.visible = visible.count();
+    m_stats.drawn = items.count();
+    m_stats.resident = m_residents.count();
+    m_stats.loading = m_loads.count();
+    m_stats.residentBytes = m_residentBytes;
+    return items;
+}
+
+//=============================================================================
+bool ClusterCache::isLoading() const
+{
+    return !m_loads.isEmpty();
+}
+
+//=============================================================================
+const ClusterCache::Stats& ClusterCache::stats() const
+{
+    return m_stats;
+}
+
+//=============================================================================
+qint64 ClusterCache::allocatedBytes() const
+{
+    return m_residentBytes;
+}
+
+//=============================================================================
+qint64 ClusterCache::clusterBytes(int index) const
+{
+    return (qint64)m_file_p->cluster(index).vertexCount *
+            m_file_p->valuesPerVertex() * sizeof(float);
+}
+
+//=============================================================================
+bool ClusterCache::makeRoom(qint64 bytes)
+{
+    if(bytes > m_budget) return false;
+    while(m_residentBytes + bytes > m_budget) {
+        // Never evict what the current frame draws.
+        int oldest = -1;
+        quint64 oldestUse = m_frame;
+        for(auto resident = m_residents.cbegin();
+                resident != m_residents.cend(); ++resident) {
+            if(resident->lastUsed < oldestUse) {
+                oldest = resident.key();
+                oldestUse = resident->lastUsed;
+            }
+        }
+        if(oldest < 0) return false;
+        evict(oldest);
+    }
+    return true;
+}
+
+//=============================================================================
+void ClusterCache::evict(int index)
+{
+    const Resident resident = m_residents.take(index);
+    glDeleteBuffers(1, &resident.buffer);
+    m_residentBytes -= resident.bytes;
+    ++m_stats.evicted;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <QFuture>
+#include <QHash>
+#include <QMatrix4x4>
+#include <QSharedPointer>
+#include <QVector>
+
+#include "GlRecorder.h"
+
+class ClusterFile;
+
+//=============================================================================
+// Pages the clusters of a ClusterFile in and out of GPU buffers.  Each frame
+// the cluster bounds are tested against the view frustum; visible clusters
+// that are not resident are read on the thread pool, nearest first, and
+// uploaded a few at a time so a frame never waits on the disk.  Resident
+// clusters are kept in an LRU cache under a byte budget, and the ones that
+// have been out of view longest are evicted first.
+class ClusterCache : protected RecordingFunctions
+{
+public:
+    struct DrawItem
+    {
+        GLuint buffer;
+        GLsizei count;
+    };
+
+    struct Stats
+    {
+        int visible = 0;
+        int drawn = 0;
+        int resident = 0;
+        int loading = 0;
+        qint64 residentBytes = 0;
+        int evicted = 0;
+    };
+
+    static constexpr qint64 DEFAULT_BUDGET = 256 * 1024 * 1024;
+    static constexpr int MAX_LOADS_IN_FLIGHT = 4;
+    static constexpr qint64 UPLOAD_BYTES_PER_FRAME = 16 * 1024 * 1024;
+
+    ClusterCache(qint64 budget = DEFAULT_BUDGET);
+
+    void initialize();
+    void release();
+
+    void setFile(const QSharedPointer<ClusterFile>& file_p);
+    bool hasFile() const;
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+
+    QVector<DrawItem> update(const QMatrix4x4& modelViewProjection);
+
+    bool isLoading() const;
+    const Stats& stats() const;
+    qint64 allocatedBytes() const;
+
+private:
+    struct Resident
+    {
+        GLuint buffer;
+        qint64 bytes;
+        quint64 lastUsed;
+    };
+
+    qint64 clusterBytes(int index) const;
+    bool makeRoom(qint64 bytes);
+    void evict(int index);
+
+    QSharedPointer<ClusterFile> m_file_p;
+    qint64 m_budget;
+    quint64 m_frame;
+    QHash<int, Resident> m_residents;
+    QHash<int, QFuture<QVector<float>>> m_loads;
+    qint64 m_residentBytes;
+    Stats m_stats;
+    bool m_initialized;
+};
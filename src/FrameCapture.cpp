@@ -0,0 +1,287 @@
+#include "FrameCapture.h"
+
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QOpenGLContext>
+#include <QtConcurrent>
+#include <cstring>
+
+namespace {
+    constexpr GLenum PIXEL_PACK_BUFFER = 0x88EB;
+    constexpr GLenum SYNC_GPU_COMMANDS_COMPLETE = 0x9117;
+    constexpr GLenum ALREADY_SIGNALED = 0x911A;
+    constexpr GLenum TIMEOUT_EXPIRED = 0x911B;
+    constexpr GLbitfield SYNC_FLUSH_COMMANDS_BIT = 0x0001;
+    constexpr GLbitfield MAP_READ_BIT = 0x0001;
+    constexpr GLuint64 WAIT_TIMEOUT_NS = 1000000000;
+
+    // Frames waiting for or being encoded, per worker thread.
+    constexpr int QUEUED_FRAMES_PER_THREAD = 2;
+}
+
+//=============================================================================
+FrameCapture::FrameCapture(int ringSize) :
+        m_ringSize(qMax(ringSize, 1)),
+        m_next(0),
+        m_usePixelBuffers(false),
+        m_initialized(false),
+        m_format(Format::PNG),
+        m_recording(false),
+        m_readFramebuffer(0),
+        m_frameIndex(0),
+        m_stalledFrames(0)
+{
+    const int queueSize = QUEUED_FRAMES_PER_THREAD * m_pool.maxThreadCount();
+    m_queueSlots.release(queueSize);
+}
+
+//=============================================================================
+FrameCapture::~FrameCapture()
+{
+    m_pool.waitForDone();
+}
+
+//=============================================================================
+void FrameCapture::initialize(QOpenGLContext *context_p)
+{
+    release();
+    initializeOpenGLFunctions();
+
+    const QSurfaceFormat format = context_p->format();
+    m_usePixelBuffers = context_p->isOpenGLES() ?
+            (format.majorVersion() >= 3) :
+            (format.version() >= qMakePair(3, 2));
+
+    m_slots.fill(Slot(), m_ringSize);
+    m_next = 0;
+    m_initialized = true;
+}
+
+//=============================================================================
+void FrameCapture::release()
+{
+    if(!m_initialized) return;
+    for(auto& slot : m_slots) {
+        releaseSlot(slot);
+    }
+    m_slots.clear();
+    m_recording = false;
+    m_initialized = false;
+}
+
+//=============================================================================
+bool FrameCapture::usesPixelBuffers() const
+{
+    return m_usePixelBuffers;
+}
+
+//=============================================================================
+bool FrameCapture::start(const QString& directory, Format format)
+{
+    if(!m_initialized || m_recording) return false;
+    if(!QDir().mkpath(directory)) return false;
+
+    m_directory = directory;
+    m_format = format;
+    m_frameIndex = 0;
+    m_stalledFrames = 0;
+    m_recording = true;
+    return true;
+}
+
+//=============================================================================
+void FrameCapture::finish()
+{
+    if(!m_recording) return;
+
+    for(int i = 0; i < m_slots.count(); ++i) {
+        Slot& slot = m_slots[(m_next + i) % m_slots.count()];
+        if(slot.frame >= 0) (void)readSlot(slot, true);
+    }
+    m_recording = false;
+    m_pool.waitForDone();
+}
+
+//=============================================================================
+bool FrameCapture::isRecording() const
+{
+    return m_recording;
+}
+
+//=============================================================================
+void FrameCapture::capture(GLuint framebuffer, int width, int height)
+{
+    if(!m_recording || width <= 0 || height <= 0) return;
+    m_readFramebuffer = framebuffer;
+
+    // Hand over every finished frame, oldest first, so files are written
+    // in order as far as the pool allows.
+    for(int i = 0; i < m_slots.count(); ++i) {
+        Slot& slot = m_slots[(m_next + i) % m_slots.count()];
+        if(slot.frame < 0) continue;
+        if(!readSlot(slot, false)) break;
+    }
+
+    // The slot about to be reused holds the oldest frame.  If the GPU is a
+    // whole ring behind, waiting for it here is the only option.
+    Slot& slot = m_slots[m_next];
+    if(slot.frame >= 0) (void)readSlot(slot, true);
+
+    resizeSlot(slot, width, height);
+    if(m_usePixelBuffers) {
+        glBindBuffer(PIXEL_PACK_BUFFER, slot.buffer);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(PIXEL_PACK_BUFFER, 0);
+        slot.fence = glFenceSync(SYNC_GPU_COMMANDS_COMPLETE, 0);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, slot.texture);
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    slot.frame = m_frameIndex++;
+    m_next = (m_next + 1) % m_slots.count();
+}
+
+//=============================================================================
+int FrameCapture::capturedFrames() const
+{
+    return m_frameIndex;
+}
+
+//=============================================================================
+int FrameCapture::stalledFrames() const
+{
+    return m_stalledFrames;
+}
+
+//=============================================================================
+qint64 FrameCapture::allocatedBytes() const
+{
+    qint64 bytes = 0;
+    for(const auto& slot : m_slots) {
+        bytes += (qint64)slot.width * slot.height * 4;
+    }
+    return bytes;
+}
+
+//=============================================================================
+void FrameCapture::resizeSlot(Slot& slot, int width, int height)
+{
+    if(slot.width == width && slot.height == height) return;
+    releaseSlot(slot);
+
+    if(m_usePixelBuffers) {
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(PIXEL_PACK_BUFFER, slot.buffer);
+        glBufferData(PIXEL_PACK_BUFFER, width * height * 4, nullptr,
+                GL_STREAM_READ);
+        glBindBuffer(PIXEL_PACK_BUFFER, 0);
+    } else {
+        glGenTextures(1, &slot.texture);
+        glBindTexture(GL_TEXTURE_2D, slot.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0,
+                GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &slot.framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, slot.framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                GL_TEXTURE_2D, slot.texture, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_readFramebuffer);
+    }
+    slot.width = width;
+    slot.height = height;
+}
+
+//=============================================================================
+void FrameCapture::releaseSlot(Slot& slot)
+{
+    if(slot.fence) glDeleteSync(slot.fence);
+    if(slot.buffer) glDeleteBuffers(1, &slot.buffer);
+    if(slot.framebuffer) glDeleteFramebuffers(1, &slot.framebuffer);
+    if(slot.texture) glDeleteTextures(1, &slot.texture);
+    slot = Slot();
+}
+
+//=============================================================================
+bool FrameCapture::readSlot(Slot& slot, bool wait)
+{
+    QByteArray pixels(slot.width * slot.height * 4, Qt::Uninitialized);
+
+    if(m_usePixelBuffers) {
+        if(slot.fence) {
+            const GLenum result = glClientWaitSync(slot.fence,
+                    wait ? SYNC_FLUSH_COMMANDS_BIT : 0,
+                    wait ? WAIT_TIMEOUT_NS : 0);
+            if(result == TIMEOUT_EXPIRED && !wait) return false;
+            // Any wait the GPU had not already finished held up the frame,
+            // even one that ended with the fence signaled.
+            if(wait && result != ALREADY_SIGNALED) ++m_stalledFrames;
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+
+        glBindBuffer(PIXEL_PACK_BUFFER, slot.buffer);
+        const void *mapped_p = glMapBufferRange(PIXEL_PACK_BUFFER, 0,
+                pixels.size(), MAP_READ_BIT);
+        if(mapped_p) {
+            std::memcpy(pixels.data(), mapped_p, pixels.size());
+            (void)glUnmapBuffer(PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(PIXEL_PACK_BUFFER, 0);
+        if(!mapped_p) pixels.clear();
+    } else {
+        // Without fences there is no way to ask, so the ring depth is the
+        // only thing that keeps this read from waiting.
+        if(!wait) return false;
+        glBindFramebuffer(GL_FRAMEBUFFER, slot.framebuffer);
+        glReadPixels(0, 0, slot.width, slot.height,
+                GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glBindFramebuffer(GL_FRAMEBUFFER, m_readFramebuffer);
+    }
+
+    if(!pixels.isEmpty()) encode(pixels, slot.width, slot.height, slot.frame);
+    slot.frame = -1;
+    return true;
+}
+
+//=============================================================================
+void FrameCapture::encode(const QByteArray& pixels, int width, int height,
+        int frame)
+{
+    // Bounded queue: if the encoders fall behind, the render thread waits
+    // here rather than buffering frames without limit.
+    if(!m_queueSlots.tryAcquire()) {
+        ++m_stalledFrames;
+        m_queueSlots.acquire();
+    }
+
+    const QString extension = (m_format == Format::PNG) ? "png" : "rgba";
+    const QString path = QString("%1/frame_%2.%3").arg(m_directory)
+            .arg(frame, 6, 10, QChar('0')).arg(extension);
+    const Format format = m_format;
+
+    (void)QtConcurrent::run(&m_pool,
+            [this, pixels, width, height, path, format]() {
+        // GL rows run bottom to top.
+        const QImage image = QImage(
+                reinterpret_cast<const uchar *>(pixels.constData()),
+                width, height, QImage::Format_RGBX8888).mirrored();
+
+        if(format == Format::PNG) {
+            (void)image.save(path, "PNG");
+        } else {
+            QFile file(path);
+            if(file.open(QIODevice::WriteOnly)) {
+                (void)file.write(
+                        reinterpret_cast<const char *>(image.constBits()),
+                        image.bytesPerLine() * image.height());
+            }
+        }
+
+        m_queueSlots.release();
+    });
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QOpenGLExtraFunctions>
+#include <QSemaphore>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+
+class QOpenGLContext;
+
+//=============================================================================
+// Records rendered frames to a numbered image sequence without waiting for
+// the GPU.  Each frame is copied into the next slot of a small ring and read
+// back only when it is a few frames old.  ES3 and desktop GL 3.2 copy into a
+// pixel buffer object and check a fence before mapping it; ES2 copies into
+// a texture with glCopyTexSubImage2D and calls glReadPixels on it when the
+// slot comes around again.  Encoding and file writes run on a worker pool.
+class FrameCapture : protected QOpenGLExtraFunctions
+{
+public:
+    enum class Format
+    {
+        PNG,
+        RAW
+    };
+
+    static constexpr int DEFAULT_RING_SIZE = 3;
+
+    FrameCapture(int ringSize = DEFAULT_RING_SIZE);
+    ~FrameCapture();
+
+    void initialize(QOpenGLContext *context_p);
+    void release();
+    bool usesPixelBuffers() const;
+
+    bool start(const QString& directory, Format format = Format::PNG);
+    void finish();
+    bool isRecording() const;
+
+    void capture(GLuint framebuffer, int width, int height);
+
+    int capturedFrames() const;
+    int stalledFrames() const;
+    qint64 allocatedBytes() const;
+
+private:
+    struct Slot
+    {
+        GLuint buffer = 0;
+        GLuint texture = 0;
+        GLuint framebuffer = 0;
+        GLsync fence = nullptr;
+        int width = 0;
+        int height = 0;
+        int frame = -1;
+    };
+
+    void resizeSlot(Slot& slot, int width, int height);
+    void releaseSlot(Slot& slot);
+    bool readSlot(Slot& slot, bool wait);
+    void encode(const QByteArray& pixels, int width, int height, int frame);
+
+    int m_ringSize;
+    QVector<Slot> m_slots;
+    int m_next;
+    bool m_usePixelBuffers;
+    bool m_initialized;
+
+    QString m_directory;
+    Format m_format;
+    bool m_recording;
+    GLuint m_readFramebuffer;
+    int m_frameIndex;
+    int m_stalledFrames;
+
+    QThreadPool m_pool;
+    QSemaphore m_queueSlots;
+};
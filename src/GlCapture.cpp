@@ -0,0 +1,258 @@
+#include "GlCapture.h"
+
+#include <QIODevice>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+    constexpr char MAGIC[8] = { 'G', 'L', 'N', 'L', 'C', 'A', 'P', '1' };
+    constexpr int FLUSH_BYTES = 256 * 1024;
+
+    // Guards against absurd lengths in damaged files.
+    constexpr quint64 MAX_COUNT = 1 << 28;
+
+    //=========================================================================
+    void appendVarint(QByteArray& buffer, quint64 value)
+    {
+        while(value >= 0x80) {
+            buffer.append((char)((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        buffer.append((char)value);
+    }
+
+    //=========================================================================
+    void appendSigned(QByteArray& buffer, qint64 value)
+    {
+        appendVarint(buffer,
+                ((quint64)value << 1) ^ (quint64)(value >> 63));
+    }
+}
+
+//=============================================================================
+QString GlCapture::opName(Op op)
+{
+    static const char *names[] = {
+        "frame", "program", "useProgram", "uniform", "bindBuffer",
+        "bufferData", "bufferSubData", "deleteBuffer",
+        "vertexAttribPointer", "enableVertexAttribArray",
+        "disableVertexAttribArray", "enable", "disable", "depthMask",
+        "cullFace", "frontFace", "blendFunc", "clearColor", "clear",
+        "viewport", "activeTexture", "bindTexture", "bindFramebuffer",
+        "drawArrays"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == (int)Op::COUNT,
+            "every opcode needs a name");
+
+    const int index = (int)op;
+    if(index < 0 || index >= (int)Op::COUNT) return QString("unknown");
+    return QString(names[index]);
+}
+
+//=============================================================================
+GlCapture::Writer::Writer() :
+        m_device_p(nullptr),
+        m_bytesWritten(0),
+        m_commandsWritten(0),
+        m_ok(false)
+{
+}
+
+//=============================================================================
+bool GlCapture::Writer::begin(QIODevice *device_p)
+{
+    m_device_p = device_p;
+    m_buffer.clear();
+    m_bytesWritten = 0;
+    m_commandsWritten = 0;
+    m_ok = (device_p != nullptr);
+    if(!m_ok) return false;
+
+    m_buffer.append(MAGIC, sizeof(MAGIC));
+    appendVarint(m_buffer, VERSION);
+    return flush();
+}
+
+//=============================================================================
+bool GlCapture::Writer::write(const Command& command)
+{
+    if(!m_ok) return false;
+
+    m_buffer.append((char)command.op);
+    appendVarint(m_buffer, command.ints.count());
+    for(qint64 value : command.ints) appendSigned(m_buffer, value);
+
+    appendVarint(m_buffer, command.floats.count());
+    for(float value : command.floats) {
+        quint32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        uchar bytes[sizeof(bits)];
+        qToLittleEndian(bits, bytes);
+        m_buffer.append(reinterpret_cast<const char *>(bytes), sizeof(bits));
+    }
+
+    appendVarint(m_buffer, command.strings.count());
+    for(const auto& string : command.strings) {
+        const QByteArray utf8 = string.toUtf8();
+        appendVarint(m_buffer, utf8.size());
+        m_buffer.append(utf8);
+    }
+
+    appendVarint(m_buffer, command.data.size());
+    m_buffer.append(command.data);
+
+    ++m_commandsWritten;
+    return m_buffer.size() < FLUSH_BYTES || flush();
+}
+
+//=============================================================================
+bool GlCapture::Writer::end()
+{
+    const bool ok = m_ok && flush();
+    m_device_p = nullptr;
+    m_ok = false;
+    return ok;
+}
+
+//=============================================================================
+qint64 GlCapture::Writer::bytesWritten() const
+{
+    return m_bytesWritten + m_buffer.size();
+}
+
+//=============================================================================
+int GlCapture::Writer::commandsWritten() const
+{
+    return m_commandsWritten;
+}
+
+//=============================================================================
+bool GlCapture::Writer::flush()
+{
+    const int size = m_buffer.size();
+    if(size > 0 && m_device_p->write(m_buffer) != size) m_ok = false;
+    m_bytesWritten += size;
+    m_buffer.clear();
+    return m_ok;
+}
+
+//=============================================================================
+GlCapture::Reader::Reader() :
+        m_device_p(nullptr),
+        m_error(false)
+{
+}
+
+//=============================================================================
+bool GlCapture::Reader::begin(QIODevice *device_p)
+{
+    m_device_p = device_p;
+    m_error = true;
+    if(!device_p) return false;
+
+    QByteArray magic;
+    quint64 version = 0;
+    if(!readBytes(&magic, sizeof(MAGIC)) ||
+            std::memcmp(magic.constData(), MAGIC, sizeof(MAGIC)) != 0 ||
+            !readVarint(&version) || version != (quint64)VERSION) {
+        return false;
+    }
+    m_error = false;
+    return true;
+}
+
+//=============================================================================
+// Returns false at the end of the capture; hasError() tells a clean end
+// from a damaged one.
+bool GlCapture::Reader::next(Command *command_p)
+{
+    if(m_error || !m_device_p) return false;
+
+    quint8 op = 0;
+    if(!readByte(&op)) return false;
+    m_error = true;
+    if(op >= (quint8)Op::COUNT) return false;
+
+    Command command;
+    command.op = (Op)op;
+
+    quint64 count = 0;
+    if(!readVarint(&count) || count > MAX_COUNT) return false;
+    command.ints.resize(count);
+    for(auto& value : command.ints) {
+        if(!readSigned(&value)) return false;
+    }
+
+    if(!readVarint(&count) || count > MAX_COUNT) return false;
+    QByteArray bytes;
+    if(!readBytes(&bytes, count * sizeof(quint32))) return false;
+    command.floats.resize(count);
+    for(int i = 0; i < command.floats.count(); ++i) {
+        const quint32 bits = qFromLittleEndian<quint32>(
+                bytes.constData() + i * sizeof(quint32));
+        std::memcpy(&command.floats[i], &bits, sizeof(bits));
+    }
+
+    if(!readVarint(&count) || count > MAX_COUNT) return false;
+    for(quint64 i = 0; i < count; ++i) {
+        quint64 length = 0;
+        if(!readVarint(&length) || !readBytes(&bytes, length)) return false;
+        command.strings.append(QString::fromUtf8(bytes));
+    }
+
+    if(!readVarint(&count) || !readBytes(&command.data, count)) return false;
+
+    *command_p = command;
+    m_error = false;
+    return true;
+}
+
+//=============================================================================
+bool GlCapture::Reader::hasError() const
+{
+    return m_error;
+}
+
+//=============================================================================
+bool GlCapture::Reader::readByte(quint8 *value_p)
+{
+    char c;
+    if(!m_device_p->getChar(&c)) return false;
+    *value_p = (quint8)c;
+    return true;
+}
+
+//=============================================================================
+bool GlCapture::Reader::readVarint(quint64 *value_p)
+{
+    quint64 value = 0;
+    for(int shift = 0; shift < 64; shift += 7) {
+        quint8 byte = 0;
+        if(!readByte(&byte)) return false;
+        value |= (quint64)(byte & 0x7f) << shift;
+        if(!(byte & 0x80)) {
+            *value_p = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+//=============================================================================
+bool GlCapture::Reader::readSigned(qint64 *value_p)
+{
+    quint64 value = 0;
+    if(!readVarint(&value)) return false;
+    *value_p = (qint64)(value >> 1) ^ -(qint64)(value & 1);
+    return true;
+}
+
+//=============================================================================
+bool GlCapture::Reader::readBytes(QByteArray *bytes_p, qint64 length)
+{
+    if(length < 0 || (quint64)length > MAX_COUNT * sizeof(quint32)) {
+        return false;
+    }
+    *bytes_p = m_device_p->read(length);
+    return bytes_p->size() == length;
+}
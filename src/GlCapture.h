@@ -0,0 +1,117 @@
+#pragma once
+
+#include <QByteArray>
+#include <QStringList>
+#include <QVector>
+
+class QIODevice;
+
+//=============================================================================
+// The binary format GL command captures are stored in.  A capture is a
+// header followed by a flat list of commands; each command is an opcode
+// and four argument lists (integers, floats, strings and one data blob),
+// any of which may be empty.  Integers are zigzag LEB128 varints and floats
+// are little endian, so typical commands take a few bytes.
+//
+// Layout:
+//   "GLNLCAP1", varint version,
+//   commands { quint8 opcode, varint intCount, varint ints...,
+//              varint floatCount, float32 floats...,
+//              varint stringCount, { varint length, UTF-8 bytes }...,
+//              varint dataLength, bytes }
+namespace GlCapture
+{
+    constexpr int VERSION = 1;
+
+    // Arguments are listed after each opcode.
+    enum class Op : quint8
+    {
+        FRAME,                  // (frame index)
+        PROGRAM,                // (program, attribute count,
+                                //  attribute locations..., uniform
+                                //  locations...), [vertex source,
+                                //  fragment source, attribute names...,
+                                //  uniform names...]
+        USE_PROGRAM,            // (program)
+        UNIFORM,                // (location, type, int values...),
+                                // {float values...}
+        BIND_BUFFER,            // (target, buffer)
+        BUFFER_DATA,            // (target, size, usage), data
+        BUFFER_SUB_DATA,        // (target, offset), data
+        DELETE_BUFFER,          // (buffer)
+        VERTEX_ATTRIB_POINTER,  // (index, size, type, normalized, stride,
+                                //  offset)
+        ENABLE_ATTRIB_ARRAY,    // (index)
+        DISABLE_ATTRIB_ARRAY,   // (index)
+        ENABLE,                 // (capability)
+        DISABLE,                // (capability)
+        DEPTH_MASK,             // (flag)
+        CULL_FACE,              // (mode)
+        FRONT_FACE,             // (mode)
+        BLEND_FUNC,             // (source rgb, destination rgb,
+                                //  source alpha, destination alpha)
+        CLEAR_COLOR,            // {red, green, blue, alpha}
+        CLEAR,                  // (mask)
+        VIEWPORT,               // (x, y, width, height)
+        ACTIVE_TEXTURE,         // (unit)
+        BIND_TEXTURE,           // (target, texture)
+        BIND_FRAMEBUFFER,       // (framebuffer, 0 for the default)
+        DRAW_ARRAYS,            // (mode, first, count)
+
+        COUNT
+    };
+
+    struct Command
+    {
+        Op op = Op::FRAME;
+        QVector<qint64> ints;
+        QVector<float> floats;
+        QStringList strings;
+        QByteArray data;
+    };
+
+    QString opName(Op op);
+
+    //=========================================================================
+    class Writer
+    {
+    public:
+        Writer();
+
+        bool begin(QIODevice *device_p);
+        bool write(const Command& command);
+        bool end();
+
+        qint64 bytesWritten() const;
+        int commandsWritten() const;
+
+    private:
+        bool flush();
+
+        QIODevice *m_device_p;
+        QByteArray m_buffer;
+        qint64 m_bytesWritten;
+        int m_commandsWritten;
+        bool m_ok;
+    };
+
+    //=========================================================================
+    class Reader
+    {
+    public:
+        Reader();
+
+        bool begin(QIODevice *device_p);
+        bool next(Command *command_p);
+        bool hasError() const;
+
+    private:
+        bool readByte(quint8 *value_p);
+        bool readVarint(quint64 *value_p);
+        bool readSigned(qint64 *value_p);
+        bool readBytes(QByteArray *bytes_p, qint64 length);
+
+        QIODevice *m_device_p;
+        bool m_error;
+    };
+}
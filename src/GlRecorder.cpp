@@ -0,0 +1,269 @@
+#include "GlRecorder.h"
+
+#include <QMutexLocker>
+
+namespace {
+    constexpr GLuint NO_PROGRAM = ~0u;
+    constexpr int MAX_NAME_LENGTH = 256;
+
+    //=========================================================================
+    // Float and integer component counts of the uniform types GLSL ES 1.00
+    // has; anything else is skipped.
+    bool uniformComponents(GLenum type, int *floats_p, int *ints_p)
+    {
+        *floats_p = 0;
+        *ints_p = 0;
+        switch(type) {
+        case GL_FLOAT: *floats_p = 1; return true;
+        case GL_FLOAT_VEC2: *floats_p = 2; return true;
+        case GL_FLOAT_VEC3: *floats_p = 3; return true;
+        case GL_FLOAT_VEC4: *floats_p = 4; return true;
+        case GL_FLOAT_MAT2: *floats_p = 4; return true;
+        case GL_FLOAT_MAT3: *floats_p = 9; return true;
+        case GL_FLOAT_MAT4: *floats_p = 16; return true;
+        case GL_INT:
+        case GL_BOOL:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_CUBE: *ints_p = 1; return true;
+        case GL_INT_VEC2:
+        case GL_BOOL_VEC2: *ints_p = 2; return true;
+        case GL_INT_VEC3:
+        case GL_BOOL_VEC3: *ints_p = 3; return true;
+        case GL_INT_VEC4:
+        case GL_BOOL_VEC4: *ints_p = 4; return true;
+        default: return false;
+        }
+    }
+}
+
+std::atomic<bool> GlRecorder::s_active(false);
+
+//=============================================================================
+GlRecorder& GlRecorder::instance()
+{
+    static GlRecorder recorder;
+    return recorder;
+}
+
+//=============================================================================
+GlRecorder::GlRecorder() :
+        m_defaultFramebuffer(0),
+        m_frames(0),
+        m_program(NO_PROGRAM)
+{
+}
+
+//=============================================================================
+void GlRecorder::registerProgram(GLuint program, const QString& vertexSource,
+        const QString& fragmentSource)
+{
+    QMutexLocker locker(&m_mutex);
+    m_sources.insert(program, { vertexSource, fragmentSource });
+    m_programsWritten.remove(program);
+}
+
+//=============================================================================
+bool GlRecorder::start(const QString& path)
+{
+    QMutexLocker locker(&m_mutex);
+    if(s_active) return false;
+
+    m_file.setFileName(path);
+    if(!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    if(!m_writer.begin(&m_file)) {
+        m_file.close();
+        return false;
+    }
+
+    m_defaultFramebuffer = 0;
+    m_frames = 0;
+    m_program = NO_PROGRAM;
+    m_programsWritten.clear();
+    m_uniforms.clear();
+    s_active = true;
+    return true;
+}
+
+//=============================================================================
+bool GlRecorder::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    if(!s_active) return false;
+    s_active = false;
+
+    const bool ok = m_writer.end();
+    m_file.close();
+    return ok;
+}
+
+//=============================================================================
+void GlRecorder::beginFrame(GLuint defaultFramebuffer)
+{
+    QMutexLocker locker(&m_mutex);
+    if(!s_active) return;
+
+    m_defaultFramebuffer = defaultFramebuffer;
+    GlCapture::Command command;
+    command.op = GlCapture::Op::FRAME;
+    command.ints << m_frames++;
+    (void)m_writer.write(command);
+}
+
+//=============================================================================
+int GlRecorder::framesRecorded() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_frames;
+}
+
+//=============================================================================
+qint64 GlRecorder::bytesRecorded() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_writer.bytesWritten();
+}
+
+//=============================================================================
+void GlRecorder::record(GlCapture::Op op, std::initializer_list<qint64> ints,
+        const QByteArray& data)
+{
+    QMutexLocker locker(&m_mutex);
+    if(!s_active) return;
+
+    GlCapture::Command command;
+    command.op = op;
+    for(qint64 value : ints) command.ints.append(value);
+    command.data = data;
+    (void)m_writer.write(command);
+}
+
+//=============================================================================
+void GlRecorder::recordFloats(GlCapture::Op op,
+        std::initializer_list<float> floats)
+{
+    QMutexLocker locker(&m_mutex);
+    if(!s_active) return;
+
+    GlCapture::Command command;
+    command.op = op;
+    for(float value : floats) command.floats.append(value);
+    (void)m_writer.write(command);
+}
+
+//=============================================================================
+// The widget's own framebuffer is written as 0 so replays can substitute
+// theirs.
+void GlRecorder::recordFramebuffer(GLuint framebuffer)
+{
+    QMutexLocker locker(&m_mutex);
+    if(!s_active) return;
+
+    GlCapture::Command command;
+    command.op = GlCapture::Op::BIND_FRAMEBUFFER;
+    command.ints << (framebuffer == m_defaultFramebuffer ? 0 : framebuffer);
+    (void)m_writer.write(command);
+}
+
+//=============================================================================
+void GlRecorder::recordDraw(QOpenGLFunctions *gl_p, GLenum mode,
+        GLint first, GLsizei count)
+{
+    QMutexLocker locker(&m_mutex);
+    if(!s_active) return;
+
+    syncProgram(gl_p);
+
+    GlCapture::Command command;
+    command.op = GlCapture::Op::DRAW_ARRAYS;
+    command.ints << mode << first << count;
+    (void)m_writer.write(command);
+}
+
+//=============================================================================
+// Writes the current program, its description the first time it is seen,
+// and every uniform whose value differs from the last one written.
+void GlRecorder::syncProgram(QOpenGLFunctions *gl_p)
+{
+    GLint current = 0;
+    gl_p->glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+    const GLuint program = current;
+
+    if(program != m_program) {
+        m_program = program;
+        GlCapture::Command command;
+        command.op = GlCapture::Op::USE_PROGRAM;
+        command.ints << program;
+        (void)m_writer.write(command);
+    }
+    if(!program) return;
+
+    char name[MAX_NAME_LENGTH];
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+
+    // ==== Program description ====
+    if(!m_programsWritten.contains(program)) {
+        const Sources sources = m_sources.value(program);
+        GlCapture::Command command;
+        command.op = GlCapture::Op::PROGRAM;
+        command.ints << program << 0;
+        command.strings << sources.vertex << sources.fragment;
+
+        GLint attributes = 0;
+        gl_p->glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &attributes);
+        for(GLint i = 0; i < attributes; ++i) {
+            gl_p->glGetActiveAttrib(program, i, sizeof(name), &length,
+                    &size, &type, name);
+            command.ints.append(gl_p->glGetAttribLocation(program, name));
+            command.strings.append(QString::fromUtf8(name, length));
+        }
+        command.ints[1] = attributes;
+
+        GLint uniforms = 0;
+        gl_p->glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniforms);
+        for(GLint i = 0; i < uniforms; ++i) {
+            gl_p->glGetActiveUniform(program, i, sizeof(name), &length,
+                    &size, &type, name);
+            command.ints.append(gl_p->glGetUniformLocation(program, name));
+            command.strings.append(QString::fromUtf8(name, length));
+        }
+
+        (void)m_writer.write(command);
+        m_programsWritten.insert(program, true);
+    }
+
+    // ==== Changed uniforms ====
+    GLint uniforms = 0;
+    gl_p->glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniforms);
+    for(GLint i = 0; i < uniforms; ++i) {
+        gl_p->glGetActiveUniform(program, i, sizeof(name), &length,
+                &size, &type, name);
+        int floatCount = 0;
+        int intCount = 0;
+        if(!uniformComponents(type, &floatCount, &intCount)) continue;
+        const GLint location = gl_p->glGetUniformLocation(program, name);
+        if(location < 0) continue;
+
+        GlCapture::Command command;
+        command.op = GlCapture::Op::UNIFORM;
+        command.ints << location << type;
+        if(floatCount > 0) {
+            GLfloat values[16];
+            gl_p->glGetUniformfv(program, location, values);
+            for(int j = 0; j < floatCount; ++j) command.floats << values[j];
+        } else {
+            GLint values[4];
+            gl_p->glGetUniformiv(program, location, values);
+            for(int j = 0; j < intCount; ++j) command.ints << values[j];
+        }
+
+        GlCapture::Command& last = m_uniforms[qMakePair(program, location)];
+        if(last.op == command.op && last.ints == command.ints &&
+                last.floats == command.floats) {
+            continue;
+        }
+        last = command;
+        (void)m_writer.write(command);
+    }
+}
@@ -0,0 +1,277 @@
+#pragma once
+
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QOpenGLFunctions>
+#include <QString>
+#include <atomic>
+
+#include "GlCapture.h"
+
+//=============================================================================
+// Records the GL commands the viewer issues into a GlCapture file.  Calls
+// are intercepted by RecordingFunctions below; uniforms set through
+// QOpenGLShaderProgram are picked up by reading the current program's
+// uniforms back before every draw and writing the ones that changed.
+// Shader sources come from ShaderCache, which registers every program it
+// builds, so programs loaded from binaries can still be replayed.
+class GlRecorder
+{
+public:
+    static GlRecorder& instance();
+
+    static bool isActive()
+    {
+        return s_active.load(std::memory_order_relaxed);
+    }
+
+    void registerProgram(GLuint program, const QString& vertexSource,
+            const QString& fragmentSource);
+
+    bool start(const QString& path);
+    bool stop();
+
+    void beginFrame(GLuint defaultFramebuffer);
+    int framesRecorded() const;
+    qint64 bytesRecorded() const;
+
+    void record(GlCapture::Op op, std::initializer_list<qint64> ints,
+            const QByteArray& data = QByteArray());
+    void recordFloats(GlCapture::Op op, std::initializer_list<float> floats);
+    void recordFramebuffer(GLuint framebuffer);
+    void recordDraw(QOpenGLFunctions *gl_p, GLenum mode, GLint first,
+            GLsizei count);
+
+private:
+    struct Sources
+    {
+        QString vertex;
+        QString fragment;
+    };
+
+    GlRecorder();
+
+    void syncProgram(QOpenGLFunctions *gl_p);
+
+    static std::atomic<bool> s_active;
+
+    mutable QMutex m_mutex;
+    QHash<GLuint, Sources> m_sources;
+    QFile m_file;
+    GlCapture::Writer m_writer;
+    GLuint m_defaultFramebuffer;
+    int m_frames;
+
+    GLuint m_program;
+    QHash<GLuint, bool> m_programsWritten;
+    QHash<QPair<GLuint, GLint>, GlCapture::Command> m_uniforms;
+};
+
+//=============================================================================
+// Drop-in replacement for QOpenGLFunctions that reports the state, buffer
+// and draw calls it forwards to the GlRecorder while a capture is running.
+// Calls made through the base class are still forwarded but not recorded.
+class RecordingFunctions : public QOpenGLFunctions
+{
+public:
+    void glBindBuffer(GLenum target, GLuint buffer)
+    {
+        QOpenGLFunctions::glBindBuffer(target, buffer);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(GlCapture::Op::BIND_BUFFER,
+                    { target, buffer });
+        }
+    }
+
+    void glBufferData(GLenum target, GLsizeiptr size, const void *data_p,
+            GLenum usage)
+    {
+        QOpenGLFunctions::glBufferData(target, size, data_p, usage);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(GlCapture::Op::BUFFER_DATA,
+                    { target, size, usage }, data_p ? QByteArray(
+                    static_cast<const char *>(data_p), size) : QByteArray());
+        }
+    }
+
+    void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size,
+            const void *data_p)
+    {
+        QOpenGLFunctions::glBufferSubData(target, offset, size, data_p);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(GlCapture::Op::BUFFER_SUB_DATA,
+                    { target, offset },
+                    QByteArray(static_cast<const char *>(data_p), size));
+        }
+    }
+
+    void glDeleteBuffers(GLsizei n, const GLuint *buffers_p)
+    {
+        if(GlRecorder::isActive()) {
+            for(GLsizei i = 0; i < n; ++i) {
+                if(!buffers_p[i]) continue;
+                GlRecorder::instance().record(GlCapture::Op::DELETE_BUFFER,
+                        { buffers_p[i] });
+            }
+        }
+        QOpenGLFunctions::glDeleteBuffers(n, buffers_p);
+    }
+
+    void glVertexAttribPointer(GLuint index, GLint size, GLenum type,
+            GLboolean normalized, GLsizei stride, const void *pointer_p)
+    {
+        QOpenGLFunctions::glVertexAttribPointer(
+                index, size, type, normalized, stride, pointer_p);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(
+                    GlCapture::Op::VERTEX_ATTRIB_POINTER,
+                    { index, size, type, normalized, stride,
+                    (qint64)reinterpret_cast<quintptr>(pointer_p) });
+        }
+    }
+
+    void glEnableVertexAttribArray(GLuint index)
+    {
+        QOpenGLFunctions::glEnableVertexAttribArray(index);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(
+                    GlCapture::Op::ENABLE_ATTRIB_ARRAY, { index });
+        }
+    }
+
+    void glDisableVertexAttribArray(GLuint index)
+    {
+        QOpenGLFunctions::glDisableVertexAttribArray(index);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(
+                    GlCapture::Op::DISABLE_ATTRIB_ARRAY, { index });
+        }
+    }
+
+    void glEnable(GLenum capability)
+    {
+        QOpenGLFunctions::glEnable(capability);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(GlCapture::Op::ENABLE,
+                    { capability });
+        }
+    }
+
+    void glDisable(GLenum capability)
+    {
+        QOpenGLFunctions::glDisable(capability);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(GlCapture::Op::DISABLE,
+                    { capability });
+        }
+    }
+
+    void glDepthMask(GLboolean flag)
+    {
+        QOpenGLFunctions::glDepthMask(flag);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(GlCapture::Op::DEPTH_MASK,
+                    { flag });
+        }
+    }
+
+    void glCullFace(GLenum mode)
+    {
+        QOpenGLFunctions::glCullFace(mode);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(GlCapture::Op::CULL_FACE, { mode });
+        }
+    }
+
+    void glFrontFace(GLenum mode)
+    {
+        QOpenGLFunctions::glFrontFace(mode);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(GlCapture::Op::FRONT_FACE,
+                    { mode });
+        }
+    }
+
+    void glBlendFunc(GLenum source, GLenum destination)
+    {
+        QOpenGLFunctions::glBlendFunc(source, destination);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(GlCapture::Op::BLEND_FUNC,
+                    { source, destination, source, destination });
+        }
+    }
+
+    void glBlendFuncSeparate(GLenum sourceRgb, GLenum destinationRgb,
+            GLenum sourceAlpha, GLenum destinationAlpha)
+    {
+        QOpenGLFunctions::glBlendFuncSeparate(sourceRgb, destinationRgb,
+                sourceAlpha, destinationAlpha);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(GlCapture::Op::BLEND_FUNC,
+                    { sourceRgb, destinationRgb,
+                    sourceAlpha, destinationAlpha });
+        }
+    }
+
+    void glClearColor(GLclampf red, GLclampf green, GLclampf blue,
+            GLclampf alpha)
+    {
+        QOpenGLFunctions::glClearColor(red, green, blue, alpha);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().recordFloats(GlCapture::Op::CLEAR_COLOR,
+                    { red, green, blue, alpha });
+        }
+    }
+
+    void glClear(GLbitfield mask)
+    {
+        QOpenGLFunctions::glClear(mask);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(GlCapture::Op::CLEAR, { mask });
+        }
+    }
+
+    void glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        QOpenGLFunctions::glViewport(x, y, width, height);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(GlCapture::Op::VIEWPORT,
+                    { x, y, width, height });
+        }
+    }
+
+    void glActiveTexture(GLenum unit)
+    {
+        QOpenGLFunctions::glActiveTexture(unit);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(GlCapture::Op::ACTIVE_TEXTURE,
+                    { unit });
+        }
+    }
+
+    void glBindTexture(GLenum target, GLuint texture)
+    {
+        QOpenGLFunctions::glBindTexture(target, texture);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().record(GlCapture::Op::BIND_TEXTURE,
+                    { target, texture });
+        }
+    }
+
+    void glBindFramebuffer(GLenum target, GLuint framebuffer)
+    {
+        QOpenGLFunctions::glBindFramebuffer(target, framebuffer);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().recordFramebuffer(framebuffer);
+        }
+    }
+
+    void glDrawArrays(GLenum mode, GLint first, GLsizei count)
+    {
+        QOpenGLFunctions::glDrawArrays(mode, first, count);
+        if(GlRecorder::isActive()) {
+            GlRecorder::instance().recordDraw(this, mode, first, count);
+        }
+    }
+};
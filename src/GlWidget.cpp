@@ -1,12 +1,100 @@
 #include "GlWidget.h"
 
+#include <QCryptographicHash>
 #include <QFile>
+#include <QFileInfo>
+#include <QMetaObject>
 #include <QMouseEvent>
 #include <QOpenGLShaderProgram>
-#include <QOpenGLTexture>
+#include <QPainter>
 #include <QRegularExpression>
+#include <QtConcurrent>
+#include <algorithm>
 
+#include "BakedOrnaments.h"
+#include "GpuResources.h"
 #include "ModelTools.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "TextureAtlas.h"
+#include "TextureResidency.h"
+
+static_assert(BakedOrnaments::VERTEX_VALUES == NUM_VERTEX_VALUES,
+        "BakedOrnaments.h is out of date");
+
+namespace {
+    constexpr int DEFAULT_POINT_BUDGET = 2000000;
+    constexpr float POINT_ERROR_PIXELS = 1.5f;
+    constexpr GLenum PROGRAM_POINT_SIZE = 0x8642;
+    const QString CLUSTER_FILE_SUFFIX = ".glc";
+
+    // Lets editors finish writing before the model is reparsed.
+    constexpr int RELOAD_DELAY_MS = 150;
+
+    // Occluders are the largest instances covering at least this much of
+    // the screen.
+    constexpr int MAX_OCCLUDERS = 8;
+    constexpr float MIN_OCCLUDER_COVERAGE = 0.02f;
+
+    // Time a frame may spend on loader uploads; the rest wait a frame.
+    constexpr int UPLOAD_BUDGET_MS = 8;
+
+    // How much the upscale pass sharpens when sharpening is on.
+    constexpr float UPSCALE_SHARPNESS = 0.5f;
+
+    // Loader uploads, least urgent first.  Model chunks go before the
+    // finished model so that it never lands ahead of its own faces.
+    enum UploadPriority
+    {
+        SCENE_UPLOAD,
+        ORNAMENT_UPLOAD,
+        MODEL_UPLOAD,
+        MODEL_CHUNK_UPLOAD
+    };
+
+    // One triangle that covers the whole viewport.
+    const GLfloat LAYER_TRIANGLE[] = {
+        -1.0f, -1.0f, 3.0f, -1.0f, -1.0f, 3.0f
+    };
+
+    //=========================================================================
+    QByteArray programKey(const QString& vertexSource,
+            const QString& fragmentSource)
+    {
+        return GpuResources::key("program",
+                vertexSource.toUtf8() + '\0' + fragmentSource.toUtf8());
+    }
+
+    //=========================================================================
+    QString texturePathFor(const QString& modelPath)
+    {
+        QString texturePath = modelPath;
+        (void)texturePath.replace(QRegularExpression("\\.[Pp][Ll][Yy]$"),
+                "-texture.png");
+        return texturePath;
+    }
+
+    //=========================================================================
+    QByteArray matrixBytes(const QMatrix4x4& matrix)
+    {
+        return QByteArray(reinterpret_cast<const char *>(matrix.constData()),
+                16 * sizeof(float));
+    }
+
+    //=========================================================================
+    // The mips of a decoded texture; null for null images.
+    QSharedPointer<const MipChain> buildMipChain(const QImage& image)
+    {
+        if(image.isNull()) return QSharedPointer<const MipChain>();
+
+        ScopedTimer timer("texture mips");
+        const QImage rgba = image.convertToFormat(QImage::Format_RGBA8888);
+        auto mips_p = QSharedPointer<MipChain>::create();
+        mips_p->build(rgba.constBits(), rgba.width(), rgba.height(),
+                rgba.bytesPerLine());
+        return mips_p;
+    }
+}
 
 //=============================================================================
 GlWidget::GlWidget(QWidget *parent_p) : QOpenGLWidget(parent_p),
@@ -14,6 +102,11 @@ GlWidget::GlWidget(QWidget *parent_p) : QOpenGLWidget(parent_p),
         m_enableDepthTesting(true),
         m_enableFacetedRender(false),
         m_enableVisibleNormals(false),
+        m_enableStatsOverlay(false),
+        m_enablePointCloud(false),
+        m_enableOcclusionCulling(true),
+        m_enableDynamicResolution(false),
+        m_enableSharpenUpscale(true),
         m_mouseActive(false),
         m_cameraDistance(20.0),
         m_cameraAngleX(15.0),
@@ -23,18 +116,93 @@ GlWidget::GlWidget(QWidget *parent_p) : QOpenGLWidget(parent_p),
         m_modelChanged(false),
         m_modelBuffer(0),
         m_modelVertexCount(0),
-        m_texture_p(nullptr),
-        m_gridBuffer(0),
+        m_faceNormalBuffer(0),
+        m_modelTexture(-1),
+        m_modelMin{ 0.0f, 0.0f, 0.0f },
+        m_modelMax{ 0.0f, 0.0f, 0.0f },
+        m_modelLoading(false),
+        m_modelGeneration(0),
+        m_chunkGeneration(0),
+        m_modelCapacity(0),
+        m_firstChunkMs(0),
+        m_modelReloaded(false),
+        m_reloadPending(false),
+        m_pointCloudChanged(false),
+        m_pointCloudGeneration(0),
+        m_pointsOnly(false),
+        m_pointBuffer(0),
+        m_pointBudget(DEFAULT_POINT_BUDGET),
+        m_pointsDrawn(0),
+        m_clusterFileChanged(false),
+        m_streamChanged(false),
+        m_streamBuffer(0),
+        m_streamVertexCount(0),
+        m_nextSceneId(0),
+        m_ornamentBuffer(0),
+        m_ornamentTexture(-1),
+        m_ornamentTextureLevel(-1),
+        m_gridFirst(0),
         m_gridVertexCount(0),
-        m_gridTexture_p(nullptr),
-        m_arrowBuffer(0),
+        m_arrowFirst(0),
         m_arrowVertexCount(0),
-        m_arrowTexture_p(nullptr),
+        m_arrowGeneration(0),
+        m_layersAvailable(false),
+        m_layerProgram_p(nullptr),
+        m_layerBuffer(0),
+        m_renderScale(1.0f),
+        m_upscaleProgram_p(nullptr),
+        m_frameMs(0.0),
         m_program_p(nullptr),
         m_ornamentProgram_p(nullptr),
-        m_shadersChanged(false)
+        m_shadersChanged(false),
+        m_shaderGeneration(0),
+        m_textureStreamer_p(nullptr),
+        m_textureView(-1),
+        m_textureBudget(-1),
+        m_captureFramesLeft(0)
 {
     updateViewMatrix();
+
+    connect(&m_shaderCompiler, &ShaderCompiler::compiled,
+            this, &GlWidget::shadersCompiled);
+    m_loader.setReadyNotifier([this]() {
+        QMetaObject::invokeMethod(this, [this]() { update(); },
+                Qt::QueuedConnection);
+    });
+
+    // Editors that save by replacing the file drop it from the watch list,
+    // so the watch is renewed when the reload starts.
+    m_reloadTimer.setSingleShot(true);
+    m_reloadTimer.setInterval(RELOAD_DELAY_MS);
+    connect(&m_modelFileWatcher, &QFileSystemWatcher::fileChanged,
+            &m_reloadTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(&m_reloadTimer, &QTimer::timeout, this, &GlWidget::reloadModel);
+    connect(&m_reloadWatcher, &QFutureWatcher<ModelReload>::finished,
+            this, [this]() {
+        const ModelReload reload = m_reloadWatcher.result();
+        if(m_reloadPending) {
+            m_reloadPending = false;
+            m_reloadTimer.start();
+        }
+        if(reload.generation != m_modelGeneration) return;
+        if(reload.model.data.isEmpty()) {
+            emit notify(QString("%1; keeping the previous version")
+                    .arg(reload.model.error));
+            return;
+        }
+        m_modelReload = reload;
+        m_modelReloaded = true;
+        update();
+    });
+    connect(&m_pointCloudWatcher,
+            &QFutureWatcher<QSharedPointer<PointOctree>>::finished,
+            this, [this]() {
+        // A build for a model that has since been released is dropped.
+        if(m_pointCloudGeneration != m_modelGeneration) return;
+        m_pointCloud = m_pointCloudWatcher.result();
+        m_pointCloudChanged = true;
+        update();
+    });
 }
 
 //=============================================================================
@@ -50,6 +218,14 @@ void GlWidget::installShaders(const QString& vertexSource,
     emit notify("Building shader program...");
     m_vertexSource = vertexSource;
     m_fragmentSource = fragmentSource;
+
+    // Keep drawing with the current program while the new one builds.
+    if(m_shaderCompiler.isRunning()) {
+        m_shaderCompiler.compile(
+                ++m_shaderGeneration, vertexSource, fragmentSource);
+        return;
+    }
+
     m_shadersChanged = true;
     update();
 }
@@ -57,8 +233,127 @@ void GlWidget::installShaders(const QString& vertexSource,
 //=============================================================================
 void GlWidget::setModel(const QString& modelPath)
 {
+    // The model on screen is kept up to date by the file watcher, so asking
+    // for it again has nothing to load.
+    const bool current = modelPath == m_modelPath &&
+            !m_pickData.isEmpty() && !m_modelLoading && !m_modelChanged &&
+            !m_modelReloaded && !m_reloadTimer.isActive() &&
+            !m_reloadWatcher.isRunning() && !m_streamBuffer &&
+            !m_streamChanged;
+    if(current) {
+        emit notify(QString("\"%1\" is already loaded").arg(modelPath));
+        return;
+    }
+
     m_modelPath = modelPath;
-    m_modelChanged = true;
+    m_modelChanged = false;
+    m_modelLoading = false;
+    m_modelReloaded = false;
+    m_reloadPending = false;
+    m_reloadTimer.stop();
+    watchModelFile();
+    m_modelChunks.clear();
+    m_modelLoadClock.start();
+    m_firstChunkMs = 0;
+    const quint64 generation = ++m_modelGeneration;
+
+    // Clustered meshes are paged in by the renderer; only the cluster table
+    // is read here.
+    m_clusterFile.reset();
+    m_clusterFileChanged = true;
+    update();
+    if(modelPath.endsWith(CLUSTER_FILE_SUFFIX, Qt::CaseInsensitive)) {
+        auto file_p = QSharedPointer<ClusterFile>::create();
+        if(!file_p->open(modelPath) ||
+                file_p->valuesPerVertex() != NUM_VERTEX_VALUES) {
+            emit notify(QString("Invalid clustered mesh \"%1\"")
+                    .arg(modelPath));
+            return;
+        }
+        m_clusterFile = file_p;
+        emit notify(QString("Opened \"%1\": %2 clusters, %3 vertices")
+                .arg(modelPath).arg(file_p->clusterCount())
+                .arg(file_p->vertexCount()));
+        return;
+    }
+
+    // Chunks are handed to the render thread as they are converted.  Any
+    // that arrive after a newer model was requested are dropped.
+    const FaceChunkHandler chunkHandler = [this, generation](
+            const QVector<GLfloat>& data, int firstFace, int faceCount) {
+        (void)m_loader.addMainThread([=]() {
+            if(generation != m_modelGeneration) return;
+            m_modelChunks.append({ generation, firstFace, faceCount, data });
+        }, {}, MODEL_CHUNK_UPLOAD);
+    };
+
+    // The arrows need the converted faces; the texture needs nothing.
+    auto model_p = QSharedPointer<ModelFile>::create();
+    model_p->path = modelPath;
+    model_p->generation = generation;
+    const int converted = addModelFileTasks(model_p, true, chunkHandler);
+    const int arrows = m_loader.add([model_p]() {
+        if(model_p->data.isEmpty()) return;
+        ScopedTimer timer("loadNormals");
+        model_p->smoothArrows =
+                buildArrowTransforms(model_p->data, NORMAL_OFFSET);
+        model_p->facetedArrows =
+                buildArrowTransforms(model_p->data, FACE_NORMALS);
+    }, { converted });
+    const int texture = m_loader.add([model_p]() {
+        model_p->textureMips = buildMipChain(
+                readTextureImage(model_p->path, &model_p->textureHash));
+    });
+
+    m_modelLoading = true;
+    (void)m_loader.addMainThread([this, model_p]() {
+        if(model_p->generation != m_modelGeneration) return;
+        m_modelLoading = false;
+        m_loadedModel = *model_p;
+        m_modelChanged = true;
+    }, { arrows, texture }, MODEL_UPLOAD);
+}
+
+//=============================================================================
+void GlWidget::pushModelVertices(const QVector<GLfloat>& vertices)
+{
+    m_streamedVertices = vertices;
+    m_streamChanged = true;
+    update();
+}
+
+//=============================================================================
+int GlWidget::addSceneModel(const QString& modelPath,
+        const QMatrix4x4& transform)
+{
+    const int id = m_nextSceneId++;
+    m_sceneRequests.append(
+            { SceneRequest::Type::ADD, id, modelPath, transform });
+    update();
+    return id;
+}
+
+//=============================================================================
+void GlWidget::removeSceneModel(int id)
+{
+    m_sceneRequests.append(
+            { SceneRequest::Type::REMOVE, id, QString(), QMatrix4x4() });
+    update();
+}
+
+//=============================================================================
+void GlWidget::setSceneModelTransform(int id, const QMatrix4x4& transform)
+{
+    m_sceneRequests.append(
+            { SceneRequest::Type::TRANSFORM, id, QString(), transform });
+    update();
+}
+
+//=============================================================================
+void GlWidget::clearScene()
+{
+    m_sceneRequests.append(
+            { SceneRequest::Type::CLEAR, -1, QString(), QMatrix4x4() });
     update();
 }
 
@@ -105,15 +400,247 @@ void GlWidget::enableVisibleNormals(bool enable)
     update();
 }
 
+//=============================================================================
+void GlWidget::enableStatsOverlay(bool enable)
+{
+    m_enableStatsOverlay = enable;
+    update();
+}
+
+//=============================================================================
+void GlWidget::enablePointCloud(bool enable)
+{
+    m_enablePointCloud = enable;
+    update();
+}
+
+//=============================================================================
+void GlWidget::enableOcclusionCulling(bool enable)
+{
+    m_enableOcclusionCulling = enable;
+    update();
+}
+
+//=============================================================================
+void GlWidget::enableDynamicResolution(bool enable)
+{
+    m_enableDynamicResolution = enable;
+    m_resolution.reset();
+    update();
+}
+
+//=============================================================================
+void GlWidget::enableSharpenUpscale(bool enable)
+{
+    m_enableSharpenUpscale = enable;
+    update();
+}
+
+//=============================================================================
+void GlWidget::setPointBudget(int points)
+{
+    m_pointBudget = qMax(points, 1);
+    update();
+}
+
+//=============================================================================
+void GlWidget::setClusterBudget(qint64 bytes)
+{
+    m_clusterCache.setBudget(bytes);
+    update();
+}
+
+//=============================================================================
+void GlWidget::setTextureBudget(qint64 bytes)
+{
+    m_textureBudget = bytes;
+    if(m_textureStreamer_p) m_textureStreamer_p->setBudget(bytes);
+    update();
+}
+
+//=============================================================================
+void GlWidget::setFrameBudget(double ms)
+{
+    m_resolution.setBudget((float)ms);
+    update();
+}
+
+//=============================================================================
+bool GlWidget::exportTrace(const QString& path)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        emit notify(QString("Could not write trace \"%1\"").arg(path));
+        return false;
+    }
+    if(!Profiler::instance().writeChromeTrace(file)) {
+        emit notify(QString("Could not write trace \"%1\"").arg(path));
+        return false;
+    }
+    emit notify(QString("Trace written to \"%1\"").arg(path));
+    return true;
+}
+
+//=============================================================================
+bool GlWidget::exportClusters(const QString& path)
+{
+    if(m_pickData.isEmpty()) {
+        emit notify("There is no loaded model to export");
+        return false;
+    }
+
+    ScopedTimer timer("ClusterFile::write");
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+            !ClusterFile::write(file, m_pickData.constData(),
+            m_pickData.count() / NUM_VERTEX_VALUES, NUM_VERTEX_VALUES)) {
+        emit notify(QString("Could not write clusters \"%1\"").arg(path));
+        return false;
+    }
+    emit notify(QString("Clusters written to \"%1\"").arg(path));
+    return true;
+}
+
+//=============================================================================
+bool GlWidget::startRecording(const QString& directory,
+        FrameCapture::Format format)
+{
+    if(!m_frameCapture.start(directory, format)) {
+        emit notify(QString("Could not record to \"%1\"").arg(directory));
+        return false;
+    }
+    emit notify(QString("Recording frames to \"%1\" (%2 readback)")
+            .arg(directory)
+            .arg(m_frameCapture.usesPixelBuffers() ? "PBO" : "deferred"));
+    update();
+    return true;
+}
+
+//=============================================================================
+void GlWidget::stopRecording()
+{
+    if(!m_frameCapture.isRecording()) return;
+
+    makeCurrent();
+    m_memory.set("capture/readback", 0, m_frameCapture.allocatedBytes());
+    m_frameCapture.finish();
+    doneCurrent();
+
+    emit notify(QString("Recorded %1 frames, %2 stalled")
+            .arg(m_frameCapture.capturedFrames())
+            .arg(m_frameCapture.stalledFrames()));
+}
+
+//=============================================================================
+bool GlWidget::isRecording() const
+{
+    return m_frameCapture.isRecording();
+}
+
+//=============================================================================
+bool GlWidget::captureFrames(const QString& path, int frames)
+{
+    if(GlRecorder::isActive()) {
+        emit notify("A GL capture is already running");
+        return false;
+    }
+    if(!GlRecorder::instance().start(path)) {
+        emit notify(QString("Could not write GL capture \"%1\"").arg(path));
+        return false;
+    }
+    m_captureFramesLeft = qMax(frames, 1);
+
+    makeCurrent();
+    recordResidentBuffers();
+    doneCurrent();
+
+    emit notify(QString("Capturing %1 frames of GL commands to \"%2\"")
+            .arg(m_captureFramesLeft).arg(path));
+    update();
+    return true;
+}
+
+//=============================================================================
+const MemoryLedger& GlWidget::memoryUsage() const
+{
+    return m_memory;
+}
+
 //=============================================================================
 void GlWidget::mousePressEvent(QMouseEvent *event_p)
 {
+    if(event_p->button() == Qt::LeftButton &&
+            (event_p->modifiers() & Qt::ControlModifier)) {
+        const PickResult result = pick(event_p->pos());
+        if(result.hit) {
+            emit notify(QString("Picked face %1, vertex %2 at "
+                    "(%3, %4, %5), normal (%6, %7, %8), uv (%9, %10)")
+                    .arg(result.face).arg(result.vertex)
+                    .arg(result.position.x()).arg(result.position.y())
+                    .arg(result.position.z())
+                    .arg(result.normal.x()).arg(result.normal.y())
+                    .arg(result.normal.z())
+                    .arg(result.textureCoord.x())
+                    .arg(result.textureCoord.y()));
+        }
+        return;
+    }
+
     if(event_p->button() == Qt::LeftButton) {
         m_lastMouse = event_p->pos();
         m_mouseActive = true;
     }
 }
 
+//=============================================================================
+GlWidget::PickResult GlWidget::pick(const QPoint& point)
+{
+    PickResult result;
+    if(m_streamBuffer) {
+        emit notify("Picking is not available for streamed geometry");
+        return result;
+    }
+    if(!m_pickBvh.isFinished() || m_pickBvh.resultCount() == 0) {
+        emit notify("The pick index is not ready yet");
+        return result;
+    }
+    const QSharedPointer<Bvh> bvh_p = m_pickBvh.result();
+    if(!bvh_p || width() <= 0 || height() <= 0) return result;
+
+    ScopedTimer timer("pick", "pick");
+
+    // ==== Unproject into model space ====
+    const float x = 2.0f * point.x() / width() - 1.0f;
+    const float y = 1.0f - 2.0f * point.y() / height();
+    const QMatrix4x4 inverse =
+            (m_projectionMatrix * m_viewMatrix * m_modelMatrix).inverted();
+    const QVector3D nearPoint = inverse.map(QVector3D(x, y, -1.0f));
+    const QVector3D farPoint = inverse.map(QVector3D(x, y, 1.0f));
+    const QVector3D direction = farPoint - nearPoint;
+
+    const float origin[3] = { nearPoint.x(), nearPoint.y(), nearPoint.z() };
+    const float ray[3] = { direction.x(), direction.y(), direction.z() };
+    const Bvh::Hit hit = bvh_p->intersect(origin, ray);
+    if(!hit.isValid()) return result;
+
+    // ==== Report the nearest corner's attributes ====
+    const float weights[3] = { 1.0f - hit.u - hit.v, hit.u, hit.v };
+    int corner = 0;
+    if(weights[1] > weights[corner]) corner = 1;
+    if(weights[2] > weights[corner]) corner = 2;
+    const int vertex = hit.triangle * 3 + corner;
+    const GLfloat *v = m_pickData.constData() + (vertex * NUM_VERTEX_VALUES);
+
+    result.hit = true;
+    result.face = hit.triangle;
+    result.vertex = m_pickVertexIndices.value(vertex, -1);
+    result.position = nearPoint + direction * hit.distance;
+    result.normal = QVector3D(v[3], v[4], v[5]);
+    const int s = TEXTURE_COORD_OFFSET / sizeof(GLfloat);
+    result.textureCoord = QVector2D(v[s], v[s + 1]);
+    return result;
+}
+
 //=============================================================================
 void GlWidget::mouseMoveEvent(QMouseEvent *event_p)
 {
@@ -147,10 +674,27 @@ void GlWidget::initializeGL()
     connect(context(), &QOpenGLContext::aboutToBeDestroyed,
         this, &GlWidget::cleanup);
 
+    if(m_gpuTimer.initialize(context())) {
+        emit notify("GPU timer queries enabled");
+    }
+
+    if(!m_shaderCompiler.start(context())) {
+        emit notify("Background shader compilation unavailable");
+    }
+
+    m_textureStreamer_p = GpuResources::instance().acquireTextureStreamer();
+    m_textureView = m_textureStreamer_p->addView();
+    if(m_textureBudget >= 0) m_textureStreamer_p->setBudget(m_textureBudget);
+
     if(m_shadersChanged) buildShaders();
     buildOrnamentShaders();
+    initializeLayers();
 
     loadOrnaments();
+    m_scene.initialize(m_textureStreamer_p);
+    m_clusterCache.initialize();
+    m_streamingBuffer.initialize(context());
+    m_frameCapture.initialize(context());
 
     glClearColor(1.0, 1.0, 1.0, 1.0);
     glEnable(GL_BLEND);
@@ -162,13 +706,29 @@ void GlWidget::resizeGL(int w, int h)
 {
     if(h > 0) m_aspectRatio = w / (double)h;
     updateProjectionMatrix();
+    m_occlusionCuller.resize(OcclusionCuller::DEFAULT_WIDTH,
+            qRound(OcclusionCuller::DEFAULT_WIDTH / m_aspectRatio));
 }
 
 //=============================================================================
 void GlWidget::paintGL()
 {
+    ScopedTimer frameTimer("frame", "frame");
+    m_gpuTimer.collect();
+    updateRenderScale();
+    if(m_captureFramesLeft > 0) {
+        GlRecorder::instance().beginFrame(defaultFramebufferObject());
+    }
+
     if(m_shadersChanged) buildShaders();
+    if(m_loader.hasMainThreadTasks()) runLoaderTasks();
+    if(m_clusterFileChanged) loadClusterFile();
+    if(!m_modelChunks.isEmpty()) uploadModelChunks();
     if(m_modelChanged) loadModel();
+    if(m_modelReloaded) applyModelReload();
+    if(!m_sceneRequests.isEmpty()) loadSceneModels();
+    if(m_streamChanged) uploadStreamedVertices();
+    if(m_pointCloudChanged) uploadPointCloud();
 
     glDepthMask(GL_TRUE);
     if(m_enableDepthTesting) {
@@ -187,7 +747,11 @@ void GlWidget::paintGL()
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    bool sceneScaled = false;
     if(m_program_p) {
+        ScopedTimer passTimer("model pass", "frame");
+        m_gpuTimer.begin("gpu model pass");
+        sceneScaled = beginSceneTarget();
         m_program_p->bind();
 
         m_program_p->setUniformValue(m_vars.uModel, m_modelMatrix);
@@ -196,8 +760,28 @@ void GlWidget::paintGL()
         m_program_p->setUniformValue(m_vars.uNormalMatrix,
                 (m_viewMatrix * m_modelMatrix).inverted().transposed());
 
-        if(m_modelBuffer) {
-            glBindBuffer(GL_ARRAY_BUFFER, m_modelBuffer);
+        const bool drawPoints = (m_enablePointCloud || m_pointsOnly) &&
+                m_pointBuffer && !m_streamBuffer;
+        const GLuint modelBuffer = drawPoints ? m_pointBuffer :
+                (m_streamBuffer ? m_streamBuffer : m_modelBuffer);
+        const int modelVertexCount =
+                m_streamBuffer ? m_streamVertexCount : m_modelVertexCount;
+
+        // Shaders with uFaceted derive the face normals from screen-space
+        // derivatives.  Points have none to derive them from, and other
+        // shaders are given stored ones for the loaded model.
+        if(m_vars.uFaceted >= 0) {
+            glUniform1i(m_vars.uFaceted,
+                    m_enableFacetedRender && !drawPoints ? 1 : 0);
+        }
+        const GLuint faceNormalBuffer = m_enableFacetedRender &&
+                m_vars.uFaceted < 0 && modelBuffer == m_modelBuffer ?
+                storedFaceNormals() : 0;
+
+        if(m_clusterCache.hasFile()) {
+            drawClusters();
+        } else if(modelBuffer) {
+            glBindBuffer(GL_ARRAY_BUFFER, modelBuffer);
 
             if(m_vars.aPosition >= 0) {
                 const intptr_t offset = POSITION_OFFSET;
@@ -207,10 +791,17 @@ void GlWidget::paintGL()
             }
 
             if(m_vars.aNormal >= 0) {
-                const intptr_t offset = m_enableFacetedRender ?
-                        FACE_NORMAL_OFFSET : NORMAL_OFFSET;
-                glVertexAttribPointer(m_vars.aNormal,
-                        3, GL_FLOAT, GL_FALSE, STRIDE, (void *)offset);
+                if(faceNormalBuffer) {
+                    glBindBuffer(GL_ARRAY_BUFFER, faceNormalBuffer);
+                    glVertexAttribPointer(m_vars.aNormal,
+                            NUM_FACE_NORMAL_VALUES, GL_FLOAT, GL_FALSE, 0,
+                            nullptr);
+                    glBindBuffer(GL_ARRAY_BUFFER, modelBuffer);
+                } else {
+                    const intptr_t offset = NORMAL_OFFSET;
+                    glVertexAttribPointer(m_vars.aNormal,
+                            3, GL_FLOAT, GL_FALSE, STRIDE, (void *)offset);
+                }
                 glEnableVertexAttribArray(m_vars.aNormal);
             }
 
@@ -221,13 +812,22 @@ void GlWidget::paintGL()
                 glEnableVertexAttribArray(m_vars.aTextureCoord);
             }
 
-            if(m_texture_p && m_vars.uTexture >= 0) {
+            const GLuint texture =
+                    m_textureStreamer_p->texture(m_modelTexture);
+            if(texture && m_vars.uTexture >= 0) {
                 constexpr int textureUnit = 0;
-                m_texture_p->bind(textureUnit);
+                glActiveTexture(GL_TEXTURE0 + textureUnit);
+                glBindTexture(GL_TEXTURE_2D, texture);
                 glUniform1i(m_vars.uTexture, textureUnit);
+                requestTexture(m_modelTexture, m_viewMatrix * m_modelMatrix,
+                        m_modelMin, m_modelMax, m_renderScale);
             }
 
-            glDrawArrays(GL_TRIANGLES, 0, m_modelVertexCount);
+            if(drawPoints) {
+                drawPointCloud();
+            } else {
+                glDrawArrays(GL_TRIANGLES, 0, modelVertexCount);
+            }
 
             if(m_vars.aTextureCoord >= 0) {
                 glDisableVertexAttribArray(m_vars.aTextureCoord);
@@ -244,85 +844,119 @@ void GlWidget::paintGL()
             glBindBuffer(GL_ARRAY_BUFFER, 0);
         }
 
+        if(m_scene.instanceCount() > 0) drawScene();
+
         m_program_p->release();
+        m_gpuTimer.end();
     }
 
+    if(sceneScaled) upscaleSceneTarget();
+
     glDepthMask(GL_FALSE);
     glDisable(GL_CULL_FACE);
 
-    if(m_ornamentProgram_p) {
-        m_ornamentProgram_p->bind();
-
-        m_ornamentProgram_p->setUniformValue(
-                m_ornamentVars.uModel, QMatrix4x4());
-        m_ornamentProgram_p->setUniformValue(
-                m_ornamentVars.uView, m_viewMatrix);
-        m_ornamentProgram_p->setUniformValue(
-                m_ornamentVars.uProjection, m_projectionMatrix);
-
-        glBindBuffer(GL_ARRAY_BUFFER, m_gridBuffer);
-
-        if(m_ornamentVars.aPosition >= 0) {
-            const intptr_t offset = POSITION_OFFSET;
-            glVertexAttribPointer(m_ornamentVars.aPosition,
-                    3, GL_FLOAT, GL_FALSE, STRIDE, (void *)offset);
-            glEnableVertexAttribArray(m_ornamentVars.aPosition);
-        }
-
-        if(m_ornamentVars.aTextureCoord >= 0) {
-            const intptr_t offset = TEXTURE_COORD_OFFSET;
-            glVertexAttribPointer(m_ornamentVars.aTextureCoord,
-                    2, GL_FLOAT, GL_FALSE, STRIDE, (void *)offset);
-            glEnableVertexAttribArray(m_ornamentVars.aTextureCoord);
-        }
-
-        if(m_gridTexture_p && m_ornamentVars.uTexture >= 0) {
-            constexpr int textureUnit = 0;
-            m_gridTexture_p->bind(textureUnit);
-            glUniform1i(m_ornamentVars.uTexture, textureUnit);
-        }
-
-        glDrawArrays(GL_TRIANGLES, 0, m_gridVertexCount);
-
-        if(m_ornamentVars.aTextureCoord >= 0) {
-            glDisableVertexAttribArray(m_ornamentVars.aTextureCoord);
+    if(m_ornamentProgram_p && m_ornamentBuffer) {
+        // The grid is drawn every frame even when it comes from a layer.
+        requestTexture(m_ornamentTexture, m_viewMatrix,
+                BakedOrnaments::GRID_MIN, BakedOrnaments::GRID_MAX);
+        if(m_layersAvailable) {
+            drawOrnamentLayers();
+        } else {
+            drawOrnaments(true, m_enableVisibleNormals);
         }
+    }
 
-        if(m_ornamentVars.aPosition >= 0) {
-            glDisableVertexAttribArray(m_ornamentVars.aPosition);
-        }
+    // Capture before the overlay so recordings show only the scene.
+    if(m_frameCapture.isRecording()) {
+        ScopedTimer captureTimer("capture", "frame");
+        const qreal ratio = devicePixelRatioF();
+        m_frameCapture.capture(defaultFramebufferObject(),
+                qRound(width() * ratio), qRound(height() * ratio));
+    }
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if(m_captureFramesLeft > 0 && --m_captureFramesLeft == 0) {
+        GlRecorder& recorder = GlRecorder::instance();
+        const bool ok = recorder.stop();
+        emit notify(QString("GL capture %1: %2 frames, %3 KB")
+                .arg(ok ? "written" : "failed")
+                .arg(recorder.framesRecorded())
+                .arg(recorder.bytesRecorded() / 1024));
+    } else if(m_captureFramesLeft > 0) {
+        update();
+    }
 
-        if(m_enableVisibleNormals) drawNormals();
+    updateTextures();
+    measureFrame();
 
-        m_ornamentProgram_p->release();
-    }
+    if(m_enableStatsOverlay) drawStats();
 }
 
 //=============================================================================
 void GlWidget::cleanup()
 {
+    m_shaderCompiler.stop();
+    ++m_shaderGeneration;
+    ++m_modelGeneration;
+    m_loader.cancel();
+    m_modelLoading = false;
+    m_modelChunks.clear();
+    m_sceneLoads.clear();
+    m_reloadTimer.stop();
+    m_reloadWatcher.waitForFinished();
+    m_modelReloaded = false;
+    if(m_captureFramesLeft > 0) {
+        m_captureFramesLeft = 0;
+        (void)GlRecorder::instance().stop();
+    }
+
     makeCurrent();
 
-    delete m_program_p;
+    m_gpuTimer.release();
+
+    // Shared resources stay alive while another view still uses them.
+    GpuResources& resources = GpuResources::instance();
+    resources.releaseProgram(m_program_p);
     m_program_p = nullptr;
-    delete m_ornamentProgram_p;
+    resources.releaseProgram(m_ornamentProgram_p);
     m_ornamentProgram_p = nullptr;
+    resources.releaseProgram(m_layerProgram_p);
+    m_layerProgram_p = nullptr;
+    resources.releaseProgram(m_upscaleProgram_p);
+    m_upscaleProgram_p = nullptr;
 
-    glDeleteBuffers(1, &m_modelBuffer);
+    resources.releaseBuffer(m_modelBuffer);
     m_modelBuffer = 0;
-    glDeleteBuffers(1, &m_gridBuffer);
-    m_gridBuffer = 0;
-    glDeleteBuffers(1, &m_arrowBuffer);
-    m_arrowBuffer = 0;
-
-    delete m_texture_p;
-    m_texture_p = nullptr;
-    delete m_gridTexture_p;
-    m_gridTexture_p = nullptr;
-    delete m_arrowTexture_p;
-    m_arrowTexture_p = nullptr;
+    m_modelVertexCount = 0;
+    m_modelCapacity = 0;
+    releaseFaceNormals();
+    glDeleteBuffers(1, &m_pointBuffer);
+    m_pointBuffer = 0;
+    m_clusterCache.release();
+    m_streamingBuffer.release();
+    m_frameCapture.finish();
+    m_frameCapture.release();
+    m_streamBuffer = 0;
+    resources.releaseBuffer(m_ornamentBuffer);
+    m_ornamentBuffer = 0;
+    glDeleteBuffers(1, &m_layerBuffer);
+    m_layerBuffer = 0;
+    m_gridLayer.release();
+    m_arrowLayer.release();
+    m_sceneTarget.release();
+
+    m_scene.release();
+    if(m_textureStreamer_p) {
+        m_textureStreamer_p->remove(m_modelTexture);
+        m_textureStreamer_p->remove(m_ornamentTexture);
+        m_textureStreamer_p->removeView(m_textureView);
+        resources.releaseTextureStreamer(m_textureStreamer_p);
+        m_textureStreamer_p = nullptr;
+    }
+    m_modelTexture = -1;
+    m_ornamentTexture = -1;
+    m_ornamentTextureLevel = -1;
+
+    m_memory.clear();
 
     doneCurrent();
 }
@@ -362,52 +996,111 @@ void GlWidget::updateProjectionMatrix()
 //=============================================================================
 void GlWidget::buildShaders()
 {
+    ScopedTimer timer("buildShaders");
     m_shadersChanged = false;
 
-    auto program_p = new QOpenGLShaderProgram(this);
-    if(!program_p->addShaderFromSourceCode(
-            QOpenGLShader::Vertex, m_vertexSource)) {
-        emit notify(program_p->log());
-        delete program_p;
-        return;
-    }
-    if(!program_p->addShaderFromSourceCode(
-            QOpenGLShader::Fragment, m_fragmentSource)) {
-        emit notify(program_p->log());
-        delete program_p;
+    QString log;
+    ShaderCache::Status status;
+    auto program_p = buildSharedProgram(
+            m_vertexSource, m_fragmentSource, &log, &status);
+    if(!program_p) {
+        emit notify(log);
         return;
     }
-    if(!program_p->link()) {
-        emit notify(program_p->log());
+    setProgram(program_p, status);
+}
+
+//=============================================================================
+void GlWidget::shadersCompiled(quint64 id, QOpenGLShaderProgram *program_p,
+        const QString& log, ShaderCache::Status status)
+{
+    makeCurrent();
+
+    if(id != m_shaderGeneration) {
         delete program_p;
-        return;
+    } else if(!program_p) {
+        emit notify(log);
+    } else {
+        setProgram(GpuResources::instance().shareProgram(
+                programKey(m_vertexSource, m_fragmentSource), program_p,
+                ShaderCache::programBytes(program_p)), status);
     }
-    delete m_program_p;
+
+    doneCurrent();
+    update();
+}
+
+//=============================================================================
+void GlWidget::setProgram(QOpenGLShaderProgram *program_p,
+        ShaderCache::Status status)
+{
+    GpuResources::instance().releaseProgram(m_program_p);
     m_program_p = program_p;
-    emit notify("Shader program built successfully!");
+    emit notify(QString("Shader program built successfully! (%1)")
+            .arg(ShaderCache::describe(status)));
+    m_memory.set("shaders/model", 0, ShaderCache::programBytes(program_p));
 
     m_vars.uModel = program_p->uniformLocation("uModel");
     m_vars.uView = program_p->uniformLocation("uView");
     m_vars.uProjection = program_p->uniformLocation("uProjection");
     m_vars.uNormalMatrix = program_p->uniformLocation("uNormalMatrix");
     m_vars.uTexture = program_p->uniformLocation("uTexture");
+    m_vars.uPointSize = program_p->uniformLocation("uPointSize");
+    m_vars.uFaceted = program_p->uniformLocation("uFaceted");
     m_vars.aPosition = program_p->attributeLocation("aPosition");
     m_vars.aNormal = program_p->attributeLocation("aNormal");
     m_vars.aTextureCoord = program_p->attributeLocation("aTextureCoord");
 }
 
+//=============================================================================
+// Takes the program another view in the share group built from the same
+// sources, or builds it and shares it.  Either way it belongs to
+// GpuResources and is let go of with releaseProgram().
+QOpenGLShaderProgram *GlWidget::buildSharedProgram(
+        const QString& vertexSource, const QString& fragmentSource,
+        QString *log_p, ShaderCache::Status *status_p)
+{
+    GpuResources& resources = GpuResources::instance();
+    const QByteArray key = programKey(vertexSource, fragmentSource);
+    QOpenGLShaderProgram *program_p = resources.acquireProgram(key);
+    if(program_p) {
+        *status_p = ShaderCache::Status::SHARED;
+        return program_p;
+    }
+
+    program_p = m_shaderCache.build(vertexSource, fragmentSource, nullptr,
+            log_p, status_p);
+    if(!program_p) return nullptr;
+    return resources.shareProgram(key, program_p,
+            ShaderCache::programBytes(program_p));
+}
+
 //=============================================================================
 void GlWidget::buildOrnamentShaders()
 {
-    auto program_p = new QOpenGLShaderProgram(this);
-    (void)program_p->addShaderFromSourceFile(
-            QOpenGLShader::Vertex, ":/ornaments.vert");
-    (void)program_p->addShaderFromSourceFile(
-            QOpenGLShader::Fragment, ":/ornaments.frag");
-    (void)program_p->link();
+    ScopedTimer timer("buildOrnamentShaders");
+
+    auto readSource = [](const QString& path) {
+        QFile file(path);
+        if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) return QString();
+        return QString::fromUtf8(file.readAll());
+    };
+
+    QString log;
+    ShaderCache::Status status;
+    auto program_p = buildSharedProgram(readSource(":/ornaments.vert"),
+            readSource(":/ornaments.frag"), &log, &status);
+    if(!program_p) {
+        emit notify(log);
+        return;
+    }
+    emit notify(QString("Ornament shaders built (%1)")
+            .arg(ShaderCache::describe(status)));
 
-    delete m_ornamentProgram_p;
+    GpuResources::instance().releaseProgram(m_ornamentProgram_p);
     m_ornamentProgram_p = program_p;
+    m_memory.set("shaders/ornaments", 0,
+            ShaderCache::programBytes(program_p));
 
     m_ornamentVars.uModel = program_p->uniformLocation("uModel");
     m_ornamentVars.uView = program_p->uniformLocation("uView");
@@ -422,117 +1115,1033 @@ void GlWidget::buildOrnamentShaders()
 void GlWidget::loadModel()
 {
     m_modelChanged = false;
-    if(m_modelPath.isNull()) return;
+    const ModelFile model = m_loadedModel;
+    m_loadedModel = ModelFile();
 
-    // ==== Load model data ====
-    QFile file(m_modelPath);
-    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        emit notify(QString("Could not open file \"%1\"").arg(m_modelPath));
+    ScopedTimer loadTimer("loadModel");
+
+    // ==== Finish the model buffer ====
+    const bool shown = (m_chunkGeneration == model.generation);
+    const QVector<GLfloat>& data = model.data;
+    const int vertexCount = data.count() / NUM_VERTEX_VALUES;
+    if(data.isEmpty() && !model.points.isEmpty()) {
+        loadPointModel(model);
         return;
     }
-    QTextStream stream(&file);
-    PlyModel ply = PlyModel::parse(stream);
-    if(!ply.isValid()) {
-        emit notify(QString("Invalid PLY file \"%1\"").arg(m_modelPath));
+    if(data.isEmpty()) {
+        // Do not leave part of a model that failed to convert on screen.
+        if(shown) releaseModel();
+        if(!model.error.isEmpty()) emit notify(model.error);
         return;
     }
-    QVector<GLfloat> data = convertPly(ply);
-    m_modelVertexCount = data.count() / NUM_VERTEX_VALUES;
 
-    glDeleteBuffers(1, &m_modelBuffer);
-    glGenBuffers(1, &m_modelBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, m_modelBuffer);
-    glBufferData(GL_ARRAY_BUFFER,
-            (data.count() * sizeof(GLfloat)), data.data(), GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if(!shown || m_modelVertexCount != vertexCount ||
+            m_modelCapacity != vertexCount) {
+        // Some chunks never made it (or the buffer is sized for a different
+        // face count), so replace the buffer with one that fits exactly.
+        if(!shown) releaseModel();
+        ScopedTimer timer("model upload");
+        GpuResources::instance().releaseBuffer(m_modelBuffer);
+        glGenBuffers(1, &m_modelBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, m_modelBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * STRIDE,
+                data.constData(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_modelVertexCount = vertexCount;
+        m_modelCapacity = vertexCount;
+    }
+    m_chunkGeneration = 0;
+    shareModelBuffer(model.contentHash);
 
-    loadNormals(data.data(), m_modelVertexCount);
+    buildDerivedData(model);
 
     // ==== Load texture ====
-    QString texturePath = m_modelPath;
-    (void)texturePath.replace(QRegularExpression("\\.[Pp][Ll][Yy]$"),
-            "-texture.png");
-    delete m_texture_p;
-    m_texture_p = new QOpenGLTexture(QImage(texturePath).mirrored());
+    m_textureStreamer_p->remove(m_modelTexture);
+    m_modelTexture = addTexture(model.textureMips, model.uvDensity,
+            model.textureHash);
+    m_textureHash = model.textureHash;
 
     // TODO: ==== Load normal map ====
+
+    m_memory.set("model/vbo", 0, (qint64)m_modelCapacity * STRIDE);
+
+    const Profiler& profiler = Profiler::instance();
+    emit notify(QString("Loaded \"%1\": read %2 ms, parse %3 ms, "
+            "convert %4 ms, upload %5 ms, normals %6 ms, "
+            "texture decode %7 ms, texture mips %8 ms, "
+            "texture upload %9 ms, first faces shown after %10 ms")
+            .arg(m_modelPath)
+            .arg(profiler.lastMs("read file"), 0, 'f', 1)
+            .arg(profiler.lastMs("PlyModel::parse"), 0, 'f', 1)
+            .arg(profiler.lastMs("convertPly"), 0, 'f', 1)
+            .arg(profiler.lastMs("model upload"), 0, 'f', 1)
+            .arg(profiler.lastMs("loadNormals"), 0, 'f', 1)
+            .arg(profiler.lastMs("texture decode"), 0, 'f', 1)
+            .arg(profiler.lastMs("texture mips"), 0, 'f', 1)
+            .arg(profiler.lastMs("texture upload"), 0, 'f', 1)
+            .arg(m_firstChunkMs));
+    emit notify(QString("Memory for \"%1\": %2").arg(m_modelPath)
+            .arg(m_memory.describe("model")));
+    emit notify(QString("Memory in use: CPU %1, GPU %2")
+            .arg(MemoryLedger::formatBytes(m_memory.cpuBytes()))
+            .arg(MemoryLedger::formatBytes(m_memory.gpuBytes())));
 }
 
 //=============================================================================
-void GlWidget::loadOrnaments()
+// A file with vertices but no faces, such as a LiDAR scan, is shown as its
+// point cloud whether or not the point cloud is switched on.
+void GlWidget::loadPointModel(const ModelFile& model)
 {
-    // ==== Grid ====
-    {
-        QVector<GLfloat> data = makeGrid(10, 10);
-        m_gridVertexCount = data.count() / NUM_VERTEX_VALUES;
-
-        glDeleteBuffers(1, &m_gridBuffer);
-        glGenBuffers(1, &m_gridBuffer);
-        glBindBuffer(GL_ARRAY_BUFFER, m_gridBuffer);
-        glBufferData(GL_ARRAY_BUFFER,
-                (data.count() * sizeof(GLfloat)), data.data(), GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-        delete m_gridTexture_p;
-        m_gridTexture_p = new QOpenGLTexture(
-                QImage(":/grid-texture.png").mirrored());
-        m_gridTexture_p->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-        m_gridTexture_p->setMagnificationFilter(QOpenGLTexture::Linear);
-    }
-
-    // ==== Arrow ====
-    {
-        QFile file(":/arrow.ply");
-        if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) return;
-        QTextStream stream(&file);
-        PlyModel ply = PlyModel::parse(stream);
-        if(!ply.isValid()) return;
-        QVector<GLfloat> data = convertPly(ply);
-        m_arrowVertexCount = data.count() / NUM_VERTEX_VALUES;
-
-        glDeleteBuffers(1, &m_arrowBuffer);
-        glGenBuffers(1, &m_arrowBuffer);
-        glBindBuffer(GL_ARRAY_BUFFER, m_arrowBuffer);
-        glBufferData(GL_ARRAY_BUFFER,
-                (data.count() * sizeof(GLfloat)), data.data(), GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-        delete m_arrowTexture_p;
-        QImage image(":/arrow-texture.png");
-        m_arrowTexture_p = new QOpenGLTexture(image.mirrored());
-
-    }
+    releaseModel();
+    m_chunkGeneration = 0;
+    m_pointsOnly = true;
+    computeBounds(model.points, m_modelMin, m_modelMax);
+    buildPointCloud(model.points);
+
+    m_modelTexture = addTexture(model.textureMips, model.uvDensity,
+            model.textureHash);
+    m_textureHash = model.textureHash;
+
+    m_memory.set("model/file", model.fileBytes, 0, true);
+    m_memory.set("model/ply", model.plyBytes, 0, true);
+    emit notify(QString("Loaded \"%1\" as %2 points; it has no faces")
+            .arg(m_modelPath)
+            .arg(model.points.count() / NUM_VERTEX_VALUES));
 }
 
 //=============================================================================
-void GlWidget::loadNormals(GLfloat *data_p, int vertexCount)
+// Everything that is built from the whole mesh once its vertices are in the
+// model buffer.
+void GlWidget::buildDerivedData(const ModelFile& model)
 {
-    for(int i = 0; i < vertexCount; ++i) {
-        auto v = data_p + (i * NUM_VERTEX_VALUES);
-        QVector3D position(v[0], v[1], v[2]);
-
-        const QVector3D up(0.0f, 0.0f, 1.0f);
-
-        QVector3D smoothNormal(v[3], v[4], v[5]);
-        QMatrix4x4 smoothTransform;
-        smoothTransform.translate(position);
-        smoothTransform.rotate(QQuaternion::rotationTo(up, smoothNormal));
-        m_smoothArrows.append(smoothTransform);
-
-        QVector3D facetedNormal(v[6], v[7], v[8]);
-        QMatrix4x4 facetedTransform;
-        facetedTransform.translate(position);
-        facetedTransform.rotate(QQuaternion::rotationTo(up, facetedNormal));
-        m_facetedArrows.append(facetedTransform);
-    }
+    const QVector<GLfloat>& data = model.data;
+
+    // ==== Build the pick index in the background ====
+    const QVector<int>& vertexIndices = model.vertexIndices;
+    releaseFaceNormals();
+    m_pickData = data;
+    m_pickVertexIndices = vertexIndices;
+    computeBounds(data, m_modelMin, m_modelMax);
+    m_pickBvh = QtConcurrent::run([data]() {
+        ScopedTimer timer("Bvh::build");
+        auto bvh_p = QSharedPointer<Bvh>::create();
+        bvh_p->build(data.constData(),
+                data.count() / NUM_VERTEX_VALUES, NUM_VERTEX_VALUES);
+        return bvh_p;
+    });
+
+    buildPointCloud(model.points);
+    loadNormals(model);
+
+    // m_pickData shares its storage with the converted vertex data.
+    m_memory.set("model/file", model.fileBytes, 0, true);
+    m_memory.set("model/ply", model.plyBytes, 0, true);
+    m_memory.set("model/vertices", data.count() * sizeof(GLfloat), 0);
+    m_memory.set("model/vertex indices",
+            vertexIndices.count() * sizeof(int), 0);
 }
 
 //=============================================================================
-void GlWidget::drawNormals()
+// The octree is built in the background from every PLY vertex, including
+// those no face uses.
+void GlWidget::buildPointCloud(const QVector<GLfloat>& points)
 {
-    glBindBuffer(GL_ARRAY_BUFFER, m_arrowBuffer);
+    m_pointCloudGeneration = m_modelGeneration;
+    m_pointCloudWatcher.setFuture(QtConcurrent::run([points]() {
+        ScopedTimer timer("PointOctree::build");
+        auto octree_p = QSharedPointer<PointOctree>::create();
+        octree_p->build(points.constData(),
+                points.count() / NUM_VERTEX_VALUES, NUM_VERTEX_VALUES);
+        return octree_p;
+    }));
+}
 
-    if(m_ornamentVars.aPosition >= 0) {
+//=============================================================================
+void GlWidget::uploadModelChunks()
+{
+    ScopedTimer timer("model upload");
+    const QList<ModelChunk> chunks = m_modelChunks;
+    m_modelChunks.clear();
+
+    for(const auto& chunk : chunks) {
+        if(chunk.firstFace == 0) {
+            // The first chunk of a model: the face count is known from the
+            // header, so the buffer is sized once for the whole model.
+            releaseModel();
+            m_chunkGeneration = chunk.generation;
+            m_modelCapacity = chunk.faceCount * 3;
+            m_firstChunkMs = m_modelLoadClock.elapsed();
+            glGenBuffers(1, &m_modelBuffer);
+            glBindBuffer(GL_ARRAY_BUFFER, m_modelBuffer);
+            glBufferData(GL_ARRAY_BUFFER, m_modelCapacity * STRIDE,
+                    nullptr, GL_STATIC_DRAW);
+        }
+        if(chunk.generation != m_chunkGeneration) continue;
+
+        // Only a contiguous prefix is drawn; a gap is fixed up by loadModel.
+        const int first = chunk.firstFace * 3;
+        const int count = chunk.data.count() / NUM_VERTEX_VALUES;
+        if(first != m_modelVertexCount || first + count > m_modelCapacity) {
+            continue;
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_modelBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, first * STRIDE, count * STRIDE,
+                chunk.data.constData());
+        m_modelVertexCount = first + count;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_memory.set("model/vbo", 0, (qint64)m_modelCapacity * STRIDE);
+}
+
+//=============================================================================
+// Hands the finished model buffer to GpuResources.  If another view in the
+// share group loaded the same file, its buffer is drawn instead and this
+// one is freed.
+void GlWidget::shareModelBuffer(const QByteArray& contentHash)
+{
+    if(!m_modelBuffer || contentHash.isEmpty() ||
+            m_modelCapacity != m_modelVertexCount) {
+        return;
+    }
+    m_modelBuffer = GpuResources::instance().shareBuffer(
+            GpuResources::key("model", contentHash), m_modelBuffer,
+            (qint64)m_modelCapacity * STRIDE);
+}
+
+//=============================================================================
+void GlWidget::releaseModel()
+{
+    GpuResources::instance().releaseBuffer(m_modelBuffer);
+    m_modelBuffer = 0;
+    m_modelVertexCount = 0;
+    m_modelCapacity = 0;
+    m_chunkGeneration = 0;
+
+    m_textureStreamer_p->remove(m_modelTexture);
+    m_modelTexture = -1;
+    m_textureHash.clear();
+
+    m_pickData.clear();
+    m_pickVertexIndices.clear();
+    m_pickBvh = QFuture<QSharedPointer<Bvh>>();
+    releaseFaceNormals();
+
+    m_pointCloud.reset();
+    m_pointCloudChanged = false;
+    m_pointCloudGeneration = 0;
+    m_pointsOnly = false;
+    glDeleteBuffers(1, &m_pointBuffer);
+    m_pointBuffer = 0;
+
+    m_smoothArrows.clear();
+    m_facetedArrows.clear();
+    ++m_arrowGeneration;
+
+    // A loaded model replaces any streamed geometry.
+    m_streamBuffer = 0;
+    m_streamChanged = false;
+    m_streamedVertices.clear();
+    m_memory.remove("stream/vertices");
+
+    m_memory.removeGroup("model");
+}
+
+//=============================================================================
+// Watches the model and its texture.  Resources never change and clustered
+// meshes are written by the viewer itself, so neither is watched.
+void GlWidget::watchModelFile()
+{
+    QStringList paths;
+    if(!m_modelPath.startsWith(':') &&
+            !m_modelPath.endsWith(CLUSTER_FILE_SUFFIX, Qt::CaseInsensitive)) {
+        for(const auto& path : { m_modelPath, texturePathFor(m_modelPath) }) {
+            if(QFileInfo::exists(path)) paths.append(path);
+        }
+    }
+
+    const QStringList watched = m_modelFileWatcher.files();
+    for(const auto& path : watched) {
+        if(!paths.contains(path)) (void)m_modelFileWatcher.removePath(path);
+    }
+    for(const auto& path : paths) {
+        if(!watched.contains(path)) (void)m_modelFileWatcher.addPath(path);
+    }
+}
+
+//=============================================================================
+void GlWidget::reloadModel()
+{
+    watchModelFile();
+
+    // Nothing is on screen to diff against, so load it from scratch.
+    if(m_modelLoading || m_modelChanged ||
+            m_pickData.isEmpty()) {
+        setModel(m_modelPath);
+        return;
+    }
+    if(m_reloadWatcher.isRunning()) {
+        m_reloadPending = true;
+        return;
+    }
+
+    const QString path = m_modelPath;
+    const quint64 generation = m_modelGeneration;
+    const QVector<GLfloat> previous = m_pickData;
+    const QByteArray textureHash = m_textureHash;
+    m_modelLoadClock.start();
+    m_reloadWatcher.setFuture(QtConcurrent::run(
+            [path, generation, previous, textureHash]() {
+        ModelReload reload;
+        reload.generation = generation;
+        reload.model = readModelFile(path, true);
+        const QVector<GLfloat>& data = reload.model.data;
+        if(data.isEmpty()) return reload;
+
+        {
+            ScopedTimer timer("model diff");
+            reload.ranges = BufferDiff::changedRanges(previous.constData(),
+                    previous.count() / NUM_VERTEX_VALUES, data.constData(),
+                    data.count() / NUM_VERTEX_VALUES, NUM_VERTEX_VALUES);
+        }
+        reload.textureMips = buildMipChain(
+                readTextureImage(path, &reload.textureHash, textureHash));
+        reload.textureChanged = (reload.textureHash != textureHash);
+        return reload;
+    }));
+}
+
+//=============================================================================
+void GlWidget::applyModelReload()
+{
+    m_modelReloaded = false;
+    const ModelReload reload = m_modelReload;
+    m_modelReload = ModelReload();
+    if(reload.generation != m_modelGeneration || !m_modelBuffer) return;
+
+    ScopedTimer reloadTimer("model reload");
+    const QVector<GLfloat>& data = reload.model.data;
+    const int vertexCount = data.count() / NUM_VERTEX_VALUES;
+    const bool geometryChanged = !reload.ranges.isEmpty() ||
+            vertexCount != m_modelVertexCount;
+
+    // ==== Upload the changed ranges ====
+    // A buffer another view still draws from is left to it, and this view
+    // uploads a copy of its own.
+    qint64 uploadedBytes = 0;
+    int uploads = 0;
+    if(geometryChanged) {
+        ScopedTimer timer("model upload");
+        if(!GpuResources::instance().detachBuffer(m_modelBuffer)) {
+            glGenBuffers(1, &m_modelBuffer);
+            m_modelCapacity = 0;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, m_modelBuffer);
+        if(vertexCount > m_modelCapacity) {
+            glBufferData(GL_ARRAY_BUFFER, vertexCount * STRIDE,
+                    data.constData(), GL_STATIC_DRAW);
+            m_modelCapacity = vertexCount;
+            uploadedBytes = (qint64)vertexCount * STRIDE;
+            uploads = 1;
+        } else {
+            for(const auto& range : reload.ranges) {
+                glBufferSubData(GL_ARRAY_BUFFER, range.first * STRIDE,
+                        range.count * STRIDE,
+                        data.constData() + range.first * NUM_VERTEX_VALUES);
+                uploadedBytes += (qint64)range.count * STRIDE;
+                ++uploads;
+            }
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_modelVertexCount = vertexCount;
+        shareModelBuffer(reload.model.contentHash);
+        buildDerivedData(reload.model);
+        m_memory.set("model/vbo", 0, (qint64)m_modelCapacity * STRIDE);
+    }
+
+    // ==== Texture ====
+    if(reload.textureChanged) {
+        m_textureStreamer_p->remove(m_modelTexture);
+        m_modelTexture = addTexture(reload.textureMips,
+                reload.model.uvDensity, reload.textureHash);
+        m_textureHash = reload.textureHash;
+    }
+
+    emit notify(QString("Reloaded \"%1\": %2 of %3 vertices changed, "
+            "%4 uploaded in %5 ranges, texture %6, shown %7 ms after the "
+            "reload started")
+            .arg(m_modelPath)
+            .arg(geometryChanged ? BufferDiff::vertexCount(reload.ranges) : 0)
+            .arg(vertexCount)
+            .arg(MemoryLedger::formatBytes(uploadedBytes))
+            .arg(uploads)
+            .arg(reload.textureChanged ? "reloaded" : "kept")
+            .arg(m_modelLoadClock.elapsed()));
+}
+
+//=============================================================================
+GlWidget::ModelFile GlWidget::readModelFile(const QString& path,
+        bool withVertexIndices, const FaceChunkHandler& chunkHandler)
+{
+    ModelFile model;
+    model.path = path;
+
+    QByteArray bytes;
+    if(!readModelBytes(&model, &bytes)) return model;
+    hashModelBytes(&model, bytes);
+    PlyModel ply;
+    if(!parseModelBytes(&model, bytes, &ply)) return model;
+    convertModel(&model, std::move(ply), withVertexIndices, chunkHandler);
+    return model;
+}
+
+//=============================================================================
+bool GlWidget::readModelBytes(ModelFile *model_p, QByteArray *bytes_p)
+{
+    ScopedTimer timer("read file");
+    QFile file(model_p->path);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        model_p->error =
+                QString("Could not open file \"%1\"").arg(model_p->path);
+        return false;
+    }
+    *bytes_p = file.readAll();
+    model_p->fileBytes = bytes_p->size();
+    return true;
+}
+
+//=============================================================================
+// The converted vertices depend on nothing but the file, so its hash names
+// the model buffer in GpuResources.
+void GlWidget::hashModelBytes(ModelFile *model_p, const QByteArray& bytes)
+{
+    if(bytes.isEmpty()) return;
+    ScopedTimer timer("hash file");
+    model_p->contentHash =
+            QCryptographicHash::hash(bytes, QCryptographicHash::Md5);
+}
+
+//=============================================================================
+bool GlWidget::parseModelBytes(ModelFile *model_p, const QByteArray& bytes,
+        PlyModel *ply_p)
+{
+    {
+        ScopedTimer timer("PlyModel::parse");
+        QTextStream stream(bytes);
+        *ply_p = PlyModel::parse(stream);
+    }
+    model_p->plyBytes = ply_p->memoryBytes();
+    if(!ply_p->isValid()) {
+        model_p->error =
+                QString("Invalid PLY file \"%1\"").arg(model_p->path);
+        return false;
+    }
+    return true;
+}
+
+//=============================================================================
+void GlWidget::convertModel(ModelFile *model_p, PlyModel ply,
+        bool withVertexIndices, const FaceChunkHandler& chunkHandler)
+{
+    ScopedTimer timer("convertPly");
+    if(withVertexIndices) model_p->points = convertPlyVertices(ply);
+    model_p->data = convertPly(std::move(ply),
+            withVertexIndices ? &model_p->vertexIndices : nullptr,
+            chunkHandler);
+    model_p->uvDensity = TextureResidency::uvDensity(
+            model_p->data.constData(),
+            model_p->data.count() / NUM_VERTEX_VALUES, NUM_VERTEX_VALUES,
+            TEXTURE_COORD_OFFSET / sizeof(GLfloat));
+}
+
+//=============================================================================
+// Adds a read, a parse and a convert task for model_p->path and returns the
+// last one.  A step that fails sets model_p->error and the rest do nothing.
+// The file is hashed alongside the parse.
+int GlWidget::addModelFileTasks(const QSharedPointer<ModelFile>& model_p,
+        bool withVertexIndices, const FaceChunkHandler& chunkHandler)
+{
+    auto bytes_p = QSharedPointer<QByteArray>::create();
+    auto ply_p = QSharedPointer<PlyModel>::create();
+
+    const int read = m_loader.add([model_p, bytes_p]() {
+        (void)readModelBytes(model_p.data(), bytes_p.data());
+    });
+    const int hash = m_loader.add([model_p, bytes_p]() {
+        hashModelBytes(model_p.data(), *bytes_p);
+    }, { read });
+    const int parse = m_loader.add([model_p, bytes_p, ply_p]() {
+        if(!model_p->error.isEmpty()) return;
+        (void)parseModelBytes(model_p.data(), *bytes_p, ply_p.data());
+    }, { read });
+    return m_loader.add(
+            [model_p, bytes_p, ply_p, withVertexIndices, chunkHandler]() {
+        *bytes_p = QByteArray();
+        if(!model_p->error.isEmpty()) return;
+        convertModel(model_p.data(), std::move(*ply_p), withVertexIndices,
+                chunkHandler);
+    }, { parse, hash });
+}
+
+//=============================================================================
+// Runs the uploads that finished loads are waiting on until the frame's
+// budget is spent; whatever is left goes in the next frame.
+void GlWidget::runLoaderTasks()
+{
+    ScopedTimer timer("loader uploads", "frame");
+    QElapsedTimer clock;
+    clock.start();
+    while(clock.elapsed() < UPLOAD_BUDGET_MS &&
+            m_loader.runMainThreadTask()) {}
+    if(m_loader.hasMainThreadTasks()) update();
+}
+
+//=============================================================================
+// Decodes the texture that goes with a model.  When the file hashes to
+// unchangedHash it is not decoded again and a null image is returned.
+QImage GlWidget::readTextureImage(const QString& modelPath,
+        QByteArray *hash_p, const QByteArray& unchangedHash)
+{
+    QByteArray bytes;
+    QFile file(texturePathFor(modelPath));
+    if(file.open(QIODevice::ReadOnly)) bytes = file.readAll();
+    const QByteArray hash = bytes.isEmpty() ? QByteArray() :
+            QCryptographicHash::hash(bytes, QCryptographicHash::Md5);
+    if(hash_p) *hash_p = hash;
+    if(!unchangedHash.isEmpty() && hash == unchangedHash) return QImage();
+
+    ScopedTimer timer("texture decode");
+    return QImage::fromData(bytes).mirrored();
+}
+
+//=============================================================================
+// Hands a texture's mips to the streamer, which starts it at a small level.
+// Returns -1 when there is no texture.  The streamer keeps the mips, so
+// they are accounted for under "textures" rather than with their model.
+// Views that show the same image file on the same geometry share it.
+int GlWidget::addTexture(const QSharedPointer<const MipChain>& mips_p,
+        float uvDensity, const QByteArray& hash)
+{
+    QByteArray key;
+    if(!hash.isEmpty()) {
+        key = hash;
+        key.append(reinterpret_cast<const char *>(&uvDensity),
+                sizeof(uvDensity));
+    }
+    return m_textureStreamer_p->add(mips_p, uvDensity, false, -1, key);
+}
+
+//=============================================================================
+// renderScale is the scale of the target the texture is drawn into.
+void GlWidget::requestTexture(int texture, const QMatrix4x4& modelView,
+        const float *min_p, const float *max_p, float renderScale)
+{
+    if(texture < 0) return;
+    const int viewportHeight =
+            qRound(height() * devicePixelRatioF() * renderScale);
+    m_textureStreamer_p->request(texture, TextureResidency::pixelsPerUnit(
+            modelView.constData(), m_projectionMatrix.constData(),
+            min_p, max_p, viewportHeight));
+}
+
+//=============================================================================
+// Moves the resident mip levels towards what this frame's draws asked for.
+// The ornament layers are drawn again when the atlas changes level.
+void GlWidget::updateTextures()
+{
+    ScopedTimer timer("texture streaming", "frame");
+    m_textureStreamer_p->update(m_textureView);
+    if(m_textureStreamer_p->isStreaming()) update();
+
+    const int ornamentLevel =
+            m_textureStreamer_p->residentLevel(m_ornamentTexture);
+    if(ornamentLevel != m_ornamentTextureLevel) {
+        m_ornamentTextureLevel = ornamentLevel;
+        m_gridLayer.invalidate();
+        m_arrowLayer.invalidate();
+    }
+
+    const TextureStreamer::Stats& stats = m_textureStreamer_p->stats();
+    m_memory.set("textures/mips", m_textureStreamer_p->chainBytes(), 0);
+    m_memory.set("textures/resident", 0, stats.residentBytes);
+}
+
+//=============================================================================
+// Starts loading every mesh the queued requests need, then applies the
+// requests in order up to the first one whose mesh is still loading.
+void GlWidget::loadSceneModels()
+{
+    for(const auto& request : m_sceneRequests) {
+        if(request.type != SceneRequest::Type::ADD ||
+                m_scene.hasMesh(request.path) ||
+                m_sceneLoads.contains(request.path)) {
+            continue;
+        }
+        m_sceneLoads.insert(request.path, true);
+        loadSceneMesh(request.path);
+    }
+
+    int applied = 0;
+    for(; applied < m_sceneRequests.count(); ++applied) {
+        const SceneRequest& request = m_sceneRequests[applied];
+        switch(request.type) {
+        case SceneRequest::Type::ADD:
+            if(!m_scene.hasMesh(request.path)) {
+                if(m_sceneLoads.value(request.path)) break;
+                // The load failed; a later request tries again.
+                (void)m_sceneLoads.remove(request.path);
+                continue;
+            }
+            (void)m_scene.addInstance(
+                    request.id, request.path, request.transform);
+            continue;
+        case SceneRequest::Type::REMOVE:
+            (void)m_scene.removeInstance(request.id);
+            continue;
+        case SceneRequest::Type::TRANSFORM:
+            m_scene.setTransform(request.id, request.transform);
+            continue;
+        case SceneRequest::Type::CLEAR:
+            m_scene.clear();
+            continue;
+        }
+        break;
+    }
+    if(applied == 0) return;
+    m_sceneRequests.erase(m_sceneRequests.begin(),
+            m_sceneRequests.begin() + applied);
+
+    const GeometryArena& arena = m_scene.arena();
+    m_memory.set("scene/arena", 0, (qint64)arena.reservedVertices() * STRIDE);
+    m_memory.set("scene/occluders", m_scene.occluderBytes(), 0);
+    emit notify(QString("Scene: %1 instances, %2 of %3 vertices used "
+            "in %4 buffers")
+            .arg(m_scene.instanceCount())
+            .arg(arena.usedVertices())
+            .arg(arena.reservedVertices())
+            .arg(arena.pageCount()));
+}
+
+//=============================================================================
+void GlWidget::loadSceneMesh(const QString& path)
+{
+    auto mesh_p = QSharedPointer<ModelFile>::create();
+    mesh_p->path = path;
+    const int converted = addModelFileTasks(mesh_p, false);
+    const int texture = m_loader.add([mesh_p]() {
+        mesh_p->textureMips = buildMipChain(
+                readTextureImage(mesh_p->path, &mesh_p->textureHash));
+    });
+    (void)m_loader.addMainThread([this, mesh_p]() {
+        addSceneMesh(*mesh_p);
+    }, { converted, texture }, SCENE_UPLOAD);
+}
+
+//=============================================================================
+void GlWidget::addSceneMesh(const ModelFile& mesh)
+{
+    m_memory.set("scene/load/file", mesh.fileBytes, 0, true);
+    m_memory.set("scene/load/ply", mesh.plyBytes, 0, true);
+    if(!mesh.error.isEmpty()) emit notify(mesh.error);
+
+    if(mesh.data.isEmpty()) {
+        m_sceneLoads.insert(mesh.path, false);
+        update();
+        return;
+    }
+
+    const int texture = addTexture(mesh.textureMips, mesh.uvDensity,
+            mesh.textureHash);
+    if(!m_scene.addMesh(mesh.path, mesh.data, texture)) {
+        emit notify(QString("Could not place \"%1\" in the scene buffers")
+                .arg(mesh.path));
+        m_textureStreamer_p->remove(texture);
+        m_sceneLoads.insert(mesh.path, false);
+    } else {
+        (void)m_sceneLoads.remove(mesh.path);
+    }
+    update();
+}
+
+//=============================================================================
+void GlWidget::uploadStreamedVertices()
+{
+    ScopedTimer timer("stream upload", "frame");
+    m_streamChanged = false;
+
+    m_streamVertexCount = m_streamedVertices.count() / NUM_VERTEX_VALUES;
+    m_pickData.clear();
+    releaseFaceNormals();
+    m_pickVertexIndices.clear();
+    m_streamBuffer = m_streamingBuffer.upload(m_streamedVertices.constData(),
+            m_streamVertexCount * STRIDE);
+
+    m_memory.remove("model/vertices");
+    m_memory.remove("model/vertex indices");
+    m_memory.set("stream/vertices",
+            m_streamedVertices.count() * sizeof(GLfloat), 0);
+    m_memory.set("stream/buffers", 0, m_streamingBuffer.allocatedBytes());
+}
+
+//=============================================================================
+void GlWidget::uploadPointCloud()
+{
+    ScopedTimer timer("point cloud upload");
+    m_pointCloudChanged = false;
+
+    glDeleteBuffers(1, &m_pointBuffer);
+    m_pointBuffer = 0;
+    if(!m_pointCloud || m_pointCloud->isEmpty()) return;
+
+    const QVector<float>& vertices = m_pointCloud->vertices();
+    glGenBuffers(1, &m_pointBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_pointBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.count() * sizeof(GLfloat),
+            vertices.constData(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    const qint64 nodeBytes =
+            (qint64)m_pointCloud->nodeCount() * sizeof(PointOctree::Node);
+    m_memory.set("model/point cloud",
+            vertices.count() * sizeof(GLfloat) + nodeBytes,
+            vertices.count() * sizeof(GLfloat));
+    emit notify(QString("Point cloud ready: %1 points in %2 octree nodes")
+            .arg(m_pointCloud->pointCount())
+            .arg(m_pointCloud->nodeCount()));
+}
+
+//=============================================================================
+void GlWidget::drawPointCloud()
+{
+    ScopedTimer timer("point selection", "frame");
+
+    // Camera position in model space, and pixels per unit at distance one
+    // (the same scale for both projections, read off the matrix).
+    const QMatrix4x4 modelView = m_viewMatrix * m_modelMatrix;
+    const QVector3D eye = modelView.inverted().map(QVector3D());
+    const float viewportHeight =
+            height() * devicePixelRatioF() * m_renderScale;
+
+    PointOctree::View view;
+    view.eye[0] = eye.x();
+    view.eye[1] = eye.y();
+    view.eye[2] = eye.z();
+    view.pixelsPerUnit = m_projectionMatrix(1, 1) * viewportHeight * 0.5f;
+    view.perspective = (m_projection == Projection::PERSPECTIVE);
+
+    const QVector<PointOctree::Range> ranges = m_pointCloud->select(
+            view, m_pointBudget, POINT_ERROR_PIXELS, &m_pointsDrawn);
+
+    if(m_vars.uPointSize >= 0) {
+        m_program_p->setUniformValue(m_vars.uPointSize,
+                (GLfloat)devicePixelRatioF());
+    }
+    if(!context()->isOpenGLES()) glEnable(PROGRAM_POINT_SIZE);
+    for(const auto& range : ranges) {
+        glDrawArrays(GL_POINTS, range.first, range.count);
+    }
+    if(!context()->isOpenGLES()) glDisable(PROGRAM_POINT_SIZE);
+}
+
+//=============================================================================
+// The faceted render's face normals for shaders that do not derive them,
+// made from the loaded model the first time they are drawn.  There are none
+// while the model buffer and the pick data disagree, as they do mid-load.
+GLuint GlWidget::storedFaceNormals()
+{
+    const int vertexCount = m_pickData.count() / NUM_VERTEX_VALUES;
+    if(vertexCount == 0 || vertexCount != m_modelVertexCount) return 0;
+    if(m_faceNormalBuffer) return m_faceNormalBuffer;
+
+    ScopedTimer timer("face normals");
+    const QVector<GLfloat> normals = makeFaceNormals(m_pickData);
+    const qint64 bytes = normals.count() * sizeof(GLfloat);
+    glGenBuffers(1, &m_faceNormalBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_faceNormalBuffer);
+    glBufferData(GL_ARRAY_BUFFER, bytes, normals.constData(),
+            GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_memory.set("model/face normals", 0, bytes);
+    return m_faceNormalBuffer;
+}
+
+//=============================================================================
+void GlWidget::releaseFaceNormals()
+{
+    glDeleteBuffers(1, &m_faceNormalBuffer);
+    m_faceNormalBuffer = 0;
+    m_memory.remove("model/face normals");
+}
+
+//=============================================================================
+void GlWidget::loadClusterFile()
+{
+    m_clusterFileChanged = false;
+    if(m_clusterFile) releaseModel();
+    m_clusterCache.setFile(m_clusterFile);
+    m_memory.remove("model/clusters");
+}
+
+//=============================================================================
+void GlWidget::drawClusters()
+{
+    const QVector<ClusterCache::DrawItem> items = m_clusterCache.update(
+            m_projectionMatrix * m_viewMatrix * m_modelMatrix);
+    m_memory.set("model/clusters", 0, m_clusterCache.allocatedBytes());
+
+    // Every cluster has its own buffer, so the attributes are set per draw.
+    for(const auto& item : items) {
+        glBindBuffer(GL_ARRAY_BUFFER, item.buffer);
+
+        if(m_vars.aPosition >= 0) {
+            const intptr_t offset = POSITION_OFFSET;
+            glVertexAttribPointer(m_vars.aPosition,
+                    3, GL_FLOAT, GL_FALSE, STRIDE, (void *)offset);
+            glEnableVertexAttribArray(m_vars.aPosition);
+        }
+
+        // Clusters only have smooth normals for shaders that do not
+        // derive face normals.
+        if(m_vars.aNormal >= 0) {
+            const intptr_t offset = NORMAL_OFFSET;
+            glVertexAttribPointer(m_vars.aNormal,
+                    3, GL_FLOAT, GL_FALSE, STRIDE, (void *)offset);
+            glEnableVertexAttribArray(m_vars.aNormal);
+        }
+
+        if(m_vars.aTextureCoord >= 0) {
+            const intptr_t offset = TEXTURE_COORD_OFFSET;
+            glVertexAttribPointer(m_vars.aTextureCoord,
+                    2, GL_FLOAT, GL_FALSE, STRIDE, (void *)offset);
+            glEnableVertexAttribArray(m_vars.aTextureCoord);
+        }
+
+        glDrawArrays(GL_TRIANGLES, 0, item.count);
+    }
+
+    if(m_vars.aTextureCoord >= 0) {
+        glDisableVertexAttribArray(m_vars.aTextureCoord);
+    }
+
+    if(m_vars.aNormal >= 0) {
+        glDisableVertexAttribArray(m_vars.aNormal);
+    }
+
+    if(m_vars.aPosition >= 0) {
+        glDisableVertexAttribArray(m_vars.aPosition);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Keep painting while clusters page in; each frame uploads a few.
+    if(m_clusterCache.isLoading()) update();
+}
+
+//=============================================================================
+// The grid and arrow vertices are baked in at build time; only the atlas
+// image is put together here, from both images loading concurrently.
+void GlWidget::loadOrnaments()
+{
+    // The ornaments are built into the program, so they are read once per
+    // process; widgets that start after the first load has finished take
+    // its result, and usually its GPU objects too.
+    static QSharedPointer<const Ornaments> built_p;
+    if(built_p) {
+        const QSharedPointer<const Ornaments> ornaments_p = built_p;
+        (void)m_loader.addMainThread([this, ornaments_p]() {
+            uploadOrnaments(*ornaments_p);
+        }, {}, ORNAMENT_UPLOAD);
+        return;
+    }
+
+    auto ornaments_p = QSharedPointer<Ornaments>::create();
+    const QVector<int> parts = {
+        m_loader.add([ornaments_p]() {
+            ornaments_p->gridImage =
+                    QImage(":/grid-texture.png").mirrored();
+        }),
+        m_loader.add([ornaments_p]() {
+            ornaments_p->arrowImage =
+                    QImage(":/arrow-texture.png").mirrored();
+        })
+    };
+
+    const int atlas = m_loader.add([ornaments_p]() {
+        ScopedTimer timer("ornament atlas");
+
+        // Same order as the bake tool, which remapped the baked texture
+        // coordinates to this layout.
+        TextureAtlas atlas;
+        const int gridImage = atlas.add(ornaments_p->gridImage);
+        const int arrowImage = atlas.add(ornaments_p->arrowImage);
+        ornaments_p->gridImage = QImage();
+        ornaments_p->arrowImage = QImage();
+        if(!atlas.build()) return;
+
+        // A layout that differs from the baked one would put the wrong
+        // texels on the ornaments.
+        const double *grid_p = BakedOrnaments::GRID_RECT;
+        const double *arrow_p = BakedOrnaments::ARROW_RECT;
+        if(atlas.textureRect(gridImage) !=
+                        QRectF(grid_p[0], grid_p[1], grid_p[2], grid_p[3]) ||
+                atlas.textureRect(arrowImage) != QRectF(
+                        arrow_p[0], arrow_p[1], arrow_p[2], arrow_p[3])) {
+            return;
+        }
+
+        ornaments_p->atlasMips = buildMipChain(atlas.image());
+        ornaments_p->maxMipLevel = atlas.maxMipLevel();
+        if(ornaments_p->atlasMips) {
+            ornaments_p->atlasKey = GpuResources::key("ornament atlas",
+                    ornaments_p->atlasMips->level(0).pixels);
+        }
+        ornaments_p->packed = true;
+    }, parts);
+
+    (void)m_loader.addMainThread([this, ornaments_p]() {
+        if(!built_p) built_p = ornaments_p;
+        uploadOrnaments(*ornaments_p);
+    }, { atlas }, ORNAMENT_UPLOAD);
+}
+
+//=============================================================================
+void GlWidget::uploadOrnaments(const Ornaments& ornaments)
+{
+    ScopedTimer timer("ornament upload");
+
+    // ==== Atlas ====
+    // Levels past maxMipLevel would blend the packed images together.
+    m_textureStreamer_p->remove(m_ornamentTexture);
+    m_ornamentTexture = -1;
+    if(ornaments.packed) {
+        m_ornamentTexture = m_textureStreamer_p->add(ornaments.atlasMips,
+                BakedOrnaments::UV_DENSITY, true, ornaments.maxMipLevel,
+                ornaments.atlasKey);
+    } else {
+        emit notify("Could not pack the ornament textures");
+    }
+
+    // ==== Buffer ====
+    m_gridFirst = BakedOrnaments::GRID_FIRST;
+    m_gridVertexCount = BakedOrnaments::GRID_VERTEX_COUNT;
+    m_arrowFirst = BakedOrnaments::ARROW_FIRST;
+    m_arrowVertexCount = BakedOrnaments::ARROW_VERTEX_COUNT;
+
+    // Every widget in the process has the same baked vertices.
+    GpuResources& resources = GpuResources::instance();
+    const QByteArray key = "ornaments:baked";
+    resources.releaseBuffer(m_ornamentBuffer);
+    m_ornamentBuffer = resources.acquireBuffer(key);
+    if(!m_ornamentBuffer) {
+        glGenBuffers(1, &m_ornamentBuffer);
+        uploadOrnamentBuffer();
+        m_ornamentBuffer = resources.shareBuffer(key, m_ornamentBuffer,
+                sizeof(BakedOrnaments::VERTICES));
+    }
+
+    // The layers were drawn without them.
+    m_gridLayer.invalidate();
+    m_arrowLayer.invalidate();
+
+    m_memory.set("ornaments/vbo", 0, sizeof(BakedOrnaments::VERTICES));
+}
+
+//=============================================================================
+void GlWidget::uploadOrnamentBuffer()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, m_ornamentBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(BakedOrnaments::VERTICES),
+            BakedOrnaments::VERTICES, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+//=============================================================================
+void GlWidget::initializeLayers()
+{
+    m_layersAvailable = RenderLayer::isSupported(context());
+    if(!m_layersAvailable) {
+        emit notify("Render layers unavailable; drawing ornaments directly");
+        return;
+    }
+
+    auto readSource = [](const QString& path) {
+        QFile file(path);
+        if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) return QString();
+        return QString::fromUtf8(file.readAll());
+    };
+
+    // GLSL ES 1.00 only writes depth through the extension.
+    auto buildProgram = [&](const QString& fragmentPath) {
+        QString fragmentSource = readSource(fragmentPath);
+        if(context()->isOpenGLES()) {
+            fragmentSource.prepend("#extension GL_EXT_frag_depth : require\n"
+                    "#define gl_FragDepth gl_FragDepthEXT\n");
+        }
+
+        QString log;
+        ShaderCache::Status status;
+        auto program_p = buildSharedProgram(readSource(":/layer.vert"),
+                fragmentSource, &log, &status);
+        if(!program_p) emit notify(log);
+        return program_p;
+    };
+
+    auto program_p = buildProgram(":/layer.frag");
+    if(!program_p) {
+        m_layersAvailable = false;
+        return;
+    }
+    GpuResources::instance().releaseProgram(m_layerProgram_p);
+    m_layerProgram_p = program_p;
+    m_memory.set("shaders/layer", 0, ShaderCache::programBytes(program_p));
+    m_layerVars.aPosition = program_p->attributeLocation("aPosition");
+    m_layerVars.uColor = program_p->uniformLocation("uColor");
+    m_layerVars.uDepth = program_p->uniformLocation("uDepth");
+
+    // Without it the model is always drawn at full resolution.
+    GpuResources::instance().releaseProgram(m_upscaleProgram_p);
+    m_upscaleProgram_p = buildProgram(":/upscale.frag");
+    if(m_upscaleProgram_p) {
+        program_p = m_upscaleProgram_p;
+        m_memory.set("shaders/upscale", 0,
+                ShaderCache::programBytes(program_p));
+        m_upscaleVars.aPosition = program_p->attributeLocation("aPosition");
+        m_upscaleVars.uColor = program_p->uniformLocation("uColor");
+        m_upscaleVars.uDepth = program_p->uniformLocation("uDepth");
+        m_upscaleVars.uTexelSize = program_p->uniformLocation("uTexelSize");
+        m_upscaleVars.uSharpness = program_p->uniformLocation("uSharpness");
+    }
+
+    glDeleteBuffers(1, &m_layerBuffer);
+    glGenBuffers(1, &m_layerBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_layerBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(LAYER_TRIANGLE), LAYER_TRIANGLE,
+            GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_gridLayer.initialize(context());
+    m_arrowLayer.initialize(context());
+    m_sceneTarget.initialize(context());
+}
+
+//=============================================================================
+void GlWidget::drawOrnaments(bool grid, bool normals)
+{
+    m_ornamentProgram_p->bind();
+
+    m_ornamentProgram_p->setUniformValue(
+            m_ornamentVars.uModel, QMatrix4x4());
+    m_ornamentProgram_p->setUniformValue(
+            m_ornamentVars.uView, m_viewMatrix);
+    m_ornamentProgram_p->setUniformValue(
+            m_ornamentVars.uProjection, m_projectionMatrix);
+
+    // Grid and arrows share one buffer and one atlas texture, so this
+    // setup covers both draws.
+    glBindBuffer(GL_ARRAY_BUFFER, m_ornamentBuffer);
+
+    if(m_ornamentVars.aPosition >= 0) {
         const intptr_t offset = POSITION_OFFSET;
         glVertexAttribPointer(m_ornamentVars.aPosition,
                 3, GL_FLOAT, GL_FALSE, STRIDE, (void *)offset);
@@ -546,20 +2155,23 @@ void GlWidget::drawNormals()
         glEnableVertexAttribArray(m_ornamentVars.aTextureCoord);
     }
 
-    if(m_arrowTexture_p && m_ornamentVars.uTexture >= 0) {
+    const GLuint texture = m_textureStreamer_p->texture(m_ornamentTexture);
+    if(texture && m_ornamentVars.uTexture >= 0) {
         constexpr int textureUnit = 0;
-        m_arrowTexture_p->bind(textureUnit);
+        glActiveTexture(GL_TEXTURE0 + textureUnit);
+        glBindTexture(GL_TEXTURE_2D, texture);
         glUniform1i(m_ornamentVars.uTexture, textureUnit);
     }
 
-    const auto& arrowTransforms =
-            m_enableFacetedRender ? m_facetedArrows : m_smoothArrows;
-    for(auto transform : arrowTransforms) {
-        m_ornamentProgram_p->setUniformValue(
-                m_ornamentVars.uModel, m_modelMatrix * transform);
-        glDrawArrays(GL_TRIANGLES, 0, m_arrowVertexCount);
+    if(grid) {
+        ScopedTimer passTimer("grid pass", "frame");
+        m_gpuTimer.begin("gpu grid pass");
+        glDrawArrays(GL_TRIANGLES, m_gridFirst, m_gridVertexCount);
+        m_gpuTimer.end();
     }
 
+    if(normals) drawNormals();
+
     if(m_ornamentVars.aTextureCoord >= 0) {
         glDisableVertexAttribArray(m_ornamentVars.aTextureCoord);
     }
@@ -569,4 +2181,499 @@ void GlWidget::drawNormals()
     }
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_ornamentProgram_p->release();
+}
+
+//=============================================================================
+void GlWidget::drawOrnamentLayers()
+{
+    const qreal ratio = devicePixelRatioF();
+    const int w = qRound(width() * ratio);
+    const int h = qRound(height() * ratio);
+    if(!m_gridLayer.resize(w, h) ||
+            (m_enableVisibleNormals && !m_arrowLayer.resize(w, h))) {
+        emit notify("Could not allocate render layers; drawing ornaments "
+                "directly");
+        m_layersAvailable = false;
+        m_gridLayer.release();
+        m_arrowLayer.release();
+        m_memory.removeGroup("layers");
+        drawOrnaments(true, m_enableVisibleNormals);
+        return;
+    }
+
+    // ==== Redraw the layers whose inputs changed ====
+    // Layers keep their own depth so they can be depth tested against the
+    // model when they are composited.
+    const GLuint target = defaultFramebufferObject();
+    glEnable(GL_DEPTH_TEST);
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+            GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    QByteArray inputs = matrixBytes(m_viewMatrix) +
+            matrixBytes(m_projectionMatrix);
+    if(m_gridLayer.setInputs(inputs)) {
+        m_gridLayer.begin();
+        drawOrnaments(true, false);
+        m_gridLayer.end(target);
+        m_memory.set("layers/grid", 0, m_gridLayer.allocatedBytes());
+    }
+
+    if(m_enableVisibleNormals) {
+        inputs += matrixBytes(m_modelMatrix);
+        inputs.append(m_enableFacetedRender ? 'f' : 's');
+        inputs.append(reinterpret_cast<const char *>(&m_arrowGeneration),
+                sizeof(m_arrowGeneration));
+        if(m_arrowLayer.setInputs(inputs)) {
+            m_arrowLayer.begin();
+            drawOrnaments(false, true);
+            m_arrowLayer.end(target);
+            m_memory.set("layers/arrows", 0, m_arrowLayer.allocatedBytes());
+        }
+    }
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if(!m_enableDepthTesting) glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+    glViewport(0, 0, w, h);
+
+    // ==== Composite ====
+    // Layer colors are premultiplied by the blend function above.
+    ScopedTimer timer("layer composite", "frame");
+    m_layerProgram_p->bind();
+    glUniform1i(m_layerVars.uColor, 0);
+    glUniform1i(m_layerVars.uDepth, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, m_layerBuffer);
+    glVertexAttribPointer(m_layerVars.aPosition,
+            2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray(m_layerVars.aPosition);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    compositeLayer(m_gridLayer);
+    if(m_enableVisibleNormals) compositeLayer(m_arrowLayer);
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisableVertexAttribArray(m_layerVars.aPosition);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_layerProgram_p->release();
+}
+
+//=============================================================================
+void GlWidget::compositeLayer(const RenderLayer& layer)
+{
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, layer.depthTexture());
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, layer.colorTexture());
+
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+//=============================================================================
+// Fill-rate bound work grows with the number of pixels, so the controller
+// is fed the GPU time of the model pass, which is the part that scales.
+// Without timer queries the time the last paintGL took stands in for it;
+// see measureFrame().
+void GlWidget::updateRenderScale()
+{
+    m_frameClock.start();
+
+    if(!m_enableDynamicResolution || !m_upscaleProgram_p) {
+        m_renderScale = 1.0f;
+        m_frameMs = 0.0;
+        return;
+    }
+
+    const double ms = m_gpuTimer.isAvailable() ?
+            Profiler::instance().lastMs("gpu model pass") : m_frameMs;
+    (void)m_resolution.addFrame((float)ms);
+    m_renderScale = m_resolution.scale();
+}
+
+//=============================================================================
+// The widget only repaints on update(), so the interval between frames is
+// mostly input and event timing.  Without timer queries the frame is
+// finished here instead, and the time it took from the start of paintGL
+// is what the controller gets next frame.
+void GlWidget::measureFrame()
+{
+    if(!m_enableDynamicResolution || !m_upscaleProgram_p ||
+            m_gpuTimer.isAvailable()) {
+        return;
+    }
+    glFinish();
+    m_frameMs = m_frameClock.nsecsElapsed() / 1e6;
+}
+
+//=============================================================================
+// Returns true if the model pass is being drawn into the scaled target.
+// Colors are premultiplied on the way in, like in the ornament layers, so
+// the upscale can composite with (ONE, ONE_MINUS_SRC_ALPHA).
+bool GlWidget::beginSceneTarget()
+{
+    if(!m_enableDynamicResolution || !m_upscaleProgram_p) {
+        if(m_sceneTarget.isAllocated()) {
+            m_sceneTarget.release();
+            m_memory.remove("layers/scene");
+        }
+        return false;
+    }
+
+    const qreal ratio = devicePixelRatioF() * m_renderScale;
+    const int w = qMax(qRound(width() * ratio), 1);
+    const int h = qMax(qRound(height() * ratio), 1);
+    if(!m_sceneTarget.resize(w, h)) {
+        emit notify("Could not allocate the scaled scene target; drawing "
+                "at full resolution");
+        m_enableDynamicResolution = false;
+        emit dynamicResolutionChanged(false);
+        m_renderScale = 1.0f;
+        m_memory.remove("layers/scene");
+        return false;
+    }
+    m_memory.set("layers/scene", 0, m_sceneTarget.allocatedBytes());
+
+    m_sceneTarget.begin();
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+            GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    return true;
+}
+
+//=============================================================================
+// Draws the scaled target over the whole window with bilinear filtering,
+// optionally sharpened, and writes its depth so that the ornaments are
+// still hidden behind the model.
+void GlWidget::upscaleSceneTarget()
+{
+    ScopedTimer timer("upscale", "frame");
+    m_gpuTimer.begin("gpu upscale");
+
+    const qreal ratio = devicePixelRatioF();
+    m_sceneTarget.end(defaultFramebufferObject());
+    glViewport(0, 0, qRound(width() * ratio), qRound(height() * ratio));
+
+    // The target samples with GL_NEAREST for compositing at full size.
+    glBindTexture(GL_TEXTURE_2D, m_sceneTarget.colorTexture());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Depth is written whatever the depth testing option says.
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_ALWAYS);
+    glDepthMask(GL_TRUE);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    const int w = qMax(qRound(width() * ratio * m_renderScale), 1);
+    const int h = qMax(qRound(height() * ratio * m_renderScale), 1);
+    m_upscaleProgram_p->bind();
+    glUniform1i(m_upscaleVars.uColor, 0);
+    glUniform1i(m_upscaleVars.uDepth, 1);
+    glUniform2f(m_upscaleVars.uTexelSize, 1.0f / w, 1.0f / h);
+    glUniform1f(m_upscaleVars.uSharpness,
+            m_enableSharpenUpscale ? UPSCALE_SHARPNESS : 0.0f);
+    glBindBuffer(GL_ARRAY_BUFFER, m_layerBuffer);
+    glVertexAttribPointer(m_upscaleVars.aPosition,
+            2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray(m_upscaleVars.aPosition);
+
+    compositeLayer(m_sceneTarget);
+
+    glDisableVertexAttribArray(m_upscaleVars.aPosition);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_upscaleProgram_p->release();
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthFunc(GL_LESS);
+    if(!m_enableDepthTesting) glDisable(GL_DEPTH_TEST);
+    m_gpuTimer.end();
+}
+
+//=============================================================================
+// Uses the arrows the loader built, if it did.
+void GlWidget::loadNormals(const ModelFile& model)
+{
+    ++m_arrowGeneration;
+    m_smoothArrows = model.smoothArrows;
+    m_facetedArrows = model.facetedArrows;
+    if(m_smoothArrows.isEmpty()) {
+        ScopedTimer timer("loadNormals");
+        m_smoothArrows = buildArrowTransforms(model.data, NORMAL_OFFSET);
+        m_facetedArrows =
+                buildArrowTransforms(model.data, FACE_NORMALS);
+    }
+    m_memory.set("model/smooth arrows",
+            m_smoothArrows.count() * sizeof(GLfloat), 0);
+    m_memory.set("model/faceted arrows",
+            m_facetedArrows.count() * sizeof(GLfloat), 0);
+}
+
+//=============================================================================
+void GlWidget::drawNormals()
+{
+    ScopedTimer timer("normals pass", "frame");
+    m_gpuTimer.begin("gpu normals pass");
+
+    // The ornament buffer, attributes and atlas are still bound from the
+    // grid draw.
+    const auto& arrowTransforms =
+            m_enableFacetedRender ? m_facetedArrows : m_smoothArrows;
+    const int arrowCount = arrowTransforms.count() / ARROW_TRANSFORM_VALUES;
+    for(int i = 0; i < arrowCount; ++i) {
+        const GLfloat *t = arrowTransforms.constData() +
+                (i * ARROW_TRANSFORM_VALUES);
+        const QMatrix4x4 transform(
+                t[0], t[1], t[2], t[3],
+                t[4], t[5], t[6], t[7],
+                t[8], t[9], t[10], t[11],
+                0.0f, 0.0f, 0.0f, 1.0f);
+        m_ornamentProgram_p->setUniformValue(
+                m_ornamentVars.uModel, m_modelMatrix * transform);
+        glDrawArrays(GL_TRIANGLES, m_arrowFirst, m_arrowVertexCount);
+    }
+
+    m_gpuTimer.end();
+}
+
+//=============================================================================
+void GlWidget::drawStats()
+{
+    const Profiler& profiler = Profiler::instance();
+    QStringList passes = {
+        "frame", "model pass", "grid pass", "normals pass"
+    };
+    if(m_layersAvailable) passes.append("layer composite");
+    if(m_enableDynamicResolution && m_upscaleProgram_p) {
+        passes.append("upscale");
+    }
+
+    QStringList lines;
+    for(const auto& pass : passes) {
+        QString line = QString("%1: %2 ms")
+                .arg(pass, -14).arg(profiler.averageMs(pass), 6, 'f', 2);
+        if(m_gpuTimer.isAvailable() && pass != "frame") {
+            line += QString("  gpu %1 ms")
+                    .arg(profiler.averageMs("gpu " + pass), 6, 'f', 2);
+        }
+        lines.append(line);
+    }
+    if((m_enablePointCloud || m_pointsOnly) && m_pointBuffer) {
+        lines.append(QString("%1: %2 of %3").arg("points", -14)
+                .arg(m_pointsDrawn).arg(m_pointCloud->pointCount()));
+    }
+    if(m_clusterCache.hasFile()) {
+        const ClusterCache::Stats& stats = m_clusterCache.stats();
+        lines.append(QString("%1: %2 of %3 visible, %4 resident (%5), "
+                "%6 loading").arg("clusters", -14)
+                .arg(stats.drawn).arg(stats.visible).arg(stats.resident)
+                .arg(MemoryLedger::formatBytes(stats.residentBytes))
+                .arg(stats.loading));
+    }
+    if(m_enableOcclusionCulling && m_scene.instanceCount() > 0) {
+        const OcclusionCuller::Stats& stats = m_occlusionCuller.stats();
+        lines.append(QString("%1: %2 of %3 culled by %4 occluders "
+                "(%5 triangles), %6 ms").arg("occlusion", -14)
+                .arg(stats.culled).arg(stats.tested).arg(stats.occluders)
+                .arg(stats.triangles)
+                .arg(profiler.averageMs("occlusion cull"), 0, 'f', 2));
+    }
+    if(m_enableDynamicResolution && m_upscaleProgram_p) {
+        const qreal ratio = devicePixelRatioF() * m_renderScale;
+        lines.append(QString("%1: %2% (%3x%4), %5 %6 of %7 ms")
+                .arg("resolution", -14).arg(qRound(m_renderScale * 100))
+                .arg(qRound(width() * ratio)).arg(qRound(height() * ratio))
+                .arg(m_gpuTimer.isAvailable() ? "model pass" : "frame")
+                .arg(m_resolution.averageMs(), 0, 'f', 2)
+                .arg(m_resolution.budget(), 0, 'f', 2));
+    }
+    if(m_textureStreamer_p->stats().textures > 0) {
+        const TextureStreamer::Stats& stats = m_textureStreamer_p->stats();
+        lines.append(QString("%1: %2 resident of %3 wanted, budget %4, "
+                "%5 streaming").arg("textures", -14)
+                .arg(MemoryLedger::formatBytes(stats.residentBytes))
+                .arg(MemoryLedger::formatBytes(stats.wantedBytes))
+                .arg(MemoryLedger::formatBytes(
+                        m_textureStreamer_p->budget()))
+                .arg(stats.streaming));
+    }
+
+    const ResourceTable::Stats shared = GpuResources::instance().stats();
+    if(shared.resources > 0) {
+        lines.append(QString("%1: %2 buffers and programs (%3), "
+                "%4 references").arg("shared", -14)
+                .arg(shared.resources)
+                .arg(MemoryLedger::formatBytes(shared.bytes))
+                .arg(shared.references));
+    }
+
+    QPainter painter(this);
+    painter.setPen(Qt::black);
+    painter.setFont(QFont("Monospace", 9));
+    painter.drawText(rect().adjusted(8, 8, -8, -8),
+            Qt::AlignLeft | Qt::AlignTop, lines.join("\n"));
+    painter.end();
+
+    // QPainter leaves its own blend state behind.
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+//=============================================================================
+// Fills the buffers that were uploaded before a capture started again, so
+// the capture does not depend on anything recorded outside of it.  Scene
+// instances and streamed vertices are not covered, and stored face normals
+// are made again the next time they are drawn.
+void GlWidget::recordResidentBuffers()
+{
+    if(m_ornamentBuffer) uploadOrnamentBuffer();
+    releaseFaceNormals();
+
+    if(m_modelBuffer && !m_pickData.isEmpty()) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_modelBuffer);
+        glBufferData(GL_ARRAY_BUFFER, m_pickData.count() * sizeof(GLfloat),
+                m_pickData.constData(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_modelCapacity = m_pickData.count() / NUM_VERTEX_VALUES;
+        m_memory.set("model/vbo", 0, (qint64)m_modelCapacity * STRIDE);
+    }
+
+    if(m_layerBuffer) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_layerBuffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(LAYER_TRIANGLE),
+                LAYER_TRIANGLE, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_gridLayer.invalidate();
+        m_arrowLayer.invalidate();
+    }
+
+    if(m_pointBuffer) m_pointCloudChanged = true;
+    if(m_clusterCache.hasFile()) m_clusterCache.setFile(m_clusterFile);
+}
+
+//=============================================================================
+void GlWidget::drawScene()
+{
+    ScopedTimer timer("scene pass", "frame");
+
+    const QList<Scene::DrawItem> items = m_scene.drawList();
+    const QVector<bool> visible = m_enableOcclusionCulling ?
+            cullSceneItems(items) : QVector<bool>(items.count(), true);
+
+    GLuint boundBuffer = 0;
+    int boundTexture = -1;
+    if(m_vars.uFaceted >= 0) {
+        glUniform1i(m_vars.uFaceted, m_enableFacetedRender ? 1 : 0);
+    }
+
+    for(int i = 0; i < items.count(); ++i) {
+        if(!visible[i]) continue;
+        const Scene::DrawItem& item = items[i];
+        if(item.buffer != boundBuffer) {
+            glBindBuffer(GL_ARRAY_BUFFER, item.buffer);
+            boundBuffer = item.buffer;
+
+            if(m_vars.aPosition >= 0) {
+                const intptr_t offset = POSITION_OFFSET;
+                glVertexAttribPointer(m_vars.aPosition,
+                        3, GL_FLOAT, GL_FALSE, STRIDE, (void *)offset);
+                glEnableVertexAttribArray(m_vars.aPosition);
+            }
+
+            // Like clusters, scene meshes only have smooth normals.
+            if(m_vars.aNormal >= 0) {
+                const intptr_t offset = NORMAL_OFFSET;
+                glVertexAttribPointer(m_vars.aNormal,
+                        3, GL_FLOAT, GL_FALSE, STRIDE, (void *)offset);
+                glEnableVertexAttribArray(m_vars.aNormal);
+            }
+
+            if(m_vars.aTextureCoord >= 0) {
+                const intptr_t offset = TEXTURE_COORD_OFFSET;
+                glVertexAttribPointer(m_vars.aTextureCoord,
+                        2, GL_FLOAT, GL_FALSE, STRIDE, (void *)offset);
+                glEnableVertexAttribArray(m_vars.aTextureCoord);
+            }
+        }
+
+        const QMatrix4x4 model = m_modelMatrix * item.transform;
+        if(item.texture != boundTexture && m_vars.uTexture >= 0) {
+            // Unknown ids give texture zero, which unbinds the unit.
+            constexpr int textureUnit = 0;
+            glActiveTexture(GL_TEXTURE0 + textureUnit);
+            glBindTexture(GL_TEXTURE_2D,
+                    m_textureStreamer_p->texture(item.texture));
+            glUniform1i(m_vars.uTexture, textureUnit);
+            boundTexture = item.texture;
+        }
+        requestTexture(item.texture, m_viewMatrix * model,
+                item.min, item.max, m_renderScale);
+        m_program_p->setUniformValue(m_vars.uModel, model);
+        m_program_p->setUniformValue(m_vars.uNormalMatrix,
+                (m_viewMatrix * model).inverted().transposed());
+
+        glDrawArrays(GL_TRIANGLES, item.first, item.count);
+    }
+
+    if(m_vars.aTextureCoord >= 0) {
+        glDisableVertexAttribArray(m_vars.aTextureCoord);
+    }
+
+    if(m_vars.aNormal >= 0) {
+        glDisableVertexAttribArray(m_vars.aNormal);
+    }
+
+    if(m_vars.aPosition >= 0) {
+        glDisableVertexAttribArray(m_vars.aPosition);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+//=============================================================================
+// Draws the largest instances into the occlusion buffer and tests every
+// instance's bounds against it.
+QVector<bool> GlWidget::cullSceneItems(const QList<Scene::DrawItem>& items)
+{
+    ScopedTimer timer("occlusion cull", "frame");
+    const QMatrix4x4 viewProjection =
+            m_projectionMatrix * m_viewMatrix * m_modelMatrix;
+
+    QVector<QMatrix4x4> matrices;
+    QVector<QPair<float, int>> coverage;
+    matrices.reserve(items.count());
+    coverage.reserve(items.count());
+    for(int i = 0; i < items.count(); ++i) {
+        const Scene::DrawItem& item = items[i];
+        matrices.append(viewProjection * item.transform);
+        coverage.append({ m_occlusionCuller.screenCoverage(
+                matrices[i].constData(), item.min, item.max), i });
+    }
+    std::sort(coverage.begin(), coverage.end(),
+            [](const QPair<float, int>& a, const QPair<float, int>& b) {
+        return a.first > b.first;
+    });
+
+    m_occlusionCuller.clear();
+    for(int i = 0; i < qMin(MAX_OCCLUDERS, coverage.count()); ++i) {
+        if(coverage[i].first < MIN_OCCLUDER_COVERAGE) break;
+        const int index = coverage[i].second;
+        const QVector<float>& occluder = items[index].occluder;
+        m_occlusionCuller.drawOccluder(matrices[index].constData(),
+                occluder.constData(), occluder.count() / 9);
+    }
+    m_occlusionCuller.buildHierarchy();
+
+    QVector<bool> visible(items.count());
+    for(int i = 0; i < items.count(); ++i) {
+        visible[i] = m_occlusionCuller.isVisible(
+                matrices[i].constData(), items[i].min, items[i].max);
+    }
+    return visible;
 }
@@ -1,11 +1,39 @@
 #pragma once
 
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QImage>
 #include <QMatrix4x4>
-#include <QOpenGLFunctions>
 #include <QOpenGLWidget>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QVector2D>
+#include <QVector3D>
+
+#include "ClusterCache.h"
+#include "FrameCapture.h"
+#include "GlRecorder.h"
+#include "MemoryLedger.h"
+#include "ModelTools.h"
+#include "Profiler.h"
+#include "RenderLayer.h"
+#include "ResolutionController.h"
+#include "ShaderCache.h"
+#include "ShaderCompiler.h"
+#include "Scene/BufferDiff.h"
+#include "Scene/Bvh.h"
+#include "Scene/ClusterFile.h"
+#include "Scene/OcclusionCuller.h"
+#include "Scene/PointOctree.h"
+#include "Scene/Scene.h"
+#include "StreamingBuffer.h"
+#include "TaskGraph.h"
+#include "TextureStreamer.h"
 
 class QOpenGLShaderProgram;
-class QOpenGLTexture;
 
 enum class Projection
 {
@@ -14,11 +42,21 @@ enum class Projection
 };
 
 //=============================================================================
-class GlWidget final : public QOpenGLWidget, private QOpenGLFunctions
+class GlWidget final : public QOpenGLWidget, private RecordingFunctions
 {
     Q_OBJECT;
 
 public:
+    struct PickResult
+    {
+        bool hit = false;
+        int face = -1;
+        int vertex = -1;
+        QVector3D position;
+        QVector3D normal;
+        QVector2D textureCoord;
+    };
+
     GlWidget(QWidget *parent_p = nullptr);
     ~GlWidget() override;
 
@@ -26,17 +64,56 @@ public:
             const QString& fragmentSource);
 
     void setModel(const QString& modelPath);
+
+    // Replaces the model's geometry (ModelTools vertex layout) from the next
+    // frame on; meant to be called once per frame for animated data.
+    void pushModelVertices(const QVector<GLfloat>& vertices);
+
+    int addSceneModel(const QString& modelPath,
+            const QMatrix4x4& transform = QMatrix4x4());
+    void removeSceneModel(int id);
+    void setSceneModelTransform(int id, const QMatrix4x4& transform);
+    void clearScene();
+
     void setModelAngle(int degrees);
     void setProjection(Projection p);
+    void setPointBudget(int points);
+    void setClusterBudget(qint64 bytes);
+    void setTextureBudget(qint64 bytes);
+
+    // The frame time that dynamic resolution aims for.
+    void setFrameBudget(double ms);
+
+    PickResult pick(const QPoint& point);
+
+    bool exportTrace(const QString& path);
+    bool exportClusters(const QString& path);
+
+    bool startRecording(const QString& directory,
+            FrameCapture::Format format = FrameCapture::Format::PNG);
+    void stopRecording();
+    bool isRecording() const;
+
+    // Records the GL commands of the next few frames into a GlCapture file
+    // that gl-lnl-replay can play back without the viewer.
+    bool captureFrames(const QString& path, int frames);
+
+    const MemoryLedger& memoryUsage() const;
 
 signals:
     void notify(const QString& text);
+    void dynamicResolutionChanged(bool enabled);
 
 public slots:
     void enableFaceCulling(bool enable);
     void enableDepthTesting(bool enable);
     void enableFacetedRender(bool enable);
     void enableVisibleNormals(bool enable);
+    void enableStatsOverlay(bool enable);
+    void enablePointCloud(bool enable);
+    void enableOcclusionCulling(bool enable);
+    void enableDynamicResolution(bool enable);
+    void enableSharpenUpscale(bool enable);
 
 protected:
     void mousePressEvent(QMouseEvent *event_p) override;
@@ -50,22 +127,139 @@ protected:
 
 private slots:
     void cleanup();
+    void shadersCompiled(quint64 id, QOpenGLShaderProgram *program_p,
+            const QString& log, ShaderCache::Status status);
 
 private:
+    struct ModelFile
+    {
+        QString path;
+        quint64 generation = 0;
+        QVector<GLfloat> data;
+        QVector<int> vertexIndices;
+        // Every PLY vertex, filled along with the vertex indices.
+        QVector<GLfloat> points;
+        qint64 fileBytes = 0;
+        qint64 plyBytes = 0;
+        QByteArray contentHash;
+        QString error;
+
+        // Filled by the loader for the main model and scene meshes.
+        QVector<GLfloat> smoothArrows;
+        QVector<GLfloat> facetedArrows;
+        QSharedPointer<const MipChain> textureMips;
+        QByteArray textureHash;
+        float uvDensity = 0.0f;
+    };
+
+    struct Ornaments
+    {
+        QImage gridImage;
+        QImage arrowImage;
+        QSharedPointer<const MipChain> atlasMips;
+        QByteArray atlasKey;
+        int maxMipLevel = 0;
+        bool packed = false;
+    };
+
+    struct ModelReload
+    {
+        quint64 generation = 0;
+        ModelFile model;
+        QVector<BufferDiff::Range> ranges;
+        QByteArray textureHash;
+        QSharedPointer<const MipChain> textureMips;
+        bool textureChanged = false;
+    };
+
+    struct ModelChunk
+    {
+        quint64 generation;
+        int firstFace;
+        int faceCount;
+        QVector<GLfloat> data;
+    };
+
+    static ModelFile readModelFile(const QString& path,
+            bool withVertexIndices,
+            const FaceChunkHandler& chunkHandler = FaceChunkHandler());
+    static bool readModelBytes(ModelFile *model_p, QByteArray *bytes_p);
+    static void hashModelBytes(ModelFile *model_p, const QByteArray& bytes);
+    static bool parseModelBytes(ModelFile *model_p, const QByteArray& bytes,
+            PlyModel *ply_p);
+    static void convertModel(ModelFile *model_p, PlyModel ply,
+            bool withVertexIndices, const FaceChunkHandler& chunkHandler);
+    static QImage readTextureImage(const QString& modelPath,
+            QByteArray *hash_p = nullptr,
+            const QByteArray& unchangedHash = QByteArray());
+
     void updateViewMatrix();
     void updateProjectionMatrix();
     void buildShaders();
+    void setProgram(QOpenGLShaderProgram *program_p,
+            ShaderCache::Status status);
+    QOpenGLShaderProgram *buildSharedProgram(const QString& vertexSource,
+            const QString& fragmentSource, QString *log_p,
+            ShaderCache::Status *status_p);
     void buildOrnamentShaders();
+    int addModelFileTasks(const QSharedPointer<ModelFile>& model_p,
+            bool withVertexIndices,
+            const FaceChunkHandler& chunkHandler = FaceChunkHandler());
+    void runLoaderTasks();
     void loadModel();
+    void uploadModelChunks();
+    void shareModelBuffer(const QByteArray& contentHash);
+    void releaseModel();
+    void loadPointModel(const ModelFile& model);
+    void buildDerivedData(const ModelFile& model);
+    void buildPointCloud(const QVector<GLfloat>& points);
+    void watchModelFile();
+    void reloadModel();
+    void applyModelReload();
+    int addTexture(const QSharedPointer<const MipChain>& mips_p,
+            float uvDensity, const QByteArray& hash = QByteArray());
+    void requestTexture(int texture, const QMatrix4x4& modelView,
+            const float *min_p, const float *max_p,
+            float renderScale = 1.0f);
+    void updateTextures();
+    void loadSceneModels();
+    void loadSceneMesh(const QString& path);
+    void addSceneMesh(const ModelFile& mesh);
+    void uploadStreamedVertices();
+    void uploadPointCloud();
+    void drawPointCloud();
+    GLuint storedFaceNormals();
+    void releaseFaceNormals();
+    void loadClusterFile();
+    void drawClusters();
+    void drawScene();
+    QVector<bool> cullSceneItems(const QList<Scene::DrawItem>& items);
     void loadOrnaments();
-    void loadNormals(GLfloat *data_p, int vertexCount);
+    void uploadOrnaments(const Ornaments& ornaments);
+    void uploadOrnamentBuffer();
+    void initializeLayers();
+    void drawOrnaments(bool grid, bool normals);
+    void drawOrnamentLayers();
+    void compositeLayer(const RenderLayer& layer);
+    void updateRenderScale();
+    void measureFrame();
+    bool beginSceneTarget();
+    void upscaleSceneTarget();
+    void loadNormals(const ModelFile& model);
     void drawNormals();
+    void drawStats();
+    void recordResidentBuffers();
 
     // ==== Misc. Options ====
     bool m_enableFaceCulling;
     bool m_enableDepthTesting;
     bool m_enableFacetedRender;
     bool m_enableVisibleNormals;
+    bool m_enableStatsOverlay;
+    bool m_enablePointCloud;
+    bool m_enableOcclusionCulling;
+    bool m_enableDynamicResolution;
+    bool m_enableSharpenUpscale;
 
     // ==== View Matrix ====
     bool m_mouseActive;
@@ -86,22 +280,150 @@ private:
     bool m_modelChanged;
     GLuint m_modelBuffer;
     int m_modelVertexCount;
-    QOpenGLTexture *m_texture_p;
+
+    // Face normals for the faceted render with a shader that does not
+    // derive them itself; see storedFaceNormals().
+    GLuint m_faceNormalBuffer;
+
+    int m_modelTexture;
+    float m_modelMin[3];
+    float m_modelMax[3];
+
+    // Models are read and converted by the loader.  Converted faces arrive
+    // in chunks that are drawn as they land in the model buffer; the
+    // finished load then fills in everything that needs the whole mesh.
+    bool m_modelLoading;
+    ModelFile m_loadedModel;
+    quint64 m_modelGeneration;
+    QList<ModelChunk> m_modelChunks;
+    quint64 m_chunkGeneration;
+    int m_modelCapacity;
+    QElapsedTimer m_modelLoadClock;
+    qint64 m_firstChunkMs;
+
+    // The model file is watched and reparsed in the background when it
+    // changes; only the vertex ranges that differ from what is on the GPU
+    // are uploaded again, and the texture is kept unless its file changed.
+    QFileSystemWatcher m_modelFileWatcher;
+    QTimer m_reloadTimer;
+    QFutureWatcher<ModelReload> m_reloadWatcher;
+    ModelReload m_modelReload;
+    bool m_modelReloaded;
+    bool m_reloadPending;
+    QByteArray m_textureHash;
 
     QMatrix4x4 m_modelMatrix;
 
+    // ==== Picking ====
+    QVector<GLfloat> m_pickData;
+    QVector<int> m_pickVertexIndices;
+    QFuture<QSharedPointer<Bvh>> m_pickBvh;
+
+    // ==== Point Cloud ====
+    QFutureWatcher<QSharedPointer<PointOctree>> m_pointCloudWatcher;
+    QSharedPointer<PointOctree> m_pointCloud;
+    bool m_pointCloudChanged;
+    quint64 m_pointCloudGeneration;
+    bool m_pointsOnly;
+    GLuint m_pointBuffer;
+    int m_pointBudget;
+    int m_pointsDrawn;
+
+    // ==== Out-of-core Model ====
+    QSharedPointer<ClusterFile> m_clusterFile;
+    bool m_clusterFileChanged;
+    ClusterCache m_clusterCache;
+
+    // ==== Streamed Model Geometry ====
+    StreamingBuffer m_streamingBuffer;
+    QVector<GLfloat> m_streamedVertices;
+    bool m_streamChanged;
+    GLuint m_streamBuffer;
+    int m_streamVertexCount;
+
+    // ==== Scene ====
+    struct SceneRequest
+    {
+        enum class Type
+        {
+            ADD,
+            REMOVE,
+            TRANSFORM,
+            CLEAR
+        };
+
+        Type type;
+        int id;
+        QString path;
+        QMatrix4x4 transform;
+    };
+
+    Scene m_scene;
+    QList<SceneRequest> m_sceneRequests;
+    int m_nextSceneId;
+
+    // Meshes being loaded (true) or that failed to load (false).
+    QHash<QString, bool> m_sceneLoads;
+
+    // The largest instances on screen are drawn into a small CPU depth
+    // buffer each frame, and instances whose bounds are hidden behind them
+    // are not drawn.
+    OcclusionCuller m_occlusionCuller;
+
+    // ==== Ornaments ====
+    GLuint m_ornamentBuffer;
+    int m_ornamentTexture;
+    int m_ornamentTextureLevel;
+
     // ==== Grid ====
-    GLuint m_gridBuffer;
+    int m_gridFirst;
     int m_gridVertexCount;
-    QOpenGLTexture *m_gridTexture_p;
 
     // ==== Arrows ====
-    GLuint m_arrowBuffer;
+    int m_arrowFirst;
     int m_arrowVertexCount;
-    QOpenGLTexture *m_arrowTexture_p;
 
-    QList<QMatrix4x4> m_smoothArrows;
-    QList<QMatrix4x4> m_facetedArrows;
+    QVector<GLfloat> m_smoothArrows;
+    QVector<GLfloat> m_facetedArrows;
+    quint32 m_arrowGeneration;
+
+    // ==== Layers ====
+    // The grid and the arrows are drawn into offscreen layers that are only
+    // redrawn when their inputs change, then depth-composited over the
+    // model every frame.
+    struct LayerVars {
+        int uColor = -1;
+        int uDepth = -1;
+        int aPosition = -1;
+    };
+
+    bool m_layersAvailable;
+    RenderLayer m_gridLayer;
+    RenderLayer m_arrowLayer;
+    QOpenGLShaderProgram *m_layerProgram_p;
+    LayerVars m_layerVars;
+    GLuint m_layerBuffer;
+
+    // ==== Dynamic Resolution ====
+    // The model pass can be drawn into a smaller target that is upscaled
+    // into the window, depth included, before the ornaments go on top.  The
+    // scale follows the GPU time of the pass, or the frame interval when
+    // there are no timer queries.
+    struct UpscaleVars {
+        int uColor = -1;
+        int uDepth = -1;
+        int uTexelSize = -1;
+        int uSharpness = -1;
+        int aPosition = -1;
+    };
+
+    ResolutionController m_resolution;
+    float m_renderScale;
+    RenderLayer m_sceneTarget;
+    QOpenGLShaderProgram *m_upscaleProgram_p;
+    UpscaleVars m_upscaleVars;
+    QElapsedTimer m_frameClock;
+    double m_frameMs;
 
     // ==== Shaders ====
     struct ShaderVars {
@@ -110,6 +432,8 @@ private:
         int uProjection = -1;
         int uNormalMatrix = -1;
         int uTexture = -1;
+        int uPointSize = -1;
+        int uFaceted = -1;
 
         int aPosition = -1;
         int aNormal = -1;
@@ -125,4 +449,33 @@ private:
     QString m_vertexSource;
     QString m_fragmentSource;
     bool m_shadersChanged;
+
+    ShaderCache m_shaderCache;
+    ShaderCompiler m_shaderCompiler;
+    quint64 m_shaderGeneration;
+
+    // ==== Textures ====
+    // Every texture is a TextureStreamer id.  Draws report how large their
+    // textures appear on screen, and the mip levels that are resident
+    // follow at the end of the frame.  The streamer is shared with the
+    // other views in the share group; this widget is one of its views.
+    TextureStreamer *m_textureStreamer_p;
+    int m_textureView;
+    qint64 m_textureBudget;
+
+    // ==== Loading ====
+    // Reads, parses, conversions and decodes of independent assets run
+    // concurrently on every core.  The uploads they end in run on the
+    // render thread at the start of a frame, most urgent first.
+    TaskGraph m_loader;
+
+    // ==== Profiling ====
+    GpuTimer m_gpuTimer;
+
+    // ==== Recording ====
+    FrameCapture m_frameCapture;
+    int m_captureFramesLeft;
+
+    // ==== Memory accounting ====
+    MemoryLedger m_memory;
 };
@@ -0,0 +1,173 @@
+#include "GpuResources.h"
+
+#include <QCryptographicHash>
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+
+#include "TextureStreamer.h"
+
+namespace {
+    //=========================================================================
+    QOpenGLContextGroup *currentShareGroup()
+    {
+        QOpenGLContext *context_p = QOpenGLContext::currentContext();
+        return context_p ? context_p->shareGroup() : nullptr;
+    }
+}
+
+//=============================================================================
+GpuResources& GpuResources::instance()
+{
+    static GpuResources resources;
+    return resources;
+}
+
+//=============================================================================
+GpuResources::GpuResources()
+{
+}
+
+//=============================================================================
+QByteArray GpuResources::key(const char *kind, const QByteArray& content)
+{
+    return QByteArray(kind) + ':' +
+            QCryptographicHash::hash(content, QCryptographicHash::Sha1);
+}
+
+//=============================================================================
+QByteArray GpuResources::key(const char *kind, const void *data_p,
+        qint64 bytes)
+{
+    return key(kind, QByteArray::fromRawData(
+            static_cast<const char *>(data_p), (int)bytes));
+}
+
+//=============================================================================
+GLuint GpuResources::acquireBuffer(const QByteArray& key)
+{
+    const GLuint buffer = (GLuint)currentGroup().buffers.acquire(key);
+    removeIfEmpty();
+    return buffer;
+}
+
+//=============================================================================
+GLuint GpuResources::shareBuffer(const QByteArray& key, GLuint buffer,
+        qint64 bytes)
+{
+    const GLuint shared =
+            (GLuint)currentGroup().buffers.add(key, buffer, bytes);
+    if(shared != buffer) {
+        QOpenGLContext::currentContext()->functions()->glDeleteBuffers(
+                1, &buffer);
+    }
+    return shared;
+}
+
+//=============================================================================
+bool GpuResources::detachBuffer(GLuint buffer)
+{
+    if(!buffer) return true;
+    const bool detached = currentGroup().buffers.detach(buffer);
+    removeIfEmpty();
+    return detached;
+}
+
+//=============================================================================
+void GpuResources::releaseBuffer(GLuint buffer)
+{
+    if(!buffer) return;
+    if(currentGroup().buffers.release(buffer)) {
+        QOpenGLContext::currentContext()->functions()->glDeleteBuffers(
+                1, &buffer);
+    }
+    removeIfEmpty();
+}
+
+//=============================================================================
+QOpenGLShaderProgram *GpuResources::acquireProgram(const QByteArray& key)
+{
+    auto program_p = reinterpret_cast<QOpenGLShaderProgram *>(
+            currentGroup().programs.acquire(key));
+    removeIfEmpty();
+    return program_p;
+}
+
+//=============================================================================
+// Shared programs belong to the table, so they lose any parent they had.
+QOpenGLShaderProgram *GpuResources::shareProgram(const QByteArray& key,
+        QOpenGLShaderProgram *program_p, qint64 bytes)
+{
+    auto shared_p = reinterpret_cast<QOpenGLShaderProgram *>(
+            currentGroup().programs.add(key,
+            reinterpret_cast<quintptr>(program_p), bytes));
+    if(shared_p != program_p) {
+        delete program_p;
+    } else if(program_p) {
+        program_p->setParent(nullptr);
+    }
+    return shared_p;
+}
+
+//=============================================================================
+void GpuResources::releaseProgram(QOpenGLShaderProgram *program_p)
+{
+    if(!program_p) return;
+    if(currentGroup().programs.release(
+            reinterpret_cast<quintptr>(program_p))) {
+        delete program_p;
+    }
+    removeIfEmpty();
+}
+
+//=============================================================================
+TextureStreamer *GpuResources::acquireTextureStreamer()
+{
+    Group& group = currentGroup();
+    if(!group.streamer_p) group.streamer_p = new TextureStreamer();
+    ++group.streamerUsers;
+    return group.streamer_p;
+}
+
+//=============================================================================
+void GpuResources::releaseTextureStreamer(TextureStreamer *streamer_p)
+{
+    Group& group = currentGroup();
+    if(!streamer_p || streamer_p != group.streamer_p) return;
+    if(--group.streamerUsers == 0) {
+        group.streamer_p->release();
+        delete group.streamer_p;
+        group.streamer_p = nullptr;
+    }
+    removeIfEmpty();
+}
+
+//=============================================================================
+ResourceTable::Stats GpuResources::stats() const
+{
+    const Group group = m_groups.value(currentShareGroup());
+    ResourceTable::Stats stats = group.buffers.stats();
+    const ResourceTable::Stats programs = group.programs.stats();
+    stats.resources += programs.resources;
+    stats.references += programs.references;
+    stats.bytes += programs.bytes;
+    return stats;
+}
+
+//=============================================================================
+GpuResources::Group& GpuResources::currentGroup()
+{
+    return m_groups[currentShareGroup()];
+}
+
+//=============================================================================
+// Groups go away with their last resource, so a share group that Qt frees
+// and later reuses the address of starts out empty.
+void GpuResources::removeIfEmpty()
+{
+    auto group = m_groups.find(currentShareGroup());
+    if(group == m_groups.end()) return;
+    if(group->buffers.isEmpty() && group->programs.isEmpty() &&
+            !group->streamer_p) {
+        (void)m_groups.erase(group);
+    }
+}
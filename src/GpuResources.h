@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QOpenGLFunctions>
+
+#include "ResourceTable.h"
+
+class QOpenGLContextGroup;
+class QOpenGLShaderProgram;
+class TextureStreamer;
+
+//=============================================================================
+// GPU resources that every viewport would otherwise hold a copy of.
+// Buffers and programs are shared under a key made from their contents, so
+// widgets that load the same file or build the same shaders end up with one
+// copy; textures are shared by handing every widget the same
+// TextureStreamer.  Objects can only be shared between contexts of one
+// share group (see Qt::AA_ShareOpenGLContexts), so each group has its own
+// set.  All calls happen on the GUI thread with a context of the group
+// current.  A resource is freed by the release that drops its last user,
+// so a widget that releases what it holds in cleanup() leaves nothing of
+// its own behind.
+class GpuResources
+{
+public:
+    static GpuResources& instance();
+
+    static QByteArray key(const char *kind, const QByteArray& content);
+    static QByteArray key(const char *kind, const void *data_p,
+            qint64 bytes);
+
+    // See ResourceTable for what these return.  Releasing a buffer or a
+    // program that was never shared frees it right away.
+    GLuint acquireBuffer(const QByteArray& key);
+    GLuint shareBuffer(const QByteArray& key, GLuint buffer, qint64 bytes);
+    bool detachBuffer(GLuint buffer);
+    void releaseBuffer(GLuint buffer);
+
+    QOpenGLShaderProgram *acquireProgram(const QByteArray& key);
+    QOpenGLShaderProgram *shareProgram(const QByteArray& key,
+            QOpenGLShaderProgram *program_p, qint64 bytes);
+    void releaseProgram(QOpenGLShaderProgram *program_p);
+
+    TextureStreamer *acquireTextureStreamer();
+    void releaseTextureStreamer(TextureStreamer *streamer_p);
+
+    // Buffers and programs of the current share group.
+    ResourceTable::Stats stats() const;
+
+private:
+    struct Group
+    {
+        ResourceTable buffers;
+        ResourceTable programs;
+        TextureStreamer *streamer_p = nullptr;
+        int streamerUsers = 0;
+    };
+
+    GpuResources();
+
+    Group& currentGroup();
+    void removeIfEmpty();
+
+    QHash<QOpenGLContextGroup *, Group> m_groups;
+};
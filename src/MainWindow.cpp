@@ -1,5 +1,11 @@
 #include "MainWindow.h"
 
+#include <QFileDialog>
+
+namespace {
+    constexpr int CAPTURE_FRAMES = 60;
+}
+
 //=============================================================================
 MainWindow::MainWindow()
 {
@@ -15,11 +21,31 @@ MainWindow::MainWindow()
             ui.glWidget, &GlWidget::enableFacetedRender);
     connect(ui.checkShowNormals, &QCheckBox::toggled,
             ui.glWidget, &GlWidget::enableVisibleNormals);
+    connect(ui.checkShowStats, &QCheckBox::toggled,
+            ui.glWidget, &GlWidget::enableStatsOverlay);
+    connect(ui.checkPointCloud, &QCheckBox::toggled,
+            ui.glWidget, &GlWidget::enablePointCloud);
+    connect(ui.checkOcclusionCulling, &QCheckBox::toggled,
+            ui.glWidget, &GlWidget::enableOcclusionCulling);
+    connect(ui.checkDynamicResolution, &QCheckBox::toggled,
+            ui.glWidget, &GlWidget::enableDynamicResolution);
+    connect(ui.checkSharpenUpscale, &QCheckBox::toggled,
+            ui.glWidget, &GlWidget::enableSharpenUpscale);
+    connect(ui.glWidget, &GlWidget::dynamicResolutionChanged,
+            ui.checkDynamicResolution, &QCheckBox::setChecked);
 
     ui.glWidget->enableFaceCulling(ui.checkFaceCulling->isChecked());
     ui.glWidget->enableDepthTesting(ui.checkDepthTesting->isChecked());
     ui.glWidget->enableFacetedRender(ui.checkFaceNormals->isChecked());
     ui.glWidget->enableVisibleNormals(ui.checkShowNormals->isChecked());
+    ui.glWidget->enableStatsOverlay(ui.checkShowStats->isChecked());
+    ui.glWidget->enablePointCloud(ui.checkPointCloud->isChecked());
+    ui.glWidget->enableOcclusionCulling(
+            ui.checkOcclusionCulling->isChecked());
+    ui.glWidget->enableDynamicResolution(
+            ui.checkDynamicResolution->isChecked());
+    ui.glWidget->enableSharpenUpscale(ui.checkSharpenUpscale->isChecked());
+    ui.glWidget->setFrameBudget(ui.spinFrameBudget->value());
 
     ui.radioPerspective->click();
 }
@@ -37,12 +63,71 @@ void MainWindow::on_buttonInstall_clicked()
     ui.glWidget->installShaders(vertexSource, fragmentSource);
 }
 
+//=============================================================================
+void MainWindow::on_buttonOpenModel_clicked()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "Open Model",
+            QString(), "Models (*.ply *.glc);;PLY (*.ply);;"
+            "Clustered Mesh (*.glc)");
+    if(path.isEmpty()) return;
+    ui.glWidget->setModel(path);
+}
+
+//=============================================================================
+void MainWindow::on_buttonExportClusters_clicked()
+{
+    const QString path = QFileDialog::getSaveFileName(this,
+            "Export Clusters", "model.glc", "Clustered Mesh (*.glc)");
+    if(path.isEmpty()) return;
+    (void)ui.glWidget->exportClusters(path);
+}
+
+//=============================================================================
+void MainWindow::on_buttonExportTrace_clicked()
+{
+    const QString path = QFileDialog::getSaveFileName(this,
+            "Export Trace", "trace.json", "Chrome Trace (*.json)");
+    if(path.isEmpty()) return;
+    (void)ui.glWidget->exportTrace(path);
+}
+
+//=============================================================================
+void MainWindow::on_buttonCaptureGl_clicked()
+{
+    const QString path = QFileDialog::getSaveFileName(this,
+            "Capture GL Frames", "frames.glcap", "GL Capture (*.glcap)");
+    if(path.isEmpty()) return;
+    (void)ui.glWidget->captureFrames(path, CAPTURE_FRAMES);
+}
+
+//=============================================================================
+void MainWindow::on_buttonRecord_toggled(bool checked)
+{
+    if(!checked) {
+        ui.glWidget->stopRecording();
+        return;
+    }
+
+    const QString directory = QFileDialog::getExistingDirectory(this,
+            "Record Frames");
+    if(directory.isEmpty() || !ui.glWidget->startRecording(directory)) {
+        const QSignalBlocker blocker(ui.buttonRecord);
+        ui.buttonRecord->setChecked(false);
+    }
+}
+
 //=============================================================================
 void MainWindow::on_sliderModelAngle_valueChanged(int degrees)
 {
     ui.glWidget->setModelAngle(degrees);
 }
 
+//=============================================================================
+void MainWindow::on_spinFrameBudget_valueChanged(int ms)
+{
+    ui.glWidget->setFrameBudget(ms);
+}
+
 //=============================================================================
 void MainWindow::on_radioOrthographic_toggled(bool)
 {
@@ -15,7 +15,13 @@ public:
 
 private slots:
     void on_buttonInstall_clicked();
+    void on_buttonOpenModel_clicked();
+    void on_buttonExportClusters_clicked();
+    void on_buttonExportTrace_clicked();
+    void on_buttonCaptureGl_clicked();
+    void on_buttonRecord_toggled(bool checked);
     void on_sliderModelAngle_valueChanged(int degrees);
+    void on_spinFrameBudget_valueChanged(int ms);
     void on_radioOrthographic_toggled(bool);
     void on_radioPerspective_toggled(bool);
     void on_glWidget_notify(const QString& text);
@@ -0,0 +1,139 @@
+#include "MemoryLedger.h"
+
+#include <QStringList>
+
+namespace {
+    bool inGroup(const QString& name, const QString& prefix)
+    {
+        return prefix.isEmpty() || name == prefix ||
+                name.startsWith(prefix + "/");
+    }
+}
+
+//=============================================================================
+MemoryLedger::MemoryLedger()
+{
+}
+
+//=============================================================================
+void MemoryLedger::set(const QString& name, qint64 cpuBytes, qint64 gpuBytes,
+        bool transient)
+{
+    Entry entry;
+    entry.name = name;
+    entry.cpuBytes = cpuBytes;
+    entry.gpuBytes = gpuBytes;
+    entry.transient = transient;
+    (void)m_entries.insert(name, entry);
+}
+
+//=============================================================================
+void MemoryLedger::remove(const QString& name)
+{
+    (void)m_entries.remove(name);
+}
+
+//=============================================================================
+void MemoryLedger::removeGroup(const QString& prefix)
+{
+    for(auto it = m_entries.begin(); it != m_entries.end();) {
+        if(inGroup(it.key(), prefix)) {
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+//=============================================================================
+void MemoryLedger::clear()
+{
+    m_entries.clear();
+}
+
+//=============================================================================
+MemoryLedger::Entry MemoryLedger::entry(const QString& name) const
+{
+    return m_entries.value(name);
+}
+
+//=============================================================================
+QList<MemoryLedger::Entry> MemoryLedger::entries(const QString& prefix) const
+{
+    QList<Entry> result;
+    for(const auto& entry : m_entries) {
+        if(inGroup(entry.name, prefix)) result.append(entry);
+    }
+    return result;
+}
+
+//=============================================================================
+qint64 MemoryLedger::cpuBytes(const QString& prefix) const
+{
+    qint64 bytes = 0;
+    for(const auto& entry : m_entries) {
+        if(!entry.transient && inGroup(entry.name, prefix)) {
+            bytes += entry.cpuBytes;
+        }
+    }
+    return bytes;
+}
+
+//=============================================================================
+qint64 MemoryLedger::gpuBytes(const QString& prefix) const
+{
+    qint64 bytes = 0;
+    for(const auto& entry : m_entries) {
+        if(!entry.transient && inGroup(entry.name, prefix)) {
+            bytes += entry.gpuBytes;
+        }
+    }
+    return bytes;
+}
+
+//=============================================================================
+QString MemoryLedger::describe(const QString& prefix) const
+{
+    QStringList parts;
+    for(const auto& entry : entries(prefix)) {
+        QStringList sizes;
+        if(entry.cpuBytes) {
+            sizes.append(QString("CPU %1").arg(formatBytes(entry.cpuBytes)));
+        }
+        if(entry.gpuBytes) {
+            sizes.append(QString("GPU %1").arg(formatBytes(entry.gpuBytes)));
+        }
+        if(sizes.isEmpty()) continue;
+        parts.append(QString("%1 %2%3").arg(entry.name)
+                .arg(sizes.join(" + "))
+                .arg(entry.transient ? " (peak, freed)" : ""));
+    }
+    parts.append(QString("total CPU %1, GPU %2")
+            .arg(formatBytes(cpuBytes(prefix)))
+            .arg(formatBytes(gpuBytes(prefix))));
+    return parts.join(", ");
+}
+
+//=============================================================================
+qint64 MemoryLedger::textureBytes(int width, int height, int mipLevels,
+        int bytesPerTexel)
+{
+    qint64 bytes = 0;
+    for(int level = 0; level < qMax(mipLevels, 1); ++level) {
+        bytes += (qint64)width * height * bytesPerTexel;
+        if(width == 1 && height == 1) break;
+        width = qMax(width / 2, 1);
+        height = qMax(height / 2, 1);
+    }
+    return bytes;
+}
+
+//=============================================================================
+QString MemoryLedger::formatBytes(qint64 bytes)
+{
+    if(bytes < 1024) return QString("%1 B").arg(bytes);
+    if(bytes < 1024 * 1024) {
+        return QString("%1 KiB").arg(bytes / 1024.0, 0, 'f', 1);
+    }
+    return QString("%1 MiB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QList>
+#include <QMap>
+#include <QString>
+
+//=============================================================================
+// Byte counts for every resource the viewer holds, keyed by a slash-separated
+// name such as "model/vbo".  GPU sizes are what was requested from GL, so
+// they are lower bounds on what the driver actually reserves.  Transient
+// entries record the peak size of data that was freed after loading.
+class MemoryLedger
+{
+public:
+    struct Entry
+    {
+        QString name;
+        qint64 cpuBytes = 0;
+        qint64 gpuBytes = 0;
+        bool transient = false;
+    };
+
+    MemoryLedger();
+
+    void set(const QString& name, qint64 cpuBytes, qint64 gpuBytes,
+            bool transient = false);
+    void remove(const QString& name);
+    void removeGroup(const QString& prefix);
+    void clear();
+
+    Entry entry(const QString& name) const;
+    QList<Entry> entries(const QString& prefix = QString()) const;
+    qint64 cpuBytes(const QString& prefix = QString()) const;
+    qint64 gpuBytes(const QString& prefix = QString()) const;
+
+    QString describe(const QString& prefix = QString()) const;
+
+    static qint64 textureBytes(int width, int height, int mipLevels,
+            int bytesPerTexel = 4);
+    static QString formatBytes(qint64 bytes);
+
+private:
+    QMap<QString, Entry> m_entries;
+};
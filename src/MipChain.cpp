@@ -0,0 +1,167 @@
+#include "MipChain.h"
+
+#include <QtConcurrent>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MIP_CHAIN_SSE2
+#endif
+
+//=============================================================================
+int MipChain::fullLevelCount(int width, int height)
+{
+    int count = 1;
+    while(width > 1 || height > 1) {
+        width = qMax(width / 2, 1);
+        height = qMax(height / 2, 1);
+        ++count;
+    }
+    return count;
+}
+
+//=============================================================================
+MipChain::MipChain()
+{
+}
+
+//=============================================================================
+void MipChain::build(const uchar *pixels_p, int width, int height,
+        int bytesPerLine)
+{
+    m_levels.clear();
+    if(width <= 0 || height <= 0) return;
+
+    Level base;
+    base.width = width;
+    base.height = height;
+    base.pixels.resize(width * height * 4);
+    for(int y = 0; y < height; ++y) {
+        std::memcpy(base.pixels.data() + y * width * 4,
+                pixels_p + y * bytesPerLine, width * 4);
+    }
+    m_levels.reserve(fullLevelCount(width, height));
+    m_levels.append(base);
+
+    while(m_levels.last().width > 1 || m_levels.last().height > 1) {
+        const Level& fine = m_levels.last();
+        Level coarse;
+        coarse.width = qMax(fine.width / 2, 1);
+        coarse.height = qMax(fine.height / 2, 1);
+        coarse.pixels.resize(coarse.width * coarse.height * 4);
+
+        if(coarse.height < 2 * BAND_ROWS) {
+            downsample(fine, &coarse, 0, coarse.height);
+        } else {
+            QVector<int> bands;
+            for(int row = 0; row < coarse.height; row += BAND_ROWS) {
+                bands.append(row);
+            }
+            Level *coarse_p = &coarse;
+            QtConcurrent::blockingMap(bands, [&fine, coarse_p](int row) {
+                const int rows = coarse_p->height - row;
+                downsample(fine, coarse_p, row,
+                        rows < BAND_ROWS ? rows : (int)BAND_ROWS);
+            });
+        }
+        m_levels.append(coarse);
+    }
+}
+
+//=============================================================================
+bool MipChain::isEmpty() const
+{
+    return m_levels.isEmpty();
+}
+
+//=============================================================================
+int MipChain::levelCount() const
+{
+    return m_levels.count();
+}
+
+//=============================================================================
+const MipChain::Level& MipChain::level(int index) const
+{
+    return m_levels[index];
+}
+
+//=============================================================================
+qint64 MipChain::bytes(int first) const
+{
+    qint64 bytes = 0;
+    for(int i = qMax(first, 0); i < m_levels.count(); ++i) {
+        bytes += m_levels[i].pixels.size();
+    }
+    return bytes;
+}
+
+//=============================================================================
+// Fills rows [firstRow, firstRow + rowCount) of coarse_p.  The pixel
+// buffers are detached before the bands start, so bands only ever write
+// their own rows.
+void MipChain::downsample(const Level& fine, Level *coarse_p, int firstRow,
+        int rowCount)
+{
+    const int fineStride = fine.width * 4;
+    const uchar *finePixels_p =
+            reinterpret_cast<const uchar *>(fine.pixels.constData());
+    uchar *coarsePixels_p = reinterpret_cast<uchar *>(
+            const_cast<char *>(coarse_p->pixels.constData()));
+
+    for(int y = firstRow; y < firstRow + rowCount; ++y) {
+        const uchar *row0_p = finePixels_p +
+                qMin(2 * y, fine.height - 1) * fineStride;
+        const uchar *row1_p = finePixels_p +
+                qMin(2 * y + 1, fine.height - 1) * fineStride;
+        uchar *out_p = coarsePixels_p + y * coarse_p->width * 4;
+
+        int x = 0;
+#ifdef MIP_CHAIN_SSE2
+        // Four output texels from eight input texels on each row.  The
+        // horizontal pairs are summed by adding each register to itself
+        // shifted by one texel, then the even texels are gathered.
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i rounding = _mm_set1_epi16(2);
+        for(; 2 * x + 8 <= fine.width; x += 4) {
+            const __m128i *a_p =
+                    reinterpret_cast<const __m128i *>(row0_p + 8 * x);
+            const __m128i *b_p =
+                    reinterpret_cast<const __m128i *>(row1_p + 8 * x);
+            const __m128i a0 = _mm_loadu_si128(a_p);
+            const __m128i a1 = _mm_loadu_si128(a_p + 1);
+            const __m128i b0 = _mm_loadu_si128(b_p);
+            const __m128i b1 = _mm_loadu_si128(b_p + 1);
+
+            __m128i sums[4] = {
+                _mm_add_epi16(_mm_unpacklo_epi8(a0, zero),
+                        _mm_unpacklo_epi8(b0, zero)),
+                _mm_add_epi16(_mm_unpackhi_epi8(a0, zero),
+                        _mm_unpackhi_epi8(b0, zero)),
+                _mm_add_epi16(_mm_unpacklo_epi8(a1, zero),
+                        _mm_unpacklo_epi8(b1, zero)),
+                _mm_add_epi16(_mm_unpackhi_epi8(a1, zero),
+                        _mm_unpackhi_epi8(b1, zero))
+            };
+            for(auto& sum : sums) {
+                sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+            }
+            const __m128i low = _mm_srli_epi16(_mm_add_epi16(
+                    _mm_unpacklo_epi64(sums[0], sums[1]), rounding), 2);
+            const __m128i high = _mm_srli_epi16(_mm_add_epi16(
+                    _mm_unpacklo_epi64(sums[2], sums[3]), rounding), 2);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out_p + 4 * x),
+                    _mm_packus_epi16(low, high));
+        }
+#endif
+        for(; x < coarse_p->width; ++x) {
+            const int x0 = qMin(2 * x, fine.width - 1) * 4;
+            const int x1 = qMin(2 * x + 1, fine.width - 1) * 4;
+            for(int c = 0; c < 4; ++c) {
+                out_p[4 * x + c] = (uchar)((row0_p[x0 + c] +
+                        row0_p[x1 + c] + row1_p[x0 + c] + row1_p[x1 + c] +
+                        2) >> 2);
+            }
+        }
+    }
+}
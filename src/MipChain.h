@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QByteArray>
+#include <QVector>
+
+//=============================================================================
+// The mip levels of an RGBA8 image, built on the CPU so they can be
+// uploaded one level at a time.  Each level is a 2x2 box filter of the one
+// above it.  Sizes halve rounding down like GL's own, so an odd last row
+// or column is left out.  Eight source texels are filtered at a time with
+// SSE2 where available, and large levels are split into bands of rows
+// that run on the thread pool.
+class MipChain
+{
+public:
+    struct Level
+    {
+        int width = 0;
+        int height = 0;
+        QByteArray pixels; // Tightly packed RGBA.
+    };
+
+    static constexpr int BAND_ROWS = 64;
+
+    static int fullLevelCount(int width, int height);
+
+    MipChain();
+
+    // bytesPerLine may include padding; the chain itself has none.
+    void build(const uchar *pixels_p, int width, int height,
+            int bytesPerLine);
+
+    bool isEmpty() const;
+    int levelCount() const;
+    const Level& level(int index) const;
+
+    // The size of the levels from first down to 1x1.
+    qint64 bytes(int first = 0) const;
+
+private:
+    static void downsample(const Level& fine, Level *coarse_p, int firstRow,
+            int rowCount);
+
+    QVector<Level> m_levels;
+};
@@ -3,7 +3,26 @@
 #include <QList>
 #include <QSet>
 #include <QString>
-#include <QVector3D>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    //=========================================================================
+    // (p2 - p1) x (p3 - p2) for the triangle whose first vertex is at
+    // triangle_p.
+    void faceNormal(const GLfloat *triangle_p, float *normal_p)
+    {
+        const GLfloat *p1 = triangle_p;
+        const GLfloat *p2 = p1 + NUM_VERTEX_VALUES;
+        const GLfloat *p3 = p2 + NUM_VERTEX_VALUES;
+        const float a[3] = { p2[0] - p1[0], p2[1] - p1[1], p2[2] - p1[2] };
+        const float b[3] = { p3[0] - p2[0], p3[1] - p2[1], p3[2] - p2[2] };
+        normal_p[0] = a[1] * b[2] - a[2] * b[1];
+        normal_p[1] = a[2] * b[0] - a[0] * b[2];
+        normal_p[2] = a[0] * b[1] - a[1] * b[0];
+    }
+}
 
 //=============================================================================
 QVector<GLfloat> makeGrid(int w, int h)
@@ -41,9 +60,6 @@ QVector<GLfloat> makeGrid(int w, int h)
                 data.append(0.0f); // nx
                 data.append(0.0f); // ny
                 data.append(1.0f); // nz
-                data.append(0.0f); // fnx
-                data.append(0.0f); // fny
-                data.append(1.0f); // fnz
                 data.append(textureCoords[i].x); // s
                 data.append(textureCoords[i].y); // t
             }
@@ -53,7 +69,8 @@ QVector<GLfloat> makeGrid(int w, int h)
 }
 
 //=============================================================================
-QVector<GLfloat> convertPly(PlyModel model)
+QVector<GLfloat> convertPly(PlyModel model, QVector<int> *vertexIndices_p,
+        const FaceChunkHandler& chunkHandler, int chunkFaces)
 {
     struct Vertex
     {
@@ -100,22 +117,15 @@ QVector<GLfloat> convertPly(PlyModel model)
     }
 
     QVector<GLfloat> face_verts;
+    QVector<int> ply_indices;
     const int faceCount = model.count("face");
+    const int valuesPerFace = 3 * NUM_VERTEX_VALUES;
+    chunkFaces = qMax(chunkFaces, 1);
+    int chunkStart = 0;
     for(int f = 0; f < faceCount; ++f) {
         QList<double> indices = model.listValue("face", f, "vertex_indices");
         if(indices.count() != 3) return QVector<GLfloat>();
 
-        QVector3D faceNormal;
-        {
-            Vertex v1 = verts.value(indices.value(0));
-            Vertex v2 = verts.value(indices.value(1));
-            Vertex v3 = verts.value(indices.value(2));
-            QVector3D p1(v1.x, v1.y, v1.z);
-            QVector3D p2(v2.x, v2.y, v2.z);
-            QVector3D p3(v3.x, v3.y, v3.z);
-            faceNormal = QVector3D::crossProduct((p2 - p1), (p3 - p2));
-        }
-
         for(int i = 0; i < indices.count(); ++i) {
             int v = (int)indices.value(i);
             if(v >= verts.count()) return QVector<GLfloat>();
@@ -126,13 +136,213 @@ QVector<GLfloat> convertPly(PlyModel model)
             face_verts.append(vert.nx);
             face_verts.append(vert.ny);
             face_verts.append(vert.nz);
-            face_verts.append(faceNormal.x());
-            face_verts.append(faceNormal.y());
-            face_verts.append(faceNormal.z());
             face_verts.append(vert.s);
             face_verts.append(vert.t);
+            if(vertexIndices_p) ply_indices.append(v);
+        }
+
+        if(chunkHandler && (f + 1 - chunkStart == chunkFaces ||
+                f + 1 == faceCount)) {
+            chunkHandler(face_verts.mid(chunkStart * valuesPerFace),
+                    chunkStart, faceCount);
+            chunkStart = f + 1;
         }
     }
 
+    if(vertexIndices_p) *vertexIndices_p = ply_indices;
     return face_verts;
 }
+
+//=============================================================================
+// One record per PLY vertex, whether or not a face uses it, so scans
+// without faces still have something to show.  Only x, y and z are
+// required; a missing normal points along z and missing texture
+// coordinates are zero.
+QVector<GLfloat> convertPlyVertices(const PlyModel& model)
+{
+    if(!model.elements().contains("vertex")) return QVector<GLfloat>();
+    const QSet<QString> properties = model.scalarProperties("vertex");
+    if(!properties.contains("x")) return QVector<GLfloat>();
+    if(!properties.contains("y")) return QVector<GLfloat>();
+    if(!properties.contains("z")) return QVector<GLfloat>();
+
+    const QString names[NUM_VERTEX_VALUES] = {
+        "x", "y", "z", "nx", "ny", "nz", "s", "t"
+    };
+    const GLfloat defaults[NUM_VERTEX_VALUES] = {
+        0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f
+    };
+    bool present[NUM_VERTEX_VALUES];
+    for(int i = 0; i < NUM_VERTEX_VALUES; ++i) {
+        present[i] = properties.contains(names[i]);
+    }
+
+    const int vertexCount = model.count("vertex");
+    QVector<GLfloat> vertices(vertexCount * NUM_VERTEX_VALUES);
+    GLfloat *vertex_p = vertices.data();
+    for(int v = 0; v < vertexCount; ++v) {
+        for(int i = 0; i < NUM_VERTEX_VALUES; ++i) {
+            *vertex_p++ = present[i] ?
+                    (GLfloat)model.scalarValue("vertex", v, names[i]) :
+                    defaults[i];
+        }
+    }
+    return vertices;
+}
+
+//=============================================================================
+// Every vertex gets the unnormalized normal of its triangle, wound the same
+// way as the triangle.
+QVector<GLfloat> makeFaceNormals(const QVector<GLfloat>& data)
+{
+    const int faceCount = data.count() / (3 * NUM_VERTEX_VALUES);
+    QVector<GLfloat> normals(faceCount * 3 * NUM_FACE_NORMAL_VALUES);
+    GLfloat *normal_p = normals.data();
+    for(int f = 0; f < faceCount; ++f) {
+        float normal[3];
+        faceNormal(data.constData() + f * 3 * NUM_VERTEX_VALUES, normal);
+        for(int corner = 0; corner < 3; ++corner) {
+            *normal_p++ = normal[0];
+            *normal_p++ = normal[1];
+            *normal_p++ = normal[2];
+        }
+    }
+    return normals;
+}
+
+//=============================================================================
+void remapTextureCoords(QVector<GLfloat>& data, const QRectF& rect)
+{
+    const int s = TEXTURE_COORD_OFFSET / sizeof(GLfloat);
+    const int vertexCount = data.count() / NUM_VERTEX_VALUES;
+    GLfloat *data_p = data.data();
+    for(int i = 0; i < vertexCount; ++i) {
+        auto v = data_p + (i * NUM_VERTEX_VALUES);
+        v[s] = rect.x() + v[s] * rect.width();
+        v[s + 1] = rect.y() + v[s + 1] * rect.height();
+    }
+}
+
+//=============================================================================
+// The box around every vertex position; all zeros for empty data.
+void computeBounds(const QVector<GLfloat>& data, float *min_p, float *max_p)
+{
+    const int vertexCount = data.count() / NUM_VERTEX_VALUES;
+    for(int i = 0; i < 3; ++i) {
+        min_p[i] = vertexCount > 0 ? data[i] : 0.0f;
+        max_p[i] = min_p[i];
+    }
+    for(int v = 1; v < vertexCount; ++v) {
+        const GLfloat *position_p = data.constData() + v * NUM_VERTEX_VALUES;
+        for(int i = 0; i < 3; ++i) {
+            min_p[i] = qMin(min_p[i], position_p[i]);
+            max_p[i] = qMax(max_p[i], position_p[i]);
+        }
+    }
+}
+
+//=============================================================================
+void makeArrowTransforms(const GLfloat *data_p, int first, int count,
+        intptr_t normalOffset, GLfloat *transforms_p)
+{
+    // Vertices are gathered into blocks of structure-of-arrays data so the
+    // inner loop has no branches and can be vectorized by the compiler.
+    constexpr int BLOCK = 8;
+    const bool faceNormals = normalOffset == FACE_NORMALS;
+    const int n = normalOffset / sizeof(GLfloat);
+
+    for(int base = first; base < first + count; base += BLOCK) {
+        const int blockSize = std::min(BLOCK, first + count - base);
+
+        float px[BLOCK], py[BLOCK], pz[BLOCK];
+        float nx[BLOCK], ny[BLOCK], nz[BLOCK];
+        for(int i = 0; i < BLOCK; ++i) {
+            const int vertex = base + std::min(i, blockSize - 1);
+            const GLfloat *v = data_p + vertex * NUM_VERTEX_VALUES;
+            px[i] = v[0];
+            py[i] = v[1];
+            pz[i] = v[2];
+            if(faceNormals) {
+                float normal[3];
+                faceNormal(data_p +
+                        (vertex - vertex % 3) * NUM_VERTEX_VALUES, normal);
+                nx[i] = normal[0];
+                ny[i] = normal[1];
+                nz[i] = normal[2];
+            } else {
+                nx[i] = v[n];
+                ny[i] = v[n + 1];
+                nz[i] = v[n + 2];
+            }
+        }
+
+        // Rotation taking +z onto the normal (as QQuaternion::rotationTo):
+        //   R = I + [v]x + [v]x^2 / (1 + z),  v = z_axis x normal
+        // An exactly opposite normal becomes a half turn about +y, and a
+        // zero-length normal leaves the arrow pointing up.
+        float m[ARROW_TRANSFORM_VALUES][BLOCK];
+        for(int i = 0; i < BLOCK; ++i) {
+            const float lengthSquared =
+                    nx[i]*nx[i] + ny[i]*ny[i] + nz[i]*nz[i];
+            const float valid = lengthSquared > 1e-20f ? 1.0f : 0.0f;
+            const float inverse =
+                    valid / std::sqrt(std::max(lengthSquared, 1e-20f));
+            const float x = nx[i] * inverse;
+            const float y = ny[i] * inverse;
+            const float z = nz[i] * inverse + (1.0f - valid);
+
+            const float opposite = z < -0.999999f ? 1.0f : 0.0f;
+            const float k = 1.0f / std::max(1.0f + z, 1e-6f);
+            const float keep = 1.0f - opposite;
+
+            m[0][i] = keep * (1.0f - x*x*k) - opposite;
+            m[1][i] = keep * (-x*y*k);
+            m[2][i] = keep * x;
+            m[3][i] = px[i];
+            m[4][i] = keep * (-x*y*k);
+            m[5][i] = keep * (1.0f - y*y*k) + opposite;
+            m[6][i] = keep * y;
+            m[7][i] = py[i];
+            m[8][i] = keep * (-x);
+            m[9][i] = keep * (-y);
+            m[10][i] = keep * z - opposite;
+            m[11][i] = pz[i];
+        }
+
+        GLfloat *out_p = transforms_p + base * ARROW_TRANSFORM_VALUES;
+        for(int i = 0; i < blockSize; ++i) {
+            for(int j = 0; j < ARROW_TRANSFORM_VALUES; ++j) {
+                out_p[i * ARROW_TRANSFORM_VALUES + j] = m[j][i];
+            }
+        }
+    }
+}
+
+//=============================================================================
+QVector<GLfloat> buildArrowTransforms(const QVector<GLfloat>& data,
+        intptr_t normalOffset)
+{
+    constexpr int CHUNK = 16 * 1024;
+
+    const int vertexCount = data.count() / NUM_VERTEX_VALUES;
+    QVector<GLfloat> transforms(vertexCount * ARROW_TRANSFORM_VALUES);
+    const GLfloat *data_p = data.constData();
+    GLfloat *transforms_p = transforms.data();
+
+    if(vertexCount <= CHUNK) {
+        makeArrowTransforms(data_p, 0, vertexCount,
+                normalOffset, transforms_p);
+        return transforms;
+    }
+
+    QVector<int> chunks;
+    for(int first = 0; first < vertexCount; first += CHUNK) {
+        chunks.append(first);
+    }
+    QtConcurrent::blockingMap(chunks, [=](int first) {
+        makeArrowTransforms(data_p, first,
+                std::min(CHUNK, vertexCount - first),
+                normalOffset, transforms_p);
+    });
+    return transforms;
+}
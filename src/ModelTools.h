@@ -1,16 +1,50 @@
 #pragma once
 
 #include <QOpenGLFunctions>
+#include <QRectF>
 #include <QVector>
+#include <functional>
 
 #include "Ply/PlyModel.h"
 
-constexpr int NUM_VERTEX_VALUES = 11;
+constexpr int NUM_VERTEX_VALUES = 8;
 constexpr GLsizei STRIDE = NUM_VERTEX_VALUES * sizeof(GLfloat);
 constexpr intptr_t POSITION_OFFSET = 0;
 constexpr intptr_t NORMAL_OFFSET = 3 * sizeof(GLfloat);
-constexpr intptr_t FACE_NORMAL_OFFSET = 6 * sizeof(GLfloat);
-constexpr intptr_t TEXTURE_COORD_OFFSET = 9 * sizeof(GLfloat);
+constexpr intptr_t TEXTURE_COORD_OFFSET = 6 * sizeof(GLfloat);
+
+// Face normals are not stored with the vertices; shaders derive them from
+// screen-space derivatives.  Where they cannot, makeFaceNormals builds the
+// three values per vertex for a buffer of their own.
+constexpr int NUM_FACE_NORMAL_VALUES = 3;
+
+// Passed to the arrow functions in place of a normal offset, it points
+// every arrow along the normal of its vertex's triangle.  The data then has
+// to hold whole triangles.
+constexpr intptr_t FACE_NORMALS = -1;
+
+// Arrow transforms are stored as row-major 3x4 matrices: rotation | position.
+constexpr int ARROW_TRANSFORM_VALUES = 12;
+
+// convertPly can hand over its output in runs of this many faces while it
+// works.  The handler gets the vertex data for the run, the index of its
+// first face and the total face count of the model.
+constexpr int DEFAULT_CHUNK_FACES = 64 * 1024;
+using FaceChunkHandler = std::function<void(
+        const QVector<GLfloat>& data, int firstFace, int faceCount)>;
 
 QVector<GLfloat> makeGrid(int w, int h);
-QVector<GLfloat> convertPly(PlyModel model);
+QVector<GLfloat> convertPly(PlyModel model,
+        QVector<int> *vertexIndices_p = nullptr,
+        const FaceChunkHandler& chunkHandler = FaceChunkHandler(),
+        int chunkFaces = DEFAULT_CHUNK_FACES);
+QVector<GLfloat> convertPlyVertices(const PlyModel& model);
+QVector<GLfloat> makeFaceNormals(const QVector<GLfloat>& data);
+void remapTextureCoords(QVector<GLfloat>& data, const QRectF& rect);
+void computeBounds(const QVector<GLfloat>& data, float *min_p,
+        float *max_p);
+
+void makeArrowTransforms(const GLfloat *data_p, int first, int count,
+        intptr_t normalOffset, GLfloat *transforms_p);
+QVector<GLfloat> buildArrowTransforms(const QVector<GLfloat>& data,
+        intptr_t normalOffset);
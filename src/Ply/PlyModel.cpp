@@ -13,17 +13,24 @@ PlyModel::ElementBuilder::ElementBuilder(const QString& name, int numExpected)
 }
 
 //=============================================================================
-void PlyModel::ElementBuilder::addScalarProperty(const QString& name)
+void PlyModel::ElementBuilder::addScalarProperty(const QString& name,
+        const QString& type)
 {
     (void)m_element.m_scalarProperties.insert(name, QList<double>());
+    (void)m_element.m_types.insert(name, type);
+    m_element.m_propertyNames.append(name);
     m_propertyNames.append(name);
     (void)m_propertyTypes.insert(name, PropertyType::SCALAR);
 }
 
 //=============================================================================
-void PlyModel::ElementBuilder::addListProperty(const QString& name)
+void PlyModel::ElementBuilder::addListProperty(const QString& name,
+        const QString& countType, const QString& valueType)
 {
     (void)m_element.m_listProperties.insert(name, QList<QList<double>>());
+    (void)m_element.m_types.insert(name, valueType);
+    (void)m_element.m_countTypes.insert(name, countType);
+    m_element.m_propertyNames.append(name);
     m_propertyNames.append(name);
     (void)m_propertyTypes.insert(name, PropertyType::LIST);
 }
@@ -73,6 +80,7 @@ PlyModel PlyModel::parse(QTextStream& stream)
 
     QList<QSharedPointer<ElementBuilder>> builders;
     QSharedPointer<ElementBuilder> currentBuilder_p;
+    QStringList comments;
 
     while(true) {
         QString line = stream.readLine();
@@ -97,18 +105,22 @@ PlyModel PlyModel::parse(QTextStream& stream)
             if(words.count() < 2) return PlyModel();
             if(words.value(1) == "list") {
                 if(words.count() < 5) return PlyModel();
-                currentBuilder_p->addListProperty(words.value(4));
+                currentBuilder_p->addListProperty(
+                        words.value(4), words.value(2), words.value(3));
             } else {
                 if(words.count() < 3) return PlyModel();
-                currentBuilder_p->addScalarProperty(words.value(2));
+                currentBuilder_p->addScalarProperty(
+                        words.value(2), words.value(1));
             }
         } else if(command == "comment") {
+            comments.append(line.trimmed().mid(command.length()).trimmed());
         } else {
             return PlyModel();
         }
     }
 
     PlyModel model;
+    model.m_comments = comments;
 
     for(auto builder_p : builders) {
         for(int i = 0; i < builder_p->numExpected(); ++i) {
@@ -120,6 +132,9 @@ PlyModel PlyModel::parse(QTextStream& stream)
         }
         (void)model.m_elements.insert(
                 builder_p->elementName(), builder_p->element());
+        if(!model.m_elementNames.contains(builder_p->elementName())) {
+            model.m_elementNames.append(builder_p->elementName());
+        }
     }
 
     model.m_valid = true;
@@ -143,6 +158,31 @@ QSet<QString> PlyModel::elements() const
     return m_elements.keys().toSet();
 }
 
+//=============================================================================
+QStringList PlyModel::elementNames() const
+{
+    return m_elementNames;
+}
+
+//=============================================================================
+QStringList PlyModel::propertyNames(const QString& element) const
+{
+    return m_elements.value(element).m_propertyNames;
+}
+
+//=============================================================================
+QString PlyModel::propertyType(const QString& element,
+        const QString& property) const
+{
+    return m_elements.value(element).m_types.value(property);
+}
+
+//=============================================================================
+QStringList PlyModel::comments() const
+{
+    return m_comments;
+}
+
 //=============================================================================
 int PlyModel::count(const QString& element) const
 {
@@ -176,3 +216,88 @@ QList<double> PlyModel::listValue(const QString& element, int index,
     Element e = m_elements.value(element);
     return e.m_listProperties.value(property).value(index);
 }
+
+//=============================================================================
+qint64 PlyModel::memoryBytes() const
+{
+    // A QList keeps one pointer-sized node per item behind a small header.
+    // A nested list fits in its node.  A double fits only where pointers
+    // are 64 bits wide; on 32-bit targets QTypeInfo<double>::isLarge holds
+    // and every value is a heap block of its own, which the allocator pads
+    // with about two pointers of bookkeeping.
+    constexpr qint64 LIST_HEADER = 4 * sizeof(int) + sizeof(void *);
+    constexpr qint64 HEAP_OVERHEAD = 2 * sizeof(void *);
+    auto listBytes = [](int count) {
+        return LIST_HEADER + ((qint64)count * sizeof(void *));
+    };
+    auto doubleListBytes = [&listBytes](int count) {
+        qint64 bytes = listBytes(count);
+        if(QTypeInfo<double>::isLarge) {
+            bytes += (qint64)count * (sizeof(double) + HEAP_OVERHEAD);
+        }
+        return bytes;
+    };
+
+    qint64 bytes = 0;
+    for(const auto& element : m_elements) {
+        for(const auto& values : element.m_scalarProperties) {
+            bytes += doubleListBytes(values.count());
+        }
+        for(const auto& lists : element.m_listProperties) {
+            bytes += listBytes(lists.count());
+            for(const auto& values : lists) {
+                bytes += doubleListBytes(values.count());
+            }
+        }
+    }
+    return bytes;
+}
+
+//=============================================================================
+void PlyModel::addComment(const QString& comment)
+{
+    m_comments.append(comment);
+}
+
+//=============================================================================
+void PlyModel::addElement(const QString& name, int count)
+{
+    if(!m_elements.contains(name)) m_elementNames.append(name);
+    Element element;
+    element.m_count = count;
+    (void)m_elements.insert(name, element);
+    m_valid = true;
+}
+
+//=============================================================================
+bool PlyModel::addScalarProperty(const QString& element, const QString& name,
+        const QString& type, const QList<double>& values)
+{
+    auto e = m_elements.find(element);
+    if(e == m_elements.end()) return false;
+    if(values.count() != e->m_count) return false;
+
+    if(!e->m_types.contains(name)) e->m_propertyNames.append(name);
+    (void)e->m_listProperties.remove(name);
+    (void)e->m_countTypes.remove(name);
+    (void)e->m_types.insert(name, type);
+    (void)e->m_scalarProperties.insert(name, values);
+    return true;
+}
+
+//=============================================================================
+bool PlyModel::addListProperty(const QString& element, const QString& name,
+        const QString& countType, const QString& valueType,
+        const QList<QList<double>>& values)
+{
+    auto e = m_elements.find(element);
+    if(e == m_elements.end()) return false;
+    if(values.count() != e->m_count) return false;
+
+    if(!e->m_types.contains(name)) e->m_propertyNames.append(name);
+    (void)e->m_scalarProperties.remove(name);
+    (void)e->m_types.insert(name, valueType);
+    (void)e->m_countTypes.insert(name, countType);
+    (void)e->m_listProperties.insert(name, values);
+    return true;
+}
@@ -1,6 +1,7 @@
 #include <QMap>
 #include <QSet>
 #include <QString>
+#include <QStringList>
 
 class QTextStream;
 
@@ -13,6 +14,11 @@ public:
 
     bool isValid() const;
     QSet<QString> elements() const;
+    QStringList elementNames() const;
+    QStringList propertyNames(const QString& element) const;
+    QString propertyType(const QString& element,
+            const QString& property) const;
+    QStringList comments() const;
     int count(const QString& element) const;
     QSet<QString> scalarProperties(const QString& element) const;
     QSet<QString> listProperties(const QString& element) const;
@@ -21,13 +27,28 @@ public:
     QList<double> listValue(const QString& element, int index,
             const QString& property) const;
 
+    qint64 memoryBytes() const;
+
+    void addComment(const QString& comment);
+    void addElement(const QString& name, int count);
+    bool addScalarProperty(const QString& element, const QString& name,
+            const QString& type, const QList<double>& values);
+    bool addListProperty(const QString& element, const QString& name,
+            const QString& countType, const QString& valueType,
+            const QList<QList<double>>& values);
+
 private:
+    friend class PlyWriter;
+
     class Element
     {
     public:
         Element() : m_count(0) {}
 
         int m_count;
+        QStringList m_propertyNames;
+        QMap<QString, QString> m_types;
+        QMap<QString, QString> m_countTypes;
         QMap<QString, QList<double>> m_scalarProperties;
         QMap<QString, QList<QList<double>>> m_listProperties;
     };
@@ -40,8 +61,9 @@ private:
         int numExpected() { return m_element.m_count; }
         Element element() { return m_element; }
 
-        void addScalarProperty(const QString& name);
-        void addListProperty(const QString& name);
+        void addScalarProperty(const QString& name, const QString& type);
+        void addListProperty(const QString& name,
+                const QString& countType, const QString& valueType);
         bool addInstance(const QStringList& words);
 
     private:
@@ -57,5 +79,7 @@ private:
     };
 
     bool m_valid;
+    QStringList m_elementNames;
+    QStringList m_comments;
     QMap<QString, Element> m_elements;
 };
@@ -0,0 +1,270 @@
+#include "PlyWriter.h"
+
+#include <QIODevice>
+#include <QLocale>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "PlyModel.h"
+
+namespace {
+    //=========================================================================
+    template<typename T>
+    void appendLittleEndian(QByteArray& buffer, T value)
+    {
+        char bytes[sizeof(T)];
+        qToLittleEndian(value, bytes);
+        buffer.append(bytes, sizeof(T));
+    }
+
+    //=========================================================================
+    // Values outside the type are clamped to it rather than wrapped.
+    template<typename T>
+    T toInteger(double value)
+    {
+        if(std::isnan(value)) return 0;
+        const double low = (double)std::numeric_limits<T>::min();
+        const double high = (double)std::numeric_limits<T>::max();
+        return (T)std::llround(qBound(low, value, high));
+    }
+}
+
+//=============================================================================
+PlyWriter::PlyWriter(int chunkSize) :
+        m_chunkSize(qMax(chunkSize, 256)),
+        m_device_p(nullptr)
+{
+}
+
+//=============================================================================
+bool PlyWriter::write(const PlyModel& model, QIODevice& device,
+        Encoding encoding)
+{
+    if(!model.isValid() || !device.isWritable()) return false;
+
+    m_device_p = &device;
+    m_buffer.reserve(m_chunkSize + 256);
+    m_buffer.resize(0);
+
+    bool ok = writeHeader(model, encoding);
+    if(ok) {
+        ok = (encoding == Encoding::ASCII) ?
+                writeAsciiBody(model) : writeBinaryBody(model);
+    }
+    ok = flush(true) && ok;
+
+    m_buffer = QByteArray();
+    m_device_p = nullptr;
+    return ok;
+}
+
+//=============================================================================
+PlyWriter::Type PlyWriter::typeOf(const QString& name)
+{
+    static const QMap<QString, Type> types = {
+        { "char", Type::INT8 }, { "int8", Type::INT8 },
+        { "uchar", Type::UINT8 }, { "uint8", Type::UINT8 },
+        { "short", Type::INT16 }, { "int16", Type::INT16 },
+        { "ushort", Type::UINT16 }, { "uint16", Type::UINT16 },
+        { "int", Type::INT32 }, { "int32", Type::INT32 },
+        { "uint", Type::UINT32 }, { "uint32", Type::UINT32 },
+        { "float", Type::FLOAT32 }, { "float32", Type::FLOAT32 },
+        { "double", Type::FLOAT64 }, { "float64", Type::FLOAT64 }
+    };
+    return types.value(name, Type::INVALID);
+}
+
+//=============================================================================
+bool PlyWriter::writeHeader(const PlyModel& model, Encoding encoding)
+{
+    QByteArray header = "ply\n";
+    header += (encoding == Encoding::ASCII) ?
+            "format ascii 1.0\n" : "format binary_little_endian 1.0\n";
+    for(const auto& comment : model.m_comments) {
+        header += "comment " + comment.toUtf8() + "\n";
+    }
+
+    for(const auto& name : model.m_elementNames) {
+        const PlyModel::Element& element = model.m_elements.find(name).value();
+        header += "element " + name.toUtf8() + " " +
+                QByteArray::number(element.m_count) + "\n";
+        for(const auto& property : element.m_propertyNames) {
+            const QString type = element.m_types.value(property);
+            if(element.m_listProperties.contains(property)) {
+                const QString countType = element.m_countTypes.value(property);
+                if(encoding != Encoding::ASCII &&
+                        (typeOf(countType) == Type::INVALID ||
+                        typeOf(countType) == Type::FLOAT32 ||
+                        typeOf(countType) == Type::FLOAT64 ||
+                        typeOf(type) == Type::INVALID)) {
+                    return false;
+                }
+                header += "property list " + countType.toUtf8() + " " +
+                        type.toUtf8() + " " + property.toUtf8() + "\n";
+            } else {
+                if(encoding != Encoding::ASCII &&
+                        typeOf(type) == Type::INVALID) {
+                    return false;
+                }
+                header += "property " + type.toUtf8() + " " +
+                        property.toUtf8() + "\n";
+            }
+        }
+    }
+    header += "end_header\n";
+
+    m_buffer.append(header);
+    return flush();
+}
+
+//=============================================================================
+bool PlyWriter::writeAsciiBody(const PlyModel& model)
+{
+    for(const auto& name : model.m_elementNames) {
+        const PlyModel::Element& element = model.m_elements.find(name).value();
+
+        // Resolve every property once so the row loop only indexes lists.
+        QList<const QList<double> *> scalars;
+        QList<const QList<QList<double>> *> lists;
+        for(const auto& property : element.m_propertyNames) {
+            auto list = element.m_listProperties.find(property);
+            if(list != element.m_listProperties.end()) {
+                scalars.append(nullptr);
+                lists.append(&list.value());
+            } else {
+                scalars.append(
+                        &element.m_scalarProperties.find(property).value());
+                lists.append(nullptr);
+            }
+        }
+
+        for(int i = 0; i < element.m_count; ++i) {
+            for(int p = 0; p < scalars.count(); ++p) {
+                if(p > 0) m_buffer.append(' ');
+                if(scalars[p]) {
+                    appendNumber(scalars[p]->value(i));
+                } else {
+                    const QList<double> values = lists[p]->value(i);
+                    m_buffer.append(QByteArray::number(values.count()));
+                    for(double value : values) {
+                        m_buffer.append(' ');
+                        appendNumber(value);
+                    }
+                }
+            }
+            m_buffer.append('\n');
+            if(!flush()) return false;
+        }
+    }
+    return true;
+}
+
+//=============================================================================
+bool PlyWriter::writeBinaryBody(const PlyModel& model)
+{
+    for(const auto& name : model.m_elementNames) {
+        const PlyModel::Element& element = model.m_elements.find(name).value();
+
+        QList<const QList<double> *> scalars;
+        QList<const QList<QList<double>> *> lists;
+        QList<Type> types;
+        QList<Type> countTypes;
+        for(const auto& property : element.m_propertyNames) {
+            types.append(typeOf(element.m_types.value(property)));
+            countTypes.append(typeOf(element.m_countTypes.value(property)));
+            auto list = element.m_listProperties.find(property);
+            if(list != element.m_listProperties.end()) {
+                scalars.append(nullptr);
+                lists.append(&list.value());
+            } else {
+                scalars.append(
+                        &element.m_scalarProperties.find(property).value());
+                lists.append(nullptr);
+            }
+        }
+
+        for(int i = 0; i < element.m_count; ++i) {
+            for(int p = 0; p < scalars.count(); ++p) {
+                if(scalars[p]) {
+                    appendBinary(scalars[p]->value(i), types[p]);
+                } else {
+                    const QList<double> values = lists[p]->value(i);
+                    appendBinary(values.count(), countTypes[p]);
+                    for(double value : values) {
+                        appendBinary(value, types[p]);
+                    }
+                }
+            }
+            if(!flush()) return false;
+        }
+    }
+    return true;
+}
+
+//=============================================================================
+void PlyWriter::appendNumber(double value)
+{
+    // Whole numbers are by far the most common (indices, counts, flags).
+    if(std::abs(value) < 1e15 && value == std::trunc(value)) {
+        m_buffer.append(QByteArray::number((qlonglong)value));
+        return;
+    }
+
+    // The shortest text that reads back exactly, in one pass.
+    m_buffer.append(
+            QByteArray::number(value, 'g', QLocale::FloatingPointShortest));
+}
+
+//=============================================================================
+void PlyWriter::appendBinary(double value, Type type)
+{
+    switch(type) {
+    case Type::INT8:
+        m_buffer.append((char)toInteger<qint8>(value));
+        break;
+    case Type::UINT8:
+        m_buffer.append((char)toInteger<quint8>(value));
+        break;
+    case Type::INT16:
+        appendLittleEndian(m_buffer, toInteger<qint16>(value));
+        break;
+    case Type::UINT16:
+        appendLittleEndian(m_buffer, toInteger<quint16>(value));
+        break;
+    case Type::INT32:
+        appendLittleEndian(m_buffer, toInteger<qint32>(value));
+        break;
+    case Type::UINT32:
+        appendLittleEndian(m_buffer, toInteger<quint32>(value));
+        break;
+    case Type::FLOAT32:
+        {
+            const float f = (float)value;
+            quint32 bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            appendLittleEndian(m_buffer, bits);
+        } break;
+    case Type::FLOAT64:
+        {
+            quint64 bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            appendLittleEndian(m_buffer, bits);
+        } break;
+    case Type::INVALID:
+        break;
+    }
+}
+
+//=============================================================================
+bool PlyWriter::flush(bool force)
+{
+    if(m_buffer.isEmpty()) return true;
+    if(!force && m_buffer.size() < m_chunkSize) return true;
+
+    const qint64 size = m_buffer.size();
+    const qint64 written = m_device_p->write(m_buffer);
+    m_buffer.resize(0);
+    return written == size;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QByteArray>
+
+class PlyModel;
+class QIODevice;
+
+//=============================================================================
+// Writes a PlyModel back out with its elements, properties, types and
+// comments in their original order.  Output is collected in large chunks
+// before it reaches the device.  ASCII numbers use the shortest text that
+// reads back to the same double, so parse -> write -> parse is lossless.
+// Binary output converts each value to its declared property type; integer
+// types clamp values they cannot hold.
+class PlyWriter
+{
+public:
+    enum class Encoding
+    {
+        ASCII,
+        BINARY_LITTLE_ENDIAN
+    };
+
+    static constexpr int DEFAULT_CHUNK_SIZE = 1024 * 1024;
+
+    PlyWriter(int chunkSize = DEFAULT_CHUNK_SIZE);
+
+    bool write(const PlyModel& model, QIODevice& device, Encoding encoding);
+
+private:
+    enum class Type
+    {
+        INVALID,
+        INT8,
+        UINT8,
+        INT16,
+        UINT16,
+        INT32,
+        UINT32,
+        FLOAT32,
+        FLOAT64
+    };
+
+    static Type typeOf(const QString& name);
+
+    bool writeHeader(const PlyModel& model, Encoding encoding);
+    bool writeAsciiBody(const PlyModel& model);
+    bool writeBinaryBody(const PlyModel& model);
+
+    void appendNumber(double value);
+    void appendBinary(double value, Type type);
+    bool flush(bool force = false);
+
+    int m_chunkSize;
+    QIODevice *m_device_p;
+    QByteArray m_buffer;
+};
@@ -0,0 +1,270 @@
+#include "Profiler.h"
+
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QOpenGLContext>
+#include <QThread>
+
+namespace {
+    constexpr GLenum TIME_ELAPSED = 0x88BF;
+    constexpr GLenum QUERY_RESULT = 0x8866;
+    constexpr GLenum QUERY_RESULT_AVAILABLE = 0x8867;
+    constexpr GLenum GPU_DISJOINT = 0x8FBB;
+
+    constexpr double AVERAGE_WEIGHT = 0.1;
+    constexpr int MAX_PENDING_QUERIES = 64;
+}
+
+//=============================================================================
+Profiler& Profiler::instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+//=============================================================================
+Profiler::Profiler()
+{
+    m_clock.start();
+}
+
+//=============================================================================
+qint64 Profiler::nowUs() const
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
+
+//=============================================================================
+void Profiler::record(const QString& name, const QString& category,
+        qint64 startUs, qint64 durationUs, quintptr threadId)
+{
+    QMutexLocker lock(&m_mutex);
+
+    if(m_events.count() >= MAX_EVENTS) {
+        m_events.erase(m_events.begin(), m_events.begin() + MAX_EVENTS / 2);
+    }
+    m_events.append({ name, category, startUs, durationUs, threadId });
+
+    const double ms = durationUs / 1000.0;
+    m_lastMs.insert(name, ms);
+    auto average = m_averageMs.find(name);
+    if(average == m_averageMs.end()) {
+        m_averageMs.insert(name, ms);
+    } else {
+        *average += AVERAGE_WEIGHT * (ms - *average);
+    }
+}
+
+//=============================================================================
+double Profiler::lastMs(const QString& name) const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_lastMs.value(name, 0.0);
+}
+
+//=============================================================================
+double Profiler::averageMs(const QString& name) const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_averageMs.value(name, 0.0);
+}
+
+//=============================================================================
+QList<Profiler::Event> Profiler::events() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_events;
+}
+
+//=============================================================================
+void Profiler::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_events.clear();
+    m_lastMs.clear();
+    m_averageMs.clear();
+}
+
+//=============================================================================
+bool Profiler::writeChromeTrace(QIODevice& device) const
+{
+    QJsonArray traceEvents;
+    for(const auto& event : events()) {
+        QJsonObject object;
+        object.insert("name", event.name);
+        object.insert("cat", event.category);
+        object.insert("ph", QString("X"));
+        object.insert("ts", (double)event.startUs);
+        object.insert("dur", (double)event.durationUs);
+        object.insert("pid", 1);
+        object.insert("tid", (double)event.threadId);
+        traceEvents.append(object);
+    }
+
+    QJsonObject gpuThreadName;
+    gpuThreadName.insert("name", QString("thread_name"));
+    gpuThreadName.insert("ph", QString("M"));
+    gpuThreadName.insert("pid", 1);
+    gpuThreadName.insert("tid", (double)GPU_THREAD_ID);
+    gpuThreadName.insert("args", QJsonObject{ { "name", "GPU" } });
+    traceEvents.append(gpuThreadName);
+
+    QJsonObject root;
+    root.insert("traceEvents", traceEvents);
+    root.insert("displayTimeUnit", QString("ms"));
+
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Compact);
+    return device.write(json) == json.size();
+}
+
+//=============================================================================
+quintptr Profiler::currentThreadId()
+{
+    return reinterpret_cast<quintptr>(QThread::currentThreadId());
+}
+
+//=============================================================================
+ScopedTimer::ScopedTimer(const QString& name, const QString& category) :
+        m_name(name),
+        m_category(category),
+        m_startUs(Profiler::instance().nowUs())
+{
+}
+
+//=============================================================================
+ScopedTimer::~ScopedTimer()
+{
+    Profiler& profiler = Profiler::instance();
+    profiler.record(m_name, m_category,
+            m_startUs, profiler.nowUs() - m_startUs);
+}
+
+//=============================================================================
+GpuTimer::GpuTimer() :
+        m_context_p(nullptr),
+        m_genQueries(nullptr),
+        m_deleteQueries(nullptr),
+        m_beginQuery(nullptr),
+        m_endQuery(nullptr),
+        m_getQueryObjectuiv(nullptr),
+        m_getQueryObjectui64v(nullptr),
+        m_disjointExtension(false),
+        m_active(false)
+{
+}
+
+//=============================================================================
+bool GpuTimer::initialize(QOpenGLContext *context_p)
+{
+    m_context_p = context_p;
+
+    QByteArray suffix;
+    if(context_p->hasExtension("GL_EXT_disjoint_timer_query")) {
+        suffix = "EXT";
+        m_disjointExtension = true;
+    } else if(context_p->isOpenGLES() ||
+            !context_p->hasExtension("GL_ARB_timer_query")) {
+        return false;
+    }
+
+    auto resolve = [&](const char *name) {
+        return context_p->getProcAddress(QByteArray(name) + suffix);
+    };
+    m_genQueries = (GenQueries)resolve("glGenQueries");
+    m_deleteQueries = (DeleteQueries)resolve("glDeleteQueries");
+    m_beginQuery = (BeginQuery)resolve("glBeginQuery");
+    m_endQuery = (EndQuery)resolve("glEndQuery");
+    m_getQueryObjectuiv = (GetQueryObjectuiv)resolve("glGetQueryObjectuiv");
+    m_getQueryObjectui64v =
+            (GetQueryObjectui64v)resolve("glGetQueryObjectui64v");
+
+    return isAvailable();
+}
+
+//=============================================================================
+void GpuTimer::release()
+{
+    if(isAvailable() && !m_allQueries.isEmpty()) {
+        m_deleteQueries(m_allQueries.count(), m_allQueries.constData());
+    }
+    m_allQueries.clear();
+    m_freeQueries.clear();
+    m_pending.clear();
+    m_active = false;
+}
+
+//=============================================================================
+bool GpuTimer::isAvailable() const
+{
+    return m_genQueries && m_deleteQueries && m_beginQuery && m_endQuery &&
+            m_getQueryObjectuiv && m_getQueryObjectui64v;
+}
+
+//=============================================================================
+void GpuTimer::begin(const QString& name)
+{
+    if(!isAvailable() || m_active) return;
+    if(m_pending.count() >= MAX_PENDING_QUERIES) return;
+
+    if(m_freeQueries.isEmpty()) {
+        GLuint id = 0;
+        m_genQueries(1, &id);
+        if(!id) return;
+        m_allQueries.append(id);
+        m_freeQueries.append(id);
+    }
+
+    const GLuint id = m_freeQueries.takeLast();
+    m_beginQuery(TIME_ELAPSED, id);
+    m_pending.append({ id, name, Profiler::instance().nowUs() });
+    m_active = true;
+}
+
+//=============================================================================
+void GpuTimer::end()
+{
+    if(!m_active) return;
+    m_endQuery(TIME_ELAPSED);
+    m_active = false;
+}
+
+//=============================================================================
+void GpuTimer::collect()
+{
+    if(!isAvailable()) return;
+
+    // A disjoint event (e.g. a power state change) invalidates every query
+    // that was in flight, so throw the whole batch away.
+    if(m_disjointExtension) {
+        GLint disjoint = 0;
+        m_context_p->functions()->glGetIntegerv(GPU_DISJOINT, &disjoint);
+        if(disjoint) {
+            while(!m_pending.isEmpty() &&
+                    !(m_active && m_pending.count() == 1)) {
+                m_freeQueries.append(m_pending.takeFirst().id);
+            }
+            return;
+        }
+    }
+
+    while(!m_pending.isEmpty()) {
+        if(m_active && m_pending.count() == 1) break;
+
+        const PendingQuery& query = m_pending.first();
+        GLuint available = 0;
+        m_getQueryObjectuiv(query.id, QUERY_RESULT_AVAILABLE, &available);
+        if(!available) break;
+
+        quint64 elapsedNs = 0;
+        m_getQueryObjectui64v(query.id, QUERY_RESULT, &elapsedNs);
+        Profiler::instance().record(query.name, "gpu",
+                query.cpuStartUs, (qint64)(elapsedNs / 1000),
+                Profiler::GPU_THREAD_ID);
+
+        m_freeQueries.append(query.id);
+        m_pending.removeFirst();
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QOpenGLFunctions>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+class QOpenGLContext;
+
+//=============================================================================
+class Profiler
+{
+public:
+    struct Event
+    {
+        QString name;
+        QString category;
+        qint64 startUs;
+        qint64 durationUs;
+        quintptr threadId;
+    };
+
+    static Profiler& instance();
+
+    qint64 nowUs() const;
+    void record(const QString& name, const QString& category,
+            qint64 startUs, qint64 durationUs,
+            quintptr threadId = currentThreadId());
+
+    double lastMs(const QString& name) const;
+    double averageMs(const QString& name) const;
+
+    QList<Event> events() const;
+    void clear();
+    bool writeChromeTrace(QIODevice& device) const;
+
+    static quintptr currentThreadId();
+
+    // Reserved pseudo thread id for GPU events in the exported trace.
+    static constexpr quintptr GPU_THREAD_ID = 1;
+
+private:
+    Profiler();
+
+    static constexpr int MAX_EVENTS = 200000;
+
+    QElapsedTimer m_clock;
+    mutable QMutex m_mutex;
+    QList<Event> m_events;
+    QHash<QString, double> m_lastMs;
+    QHash<QString, double> m_averageMs;
+};
+
+//=============================================================================
+class ScopedTimer
+{
+public:
+    ScopedTimer(const QString& name, const QString& category = "load");
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    QString m_name;
+    QString m_category;
+    qint64 m_startUs;
+};
+
+//=============================================================================
+// Times GL work with EXT_disjoint_timer_query (or ARB_timer_query on desktop
+// GL).  Results are collected a few frames late so the CPU never waits on a
+// query, and are recorded into the Profiler under the "gpu" category.
+class GpuTimer
+{
+public:
+    GpuTimer();
+
+    bool initialize(QOpenGLContext *context_p);
+    void release();
+    bool isAvailable() const;
+
+    void begin(const QString& name);
+    void end();
+    void collect();
+
+private:
+    typedef void (QOPENGLF_APIENTRYP GenQueries)(GLsizei, GLuint *);
+    typedef void (QOPENGLF_APIENTRYP DeleteQueries)(GLsizei, const GLuint *);
+    typedef void (QOPENGLF_APIENTRYP BeginQuery)(GLenum, GLuint);
+    typedef void (QOPENGLF_APIENTRYP EndQuery)(GLenum);
+    typedef void (QOPENGLF_APIENTRYP GetQueryObjectuiv)(
+            GLuint, GLenum, GLuint *);
+    typedef void (QOPENGLF_APIENTRYP GetQueryObjectui64v)(
+            GLuint, GLenum, quint64 *);
+
+    struct PendingQuery
+    {
+        GLuint id;
+        QString name;
+        qint64 cpuStartUs;
+    };
+
+    QOpenGLContext *m_context_p;
+    GenQueries m_genQueries;
+    DeleteQueries m_deleteQueries;
+    BeginQuery m_beginQuery;
+    EndQuery m_endQuery;
+    GetQueryObjectuiv m_getQueryObjectuiv;
+    GetQueryObjectui64v m_getQueryObjectui64v;
+    bool m_disjointExtension;
+
+    QVector<GLuint> m_freeQueries;
+    QVector<GLuint> m_allQueries;
+    QList<PendingQuery> m_pending;
+    bool m_active;
+};
@@ -0,0 +1,164 @@
+#include "RenderLayer.h"
+
+#include <QOpenGLContext>
+
+namespace {
+    constexpr GLenum DEPTH_COMPONENT24 = 0x81A6;
+}
+
+//=============================================================================
+bool RenderLayer::isSupported(QOpenGLContext *context_p)
+{
+    if(!context_p->isOpenGLES()) return true;
+    const bool depthTextures = context_p->format().majorVersion() >= 3 ||
+            context_p->hasExtension("GL_OES_depth_texture");
+    return depthTextures && context_p->hasExtension("GL_EXT_frag_depth");
+}
+
+//=============================================================================
+RenderLayer::RenderLayer() :
+        m_framebuffer(0),
+        m_colorTexture(0),
+        m_depthTexture(0),
+        m_depthFormat(GL_DEPTH_COMPONENT),
+        m_width(0),
+        m_height(0),
+        m_clearColor{},
+        m_initialized(false)
+{
+}
+
+//=============================================================================
+void RenderLayer::initialize(QOpenGLContext *context_p)
+{
+    release();
+    initializeOpenGLFunctions();
+
+    // ES2 only takes the unsized format; everything else gets 24 bits.
+    const bool es2 = context_p->isOpenGLES() &&
+            context_p->format().majorVersion() < 3;
+    m_depthFormat = es2 ? GL_DEPTH_COMPONENT : DEPTH_COMPONENT24;
+    m_initialized = true;
+}
+
+//=============================================================================
+void RenderLayer::release()
+{
+    if(!m_initialized) return;
+    glDeleteFramebuffers(1, &m_framebuffer);
+    glDeleteTextures(1, &m_colorTexture);
+    glDeleteTextures(1, &m_depthTexture);
+    m_framebuffer = 0;
+    m_colorTexture = 0;
+    m_depthTexture = 0;
+    m_width = 0;
+    m_height = 0;
+    m_inputs.clear();
+}
+
+//=============================================================================
+// Returns false if the target could not be allocated at this size.
+bool RenderLayer::resize(int width, int height)
+{
+    if(!m_initialized || width <= 0 || height <= 0) return false;
+    if(width == m_width && height == m_height) return isAllocated();
+
+    release();
+    m_width = width;
+    m_height = height;
+
+    auto makeTexture = [this](GLuint *texture_p, GLenum internalFormat,
+            GLenum format, GLenum type) {
+        glGenTextures(1, texture_p);
+        glBindTexture(GL_TEXTURE_2D, *texture_p);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, m_width, m_height,
+                0, format, type, nullptr);
+    };
+    makeTexture(&m_colorTexture, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE);
+    makeTexture(&m_depthTexture, m_depthFormat, GL_DEPTH_COMPONENT,
+            GL_UNSIGNED_INT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+            GL_TEXTURE_2D, m_colorTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+            GL_TEXTURE_2D, m_depthTexture, 0);
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+
+    if(status != GL_FRAMEBUFFER_COMPLETE) {
+        release();
+        return false;
+    }
+    return true;
+}
+
+//=============================================================================
+bool RenderLayer::isAllocated() const
+{
+    return m_framebuffer != 0;
+}
+
+//=============================================================================
+// Returns true if the layer has to be drawn again for these inputs.
+bool RenderLayer::setInputs(const QByteArray& inputs)
+{
+    if(inputs == m_inputs && !m_inputs.isNull()) return false;
+    m_inputs = inputs;
+    return true;
+}
+
+//=============================================================================
+void RenderLayer::invalidate()
+{
+    m_inputs.clear();
+}
+
+//=============================================================================
+// Clears to transparent black, so drawing with premultiplied alpha leaves
+// an image that composites with (ONE, ONE_MINUS_SRC_ALPHA).
+void RenderLayer::begin()
+{
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, m_clearColor);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glViewport(0, 0, m_width, m_height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glDepthMask(GL_TRUE);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+//=============================================================================
+void RenderLayer::end(GLuint framebuffer)
+{
+    glClearColor(m_clearColor[0], m_clearColor[1], m_clearColor[2],
+            m_clearColor[3]);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+//=============================================================================
+GLuint RenderLayer::colorTexture() const
+{
+    return m_colorTexture;
+}
+
+//=============================================================================
+GLuint RenderLayer::depthTexture() const
+{
+    return m_depthTexture;
+}
+
+//=============================================================================
+qint64 RenderLayer::allocatedBytes() const
+{
+    // RGBA8 color and depth, which drivers pad to 32 bits.
+    if(!isAllocated()) return 0;
+    return (qint64)m_width * m_height * (4 + 4);
+}
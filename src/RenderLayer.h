@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QByteArray>
+
+#include "GlRecorder.h"
+
+class QOpenGLContext;
+
+//=============================================================================
+// An offscreen color + depth target that keeps its contents between frames.
+// The caller describes everything the layer's image depends on as a blob of
+// bytes; the layer only needs drawing again when that blob changes or the
+// target is resized.  Both attachments are textures so the layer can be
+// composited back into the scene with its depth intact.  On ES that needs
+// depth textures (core in ES3, GL_OES_depth_texture in ES2) and
+// GL_EXT_frag_depth for the compositing shader.
+class RenderLayer : protected RecordingFunctions
+{
+public:
+    static bool isSupported(QOpenGLContext *context_p);
+
+    RenderLayer();
+
+    void initialize(QOpenGLContext *context_p);
+    void release();
+
+    bool resize(int width, int height);
+    bool isAllocated() const;
+    bool setInputs(const QByteArray& inputs);
+    void invalidate();
+
+    void begin();
+    void end(GLuint framebuffer);
+
+    GLuint colorTexture() const;
+    GLuint depthTexture() const;
+    qint64 allocatedBytes() const;
+
+private:
+    GLuint m_framebuffer;
+    GLuint m_colorTexture;
+    GLuint m_depthTexture;
+    GLenum m_depthFormat;
+    int m_width;
+    int m_height;
+    QByteArray m_inputs;
+    GLfloat m_clearColor[4];
+    bool m_initialized;
+};
@@ -0,0 +1,102 @@
+#include "ResolutionController.h"
+
+#include <QtGlobal>
+#include <cmath>
+
+namespace {
+    // Weight of the newest frame in the average.
+    constexpr float SMOOTHING = 0.25f;
+
+    //=========================================================================
+    float roundDown(float scale)
+    {
+        const float step = ResolutionController::SCALE_STEP;
+        return std::floor(scale / step + 1e-3f) * step;
+    }
+}
+
+//=============================================================================
+ResolutionController::ResolutionController(float budgetMs) :
+        m_budgetMs(budgetMs)
+{
+    reset();
+}
+
+//=============================================================================
+void ResolutionController::setBudget(float ms)
+{
+    m_budgetMs = ms;
+    m_framesInBudget = 0;
+}
+
+//=============================================================================
+float ResolutionController::budget() const
+{
+    return m_budgetMs;
+}
+
+//=============================================================================
+void ResolutionController::reset()
+{
+    m_scale = MAX_SCALE;
+    m_averageMs = 0.0f;
+    m_samples = 0;
+    m_settleFrames = 0;
+    m_framesInBudget = 0;
+}
+
+//=============================================================================
+bool ResolutionController::addFrame(float ms)
+{
+    if(ms <= 0.0f || m_budgetMs <= 0.0f) return false;
+    if(m_settleFrames > 0) {
+        --m_settleFrames;
+        return false;
+    }
+
+    m_averageMs = m_samples == 0 ? ms :
+            m_averageMs + SMOOTHING * (ms - m_averageMs);
+    if(++m_samples < SETTLE_FRAMES) return false;
+
+    float scale = m_scale;
+    if(m_averageMs > m_budgetMs) {
+        m_framesInBudget = 0;
+        scale = qMin(roundDown(m_scale * std::sqrt(m_budgetMs / m_averageMs)),
+                m_scale - SCALE_STEP);
+    } else if(m_averageMs < HEADROOM * m_budgetMs) {
+        // Aim below the budget so the next frame does not land right on it.
+        scale = roundDown(m_scale *
+                std::sqrt(HEADROOM * m_budgetMs / m_averageMs));
+    } else if(++m_framesInBudget >= PROBE_FRAMES) {
+        scale = m_scale + SCALE_STEP;
+    }
+
+    const float minScale = MIN_SCALE;
+    const float maxScale = MAX_SCALE;
+    scale = qBound(m_scale - MAX_CHANGE, scale, m_scale + MAX_CHANGE);
+    scale = qBound(minScale, scale, maxScale);
+    if(std::fabs(scale - m_scale) < 0.5f * SCALE_STEP) return false;
+    setScale(scale);
+    return true;
+}
+
+//=============================================================================
+float ResolutionController::scale() const
+{
+    return m_scale;
+}
+
+//=============================================================================
+float ResolutionController::averageMs() const
+{
+    return m_averageMs;
+}
+
+//=============================================================================
+void ResolutionController::setScale(float scale)
+{
+    m_scale = std::round(scale / SCALE_STEP) * SCALE_STEP;
+    m_samples = 0;
+    m_settleFrames = SETTLE_FRAMES;
+    m_framesInBudget = 0;
+}
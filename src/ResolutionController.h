@@ -0,0 +1,49 @@
+#pragma once
+
+//=============================================================================
+// Picks the render scale that keeps frame times inside a budget.  Frame
+// times are smoothed, and fill-rate bound work is assumed to grow with the
+// number of pixels, so a frame that takes t ms at scale s would take about
+// t * (s' / s)^2 ms at scale s'.  The scale only moves in whole steps,
+// never by more than MAX_CHANGE at once, and the frames right after a
+// change are ignored because they were mostly measured at the old scale.
+//
+// Frame times that cannot drop below the budget (a frame interval locked
+// to vsync, for one) would never let the scale grow again, so after
+// PROBE_FRAMES frames inside the budget it is raised by a step anyway.
+class ResolutionController
+{
+public:
+    static constexpr float MIN_SCALE = 0.5f;
+    static constexpr float MAX_SCALE = 1.0f;
+    static constexpr float SCALE_STEP = 0.05f;
+    static constexpr float MAX_CHANGE = 0.15f;
+    static constexpr float HEADROOM = 0.8f;
+    static constexpr float DEFAULT_BUDGET_MS = 1000.0f / 60.0f;
+    static constexpr int SETTLE_FRAMES = 4;
+    static constexpr int PROBE_FRAMES = 120;
+
+    ResolutionController(float budgetMs = DEFAULT_BUDGET_MS);
+
+    void setBudget(float ms);
+    float budget() const;
+
+    // Back to full scale with no history.
+    void reset();
+
+    // Returns true if the scale changed.
+    bool addFrame(float ms);
+
+    float scale() const;
+    float averageMs() const;
+
+private:
+    void setScale(float scale);
+
+    float m_budgetMs;
+    float m_scale;
+    float m_averageMs;
+    int m_samples;
+    int m_settleFrames;
+    int m_framesInBudget;
+};
@@ -0,0 +1,87 @@
+#include "ResourceTable.h"
+
+//=============================================================================
+ResourceTable::ResourceTable()
+{
+}
+
+//=============================================================================
+quintptr ResourceTable::acquire(const QByteArray& key)
+{
+    const quintptr handle = m_handles.value(key, 0);
+    if(handle) ++m_entries[handle].users;
+    return handle;
+}
+
+//=============================================================================
+quintptr ResourceTable::add(const QByteArray& key, quintptr handle,
+        qint64 bytes)
+{
+    const quintptr existing = acquire(key);
+    if(existing || !handle) return existing;
+
+    Entry entry;
+    entry.key = key;
+    entry.users = 1;
+    entry.bytes = bytes;
+    (void)m_entries.insert(handle, entry);
+    (void)m_handles.insert(key, handle);
+    return handle;
+}
+
+//=============================================================================
+bool ResourceTable::release(quintptr handle)
+{
+    auto entry = m_entries.find(handle);
+    if(entry == m_entries.end()) return true;
+    if(--entry->users > 0) return false;
+
+    (void)m_handles.remove(entry->key);
+    (void)m_entries.erase(entry);
+    return true;
+}
+
+//=============================================================================
+bool ResourceTable::detach(quintptr handle)
+{
+    auto entry = m_entries.find(handle);
+    if(entry == m_entries.end()) return true;
+    if(entry->users > 1) {
+        --entry->users;
+        return false;
+    }
+
+    (void)m_handles.remove(entry->key);
+    (void)m_entries.erase(entry);
+    return true;
+}
+
+//=============================================================================
+bool ResourceTable::contains(quintptr handle) const
+{
+    return m_entries.contains(handle);
+}
+
+//=============================================================================
+int ResourceTable::users(quintptr handle) const
+{
+    return m_entries.value(handle).users;
+}
+
+//=============================================================================
+bool ResourceTable::isEmpty() const
+{
+    return m_entries.isEmpty();
+}
+
+//=============================================================================
+ResourceTable::Stats ResourceTable::stats() const
+{
+    Stats stats;
+    for(const auto& entry : m_entries) {
+        ++stats.resources;
+        stats.references += entry.users;
+        stats.bytes += entry.bytes;
+    }
+    return stats;
+}
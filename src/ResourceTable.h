@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+
+//=============================================================================
+// Reference counts for resources that are shared under a key made from
+// their contents.  A handle is whatever names the resource to its owner (a
+// GL object name, a pointer); the table never frees anything itself, it
+// only tells the caller when the last reference is gone.  Handle 0 means
+// "none" and is never stored.
+class ResourceTable
+{
+public:
+    struct Stats
+    {
+        int resources = 0;
+        int references = 0;
+        qint64 bytes = 0;
+    };
+
+    ResourceTable();
+
+    // Takes a reference on the resource shared under key, or returns 0.
+    quintptr acquire(const QByteArray& key);
+
+    // Shares handle under key with one reference.  If another resource got
+    // there first, that one is referenced and returned instead, and the
+    // caller frees handle.
+    quintptr add(const QByteArray& key, quintptr handle, qint64 bytes);
+
+    // Drops a reference.  Returns true if the caller should free the
+    // resource: either that was the last reference, or the table never
+    // knew the handle.
+    bool release(quintptr handle);
+
+    // Takes handle out of the table so its one user can change it.  Returns
+    // false if others still use it; the caller's reference is dropped then
+    // and it has to make its own copy.
+    bool detach(quintptr handle);
+
+    bool contains(quintptr handle) const;
+    int users(quintptr handle) const;
+    bool isEmpty() const;
+    Stats stats() const;
+
+private:
+    struct Entry
+    {
+        QByteArray key;
+        int users = 0;
+        qint64 bytes = 0;
+    };
+
+    QHash<QByteArray, quintptr> m_handles;
+    QHash<quintptr, Entry> m_entries;
+};
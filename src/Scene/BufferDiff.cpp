@@ -0,0 +1,49 @@
+#include "BufferDiff.h"
+
+#include <cstring>
+
+//=============================================================================
+QVector<BufferDiff::Range> BufferDiff::changedRanges(const float *previous_p,
+        int previousCount, const float *current_p, int currentCount,
+        int valuesPerVertex, int mergeGap)
+{
+    QVector<Range> ranges;
+    if(currentCount <= 0 || valuesPerVertex <= 0) return ranges;
+
+    auto add = [&](int first, int count) {
+        if(!ranges.isEmpty()) {
+            Range& last = ranges.last();
+            if(first - (last.first + last.count) < mergeGap) {
+                last.count = first + count - last.first;
+                return;
+            }
+        }
+        ranges.append({ first, count });
+    };
+
+    const size_t vertexBytes = valuesPerVertex * sizeof(float);
+    const int common = qMin(qMax(previousCount, 0), currentCount);
+    int runStart = -1;
+    for(int i = 0; i < common; ++i) {
+        const size_t offset = (size_t)i * valuesPerVertex;
+        const bool changed = std::memcmp(previous_p + offset,
+                current_p + offset, vertexBytes) != 0;
+        if(changed && runStart < 0) {
+            runStart = i;
+        } else if(!changed && runStart >= 0) {
+            add(runStart, i - runStart);
+            runStart = -1;
+        }
+    }
+    if(runStart >= 0) add(runStart, common - runStart);
+    if(currentCount > common) add(common, currentCount - common);
+    return ranges;
+}
+
+//=============================================================================
+int BufferDiff::vertexCount(const QVector<Range>& ranges)
+{
+    int count = 0;
+    for(const auto& range : ranges) count += range.count;
+    return count;
+}
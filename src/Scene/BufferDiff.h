@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QVector>
+
+//=============================================================================
+// Finds the parts of a vertex array that changed between two versions, so
+// only those need to be sent to the GPU again.  Vertices are compared
+// bitwise.  Ranges separated by fewer than mergeGap unchanged vertices are
+// merged, which trades a few redundant bytes for fewer buffer updates.
+namespace BufferDiff
+{
+    constexpr int DEFAULT_MERGE_GAP = 256;
+
+    struct Range
+    {
+        int first;
+        int count;
+    };
+
+    // Vertices past the end of the previous array always count as changed;
+    // ones past the end of the current array are ignored.
+    QVector<Range> changedRanges(const float *previous_p, int previousCount,
+            const float *current_p, int currentCount, int valuesPerVertex,
+            int mergeGap = DEFAULT_MERGE_GAP);
+
+    int vertexCount(const QVector<Range>& ranges);
+}
@@ -0,0 +1,337 @@
+#include "Bvh.h"
+
+#include <QVarLengthArray>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    constexpr float INF = std::numeric_limits<float>::infinity();
+
+    //=========================================================================
+    float surfaceArea(const float *min_p, const float *max_p)
+    {
+        const float dx = max_p[0] - min_p[0];
+        const float dy = max_p[1] - min_p[1];
+        const float dz = max_p[2] - min_p[2];
+        if(dx < 0.0f || dy < 0.0f || dz < 0.0f) return 0.0f;
+        return 2.0f * (dx*dy + dy*dz + dz*dx);
+    }
+
+    //=========================================================================
+    void grow(float *min_p, float *max_p,
+            const float *otherMin_p, const float *otherMax_p)
+    {
+        for(int i = 0; i < 3; ++i) {
+            min_p[i] = std::min(min_p[i], otherMin_p[i]);
+            max_p[i] = std::max(max_p[i], otherMax_p[i]);
+        }
+    }
+
+    //=========================================================================
+    float hitBox(const float *min_p, const float *max_p,
+            const float *origin_p, const float *inverse_p, float limit)
+    {
+        float tEntry = 0.0f;
+        float tExit = limit;
+        for(int i = 0; i < 3; ++i) {
+            float t0 = (min_p[i] - origin_p[i]) * inverse_p[i];
+            float t1 = (max_p[i] - origin_p[i]) * inverse_p[i];
+            if(t0 > t1) std::swap(t0, t1);
+            tEntry = std::max(tEntry, t0);
+            tExit = std::min(tExit, t1);
+        }
+        return tEntry <= tExit ? tEntry : INF;
+    }
+}
+
+//=============================================================================
+Bvh::Bvh() : m_depth(0)
+{
+}
+
+//=============================================================================
+void Bvh::build(const float *vertices_p, int vertexCount, int stride)
+{
+    m_nodes.clear();
+    m_triangles.clear();
+    m_triangleIds.clear();
+    m_depth = 0;
+
+    const int triangleCount = vertexCount / 3;
+    if(triangleCount == 0) return;
+
+    QVector<Bounds> bounds(triangleCount);
+    QVector<int> ids(triangleCount);
+    for(int t = 0; t < triangleCount; ++t) {
+        Bounds& b = bounds[t];
+        for(int i = 0; i < 3; ++i) {
+            b.min[i] = INF;
+            b.max[i] = -INF;
+        }
+        for(int corner = 0; corner < 3; ++corner) {
+            const float *p = vertices_p + (t*3 + corner) * stride;
+            for(int i = 0; i < 3; ++i) {
+                b.min[i] = std::min(b.min[i], p[i]);
+                b.max[i] = std::max(b.max[i], p[i]);
+            }
+        }
+        for(int i = 0; i < 3; ++i) {
+            b.centroid[i] = 0.5f * (b.min[i] + b.max[i]);
+        }
+        ids[t] = t;
+    }
+
+    m_nodes.reserve(2 * triangleCount);
+    m_nodes.append(Node());
+    (void)subdivide(0, 0, triangleCount, bounds, ids, 1);
+    m_nodes.squeeze();
+
+    // Store the triangles in leaf order so each leaf reads one run.
+    m_triangles.resize(triangleCount * 9);
+    m_triangleIds = ids;
+    for(int slot = 0; slot < triangleCount; ++slot) {
+        for(int corner = 0; corner < 3; ++corner) {
+            const float *p = vertices_p + (ids[slot]*3 + corner) * stride;
+            float *q = m_triangles.data() + slot*9 + corner*3;
+            q[0] = p[0];
+            q[1] = p[1];
+            q[2] = p[2];
+        }
+    }
+}
+
+//=============================================================================
+bool Bvh::isEmpty() const
+{
+    return m_nodes.isEmpty();
+}
+
+//=============================================================================
+int Bvh::triangleCount() const
+{
+    return m_triangleIds.count();
+}
+
+//=============================================================================
+int Bvh::nodeCount() const
+{
+    return m_nodes.count();
+}
+
+//=============================================================================
+int Bvh::depth() const
+{
+    return m_depth;
+}
+
+//=============================================================================
+Bvh::Hit Bvh::intersect(const float *origin_p,
+        const float *direction_p) const
+{
+    Hit hit;
+    if(m_nodes.isEmpty()) return hit;
+
+    float inverse[3];
+    for(int i = 0; i < 3; ++i) {
+        inverse[i] = 1.0f / direction_p[i];
+    }
+
+    float best = INF;
+    QVarLengthArray<int, 64> stack;
+    stack.append(0);
+
+    while(!stack.isEmpty()) {
+        const Node& node = m_nodes.at(stack.last());
+        stack.removeLast();
+        if(hitBox(node.min, node.max, origin_p, inverse, best) == INF) {
+            continue;
+        }
+
+        if(node.count == 0) {
+            // Visit the nearer child first so it can shorten the ray.
+            const Node& left = m_nodes.at(node.first);
+            const Node& right = m_nodes.at(node.first + 1);
+            const float leftDistance =
+                    hitBox(left.min, left.max, origin_p, inverse, best);
+            const float rightDistance =
+                    hitBox(right.min, right.max, origin_p, inverse, best);
+            if(leftDistance <= rightDistance) {
+                if(rightDistance != INF) stack.append(node.first + 1);
+                if(leftDistance != INF) stack.append(node.first);
+            } else {
+                if(leftDistance != INF) stack.append(node.first);
+                stack.append(node.first + 1);
+            }
+            continue;
+        }
+
+        // ==== Moller-Trumbore ====
+        for(int slot = node.first; slot < node.first + node.count; ++slot) {
+            const float *p = m_triangles.constData() + slot*9;
+            const float e1[3] = { p[3]-p[0], p[4]-p[1], p[5]-p[2] };
+            const float e2[3] = { p[6]-p[0], p[7]-p[1], p[8]-p[2] };
+            const float *d = direction_p;
+            const float h[3] = {
+                d[1]*e2[2] - d[2]*e2[1],
+                d[2]*e2[0] - d[0]*e2[2],
+                d[0]*e2[1] - d[1]*e2[0]
+            };
+            const float a = e1[0]*h[0] + e1[1]*h[1] + e1[2]*h[2];
+            if(std::abs(a) < 1e-12f) continue;
+
+            const float f = 1.0f / a;
+            const float s[3] = {
+                origin_p[0]-p[0], origin_p[1]-p[1], origin_p[2]-p[2]
+            };
+            const float u = f * (s[0]*h[0] + s[1]*h[1] + s[2]*h[2]);
+            if(u < 0.0f || u > 1.0f) continue;
+
+            const float q[3] = {
+                s[1]*e1[2] - s[2]*e1[1],
+                s[2]*e1[0] - s[0]*e1[2],
+                s[0]*e1[1] - s[1]*e1[0]
+            };
+            const float v = f * (d[0]*q[0] + d[1]*q[1] + d[2]*q[2]);
+            if(v < 0.0f || u + v > 1.0f) continue;
+
+            const float t = f * (e2[0]*q[0] + e2[1]*q[1] + e2[2]*q[2]);
+            if(t <= 0.0f || t >= best) continue;
+
+            best = t;
+            hit.triangle = m_triangleIds.at(slot);
+            hit.distance = t;
+            hit.u = u;
+            hit.v = v;
+        }
+    }
+
+    return hit;
+}
+
+//=============================================================================
+int Bvh::subdivide(int node, int first, int count,
+        const QVector<Bounds>& bounds, QVector<int>& ids, int level)
+{
+    m_depth = std::max(m_depth, level);
+
+    Node current;
+    float centroidMin[3] = { INF, INF, INF };
+    float centroidMax[3] = { -INF, -INF, -INF };
+    for(int i = 0; i < 3; ++i) {
+        current.min[i] = INF;
+        current.max[i] = -INF;
+    }
+    for(int i = first; i < first + count; ++i) {
+        const Bounds& b = bounds.at(ids.at(i));
+        grow(current.min, current.max, b.min, b.max);
+        grow(centroidMin, centroidMax, b.centroid, b.centroid);
+    }
+    current.first = first;
+    current.count = count;
+    m_nodes[node] = current;
+
+    if(count <= MAX_LEAF_SIZE) return node;
+
+    // ==== Binned SAH over all three axes ====
+    int bestAxis = -1;
+    int bestSplit = 0;
+    float bestCost = INF;
+    if(level < MAX_SAH_DEPTH) {
+        for(int axis = 0; axis < 3; ++axis) {
+            const float extent = centroidMax[axis] - centroidMin[axis];
+            if(extent <= 0.0f) continue;
+            const float scale = BIN_COUNT / extent;
+
+            int binCounts[BIN_COUNT] = {};
+            float binMin[BIN_COUNT][3];
+            float binMax[BIN_COUNT][3];
+            for(int b = 0; b < BIN_COUNT; ++b) {
+                for(int i = 0; i < 3; ++i) {
+                    binMin[b][i] = INF;
+                    binMax[b][i] = -INF;
+                }
+            }
+            for(int i = first; i < first + count; ++i) {
+                const Bounds& b = bounds.at(ids.at(i));
+                const int bin = std::min(BIN_COUNT - 1,
+                        (int)((b.centroid[axis] - centroidMin[axis]) * scale));
+                ++binCounts[bin];
+                grow(binMin[bin], binMax[bin], b.min, b.max);
+            }
+
+            float rightArea[BIN_COUNT];
+            int rightCount[BIN_COUNT];
+            float accumulatedMin[3] = { INF, INF, INF };
+            float accumulatedMax[3] = { -INF, -INF, -INF };
+            int accumulated = 0;
+            for(int b = BIN_COUNT - 1; b > 0; --b) {
+                grow(accumulatedMin, accumulatedMax, binMin[b], binMax[b]);
+                accumulated += binCounts[b];
+                rightArea[b] = surfaceArea(accumulatedMin, accumulatedMax);
+                rightCount[b] = accumulated;
+            }
+
+            for(int i = 0; i < 3; ++i) {
+                accumulatedMin[i] = INF;
+                accumulatedMax[i] = -INF;
+            }
+            accumulated = 0;
+            for(int b = 0; b < BIN_COUNT - 1; ++b) {
+                grow(accumulatedMin, accumulatedMax, binMin[b], binMax[b]);
+                accumulated += binCounts[b];
+                if(accumulated == 0 || rightCount[b + 1] == 0) continue;
+                const float cost =
+                        surfaceArea(accumulatedMin, accumulatedMax) *
+                        accumulated + rightArea[b + 1] * rightCount[b + 1];
+                if(cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b + 1;
+                }
+            }
+        }
+    }
+
+    const float leafCost = surfaceArea(current.min, current.max) * count;
+    int middle = first;
+    if(bestAxis >= 0) {
+        if(bestCost >= leafCost && count <= 4 * MAX_LEAF_SIZE) return node;
+
+        const float extent = centroidMax[bestAxis] - centroidMin[bestAxis];
+        const float scale = BIN_COUNT / extent;
+        const float axisMin = centroidMin[bestAxis];
+        middle = std::partition(ids.begin() + first,
+                ids.begin() + first + count, [&](int id) {
+            const int bin = std::min(BIN_COUNT - 1,
+                    (int)((bounds.at(id).centroid[bestAxis] - axisMin) *
+                    scale));
+            return bin < bestSplit;
+        }) - ids.begin();
+    }
+
+    // Fall back to a median split when SAH found nothing usable.
+    if(middle <= first || middle >= first + count) {
+        int axis = 0;
+        for(int i = 1; i < 3; ++i) {
+            if(centroidMax[i] - centroidMin[i] >
+                    centroidMax[axis] - centroidMin[axis]) axis = i;
+        }
+        middle = first + count / 2;
+        std::nth_element(ids.begin() + first, ids.begin() + middle,
+                ids.begin() + first + count, [&](int a, int b) {
+            return bounds.at(a).centroid[axis] < bounds.at(b).centroid[axis];
+        });
+    }
+
+    const int children = m_nodes.count();
+    m_nodes.append(Node());
+    m_nodes.append(Node());
+    m_nodes[node].first = children;
+    m_nodes[node].count = 0;
+
+    (void)subdivide(children, first, middle - first, bounds, ids, level + 1);
+    (void)subdivide(children + 1, middle, first + count - middle,
+            bounds, ids, level + 1);
+    return node;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QVector>
+
+//=============================================================================
+// Bounding volume hierarchy over a triangle soup, built with a binned
+// surface area heuristic and flattened into one node array.  Only the
+// triangle positions are copied in, so it can be built off the GUI thread
+// from the same vertex data that goes to the GPU.
+class Bvh
+{
+public:
+    struct Hit
+    {
+        int triangle = -1;
+        float distance = 0.0f;
+        float u = 0.0f;
+        float v = 0.0f;
+
+        bool isValid() const { return triangle >= 0; }
+    };
+
+    Bvh();
+
+    void build(const float *vertices_p, int vertexCount, int stride);
+
+    bool isEmpty() const;
+    int triangleCount() const;
+    int nodeCount() const;
+    int depth() const;
+
+    Hit intersect(const float *origin_p, const float *direction_p) const;
+
+private:
+    struct Node
+    {
+        float min[3];
+        float max[3];
+        int first;
+        int count;
+    };
+
+    struct Bounds
+    {
+        float min[3];
+        float max[3];
+        float centroid[3];
+    };
+
+    static constexpr int BIN_COUNT = 16;
+    static constexpr int MAX_LEAF_SIZE = 4;
+    static constexpr int MAX_SAH_DEPTH = 48;
+
+    int subdivide(int node, int first, int count,
+            const QVector<Bounds>& bounds, QVector<int>& ids, int level);
+
+    QVector<Node> m_nodes;
+    QVector<float> m_triangles;
+    QVector<int> m_triangleIds;
+    int m_depth;
+};
@@ -0,0 +1,345 @@
+#include "ClusterFile.h"
+
+#include <QIODevice>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+    constexpr char MAGIC[8] = { 'G', 'L', 'N', 'L', 'C', 'L', 'S', 'T' };
+    constexpr qint64 HEADER_BYTES = sizeof(MAGIC) + 3 * sizeof(quint32);
+    constexpr qint64 TABLE_ENTRY_BYTES =
+            6 * sizeof(float) + sizeof(quint64) + sizeof(quint32);
+    constexpr float INF = std::numeric_limits<float>::infinity();
+
+    //=========================================================================
+    template<typename T>
+    void appendLittleEndian(QByteArray& buffer, T value)
+    {
+        uchar bytes[sizeof(T)];
+        qToLittleEndian(value, bytes);
+        buffer.append(reinterpret_cast<const char *>(bytes), sizeof(T));
+    }
+
+    //=========================================================================
+    void appendFloat(QByteArray& buffer, float value)
+    {
+        quint32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        appendLittleEndian(buffer, bits);
+    }
+
+    //=========================================================================
+    template<typename T>
+    T takeLittleEndian(const char *&data_p)
+    {
+        const T value = qFromLittleEndian<T>(data_p);
+        data_p += sizeof(T);
+        return value;
+    }
+
+    //=========================================================================
+    float takeFloat(const char *&data_p)
+    {
+        const quint32 bits = takeLittleEndian<quint32>(data_p);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    //=========================================================================
+    // Spreads the low 10 bits of v so there are two zero bits between each.
+    quint32 spreadBits(quint32 v)
+    {
+        v &= 0x3ff;
+        v = (v | (v << 16)) & 0x030000ff;
+        v = (v | (v << 8)) & 0x0300f00f;
+        v = (v | (v << 4)) & 0x030c30c3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    }
+}
+
+//=============================================================================
+bool ClusterFile::write(QIODevice& device, const float *vertices_p,
+        int vertexCount, int valuesPerVertex, int clusterTriangles)
+{
+    if(valuesPerVertex < 3 || vertexCount < 0 || vertexCount % 3 != 0) {
+        return false;
+    }
+    clusterTriangles = qMax(clusterTriangles, 1);
+    const int triangleCount = vertexCount / 3;
+    const int triangleValues = 3 * valuesPerVertex;
+
+    // ==== Order triangles along a Morton curve ====
+    float min[3] = { INF, INF, INF };
+    float max[3] = { -INF, -INF, -INF };
+    QVector<float> centroids(triangleCount * 3);
+    for(int t = 0; t < triangleCount; ++t) {
+        float *c = centroids.data() + t * 3;
+        centroid(vertices_p + t * triangleValues, valuesPerVertex, c);
+        for(int i = 0; i < 3; ++i) {
+            min[i] = std::min(min[i], c[i]);
+            max[i] = std::max(max[i], c[i]);
+        }
+    }
+
+    QVector<quint32> codes(triangleCount);
+    for(int t = 0; t < triangleCount; ++t) {
+        codes[t] = mortonCode(centroids.constData() + t * 3, min, max);
+    }
+
+    QVector<int> order(triangleCount);
+    for(int t = 0; t < triangleCount; ++t) order[t] = t;
+    std::sort(order.begin(), order.end(), [&codes](int a, int b) {
+        if(codes[a] != codes[b]) return codes[a] < codes[b];
+        return a < b;
+    });
+
+    // ==== Cluster table ====
+    QVector<Cluster> clusters =
+            layout(triangleCount, valuesPerVertex, clusterTriangles);
+    for(int c = 0; c < clusters.count(); ++c) {
+        const int first = c * clusterTriangles;
+        const int count = clusters[c].vertexCount / 3;
+        for(int t = first; t < first + count; ++t) {
+            growBounds(clusters[c], vertices_p + order[t] * triangleValues,
+                    valuesPerVertex);
+        }
+    }
+    QByteArray buffer = header(valuesPerVertex, clusters);
+    if(device.write(buffer) != buffer.size()) return false;
+
+    // ==== Vertex data, one cluster at a time ====
+    for(int c = 0; c < clusters.count(); ++c) {
+        buffer.clear();
+        const int first = c * clusterTriangles;
+        const int count = clusters[c].vertexCount / 3;
+        for(int t = first; t < first + count; ++t) {
+            appendTriangle(buffer, vertices_p + order[t] * triangleValues,
+                    valuesPerVertex);
+        }
+        if(device.write(buffer) != buffer.size()) return false;
+    }
+    return true;
+}
+
+//=============================================================================
+ClusterFile::ClusterFile() :
+        m_valuesPerVertex(0)
+{
+}
+
+//=============================================================================
+bool ClusterFile::open(const QString& path)
+{
+    QMutexLocker locker(&m_mutex);
+    m_file.close();
+    m_clusters.clear();
+    m_valuesPerVertex = 0;
+
+    m_file.setFileName(path);
+    if(!m_file.open(QIODevice::ReadOnly)) return false;
+
+    const QByteArray header = m_file.read(HEADER_BYTES);
+    if(header.size() != HEADER_BYTES ||
+            std::memcmp(header.constData(), MAGIC, sizeof(MAGIC)) != 0) {
+        m_file.close();
+        return false;
+    }
+    const char *data_p = header.constData() + sizeof(MAGIC);
+    const quint32 version = takeLittleEndian<quint32>(data_p);
+    const quint32 valuesPerVertex = takeLittleEndian<quint32>(data_p);
+    const quint32 clusterCount = takeLittleEndian<quint32>(data_p);
+    if(version != VERSION || valuesPerVertex < 3 ||
+            clusterCount * TABLE_ENTRY_BYTES >
+            m_file.size() - HEADER_BYTES) {
+        m_file.close();
+        return false;
+    }
+
+    const QByteArray table = m_file.read(clusterCount * TABLE_ENTRY_BYTES);
+    if(table.size() != (int)(clusterCount * TABLE_ENTRY_BYTES)) {
+        m_file.close();
+        return false;
+    }
+
+    QVector<Cluster> clusters(clusterCount);
+    data_p = table.constData();
+    for(auto& cluster : clusters) {
+        for(int i = 0; i < 3; ++i) cluster.min[i] = takeFloat(data_p);
+        for(int i = 0; i < 3; ++i) cluster.max[i] = takeFloat(data_p);
+        cluster.offset = (qint64)takeLittleEndian<quint64>(data_p);
+        cluster.vertexCount = (int)takeLittleEndian<quint32>(data_p);
+
+        const qint64 bytes = (qint64)cluster.vertexCount * valuesPerVertex *
+                sizeof(float);
+        if(cluster.vertexCount < 0 || cluster.offset < 0 ||
+                cluster.offset + bytes > m_file.size()) {
+            m_file.close();
+            return false;
+        }
+    }
+
+    m_valuesPerVertex = valuesPerVertex;
+    m_clusters = clusters;
+    return true;
+}
+
+//=============================================================================
+void ClusterFile::close()
+{
+    QMutexLocker locker(&m_mutex);
+    m_file.close();
+    m_clusters.clear();
+    m_valuesPerVertex = 0;
+}
+
+//=============================================================================
+bool ClusterFile::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+//=============================================================================
+int ClusterFile::valuesPerVertex() const
+{
+    return m_valuesPerVertex;
+}
+
+//=============================================================================
+int ClusterFile::clusterCount() const
+{
+    return m_clusters.count();
+}
+
+//=============================================================================
+const ClusterFile::Cluster& ClusterFile::cluster(int index) const
+{
+    return m_clusters[index];
+}
+
+//=============================================================================
+qint64 ClusterFile::vertexCount() const
+{
+    qint64 count = 0;
+    for(const auto& cluster : m_clusters) count += cluster.vertexCount;
+    return count;
+}
+
+//=============================================================================
+QVector<float> ClusterFile::read(int index) const
+{
+    QVector<float> vertices;
+    if(index < 0 || index >= m_clusters.count()) return vertices;
+    const Cluster& cluster = m_clusters[index];
+    const int valueCount = cluster.vertexCount * m_valuesPerVertex;
+
+    QByteArray bytes;
+    {
+        QMutexLocker locker(&m_mutex);
+        if(!m_file.seek(cluster.offset)) return vertices;
+        bytes = m_file.read((qint64)valueCount * sizeof(float));
+    }
+    if(bytes.size() != valueCount * (int)sizeof(float)) return vertices;
+
+    vertices.resize(valueCount);
+    const char *data_p = bytes.constData();
+    for(int i = 0; i < valueCount; ++i) vertices[i] = takeFloat(data_p);
+    return vertices;
+}
+
+//=============================================================================
+void ClusterFile::centroid(const float *triangle_p, int valuesPerVertex,
+        float *centroid_p)
+{
+    for(int i = 0; i < 3; ++i) {
+        float sum = 0.0f;
+        for(int c = 0; c < 3; ++c) sum += triangle_p[c * valuesPerVertex + i];
+        centroid_p[i] = sum / 3.0f;
+    }
+}
+
+//=============================================================================
+// Ten bits per axis over the box of all centroids.
+quint32 ClusterFile::mortonCode(const float *centroid_p, const float *min_p,
+        const float *max_p)
+{
+    quint32 code = 0;
+    for(int i = 0; i < 3; ++i) {
+        const float extent = max_p[i] - min_p[i];
+        const float u = extent > 0.0f ?
+                (centroid_p[i] - min_p[i]) / extent : 0.0f;
+        code |= spreadBits((quint32)(u * 1023.0f)) << i;
+    }
+    return code;
+}
+
+//=============================================================================
+// Every cluster but the last holds clusterTriangles triangles.  The bounds
+// start out empty.
+QVector<ClusterFile::Cluster> ClusterFile::layout(qint64 triangleCount,
+        int valuesPerVertex, int clusterTriangles)
+{
+    const int clusterCount =
+            (int)((triangleCount + clusterTriangles - 1) / clusterTriangles);
+    QVector<Cluster> clusters(clusterCount);
+    qint64 offset = HEADER_BYTES + clusterCount * TABLE_ENTRY_BYTES;
+    for(int c = 0; c < clusterCount; ++c) {
+        Cluster& cluster = clusters[c];
+        const qint64 first = (qint64)c * clusterTriangles;
+        const int count = (int)qMin<qint64>(clusterTriangles,
+                triangleCount - first);
+        for(int i = 0; i < 3; ++i) {
+            cluster.min[i] = INF;
+            cluster.max[i] = -INF;
+        }
+        cluster.offset = offset;
+        cluster.vertexCount = count * 3;
+        offset += (qint64)cluster.vertexCount * valuesPerVertex *
+                sizeof(float);
+    }
+    return clusters;
+}
+
+//=============================================================================
+void ClusterFile::growBounds(Cluster& cluster, const float *triangle_p,
+        int valuesPerVertex)
+{
+    for(int corner = 0; corner < 3; ++corner) {
+        for(int i = 0; i < 3; ++i) {
+            const float p = triangle_p[corner * valuesPerVertex + i];
+            cluster.min[i] = std::min(cluster.min[i], p);
+            cluster.max[i] = std::max(cluster.max[i], p);
+        }
+    }
+}
+
+//=============================================================================
+QByteArray ClusterFile::header(int valuesPerVertex,
+        const QVector<Cluster>& clusters)
+{
+    QByteArray buffer;
+    buffer.append(MAGIC, sizeof(MAGIC));
+    appendLittleEndian(buffer, VERSION);
+    appendLittleEndian(buffer, (quint32)valuesPerVertex);
+    appendLittleEndian(buffer, (quint32)clusters.count());
+    for(const auto& cluster : clusters) {
+        for(int i = 0; i < 3; ++i) appendFloat(buffer, cluster.min[i]);
+        for(int i = 0; i < 3; ++i) appendFloat(buffer, cluster.max[i]);
+        appendLittleEndian(buffer, (quint64)cluster.offset);
+        appendLittleEndian(buffer, (quint32)cluster.vertexCount);
+    }
+    return buffer;
+}
+
+//=============================================================================
+void ClusterFile::appendTriangle(QByteArray& buffer, const float *triangle_p,
+        int valuesPerVertex)
+{
+    for(int i = 0; i < 3 * valuesPerVertex; ++i) {
+        appendFloat(buffer, triangle_p[i]);
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QFile>
+#include <QMutex>
+#include <QVector>
+
+class QIODevice;
+
+//=============================================================================
+// A triangle mesh on disk, split into spatially coherent clusters that can
+// be read one at a time.  Triangles are ordered along a Morton curve over
+// their centroids and cut into runs of a fixed size, and every cluster
+// records its bounding box, so a renderer can decide what it needs from the
+// table alone and never has to hold the whole mesh in memory.
+//
+// Layout (all little endian):
+//   "GLNLCLST", quint32 version, quint32 valuesPerVertex,
+//   quint32 clusterCount,
+//   clusterCount x { float min[3], float max[3], quint64 offset,
+//                    quint32 vertexCount },
+//   vertex data (float32, valuesPerVertex per vertex)
+//
+// write() needs the whole mesh at once; ClusterWriter makes the same file
+// from a mesh that does not fit in memory.
+class ClusterFile
+{
+public:
+    struct Cluster
+    {
+        float min[3];
+        float max[3];
+        qint64 offset;
+        int vertexCount;
+    };
+
+    static constexpr quint32 VERSION = 1;
+    static constexpr int DEFAULT_CLUSTER_TRIANGLES = 4096;
+
+    static bool write(QIODevice& device, const float *vertices_p,
+            int vertexCount, int valuesPerVertex,
+            int clusterTriangles = DEFAULT_CLUSTER_TRIANGLES);
+
+    ClusterFile();
+
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const;
+
+    int valuesPerVertex() const;
+    int clusterCount() const;
+    const Cluster& cluster(int index) const;
+    qint64 vertexCount() const;
+
+    // Safe to call from several threads at once.
+    QVector<float> read(int index) const;
+
+private:
+    friend class ClusterWriter;
+
+    static void centroid(const float *triangle_p, int valuesPerVertex,
+            float *centroid_p);
+    static quint32 mortonCode(const float *centroid_p, const float *min_p,
+            const float *max_p);
+    static QVector<Cluster> layout(qint64 triangleCount,
+            int valuesPerVertex, int clusterTriangles);
+    static void growBounds(Cluster& cluster, const float *triangle_p,
+            int valuesPerVertex);
+    static QByteArray header(int valuesPerVertex,
+            const QVector<Cluster>& clusters);
+    static void appendTriangle(QByteArray& buffer, const float *triangle_p,
+            int valuesPerVertex);
+
+    mutable QMutex m_mutex;
+    mutable QFile m_file;
+    int m_valuesPerVertex;
+    QVector<Cluster> m_clusters;
+};
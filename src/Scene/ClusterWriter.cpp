@@ -0,0 +1,217 @@
+#include "ClusterWriter.h"
+
+#include <QIODevice>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <vector>
+
+namespace {
+    constexpr float INF = std::numeric_limits<float>::infinity();
+
+    // The next record of a sorted run.
+    struct Head
+    {
+        quint32 code;
+        int run;
+    };
+
+    // Orders the merge queue so the smallest code, then the earliest run,
+    // comes out first.
+    struct LaterHead
+    {
+        bool operator()(const Head& a, const Head& b) const
+        {
+            if(a.code != b.code) return a.code > b.code;
+            return a.run > b.run;
+        }
+    };
+
+    //=========================================================================
+    // Run records are a Morton code and a triangle, in native byte order;
+    // they never leave this machine.
+    bool readRecord(QIODevice& run, QByteArray *record_p, quint32 *code_p)
+    {
+        const qint64 bytes = run.read(record_p->data(), record_p->size());
+        if(bytes != record_p->size()) return false;
+        std::memcpy(code_p, record_p->constData(), sizeof(quint32));
+        return true;
+    }
+}
+
+//=============================================================================
+ClusterWriter::ClusterWriter(int valuesPerVertex, int clusterTriangles,
+        int runTriangles) :
+        m_valuesPerVertex(valuesPerVertex),
+        m_clusterTriangles(qMax(clusterTriangles, 1)),
+        m_runTriangles(qMax(runTriangles, 1)),
+        m_failed(valuesPerVertex < 3),
+        m_triangleCount(0),
+        m_min{ INF, INF, INF },
+        m_max{ -INF, -INF, -INF }
+{
+}
+
+//=============================================================================
+bool ClusterWriter::addTriangles(const float *vertices_p, int vertexCount)
+{
+    if(m_failed) return false;
+    if(vertexCount < 0 || vertexCount % 3 != 0 ||
+            (!m_spill.isOpen() && !m_spill.open())) {
+        m_failed = true;
+        return false;
+    }
+
+    const int triangleValues = 3 * m_valuesPerVertex;
+    for(int t = 0; t < vertexCount / 3; ++t) {
+        float centroid[3];
+        ClusterFile::centroid(vertices_p + t * triangleValues,
+                m_valuesPerVertex, centroid);
+        for(int i = 0; i < 3; ++i) {
+            m_min[i] = std::min(m_min[i], centroid[i]);
+            m_max[i] = std::max(m_max[i], centroid[i]);
+        }
+    }
+
+    const qint64 bytes =
+            (qint64)vertexCount * m_valuesPerVertex * sizeof(float);
+    if(m_spill.write(reinterpret_cast<const char *>(vertices_p), bytes) !=
+            bytes) {
+        m_failed = true;
+        return false;
+    }
+    m_triangleCount += vertexCount / 3;
+    return true;
+}
+
+//=============================================================================
+qint64 ClusterWriter::triangleCount() const
+{
+    return m_triangleCount;
+}
+
+//=============================================================================
+// Ties between runs go to the earlier run, which holds the earlier
+// triangles, so the merge comes out in the order ClusterFile::write sorts
+// the whole mesh into.
+bool ClusterWriter::write(QIODevice& device)
+{
+    if(m_failed || device.isSequential()) return false;
+
+    Runs runs;
+    if(!writeRuns(&runs)) return false;
+
+    // ==== Placeholder table ====
+    const qint64 start = device.pos();
+    QVector<ClusterFile::Cluster> clusters = ClusterFile::layout(
+            m_triangleCount, m_valuesPerVertex, m_clusterTriangles);
+    QByteArray buffer = ClusterFile::header(m_valuesPerVertex, clusters);
+    if(device.write(buffer) != buffer.size()) return false;
+
+    // ==== Merge the runs ====
+    const int triangleValues = 3 * m_valuesPerVertex;
+    const int recordBytes = sizeof(quint32) + triangleValues * sizeof(float);
+    QVector<QByteArray> records(runs.count(), QByteArray(recordBytes, 0));
+    QVector<qint64> left(runs.count());
+    std::priority_queue<Head, std::vector<Head>, LaterHead> heads;
+    for(int r = 0; r < runs.count(); ++r) {
+        left[r] = runs[r]->size() / recordBytes;
+        Head head = { 0, r };
+        if(!runs[r]->seek(0) ||
+                !readRecord(*runs[r], &records[r], &head.code)) {
+            return false;
+        }
+        --left[r];
+        heads.push(head);
+    }
+
+    QVector<float> triangle(triangleValues);
+    int cluster = 0;
+    int filled = 0;
+    buffer.clear();
+    while(!heads.empty()) {
+        Head head = heads.top();
+        heads.pop();
+        std::memcpy(triangle.data(),
+                records[head.run].constData() + sizeof(quint32),
+                triangleValues * sizeof(float));
+        ClusterFile::growBounds(clusters[cluster], triangle.constData(),
+                m_valuesPerVertex);
+        ClusterFile::appendTriangle(buffer, triangle.constData(),
+                m_valuesPerVertex);
+        if(++filled == clusters[cluster].vertexCount / 3) {
+            if(device.write(buffer) != buffer.size()) return false;
+            buffer.clear();
+            ++cluster;
+            filled = 0;
+        }
+
+        if(left[head.run] > 0) {
+            if(!readRecord(*runs[head.run], &records[head.run],
+                    &head.code)) {
+                return false;
+            }
+            --left[head.run];
+            heads.push(head);
+        }
+    }
+
+    // ==== Final table ====
+    const qint64 end = device.pos();
+    buffer = ClusterFile::header(m_valuesPerVertex, clusters);
+    return device.seek(start) && device.write(buffer) == buffer.size() &&
+            device.seek(end);
+}
+
+//=============================================================================
+// Reads the spill back a run at a time and writes each run out sorted.
+bool ClusterWriter::writeRuns(Runs *runs_p)
+{
+    if(m_triangleCount == 0) return true;
+    if(!m_spill.flush() || !m_spill.seek(0)) return false;
+
+    const int triangleValues = 3 * m_valuesPerVertex;
+    const qint64 triangleBytes = triangleValues * sizeof(float);
+    const int recordBytes = sizeof(quint32) + triangleBytes;
+    for(qint64 first = 0; first < m_triangleCount; first += m_runTriangles) {
+        const int count = (int)qMin<qint64>(m_runTriangles,
+                m_triangleCount - first);
+        QVector<float> triangles(count * triangleValues);
+        const qint64 bytes = count * triangleBytes;
+        if(m_spill.read(reinterpret_cast<char *>(triangles.data()),
+                bytes) != bytes) {
+            return false;
+        }
+
+        QVector<quint32> codes(count);
+        for(int t = 0; t < count; ++t) {
+            float centroid[3];
+            ClusterFile::centroid(triangles.constData() + t * triangleValues,
+                    m_valuesPerVertex, centroid);
+            codes[t] = ClusterFile::mortonCode(centroid, m_min, m_max);
+        }
+        QVector<int> order(count);
+        for(int t = 0; t < count; ++t) order[t] = t;
+        std::sort(order.begin(), order.end(), [&codes](int a, int b) {
+            if(codes[a] != codes[b]) return codes[a] < codes[b];
+            return a < b;
+        });
+
+        auto run_p = QSharedPointer<QTemporaryFile>::create();
+        if(!run_p->open()) return false;
+        QByteArray record(recordBytes, 0);
+        for(int t : order) {
+            std::memcpy(record.data(), &codes[t], sizeof(quint32));
+            std::memcpy(record.data() + sizeof(quint32),
+                    triangles.constData() + t * triangleValues,
+                    triangleBytes);
+            if(run_p->write(record) != recordBytes) return false;
+        }
+        if(!run_p->flush()) return false;
+        runs_p->append(run_p);
+    }
+
+    // Later batches still go on the end.
+    return m_spill.seek(m_spill.size());
+}
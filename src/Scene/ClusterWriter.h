@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QSharedPointer>
+#include <QTemporaryFile>
+#include <QVector>
+
+#include "ClusterFile.h"
+
+class QIODevice;
+
+//=============================================================================
+// Makes the same file as ClusterFile::write without holding the mesh in
+// memory.  Triangles are added in batches of any size and spilled to a
+// temporary file as they come.  write() then reads them back in runs of
+// runTriangles, sorts each run along the Morton curve into a temporary file
+// of its own, and merges the runs into the device; only one run and a
+// record per run are in memory at a time.  The cluster table is filled in
+// once the vertex data is written, so the device has to be seekable.
+class ClusterWriter
+{
+public:
+    static constexpr int DEFAULT_RUN_TRIANGLES = 256 * 1024;
+
+    ClusterWriter(int valuesPerVertex,
+            int clusterTriangles = ClusterFile::DEFAULT_CLUSTER_TRIANGLES,
+            int runTriangles = DEFAULT_RUN_TRIANGLES);
+
+    ClusterWriter(const ClusterWriter&) = delete;
+    ClusterWriter& operator=(const ClusterWriter&) = delete;
+
+    // vertexCount must be a multiple of three.  Once a call fails the
+    // writer stays failed.
+    bool addTriangles(const float *vertices_p, int vertexCount);
+    qint64 triangleCount() const;
+
+    bool write(QIODevice& device);
+
+private:
+    typedef QVector<QSharedPointer<QTemporaryFile>> Runs;
+
+    bool writeRuns(Runs *runs_p);
+
+    int m_valuesPerVertex;
+    int m_clusterTriangles;
+    int m_runTriangles;
+    QTemporaryFile m_spill;
+    bool m_failed;
+    qint64 m_triangleCount;
+    float m_min[3];
+    float m_max[3];
+};
@@ -0,0 +1,115 @@
+#include "GeometryArena.h"
+
+#include "ModelTools.h"
+
+//=============================================================================
+GeometryArena::GeometryArena(quint32 pageVertices) :
+        m_pageVertices(pageVertices),
+        m_initialized(false)
+{
+}
+
+//=============================================================================
+void GeometryArena::initialize()
+{
+    initializeOpenGLFunctions();
+    m_initialized = true;
+}
+
+//=============================================================================
+void GeometryArena::release()
+{
+    if(!m_initialized) return;
+    for(auto& page : m_pages) {
+        glDeleteBuffers(1, &page.buffer);
+    }
+    m_pages.clear();
+}
+
+//=============================================================================
+ArenaRange GeometryArena::allocate(const GLfloat *data_p, int vertexCount)
+{
+    ArenaRange range;
+    if(!m_initialized || vertexCount <= 0) return range;
+
+    for(int i = 0; i < m_pages.count(); ++i) {
+        const quint32 first = m_pages[i].allocator.allocate(vertexCount);
+        if(first != OffsetAllocator::INVALID) {
+            range.page = i;
+            range.first = first;
+            break;
+        }
+    }
+
+    if(!range.isValid()) {
+        const int page = addPage(qMax(m_pageVertices, (quint32)vertexCount));
+        if(page < 0) return range;
+        range.page = page;
+        range.first = m_pages[page].allocator.allocate(vertexCount);
+    }
+    range.count = vertexCount;
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_pages[range.page].buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, range.first * STRIDE,
+            vertexCount * STRIDE, data_p);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return range;
+}
+
+//=============================================================================
+void GeometryArena::free(const ArenaRange& range)
+{
+    if(range.page < 0 || range.page >= m_pages.count()) return;
+    (void)m_pages[range.page].allocator.free(range.first);
+}
+
+//=============================================================================
+int GeometryArena::pageCount() const
+{
+    return m_pages.count();
+}
+
+//=============================================================================
+GLuint GeometryArena::buffer(int page) const
+{
+    return m_pages.value(page).buffer;
+}
+
+//=============================================================================
+quint32 GeometryArena::pageVertices(int page) const
+{
+    return m_pages.value(page).allocator.capacity();
+}
+
+//=============================================================================
+quint32 GeometryArena::usedVertices() const
+{
+    quint32 used = 0;
+    for(const auto& page : m_pages) used += page.allocator.used();
+    return used;
+}
+
+//=============================================================================
+quint32 GeometryArena::reservedVertices() const
+{
+    quint32 reserved = 0;
+    for(const auto& page : m_pages) reserved += page.allocator.capacity();
+    return reserved;
+}
+
+//=============================================================================
+int GeometryArena::addPage(quint32 vertices)
+{
+    Page page;
+    glGenBuffers(1, &page.buffer);
+    if(!page.buffer) return -1;
+
+    glBindBuffer(GL_ARRAY_BUFFER, page.buffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices * STRIDE, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    page.allocator.reset(vertices);
+    m_pages.append(page);
+    return m_pages.count() - 1;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QVector>
+
+#include "GlRecorder.h"
+#include "OffsetAllocator.h"
+
+//=============================================================================
+struct ArenaRange
+{
+    int page = -1;
+    GLint first = 0;
+    GLsizei count = 0;
+
+    bool isValid() const { return page >= 0; }
+};
+
+//=============================================================================
+// Keeps vertex data (in the ModelTools layout) for many meshes in a few large
+// GL buffers.  Each buffer is allocated once and then sub-allocated in whole
+// vertices, so meshes can share attribute pointers and be drawn with
+// glDrawArrays(first, count).  Meshes larger than a page get a page of their
+// own.
+class GeometryArena : protected RecordingFunctions
+{
+public:
+    static constexpr quint32 DEFAULT_PAGE_VERTICES = 256 * 1024;
+
+    GeometryArena(quint32 pageVertices = DEFAULT_PAGE_VERTICES);
+
+    void initialize();
+    void release();
+
+    ArenaRange allocate(const GLfloat *data_p, int vertexCount);
+    void free(const ArenaRange& range);
+
+    int pageCount() const;
+    GLuint buffer(int page) const;
+    quint32 pageVertices(int page) const;
+    quint32 usedVertices() const;
+    quint32 reservedVertices() const;
+
+private:
+    struct Page
+    {
+        GLuint buffer = 0;
+        OffsetAllocator allocator;
+    };
+
+    int addPage(quint32 vertices);
+
+    quint32 m_pageVertices;
+    QVector<Page> m_pages;
+    bool m_initialized;
+};
@@ -0,0 +1,389 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OCCLUSION_CULLER_SSE2
+#endif
+
+namespace {
+    // Corners nearer than this are treated as crossing the near plane.
+    constexpr float NEAR_W = 1.0e-5f;
+
+    // Lets an occluder's own box pass the test against its own depth.
+    constexpr float DEPTH_BIAS = 1.0e-5f;
+
+    constexpr int MAX_TEST_TEXELS = 4;
+
+    //=========================================================================
+    void transform(const float *m_p, const float *p_p, float *clip_p)
+    {
+        for(int i = 0; i < 4; ++i) {
+            clip_p[i] = m_p[i] * p_p[0] + m_p[4 + i] * p_p[1] +
+                    m_p[8 + i] * p_p[2] + m_p[12 + i];
+        }
+    }
+}
+
+//=============================================================================
+QVector<float> OcclusionCuller::simplifyOccluder(const float *vertices_p,
+        int vertexCount, int stride, int maxTriangles)
+{
+    const int triangleCount = vertexCount / 3;
+    QVector<float> areas(triangleCount);
+    for(int t = 0; t < triangleCount; ++t) {
+        const float *a_p = vertices_p + (3 * t) * stride;
+        const float *b_p = a_p + stride;
+        const float *c_p = b_p + stride;
+        float ab[3];
+        float ac[3];
+        for(int i = 0; i < 3; ++i) {
+            ab[i] = b_p[i] - a_p[i];
+            ac[i] = c_p[i] - a_p[i];
+        }
+        const float x = ab[1] * ac[2] - ab[2] * ac[1];
+        const float y = ab[2] * ac[0] - ab[0] * ac[2];
+        const float z = ab[0] * ac[1] - ab[1] * ac[0];
+        areas[t] = x * x + y * y + z * z;
+    }
+
+    // The kept triangles stay in mesh order for better locality.
+    QVector<int> order(triangleCount);
+    std::iota(order.begin(), order.end(), 0);
+    if(triangleCount > maxTriangles) {
+        std::nth_element(order.begin(), order.begin() + maxTriangles,
+                order.end(), [&areas](int left, int right) {
+            return areas[left] > areas[right];
+        });
+        order.resize(qMax(maxTriangles, 0));
+        std::sort(order.begin(), order.end());
+    }
+
+    QVector<float> positions;
+    positions.reserve(order.count() * 9);
+    for(int t : order) {
+        if(!(areas[t] > 0.0f)) continue;
+        for(int corner = 0; corner < 3; ++corner) {
+            const float *v_p = vertices_p + (3 * t + corner) * stride;
+            positions.append(v_p[0]);
+            positions.append(v_p[1]);
+            positions.append(v_p[2]);
+        }
+    }
+    return positions;
+}
+
+//=============================================================================
+OcclusionCuller::OcclusionCuller(int width, int height)
+{
+    resize(width, height);
+}
+
+//=============================================================================
+void OcclusionCuller::resize(int width, int height)
+{
+    Level base;
+    base.width = qMax((width + 3) & ~3, 4);
+    base.height = qMax(height, 1);
+    base.depth = QVector<float>(base.width * base.height, 1.0f);
+    m_levels = { base };
+    m_stats = Stats();
+}
+
+//=============================================================================
+int OcclusionCuller::width() const
+{
+    return m_levels[0].width;
+}
+
+//=============================================================================
+int OcclusionCuller::height() const
+{
+    return m_levels[0].height;
+}
+
+//=============================================================================
+void OcclusionCuller::clear()
+{
+    m_levels.resize(1);
+    m_levels[0].depth.fill(1.0f);
+    m_stats = Stats();
+}
+
+//=============================================================================
+void OcclusionCuller::drawOccluder(const float *matrix_p,
+        const float *positions_p, int triangleCount)
+{
+    ++m_stats.occluders;
+    const float halfWidth = m_levels[0].width * 0.5f;
+    const float halfHeight = m_levels[0].height * 0.5f;
+
+    for(int t = 0; t < triangleCount; ++t) {
+        float screen[3][3];
+        bool nearClipped = false;
+        for(int corner = 0; corner < 3; ++corner) {
+            float clip[4];
+            transform(matrix_p, positions_p + (3 * t + corner) * 3, clip);
+            if(clip[3] < NEAR_W || clip[2] < -clip[3]) {
+                nearClipped = true;
+                break;
+            }
+            const float inverseW = 1.0f / clip[3];
+            screen[corner][0] = (clip[0] * inverseW + 1.0f) * halfWidth;
+            screen[corner][1] = (clip[1] * inverseW + 1.0f) * halfHeight;
+            screen[corner][2] = (clip[2] * inverseW + 1.0f) * 0.5f;
+        }
+        if(nearClipped) continue;
+
+        rasterize(screen[0], screen[1], screen[2]);
+        ++m_stats.triangles;
+    }
+}
+
+//=============================================================================
+// Each texel of a level holds the farthest depth of the 2x2 texels below.
+void OcclusionCuller::buildHierarchy()
+{
+    m_levels.resize(1);
+    while(m_levels.last().width > 1 || m_levels.last().height > 1) {
+        const Level fine = m_levels.last();
+        Level coarse;
+        coarse.width = (fine.width + 1) / 2;
+        coarse.height = (fine.height + 1) / 2;
+        coarse.depth.resize(coarse.width * coarse.height);
+
+        for(int y = 0; y < coarse.height; ++y) {
+            const int y0 = 2 * y;
+            const int y1 = qMin(y0 + 1, fine.height - 1);
+            for(int x = 0; x < coarse.width; ++x) {
+                const int x0 = 2 * x;
+                const int x1 = qMin(x0 + 1, fine.width - 1);
+                coarse.depth[y * coarse.width + x] = std::max(
+                        std::max(fine.depth[y0 * fine.width + x0],
+                                fine.depth[y0 * fine.width + x1]),
+                        std::max(fine.depth[y1 * fine.width + x0],
+                                fine.depth[y1 * fine.width + x1]));
+            }
+        }
+        m_levels.append(coarse);
+    }
+}
+
+//=============================================================================
+int OcclusionCuller::levelCount() const
+{
+    return m_levels.count();
+}
+
+//=============================================================================
+float OcclusionCuller::depth(int x, int y, int level) const
+{
+    const Level& l = m_levels[level];
+    return l.depth[y * l.width + x];
+}
+
+//=============================================================================
+float OcclusionCuller::screenCoverage(const float *matrix_p,
+        const float *min_p, const float *max_p) const
+{
+    ScreenRect rect;
+    if(!projectBox(matrix_p, min_p, max_p, &rect)) return 1.0f;
+
+    const Level& base = m_levels[0];
+    const float w = std::min(rect.max[0], (float)base.width) -
+            std::max(rect.min[0], 0.0f);
+    const float h = std::min(rect.max[1], (float)base.height) -
+            std::max(rect.min[1], 0.0f);
+    if(w <= 0.0f || h <= 0.0f) return 0.0f;
+    return (w * h) / (base.width * base.height);
+}
+
+//=============================================================================
+// Boxes that are off screen or beyond the far plane count as hidden too.
+bool OcclusionCuller::isVisible(const float *matrix_p, const float *min_p,
+        const float *max_p)
+{
+    ++m_stats.tested;
+    ScreenRect rect;
+    if(!projectBox(matrix_p, min_p, max_p, &rect)) return true;
+
+    const Level& base = m_levels[0];
+    bool visible = false;
+    if(rect.min[2] <= 1.0f && rect.max[0] >= 0.0f && rect.max[1] >= 0.0f &&
+            rect.min[0] < base.width && rect.min[1] < base.height) {
+        const int x0 = (int)std::max(rect.min[0], 0.0f);
+        const int y0 = (int)std::max(rect.min[1], 0.0f);
+        const int x1 = (int)std::min(rect.max[0], base.width - 1.0f);
+        const int y1 = (int)std::min(rect.max[1], base.height - 1.0f);
+
+        int level = 0;
+        while(level + 1 < m_levels.count() &&
+                ((x1 >> level) - (x0 >> level) >= MAX_TEST_TEXELS ||
+                (y1 >> level) - (y0 >> level) >= MAX_TEST_TEXELS)) {
+            ++level;
+        }
+
+        const Level& test = m_levels[level];
+        for(int y = y0 >> level; !visible && y <= (y1 >> level); ++y) {
+            for(int x = x0 >> level; x <= (x1 >> level); ++x) {
+                if(test.depth[y * test.width + x] + DEPTH_BIAS >=
+                        rect.min[2]) {
+                    visible = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    if(!visible) ++m_stats.culled;
+    return visible;
+}
+
+//=============================================================================
+const OcclusionCuller::Stats& OcclusionCuller::stats() const
+{
+    return m_stats;
+}
+
+//=============================================================================
+// Returns false if a corner of the box reaches in front of the near plane.
+bool OcclusionCuller::projectBox(const float *matrix_p, const float *min_p,
+        const float *max_p, ScreenRect *rect_p) const
+{
+    const float halfWidth = m_levels[0].width * 0.5f;
+    const float halfHeight = m_levels[0].height * 0.5f;
+
+    for(int i = 0; i < 3; ++i) {
+        rect_p->min[i] = HUGE_VALF;
+        rect_p->max[i] = -HUGE_VALF;
+    }
+    for(int i = 0; i < 8; ++i) {
+        const float corner[3] = {
+            (i & 1) ? max_p[0] : min_p[0],
+            (i & 2) ? max_p[1] : min_p[1],
+            (i & 4) ? max_p[2] : min_p[2]
+        };
+        float clip[4];
+        transform(matrix_p, corner, clip);
+        if(clip[3] < NEAR_W || clip[2] < -clip[3]) return false;
+
+        const float inverseW = 1.0f / clip[3];
+        const float screen[3] = {
+            (clip[0] * inverseW + 1.0f) * halfWidth,
+            (clip[1] * inverseW + 1.0f) * halfHeight,
+            (clip[2] * inverseW + 1.0f) * 0.5f
+        };
+        for(int j = 0; j < 3; ++j) {
+            rect_p->min[j] = std::min(rect_p->min[j], screen[j]);
+            rect_p->max[j] = std::max(rect_p->max[j], screen[j]);
+        }
+    }
+    return true;
+}
+
+//=============================================================================
+// Keeps the nearest depth at every pixel whose center the triangle covers.
+// Corners are x and y in pixels and window depth.
+void OcclusionCuller::rasterize(const float *v0_p, const float *v1_p,
+        const float *v2_p)
+{
+    // Both windings are drawn, so put the corners in counterclockwise order.
+    float area = (v1_p[0] - v0_p[0]) * (v2_p[1] - v0_p[1]) -
+            (v2_p[0] - v0_p[0]) * (v1_p[1] - v0_p[1]);
+    if(area < 0.0f) {
+        std::swap(v1_p, v2_p);
+        area = -area;
+    }
+    if(!(area > 0.0f)) return;
+
+    Level& base = m_levels[0];
+    const float minX = std::min({ v0_p[0], v1_p[0], v2_p[0] });
+    const float maxX = std::max({ v0_p[0], v1_p[0], v2_p[0] });
+    const float minY = std::min({ v0_p[1], v1_p[1], v2_p[1] });
+    const float maxY = std::max({ v0_p[1], v1_p[1], v2_p[1] });
+    if(maxX < 0.0f || maxY < 0.0f ||
+            minX > base.width || minY > base.height) {
+        return;
+    }
+
+    // Rows start on a multiple of four so whole groups stay in the row.
+    const int x0 = (int)std::max(std::floor(minX), 0.0f) & ~3;
+    const int x1 = (int)std::min(std::ceil(maxX), base.width - 1.0f);
+    const int y0 = (int)std::max(std::floor(minY), 0.0f);
+    const int y1 = (int)std::min(std::ceil(maxY), base.height - 1.0f);
+
+    // Edge e is the one opposite corner e; its function is positive inside
+    // and, divided by the area, is that corner's barycentric weight.
+    const float *corners[3] = { v0_p, v1_p, v2_p };
+    float a[3];
+    float b[3];
+    float c[3];
+    for(int e = 0; e < 3; ++e) {
+        const float *p_p = corners[(e + 1) % 3];
+        const float *q_p = corners[(e + 2) % 3];
+        a[e] = p_p[1] - q_p[1];
+        b[e] = q_p[0] - p_p[0];
+        c[e] = p_p[0] * q_p[1] - p_p[1] * q_p[0];
+    }
+    const float inverseArea = 1.0f / area;
+    const float zA = (a[0] * v0_p[2] + a[1] * v1_p[2] + a[2] * v2_p[2]) *
+            inverseArea;
+    const float zB = (b[0] * v0_p[2] + b[1] * v1_p[2] + b[2] * v2_p[2]) *
+            inverseArea;
+    const float zC = (c[0] * v0_p[2] + c[1] * v1_p[2] + c[2] * v2_p[2]) *
+            inverseArea;
+
+#ifdef OCCLUSION_CULLER_SSE2
+    const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 farPlane = _mm_set1_ps(1.0f);
+    const __m128 a0 = _mm_set1_ps(a[0]);
+    const __m128 a1 = _mm_set1_ps(a[1]);
+    const __m128 a2 = _mm_set1_ps(a[2]);
+    const __m128 za = _mm_set1_ps(zA);
+
+    for(int y = y0; y <= y1; ++y) {
+        const float py = y + 0.5f;
+        const __m128 r0 = _mm_set1_ps(b[0] * py + c[0]);
+        const __m128 r1 = _mm_set1_ps(b[1] * py + c[1]);
+        const __m128 r2 = _mm_set1_ps(b[2] * py + c[2]);
+        const __m128 rz = _mm_set1_ps(zB * py + zC);
+        float *row_p = base.depth.data() + y * base.width;
+
+        for(int x = x0; x <= x1; x += 4) {
+            const __m128 px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+            __m128 inside = _mm_cmpge_ps(
+                    _mm_add_ps(_mm_mul_ps(a0, px), r0), zero);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(
+                    _mm_add_ps(_mm_mul_ps(a1, px), r1), zero));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(
+                    _mm_add_ps(_mm_mul_ps(a2, px), r2), zero));
+
+            // Pixels outside the triangle are offered the far plane, which
+            // never wins the minimum.
+            const __m128 z = _mm_add_ps(_mm_mul_ps(za, px), rz);
+            const __m128 offered = _mm_or_ps(_mm_and_ps(inside, z),
+                    _mm_andnot_ps(inside, farPlane));
+            _mm_storeu_ps(row_p + x,
+                    _mm_min_ps(_mm_loadu_ps(row_p + x), offered));
+        }
+    }
+#else
+    for(int y = y0; y <= y1; ++y) {
+        const float py = y + 0.5f;
+        float *row_p = base.depth.data() + y * base.width;
+        for(int x = x0; x <= x1; ++x) {
+            const float px = x + 0.5f;
+            if(a[0] * px + b[0] * py + c[0] < 0.0f ||
+                    a[1] * px + b[1] * py + c[1] < 0.0f ||
+                    a[2] * px + b[2] * py + c[2] < 0.0f) {
+                continue;
+            }
+            row_p[x] = std::min(row_p[x], zA * px + zB * py + zC);
+        }
+    }
+#endif
+}
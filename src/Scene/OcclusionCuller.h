@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QVector>
+
+//=============================================================================
+// Software occlusion culling.  A few large occluders are rasterized into a
+// small CPU depth buffer, four pixels at a time with SSE2 where available,
+// and a max-depth pyramid is built over it.  Bounding boxes are then tested
+// against the coarsest pyramid level where they cover at most 4x4 texels:
+// a box is hidden when every texel it touches holds something nearer than
+// the nearest point of the box.
+//
+// Matrices are column-major model-view-projection matrices in the layout
+// of QMatrix4x4::constData(), and depth follows GL's [0, 1] window range.
+// Occluder triangles that reach in front of the near plane are skipped and
+// boxes that do are always visible, so culling only errs on the side of
+// drawing too much.
+class OcclusionCuller
+{
+public:
+    struct Stats
+    {
+        int occluders = 0;
+        int triangles = 0;
+        int tested = 0;
+        int culled = 0;
+    };
+
+    static constexpr int DEFAULT_WIDTH = 256;
+    static constexpr int DEFAULT_HEIGHT = 128;
+    static constexpr int DEFAULT_OCCLUDER_TRIANGLES = 256;
+
+    // Keeps the largest triangles of a mesh, which is a stand-in that can
+    // only ever hide less than the mesh itself.  Returns packed positions.
+    static QVector<float> simplifyOccluder(const float *vertices_p,
+            int vertexCount, int stride,
+            int maxTriangles = DEFAULT_OCCLUDER_TRIANGLES);
+
+    OcclusionCuller(int width = DEFAULT_WIDTH, int height = DEFAULT_HEIGHT);
+
+    // The width is rounded up to a multiple of four.
+    void resize(int width, int height);
+    int width() const;
+    int height() const;
+
+    void clear();
+    void drawOccluder(const float *matrix_p, const float *positions_p,
+            int triangleCount);
+    void buildHierarchy();
+
+    int levelCount() const;
+    float depth(int x, int y, int level = 0) const;
+
+    // The fraction of the buffer covered by the box's screen rectangle; 1
+    // for boxes that reach in front of the near plane.
+    float screenCoverage(const float *matrix_p, const float *min_p,
+            const float *max_p) const;
+    bool isVisible(const float *matrix_p, const float *min_p,
+            const float *max_p);
+
+    const Stats& stats() const;
+
+private:
+    struct Level
+    {
+        int width;
+        int height;
+        QVector<float> depth;
+    };
+
+    struct ScreenRect
+    {
+        float min[3];
+        float max[3];
+    };
+
+    bool projectBox(const float *matrix_p, const float *min_p,
+            const float *max_p, ScreenRect *rect_p) const;
+    void rasterize(const float *v0_p, const float *v1_p, const float *v2_p);
+
+    QVector<Level> m_levels;
+    Stats m_stats;
+};
@@ -0,0 +1,127 @@
+#include "OffsetAllocator.h"
+
+constexpr quint32 OffsetAllocator::INVALID;
+
+//=============================================================================
+OffsetAllocator::OffsetAllocator(quint32 capacity) :
+        m_capacity(0),
+        m_used(0)
+{
+    reset(capacity);
+}
+
+//=============================================================================
+void OffsetAllocator::reset(quint32 capacity)
+{
+    m_capacity = capacity;
+    m_used = 0;
+    m_freeByOffset.clear();
+    m_freeBySize.clear();
+    m_allocations.clear();
+    if(capacity > 0) insertFree(0, capacity);
+}
+
+//=============================================================================
+quint32 OffsetAllocator::allocate(quint32 size)
+{
+    if(size == 0) return INVALID;
+
+    auto best = m_freeBySize.lowerBound(size);
+    if(best == m_freeBySize.end()) return INVALID;
+
+    const quint32 blockSize = best.key();
+    const quint32 offset = best.value();
+    removeFree(offset, blockSize);
+    if(blockSize > size) insertFree(offset + size, blockSize - size);
+
+    (void)m_allocations.insert(offset, size);
+    m_used += size;
+    return offset;
+}
+
+//=============================================================================
+bool OffsetAllocator::free(quint32 offset)
+{
+    auto allocation = m_allocations.find(offset);
+    if(allocation == m_allocations.end()) return false;
+
+    quint32 start = offset;
+    quint32 size = allocation.value();
+    m_used -= size;
+    (void)m_allocations.erase(allocation);
+
+    // ==== Merge with the following free block ====
+    auto next = m_freeByOffset.find(start + size);
+    if(next != m_freeByOffset.end()) {
+        const quint32 nextSize = next.value();
+        removeFree(start + size, nextSize);
+        size += nextSize;
+    }
+
+    // ==== Merge with the preceding free block ====
+    auto previous = m_freeByOffset.lowerBound(start);
+    if(previous != m_freeByOffset.begin()) {
+        --previous;
+        if(previous.key() + previous.value() == start) {
+            const quint32 previousStart = previous.key();
+            const quint32 previousSize = previous.value();
+            removeFree(previousStart, previousSize);
+            start = previousStart;
+            size += previousSize;
+        }
+    }
+
+    insertFree(start, size);
+    return true;
+}
+
+//=============================================================================
+quint32 OffsetAllocator::sizeOf(quint32 offset) const
+{
+    return m_allocations.value(offset, 0);
+}
+
+//=============================================================================
+quint32 OffsetAllocator::capacity() const
+{
+    return m_capacity;
+}
+
+//=============================================================================
+quint32 OffsetAllocator::used() const
+{
+    return m_used;
+}
+
+//=============================================================================
+quint32 OffsetAllocator::largestFreeBlock() const
+{
+    if(m_freeBySize.isEmpty()) return 0;
+    return m_freeBySize.lastKey();
+}
+
+//=============================================================================
+int OffsetAllocator::freeBlockCount() const
+{
+    return m_freeByOffset.count();
+}
+
+//=============================================================================
+int OffsetAllocator::allocationCount() const
+{
+    return m_allocations.count();
+}
+
+//=============================================================================
+void OffsetAllocator::insertFree(quint32 offset, quint32 size)
+{
+    (void)m_freeByOffset.insert(offset, size);
+    (void)m_freeBySize.insert(size, offset);
+}
+
+//=============================================================================
+void OffsetAllocator::removeFree(quint32 offset, quint32 size)
+{
+    (void)m_freeByOffset.remove(offset);
+    (void)m_freeBySize.remove(size, offset);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QMap>
+#include <QtGlobal>
+
+//=============================================================================
+// Hands out ranges of a fixed-size address space (e.g. vertex slots in a GL
+// buffer) without ever touching the memory itself.  Allocation is best fit
+// over a size-ordered free list, and freed ranges are merged with their free
+// neighbours so the space does not fragment under load/unload churn.
+class OffsetAllocator
+{
+public:
+    static constexpr quint32 INVALID = 0xFFFFFFFF;
+
+    OffsetAllocator(quint32 capacity = 0);
+
+    void reset(quint32 capacity);
+
+    quint32 allocate(quint32 size);
+    bool free(quint32 offset);
+    quint32 sizeOf(quint32 offset) const;
+
+    quint32 capacity() const;
+    quint32 used() const;
+    quint32 largestFreeBlock() const;
+    int freeBlockCount() const;
+    int allocationCount() const;
+
+private:
+    void insertFree(quint32 offset, quint32 size);
+    void removeFree(quint32 offset, quint32 size);
+
+    quint32 m_capacity;
+    quint32 m_used;
+    QMap<quint32, quint32> m_freeByOffset;
+    QMultiMap<quint32, quint32> m_freeBySize;
+    QMap<quint32, quint32> m_allocations;
+};
@@ -0,0 +1,293 @@
+#include "PointOctree.h"
+
+#include <QHash>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <queue>
+
+namespace {
+    constexpr float INF = std::numeric_limits<float>::infinity();
+
+    //=========================================================================
+    void childCenter(const float *center_p, float halfSize, int octant,
+            float *result_p)
+    {
+        const float quarter = 0.5f * halfSize;
+        for(int i = 0; i < 3; ++i) {
+            const bool upper = (octant & (1 << i)) != 0;
+            result_p[i] = center_p[i] + (upper ? quarter : -quarter);
+        }
+    }
+}
+
+//=============================================================================
+PointOctree::PointOctree(int nodePoints) :
+        m_nodePoints(qMax(nodePoints, 1)),
+        m_gridSize(qMax(1, (int)std::ceil(std::cbrt((double)m_nodePoints)))),
+        m_source_p(nullptr),
+        m_stride(0)
+{
+}
+
+//=============================================================================
+void PointOctree::build(const float *vertices_p, int vertexCount, int stride)
+{
+    m_nodes.clear();
+    m_vertices.clear();
+    if(vertexCount <= 0) return;
+
+    m_source_p = vertices_p;
+    m_stride = stride;
+
+    // ==== Bounding cube ====
+    float min[3] = { INF, INF, INF };
+    float max[3] = { -INF, -INF, -INF };
+    for(int v = 0; v < vertexCount; ++v) {
+        const float *p = vertices_p + v * stride;
+        for(int i = 0; i < 3; ++i) {
+            min[i] = std::min(min[i], p[i]);
+            max[i] = std::max(max[i], p[i]);
+        }
+    }
+    float center[3];
+    float halfSize = 0.0f;
+    for(int i = 0; i < 3; ++i) {
+        center[i] = 0.5f * (min[i] + max[i]);
+        halfSize = std::max(halfSize, 0.5f * (max[i] - min[i]));
+    }
+    // Points on the upper faces must still land inside.
+    halfSize = std::max(halfSize * 1.0001f, 1e-6f);
+
+    QVector<int> ids(vertexCount);
+    for(int v = 0; v < vertexCount; ++v) ids[v] = v;
+
+    // ==== Root, then the eight subtrees in parallel ====
+    Split root = split(ids, center, halfSize, 0);
+    ids.clear();
+
+    QVector<int> octants;
+    for(int octant = 0; octant < 8; ++octant) octants.append(octant);
+    QVector<Subtree> subtrees(8);
+    Subtree *subtrees_p = subtrees.data();
+    QtConcurrent::blockingMap(octants, [&](int octant) {
+        if(root.children[octant].isEmpty()) return;
+        float c[3];
+        childCenter(center, halfSize, octant, c);
+        (void)buildSubtree(root.children[octant], c, 0.5f * halfSize, 1,
+                subtrees_p[octant]);
+    });
+
+    // ==== Splice into one preorder node array ====
+    QVector<int> order = root.own;
+    Node rootNode;
+    std::memcpy(rootNode.center, center, sizeof(center));
+    rootNode.halfSize = halfSize;
+    rootNode.spacing = root.spacing;
+    rootNode.first = 0;
+    rootNode.count = root.own.count();
+    std::fill(rootNode.children, rootNode.children + 8, -1);
+    m_nodes.append(rootNode);
+
+    for(int octant = 0; octant < 8; ++octant) {
+        const Subtree& subtree = subtrees[octant];
+        if(subtree.nodes.isEmpty()) continue;
+
+        const int nodeOffset = m_nodes.count();
+        const int pointOffset = order.count();
+        for(Node node : subtree.nodes) {
+            node.first += pointOffset;
+            node.subtreeEnd += pointOffset;
+            for(auto& child : node.children) {
+                if(child >= 0) child += nodeOffset;
+            }
+            m_nodes.append(node);
+        }
+        order += subtree.order;
+        m_nodes[0].children[octant] = nodeOffset;
+    }
+    m_nodes[0].subtreeEnd = order.count();
+
+    // ==== Reorder the vertex records ====
+    m_vertices.resize(order.count() * stride);
+    for(int i = 0; i < order.count(); ++i) {
+        std::memcpy(m_vertices.data() + i * stride,
+                vertices_p + order[i] * stride, stride * sizeof(float));
+    }
+    m_source_p = nullptr;
+}
+
+//=============================================================================
+bool PointOctree::isEmpty() const
+{
+    return m_nodes.isEmpty();
+}
+
+//=============================================================================
+int PointOctree::pointCount() const
+{
+    return m_nodes.isEmpty() ? 0 : m_nodes.first().subtreeEnd;
+}
+
+//=============================================================================
+int PointOctree::nodeCount() const
+{
+    return m_nodes.count();
+}
+
+//=============================================================================
+const PointOctree::Node& PointOctree::node(int index) const
+{
+    return m_nodes.at(index);
+}
+
+//=============================================================================
+const QVector<float>& PointOctree::vertices() const
+{
+    return m_vertices;
+}
+
+//=============================================================================
+QVector<PointOctree::Range> PointOctree::select(const View& view,
+        int pointBudget, float maxErrorPixels, int *selectedPoints_p) const
+{
+    QVector<Range> ranges;
+    if(selectedPoints_p) *selectedPoints_p = 0;
+    if(m_nodes.isEmpty()) return ranges;
+
+    // Refine the node with the largest on-screen error first, until the
+    // error is small enough or the next children would not fit the budget.
+    using Candidate = std::pair<float, int>;
+    std::priority_queue<Candidate> queue;
+
+    QVector<int> selected;
+    selected.append(0);
+    int points = m_nodes[0].count;
+    queue.push({ projectedError(m_nodes[0], view), 0 });
+
+    while(!queue.empty()) {
+        const Candidate candidate = queue.top();
+        queue.pop();
+        if(candidate.first <= maxErrorPixels) break;
+
+        const Node& node = m_nodes[candidate.second];
+        for(int child : node.children) {
+            if(child < 0) continue;
+            const Node& childNode = m_nodes[child];
+            if(points + childNode.count > pointBudget) continue;
+            points += childNode.count;
+            selected.append(child);
+            queue.push({ projectedError(childNode, view), child });
+        }
+    }
+
+    // Preorder layout: sorting by offset lets neighbours merge.
+    std::sort(selected.begin(), selected.end(), [this](int a, int b) {
+        return m_nodes[a].first < m_nodes[b].first;
+    });
+    for(int index : selected) {
+        const Node& node = m_nodes[index];
+        if(node.count == 0) continue;
+        if(!ranges.isEmpty() &&
+                ranges.last().first + ranges.last().count == node.first) {
+            ranges.last().count += node.count;
+        } else {
+            ranges.append({ node.first, node.count });
+        }
+    }
+
+    if(selectedPoints_p) *selectedPoints_p = points;
+    return ranges;
+}
+
+//=============================================================================
+PointOctree::Split PointOctree::split(const QVector<int>& ids,
+        const float *center_p, float halfSize, int depth) const
+{
+    Split result;
+    const float edge = 2.0f * halfSize;
+
+    if(ids.count() <= m_nodePoints || depth >= MAX_DEPTH) {
+        result.own = ids;
+        result.spacing = 0.0f;
+        return result;
+    }
+
+    // Keep the first point in each cell of a grid over the node, which
+    // spreads the node's sample evenly; everything else goes down.
+    const int grid = m_gridSize;
+    const float cellScale = grid / edge;
+    QHash<int, bool> taken;
+    taken.reserve(std::min(ids.count(), grid * grid * grid));
+
+    for(int id : ids) {
+        const float *p = m_source_p + id * m_stride;
+        int cell[3];
+        int octant = 0;
+        for(int i = 0; i < 3; ++i) {
+            const float local = p[i] - (center_p[i] - halfSize);
+            cell[i] = qBound(0, (int)(local * cellScale), grid - 1);
+            if(p[i] >= center_p[i]) octant |= (1 << i);
+        }
+        const int key = (cell[2] * grid + cell[1]) * grid + cell[0];
+        if(!taken.contains(key)) {
+            taken.insert(key, true);
+            result.own.append(id);
+        } else {
+            result.children[octant].append(id);
+        }
+    }
+    result.spacing = edge / grid;
+    return result;
+}
+
+//=============================================================================
+int PointOctree::buildSubtree(const QVector<int>& ids, const float *center_p,
+        float halfSize, int depth, Subtree& subtree) const
+{
+    Split s = split(ids, center_p, halfSize, depth);
+
+    const int index = subtree.nodes.count();
+    Node node;
+    std::memcpy(node.center, center_p, sizeof(node.center));
+    node.halfSize = halfSize;
+    node.spacing = s.spacing;
+    node.first = subtree.order.count();
+    node.count = s.own.count();
+    std::fill(node.children, node.children + 8, -1);
+    subtree.nodes.append(node);
+    subtree.order += s.own;
+    s.own.clear();
+
+    for(int octant = 0; octant < 8; ++octant) {
+        if(s.children[octant].isEmpty()) continue;
+        float c[3];
+        childCenter(center_p, halfSize, octant, c);
+        const int child = buildSubtree(
+                s.children[octant], c, 0.5f * halfSize, depth + 1, subtree);
+        s.children[octant].clear();
+        subtree.nodes[index].children[octant] = child;
+    }
+    subtree.nodes[index].subtreeEnd = subtree.order.count();
+    return index;
+}
+
+//=============================================================================
+float PointOctree::projectedError(const Node& node, const View& view) const
+{
+    if(node.spacing <= 0.0f) return 0.0f;
+    if(!view.perspective) return node.spacing * view.pixelsPerUnit;
+
+    float distanceSquared = 0.0f;
+    for(int i = 0; i < 3; ++i) {
+        const float d = node.center[i] - view.eye[i];
+        distanceSquared += d * d;
+    }
+    // Measure to the nearest point of the node's bounding sphere.
+    const float radius = node.halfSize * 1.7320508f;
+    const float distance =
+            std::max(std::sqrt(distanceSquared) - radius, 1e-3f);
+    return node.spacing * view.pixelsPerUnit / distance;
+}
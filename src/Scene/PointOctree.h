@@ -0,0 +1,84 @@
+#pragma once
+
+#include <QVector>
+
+//=============================================================================
+// Level-of-detail octree over a point set.  Every node keeps an evenly
+// spread sample of the points that fall inside it and passes the rest down
+// to its children, so drawing a node alone gives a coarse version of its
+// whole subtree.  Vertices are reordered so each node's own points, and
+// each whole subtree, are contiguous ranges that glDrawArrays can use
+// directly.  The eight top-level subtrees are built in parallel.
+class PointOctree
+{
+public:
+    struct Node
+    {
+        float center[3];
+        float halfSize;
+        float spacing;
+        int first;
+        int count;
+        int subtreeEnd;
+        int children[8];
+    };
+
+    // The camera in model space.  pixelsPerUnit is the on-screen size of
+    // one unit at distance one (perspective) or anywhere (orthographic).
+    struct View
+    {
+        float eye[3];
+        float pixelsPerUnit;
+        bool perspective;
+    };
+
+    struct Range
+    {
+        int first;
+        int count;
+    };
+
+    static constexpr int DEFAULT_NODE_POINTS = 4096;
+    static constexpr int MAX_DEPTH = 20;
+
+    PointOctree(int nodePoints = DEFAULT_NODE_POINTS);
+
+    void build(const float *vertices_p, int vertexCount, int stride);
+
+    bool isEmpty() const;
+    int pointCount() const;
+    int nodeCount() const;
+    const Node& node(int index) const;
+    const QVector<float>& vertices() const;
+
+    QVector<Range> select(const View& view, int pointBudget,
+            float maxErrorPixels, int *selectedPoints_p = nullptr) const;
+
+private:
+    struct Subtree
+    {
+        QVector<Node> nodes;
+        QVector<int> order;
+    };
+
+    struct Split
+    {
+        QVector<int> own;
+        QVector<int> children[8];
+        float spacing;
+    };
+
+    Split split(const QVector<int>& ids, const float *center_p,
+            float halfSize, int depth) const;
+    int buildSubtree(const QVector<int>& ids, const float *center_p,
+            float halfSize, int depth, Subtree& subtree) const;
+    float projectedError(const Node& node, const View& view) const;
+
+    int m_nodePoints;
+    int m_gridSize;
+    const float *m_source_p;
+    int m_stride;
+
+    QVector<Node> m_nodes;
+    QVector<float> m_vertices;
+};
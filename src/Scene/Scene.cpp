@@ -0,0 +1,173 @@
+#include "Scene.h"
+
+#include <algorithm>
+
+#include "ModelTools.h"
+#include "Scene/OcclusionCuller.h"
+#include "TextureStreamer.h"
+
+//=============================================================================
+Scene::Scene() :
+        m_textures_p(nullptr)
+{
+}
+
+//=============================================================================
+Scene::~Scene()
+{
+}
+
+//=============================================================================
+void Scene::initialize(TextureStreamer *textures_p)
+{
+    m_textures_p = textures_p;
+    m_arena.initialize();
+}
+
+//=============================================================================
+void Scene::release()
+{
+    if(m_textures_p) {
+        for(const auto& mesh : m_meshes) {
+            m_textures_p->remove(mesh.texture);
+        }
+    }
+    m_meshes.clear();
+    m_instances.clear();
+    m_arena.release();
+}
+
+//=============================================================================
+bool Scene::hasMesh(const QString& path) const
+{
+    return m_meshes.contains(path);
+}
+
+//=============================================================================
+bool Scene::addMesh(const QString& path, const QVector<GLfloat>& data,
+        int texture)
+{
+    if(m_meshes.contains(path)) return false;
+
+    Mesh mesh;
+    mesh.range = m_arena.allocate(
+            data.constData(), data.count() / NUM_VERTEX_VALUES);
+    if(!mesh.range.isValid()) return false;
+    mesh.texture = texture;
+
+    const int vertexCount = data.count() / NUM_VERTEX_VALUES;
+    computeBounds(data, mesh.min, mesh.max);
+    mesh.occluder = OcclusionCuller::simplifyOccluder(
+            data.constData(), vertexCount, NUM_VERTEX_VALUES);
+
+    (void)m_meshes.insert(path, mesh);
+    return true;
+}
+
+//=============================================================================
+bool Scene::addInstance(int id, const QString& path,
+        const QMatrix4x4& transform)
+{
+    auto mesh = m_meshes.find(path);
+    if(mesh == m_meshes.end()) return false;
+    if(m_instances.contains(id)) return false;
+
+    ++mesh->users;
+    (void)m_instances.insert(id, { path, transform });
+    return true;
+}
+
+//=============================================================================
+bool Scene::removeInstance(int id)
+{
+    auto instance = m_instances.find(id);
+    if(instance == m_instances.end()) return false;
+
+    const QString path = instance->mesh;
+    (void)m_instances.erase(instance);
+
+    auto mesh = m_meshes.find(path);
+    if(mesh != m_meshes.end() && --mesh->users <= 0) releaseMesh(path);
+    return true;
+}
+
+//=============================================================================
+bool Scene::hasInstance(int id) const
+{
+    return m_instances.contains(id);
+}
+
+//=============================================================================
+void Scene::setTransform(int id, const QMatrix4x4& transform)
+{
+    auto instance = m_instances.find(id);
+    if(instance != m_instances.end()) instance->transform = transform;
+}
+
+//=============================================================================
+void Scene::clear()
+{
+    for(auto id : m_instances.keys()) {
+        (void)removeInstance(id);
+    }
+}
+
+//=============================================================================
+int Scene::instanceCount() const
+{
+    return m_instances.count();
+}
+
+//=============================================================================
+QList<Scene::DrawItem> Scene::drawList() const
+{
+    QList<DrawItem> items;
+    for(const auto& instance : m_instances) {
+        const Mesh mesh = m_meshes.value(instance.mesh);
+        if(!mesh.range.isValid()) continue;
+
+        DrawItem item;
+        item.buffer = m_arena.buffer(mesh.range.page);
+        item.first = mesh.range.first;
+        item.count = mesh.range.count;
+        item.texture = mesh.texture;
+        item.transform = instance.transform;
+        std::copy(mesh.min, mesh.min + 3, item.min);
+        std::copy(mesh.max, mesh.max + 3, item.max);
+        item.occluder = mesh.occluder;
+        items.append(item);
+    }
+
+    // Group by buffer, then texture, so state changes happen once per run.
+    std::sort(items.begin(), items.end(),
+            [](const DrawItem& a, const DrawItem& b) {
+        if(a.buffer != b.buffer) return a.buffer < b.buffer;
+        if(a.texture != b.texture) return a.texture < b.texture;
+        return a.first < b.first;
+    });
+    return items;
+}
+
+//=============================================================================
+const GeometryArena& Scene::arena() const
+{
+    return m_arena;
+}
+
+//=============================================================================
+qint64 Scene::occluderBytes() const
+{
+    qint64 bytes = 0;
+    for(const auto& mesh : m_meshes) {
+        bytes += mesh.occluder.count() * sizeof(float);
+    }
+    return bytes;
+}
+
+//=============================================================================
+void Scene::releaseMesh(const QString& path)
+{
+    Mesh mesh = m_meshes.take(path);
+    m_arena.free(mesh.range);
+    if(m_textures_p) m_textures_p->remove(mesh.texture);
+}
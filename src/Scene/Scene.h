@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QMatrix4x4>
+#include <QString>
+#include <QVector>
+
+#include "GeometryArena.h"
+
+class TextureStreamer;
+
+//=============================================================================
+// A set of model instances.  Each mesh is loaded once, lives in the shared
+// GeometryArena, and is released again when its last instance goes away.
+// Meshes also keep their bounds and a simplified occluder for
+// OcclusionCuller.  Textures are TextureStreamer ids owned by the mesh.
+class Scene
+{
+public:
+    struct DrawItem
+    {
+        GLuint buffer;
+        GLint first;
+        GLsizei count;
+        int texture;
+        QMatrix4x4 transform;
+        float min[3];
+        float max[3];
+        QVector<float> occluder;
+    };
+
+    Scene();
+    ~Scene();
+
+    void initialize(TextureStreamer *textures_p);
+    void release();
+
+    bool hasMesh(const QString& path) const;
+    bool addMesh(const QString& path, const QVector<GLfloat>& data,
+            int texture);
+
+    bool addInstance(int id, const QString& path,
+            const QMatrix4x4& transform);
+    bool removeInstance(int id);
+    bool hasInstance(int id) const;
+    void setTransform(int id, const QMatrix4x4& transform);
+    void clear();
+
+    int instanceCount() const;
+    QList<DrawItem> drawList() const;
+    const GeometryArena& arena() const;
+    qint64 occluderBytes() const;
+
+private:
+    struct Mesh
+    {
+        ArenaRange range;
+        int texture = -1;
+        int users = 0;
+        float min[3] = { 0.0f, 0.0f, 0.0f };
+        float max[3] = { 0.0f, 0.0f, 0.0f };
+        QVector<float> occluder;
+    };
+
+    struct Instance
+    {
+        QString mesh;
+        QMatrix4x4 transform;
+    };
+
+    void releaseMesh(const QString& path);
+
+    GeometryArena m_arena;
+    TextureStreamer *m_textures_p;
+    QHash<QString, Mesh> m_meshes;
+    QHash<int, Instance> m_instances;
+};
@@ -0,0 +1,250 @@
+#include "ShaderCache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "GlRecorder.h"
+
+namespace {
+    constexpr GLenum PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+    constexpr GLenum PROGRAM_BINARY_LENGTH = 0x8741;
+    constexpr GLenum NUM_PROGRAM_BINARY_FORMATS = 0x87FE;
+    constexpr quint32 FILE_MAGIC = 0x50424331; // "PBC1"
+
+    typedef void (QOPENGLF_APIENTRYP GetProgramBinary)(
+            GLuint, GLsizei, GLsizei *, GLenum *, void *);
+    typedef void (QOPENGLF_APIENTRYP ProgramBinary)(
+            GLuint, GLenum, const void *, GLint);
+    typedef void (QOPENGLF_APIENTRYP ProgramParameteri)(
+            GLuint, GLenum, GLint);
+
+    struct BinaryFunctions
+    {
+        GetProgramBinary getProgramBinary = nullptr;
+        ProgramBinary programBinary = nullptr;
+        ProgramParameteri programParameteri = nullptr;
+
+        bool isValid() const { return getProgramBinary && programBinary; }
+    };
+
+    //=========================================================================
+    BinaryFunctions resolveBinaryFunctions(QOpenGLContext *context_p)
+    {
+        BinaryFunctions f;
+        if(!context_p) return f;
+
+        const QSurfaceFormat format = context_p->format();
+        const bool core = context_p->isOpenGLES() ?
+                (format.majorVersion() >= 3) :
+                (format.version() >= qMakePair(4, 1) ||
+                context_p->hasExtension("GL_ARB_get_program_binary"));
+
+        if(core) {
+            f.getProgramBinary = (GetProgramBinary)
+                    context_p->getProcAddress("glGetProgramBinary");
+            f.programBinary = (ProgramBinary)
+                    context_p->getProcAddress("glProgramBinary");
+            f.programParameteri = (ProgramParameteri)
+                    context_p->getProcAddress("glProgramParameteri");
+        } else if(context_p->hasExtension("GL_OES_get_program_binary")) {
+            f.getProgramBinary = (GetProgramBinary)
+                    context_p->getProcAddress("glGetProgramBinaryOES");
+            f.programBinary = (ProgramBinary)
+                    context_p->getProcAddress("glProgramBinaryOES");
+        }
+
+        // Some drivers expose the entry points but support no formats.
+        GLint numFormats = 0;
+        context_p->functions()->glGetIntegerv(
+                NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        if(numFormats <= 0) return BinaryFunctions();
+
+        return f;
+    }
+
+    //=========================================================================
+    QString cacheKey(QOpenGLFunctions *gl_p, const QString& vertexSource,
+            const QString& fragmentSource)
+    {
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(vertexSource.toUtf8());
+        hash.addData("\0", 1);
+        hash.addData(fragmentSource.toUtf8());
+        for(GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+            hash.addData("\0", 1);
+            auto value_p = gl_p->glGetString(name);
+            if(value_p) hash.addData(reinterpret_cast<const char *>(value_p));
+        }
+        return QString::fromLatin1(hash.result().toHex());
+    }
+}
+
+//=============================================================================
+ShaderCache::ShaderCache() :
+        m_directory(QStandardPaths::writableLocation(
+                QStandardPaths::CacheLocation) + "/shaders")
+{
+}
+
+//=============================================================================
+void ShaderCache::setDirectory(const QString& directory)
+{
+    m_directory = directory;
+}
+
+//=============================================================================
+QString ShaderCache::directory() const
+{
+    return m_directory;
+}
+
+//=============================================================================
+QOpenGLShaderProgram *ShaderCache::build(const QString& vertexSource,
+        const QString& fragmentSource, QObject *parent_p,
+        QString *log_p, Status *status_p)
+{
+    QOpenGLContext *context_p = QOpenGLContext::currentContext();
+    const BinaryFunctions binary = resolveBinaryFunctions(context_p);
+
+    *status_p = Status::UNAVAILABLE;
+    QString path;
+
+    // ==== Try the cached binary ====
+    if(binary.isValid() && !m_directory.isEmpty()) {
+        path = QDir(m_directory).filePath(cacheKey(context_p->functions(),
+                vertexSource, fragmentSource) + ".bin");
+        *status_p = Status::MISS;
+
+        QFile file(path);
+        if(file.open(QIODevice::ReadOnly)) {
+            QDataStream stream(&file);
+            quint32 magic = 0;
+            quint32 format = 0;
+            QByteArray data;
+            stream >> magic >> format >> data;
+
+            if(stream.status() == QDataStream::Ok &&
+                    magic == FILE_MAGIC && !data.isEmpty()) {
+                auto program_p = new QOpenGLShaderProgram(parent_p);
+                if(program_p->create()) {
+                    binary.programBinary(program_p->programId(), format,
+                            data.constData(), data.size());
+
+                    // With no shaders attached, link() just checks the
+                    // link status that glProgramBinary left behind.
+                    if(program_p->link()) {
+                        *status_p = Status::HIT;
+                        GlRecorder::instance().registerProgram(
+                                program_p->programId(), vertexSource,
+                                fragmentSource);
+                        return program_p;
+                    }
+                }
+                delete program_p;
+            }
+
+            // The driver changed or the file is damaged, so rebuild it.
+            file.close();
+            (void)QFile::remove(path);
+            *status_p = Status::REJECTED;
+        }
+    }
+
+    // ==== Compile from source ====
+    auto program_p = new QOpenGLShaderProgram(parent_p);
+    if(!program_p->addShaderFromSourceCode(
+            QOpenGLShader::Vertex, vertexSource)) {
+        *log_p = program_p->log();
+        delete program_p;
+        return nullptr;
+    }
+    if(!program_p->addShaderFromSourceCode(
+            QOpenGLShader::Fragment, fragmentSource)) {
+        *log_p = program_p->log();
+        delete program_p;
+        return nullptr;
+    }
+    if(!path.isEmpty() && binary.programParameteri) {
+        binary.programParameteri(program_p->programId(),
+                PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    if(!program_p->link()) {
+        *log_p = program_p->log();
+        delete program_p;
+        return nullptr;
+    }
+
+    // ==== Store the binary ====
+    if(!path.isEmpty()) {
+        GLint length = 0;
+        context_p->functions()->glGetProgramiv(
+                program_p->programId(), PROGRAM_BINARY_LENGTH, &length);
+        if(length > 0) {
+            QByteArray data(length, Qt::Uninitialized);
+            GLsizei written = 0;
+            GLenum format = 0;
+            binary.getProgramBinary(program_p->programId(),
+                    length, &written, &format, data.data());
+            data.resize(written);
+
+            QSaveFile file(path);
+            if(written > 0 && QDir().mkpath(m_directory) &&
+                    file.open(QIODevice::WriteOnly)) {
+                QDataStream stream(&file);
+                stream << FILE_MAGIC << (quint32)format << data;
+                (void)file.commit();
+            }
+        }
+    }
+
+    GlRecorder::instance().registerProgram(
+            program_p->programId(), vertexSource, fragmentSource);
+    return program_p;
+}
+
+//=============================================================================
+qint64 ShaderCache::programBytes(QOpenGLShaderProgram *program_p)
+{
+    QOpenGLContext *context_p = QOpenGLContext::currentContext();
+    if(!program_p || !context_p) return 0;
+
+    // The linked binary is the closest thing to the driver's own footprint.
+    // Without binary support, count the source it keeps for each shader.
+    if(resolveBinaryFunctions(context_p).isValid()) {
+        GLint length = 0;
+        context_p->functions()->glGetProgramiv(
+                program_p->programId(), PROGRAM_BINARY_LENGTH, &length);
+        if(length > 0) return length;
+    }
+
+    qint64 bytes = 0;
+    for(auto shader_p : program_p->shaders()) {
+        bytes += shader_p->sourceCode().size();
+    }
+    return bytes;
+}
+
+//=============================================================================
+QString ShaderCache::describe(Status status)
+{
+    switch(status) {
+    case Status::UNAVAILABLE:
+        return "program binaries not supported";
+    case Status::HIT:
+        return "cache hit";
+    case Status::MISS:
+        return "cache miss";
+    case Status::REJECTED:
+        return "cached binary rejected, rebuilt from source";
+    case Status::SHARED:
+        return "shared with another view";
+    }
+    return QString();
+}
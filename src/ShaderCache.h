@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+class QObject;
+class QOpenGLShaderProgram;
+
+//=============================================================================
+// Builds shader programs, keeping linked program binaries on disk
+// (OES_get_program_binary, or ARB_get_program_binary on desktop GL) so that
+// later builds of the same sources on the same driver skip compile and link.
+// All work happens in whatever context is current on the calling thread.
+class ShaderCache
+{
+public:
+    enum class Status
+    {
+        UNAVAILABLE,
+        HIT,
+        MISS,
+        REJECTED,
+        SHARED
+    };
+
+    ShaderCache();
+
+    void setDirectory(const QString& directory);
+    QString directory() const;
+
+    QOpenGLShaderProgram *build(const QString& vertexSource,
+            const QString& fragmentSource, QObject *parent_p,
+            QString *log_p, Status *status_p);
+
+    static QString describe(Status status);
+    static qint64 programBytes(QOpenGLShaderProgram *program_p);
+
+private:
+    QString m_directory;
+};
@@ -0,0 +1,115 @@
+#include "ShaderCompiler.h"
+
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+
+#include "Profiler.h"
+
+//=============================================================================
+ShaderCompiler::ShaderCompiler(QObject *parent_p) : QObject(parent_p),
+        m_worker_p(nullptr),
+        m_surface_p(nullptr),
+        m_context_p(nullptr)
+{
+}
+
+//=============================================================================
+ShaderCompiler::~ShaderCompiler()
+{
+    stop();
+}
+
+//=============================================================================
+bool ShaderCompiler::start(QOpenGLContext *shareContext_p)
+{
+    stop();
+
+    // The surface has to be created on the GUI thread; the context is
+    // created here and then handed to the worker.
+    m_surface_p = new QOffscreenSurface();
+    m_surface_p->setFormat(shareContext_p->format());
+    m_surface_p->create();
+
+    m_context_p = new QOpenGLContext();
+    m_context_p->setFormat(shareContext_p->format());
+    m_context_p->setShareContext(shareContext_p);
+    if(!m_surface_p->isValid() || !m_context_p->create()) {
+        delete m_context_p;
+        m_context_p = nullptr;
+        delete m_surface_p;
+        m_surface_p = nullptr;
+        return false;
+    }
+
+    m_worker_p = new QObject();
+    m_worker_p->moveToThread(&m_thread);
+    m_context_p->moveToThread(&m_thread);
+    m_thread.start();
+    return true;
+}
+
+//=============================================================================
+void ShaderCompiler::stop()
+{
+    if(!m_thread.isRunning()) return;
+
+    QOpenGLContext *context_p = m_context_p;
+    QMetaObject::invokeMethod(m_worker_p, [context_p]() {
+        context_p->doneCurrent();
+        delete context_p;
+    }, Qt::BlockingQueuedConnection);
+    m_context_p = nullptr;
+
+    m_thread.quit();
+    m_thread.wait();
+
+    delete m_worker_p;
+    m_worker_p = nullptr;
+    delete m_surface_p;
+    m_surface_p = nullptr;
+}
+
+//=============================================================================
+bool ShaderCompiler::isRunning() const
+{
+    return m_thread.isRunning();
+}
+
+//=============================================================================
+void ShaderCompiler::compile(quint64 id, const QString& vertexSource,
+        const QString& fragmentSource)
+{
+    if(!isRunning()) return;
+
+    QThread *ownerThread_p = thread();
+    QOpenGLContext *context_p = m_context_p;
+    QOffscreenSurface *surface_p = m_surface_p;
+    ShaderCache cache = m_cache;
+
+    QMetaObject::invokeMethod(m_worker_p, [=]() mutable {
+        QString log;
+        ShaderCache::Status status = ShaderCache::Status::UNAVAILABLE;
+        QOpenGLShaderProgram *program_p = nullptr;
+
+        if(context_p->makeCurrent(surface_p)) {
+            ScopedTimer timer("buildShaders (worker)");
+            program_p = cache.build(
+                    vertexSource, fragmentSource, nullptr, &log, &status);
+            if(program_p) {
+                // Make sure the program is complete before another context
+                // in the share group starts using it.
+                context_p->functions()->glFinish();
+                program_p->moveToThread(ownerThread_p);
+            }
+            context_p->doneCurrent();
+        } else {
+            log = "Could not make the shader compiler context current";
+        }
+
+        QMetaObject::invokeMethod(this, [=]() {
+            emit compiled(id, program_p, log, status);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
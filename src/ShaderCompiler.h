@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+
+#include "ShaderCache.h"
+
+class QOffscreenSurface;
+class QOpenGLContext;
+class QOpenGLShaderProgram;
+
+//=============================================================================
+// Compiles and links shader programs on a worker thread, in a context that
+// shares with the one they will be drawn with.  Finished programs are handed
+// back to the owner's thread through compiled(), which takes ownership.
+class ShaderCompiler final : public QObject
+{
+    Q_OBJECT;
+
+public:
+    ShaderCompiler(QObject *parent_p = nullptr);
+    ~ShaderCompiler() override;
+
+    bool start(QOpenGLContext *shareContext_p);
+    void stop();
+    bool isRunning() const;
+
+    void compile(quint64 id, const QString& vertexSource,
+            const QString& fragmentSource);
+
+signals:
+    void compiled(quint64 id, QOpenGLShaderProgram *program_p,
+            const QString& log, ShaderCache::Status status);
+
+private:
+    QThread m_thread;
+    QObject *m_worker_p;
+    QOffscreenSurface *m_surface_p;
+    QOpenGLContext *m_context_p;
+    ShaderCache m_cache;
+};
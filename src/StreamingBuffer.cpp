@@ -0,0 +1,99 @@
+#include "StreamingBuffer.h"
+
+#include <QOpenGLContext>
+#include <cstring>
+
+namespace {
+    constexpr GLbitfield MAP_WRITE_BIT = 0x0002;
+    constexpr GLbitfield MAP_INVALIDATE_BUFFER_BIT = 0x0008;
+}
+
+//=============================================================================
+StreamingBuffer::StreamingBuffer(int ringSize) :
+        m_ringSize(qMax(ringSize, 1)),
+        m_index(0),
+        m_useMapBufferRange(false)
+{
+}
+
+//=============================================================================
+void StreamingBuffer::initialize(QOpenGLContext *context_p)
+{
+    release();
+    initializeOpenGLFunctions();
+
+    const QSurfaceFormat format = context_p->format();
+    m_useMapBufferRange = context_p->isOpenGLES() ?
+            (format.majorVersion() >= 3) :
+            (format.majorVersion() >= 3 ||
+            context_p->hasExtension("GL_ARB_map_buffer_range"));
+
+    m_buffers.fill(0, m_ringSize);
+    m_capacities.fill(0, m_ringSize);
+    glGenBuffers(m_ringSize, m_buffers.data());
+    m_index = 0;
+}
+
+//=============================================================================
+void StreamingBuffer::release()
+{
+    if(m_buffers.isEmpty()) return;
+    glDeleteBuffers(m_buffers.count(), m_buffers.constData());
+    m_buffers.clear();
+    m_capacities.clear();
+}
+
+//=============================================================================
+bool StreamingBuffer::usesMapBufferRange() const
+{
+    return m_useMapBufferRange;
+}
+
+//=============================================================================
+GLuint StreamingBuffer::upload(const void *data_p, GLsizeiptr size)
+{
+    if(m_buffers.isEmpty()) return 0;
+
+    m_index = (m_index + 1) % m_buffers.count();
+    const GLuint buffer = m_buffers[m_index];
+    GLsizeiptr& capacity = m_capacities[m_index];
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+    bool written = false;
+    if(size > capacity) {
+        // Growing allocates fresh storage, so the data can go in directly.
+        glBufferData(GL_ARRAY_BUFFER, size, data_p, GL_STREAM_DRAW);
+        capacity = size;
+        written = true;
+    } else if(m_useMapBufferRange) {
+        void *mapped_p = glMapBufferRange(GL_ARRAY_BUFFER, 0, size,
+                MAP_WRITE_BIT | MAP_INVALIDATE_BUFFER_BIT);
+        if(mapped_p) {
+            std::memcpy(mapped_p, data_p, size);
+            written = glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+    }
+
+    if(!written) {
+        glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, data_p);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return buffer;
+}
+
+//=============================================================================
+GLuint StreamingBuffer::current() const
+{
+    return m_buffers.value(m_index, 0);
+}
+
+//=============================================================================
+qint64 StreamingBuffer::allocatedBytes() const
+{
+    qint64 bytes = 0;
+    for(auto capacity : m_capacities) bytes += capacity;
+    return bytes;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QOpenGLExtraFunctions>
+#include <QVector>
+
+class QOpenGLContext;
+
+//=============================================================================
+// A ring of vertex buffers for data that changes every frame.  Each upload
+// goes to the next buffer in the ring, so the GPU can still be reading the
+// previous frames' data while the CPU writes.  ES3 and desktop GL write
+// through glMapBufferRange with an invalidating map; ES2 orphans the buffer
+// with glBufferData(nullptr) and fills it with glBufferSubData.  Neither
+// path waits for the GPU.
+class StreamingBuffer : protected QOpenGLExtraFunctions
+{
+public:
+    static constexpr int DEFAULT_RING_SIZE = 3;
+
+    StreamingBuffer(int ringSize = DEFAULT_RING_SIZE);
+
+    void initialize(QOpenGLContext *context_p);
+    void release();
+    bool usesMapBufferRange() const;
+
+    GLuint upload(const void *data_p, GLsizeiptr size);
+    GLuint current() const;
+    qint64 allocatedBytes() const;
+
+private:
+    int m_ringSize;
+    QVector<GLuint> m_buffers;
+    QVector<GLsizeiptr> m_capacities;
+    int m_index;
+    bool m_useMapBufferRange;
+};
@@ -0,0 +1,291 @@
+#include "TaskGraph.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+
+namespace {
+    // Lets tasks that add tasks queue them on their own worker.
+    thread_local const TaskGraph *t_graph = nullptr;
+    thread_local int t_worker = -1;
+}
+
+//=============================================================================
+TaskGraph::TaskGraph(int workerCount) :
+        m_nextId(0),
+        m_nextWorker(0),
+        m_queued(0),
+        m_running(0),
+        m_stopping(false),
+        m_tasksRun(0),
+        m_steals(0)
+{
+    if(workerCount <= 0) workerCount = qMax(QThread::idealThreadCount(), 1);
+    for(int i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(new Worker());
+    }
+    for(int i = 0; i < workerCount; ++i) {
+        m_threads.emplace_back(&TaskGraph::workerLoop, this, i);
+    }
+}
+
+//=============================================================================
+TaskGraph::~TaskGraph()
+{
+    cancel();
+    {
+        QMutexLocker locker(&m_idleMutex);
+        m_stopping = true;
+    }
+    m_wake.wakeAll();
+    for(auto& thread : m_threads) thread.join();
+}
+
+//=============================================================================
+void TaskGraph::setReadyNotifier(const std::function<void()>& notifier)
+{
+    QMutexLocker locker(&m_mutex);
+    m_notifier = notifier;
+}
+
+//=============================================================================
+int TaskGraph::add(const Task& task, const QVector<int>& dependencies)
+{
+    return addNode(task, dependencies, false, 0);
+}
+
+//=============================================================================
+int TaskGraph::addMainThread(const Task& task,
+        const QVector<int>& dependencies, int priority)
+{
+    return addNode(task, dependencies, true, priority);
+}
+
+//=============================================================================
+bool TaskGraph::runMainThreadTask()
+{
+    int id;
+    Task task;
+    {
+        QMutexLocker locker(&m_mutex);
+        if(m_mainReady.empty()) return false;
+        auto first = m_mainReady.begin();
+        id = first->first.second;
+        task = std::move(first->second);
+        m_mainReady.erase(first);
+    }
+    task();
+    ++m_tasksRun;
+    complete(id, -1);
+    return true;
+}
+
+//=============================================================================
+bool TaskGraph::hasMainThreadTasks() const
+{
+    QMutexLocker locker(&m_mutex);
+    return !m_mainReady.empty();
+}
+
+//=============================================================================
+bool TaskGraph::waitForWorkers(int msecs)
+{
+    QElapsedTimer clock;
+    clock.start();
+    QMutexLocker locker(&m_idleMutex);
+    while(m_queued + m_running > 0) {
+        if(msecs < 0) {
+            m_idle.wait(&m_idleMutex);
+            continue;
+        }
+        const qint64 remaining = msecs - clock.elapsed();
+        if(remaining <= 0) return false;
+        (void)m_idle.wait(&m_idleMutex, remaining);
+    }
+    return true;
+}
+
+//=============================================================================
+void TaskGraph::cancel()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_nodes.clear();
+        m_mainReady.clear();
+    }
+
+    int removed = 0;
+    for(auto& worker_p : m_workers) {
+        QMutexLocker locker(&worker_p->mutex);
+        removed += worker_p->queue.size();
+        worker_p->queue.clear();
+    }
+
+    QMutexLocker locker(&m_idleMutex);
+    m_queued -= removed;
+    while(m_running > 0) m_idle.wait(&m_idleMutex);
+}
+
+//=============================================================================
+int TaskGraph::workerCount() const
+{
+    return m_workers.size();
+}
+
+//=============================================================================
+TaskGraph::Stats TaskGraph::stats() const
+{
+    Stats stats;
+    stats.tasksRun = m_tasksRun;
+    stats.steals = m_steals;
+    return stats;
+}
+
+//=============================================================================
+int TaskGraph::addNode(const Task& task, const QVector<int>& dependencies,
+        bool mainThread, int priority)
+{
+    int id;
+    std::vector<std::pair<int, Task>> ready;
+    std::function<void()> notifier;
+    {
+        QMutexLocker locker(&m_mutex);
+        id = m_nextId++;
+
+        Node node;
+        node.mainThread = mainThread;
+        node.priority = priority;
+        for(int dependency : dependencies) {
+            auto other = m_nodes.find(dependency);
+            if(other == m_nodes.end() || other->dependents.contains(id)) {
+                continue;
+            }
+            other->dependents.append(id);
+            ++node.waiting;
+        }
+
+        if(node.waiting > 0) {
+            node.task = task;
+        } else if(mainThread) {
+            m_mainReady.emplace(std::make_pair(-priority, id), task);
+            notifier = m_notifier;
+        } else {
+            ready.emplace_back(id, task);
+        }
+        m_nodes.insert(id, node);
+    }
+
+    if(notifier) notifier();
+    schedule(ready, t_graph == this ? t_worker : -1);
+    return id;
+}
+
+//=============================================================================
+void TaskGraph::complete(int id, int worker)
+{
+    std::vector<std::pair<int, Task>> ready;
+    std::function<void()> notifier;
+    {
+        QMutexLocker locker(&m_mutex);
+        const Node node = m_nodes.take(id);
+        for(int dependent : node.dependents) {
+            auto other = m_nodes.find(dependent);
+            if(other == m_nodes.end() || --other->waiting > 0) continue;
+            if(other->mainThread) {
+                m_mainReady.emplace(std::make_pair(-other->priority,
+                        dependent), std::move(other->task));
+                notifier = m_notifier;
+            } else {
+                ready.emplace_back(dependent, std::move(other->task));
+            }
+            other->task = Task();
+        }
+    }
+
+    if(notifier) notifier();
+    schedule(ready, worker);
+
+    if(worker < 0) return;
+    QMutexLocker locker(&m_idleMutex);
+    --m_running;
+    if(m_queued == 0 && m_running == 0) m_idle.wakeAll();
+}
+
+//=============================================================================
+// Tasks made ready by a worker stay on its queue; the rest are dealt out.
+void TaskGraph::schedule(std::vector<std::pair<int, Task>>& tasks,
+        int worker)
+{
+    if(tasks.empty()) return;
+    for(auto& task : tasks) {
+        const int index = worker >= 0 ? worker :
+                m_nextWorker++ % (int)m_workers.size();
+        Worker& target = *m_workers[index];
+        QMutexLocker locker(&target.mutex);
+        target.queue.push_back(std::move(task));
+    }
+
+    {
+        QMutexLocker locker(&m_idleMutex);
+        m_queued += tasks.size();
+    }
+    if(tasks.size() == 1) {
+        m_wake.wakeOne();
+    } else {
+        m_wake.wakeAll();
+    }
+}
+
+//=============================================================================
+bool TaskGraph::takeTask(int worker, std::pair<int, Task> *item_p)
+{
+    bool found = false;
+    {
+        Worker& own = *m_workers[worker];
+        QMutexLocker locker(&own.mutex);
+        if(!own.queue.empty()) {
+            *item_p = std::move(own.queue.back());
+            own.queue.pop_back();
+            found = true;
+        }
+    }
+
+    const int count = m_workers.size();
+    for(int i = 1; !found && i < count; ++i) {
+        Worker& victim = *m_workers[(worker + i) % count];
+        QMutexLocker locker(&victim.mutex);
+        if(!victim.queue.empty()) {
+            *item_p = std::move(victim.queue.front());
+            victim.queue.pop_front();
+            ++m_steals;
+            found = true;
+        }
+    }
+    if(!found) return false;
+
+    QMutexLocker locker(&m_idleMutex);
+    --m_queued;
+    ++m_running;
+    return true;
+}
+
+//=============================================================================
+void TaskGraph::workerLoop(int index)
+{
+    t_graph = this;
+    t_worker = index;
+
+    for(;;) {
+        std::pair<int, Task> item;
+        if(takeTask(index, &item)) {
+            item.second();
+            ++m_tasksRun;
+            complete(item.first, index);
+            continue;
+        }
+
+        QMutexLocker locker(&m_idleMutex);
+        if(m_stopping) return;
+        if(m_queued == 0) m_wake.wait(&m_idleMutex);
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+//=============================================================================
+// Runs tasks with dependencies on a fixed set of worker threads.  A task
+// becomes ready when everything it depends on has finished.  Each worker
+// has its own queue: tasks made ready by a worker go on that worker's
+// queue and are taken newest first, so related work stays on one core,
+// while idle workers steal the oldest tasks from the others.
+//
+// Main-thread tasks never run on a worker.  Once ready they wait in a
+// priority queue until the owning thread calls runMainThreadTask(), which
+// is how GL uploads are kept on the render thread.  Dependencies can mix
+// both kinds, and tasks may add further tasks while they run.
+class TaskGraph
+{
+public:
+    using Task = std::function<void()>;
+
+    struct Stats
+    {
+        int tasksRun = 0;
+        int steals = 0;
+    };
+
+    // 0 uses one worker per core.
+    explicit TaskGraph(int workerCount = 0);
+    ~TaskGraph();
+
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    // Called on the thread that made a main-thread task ready.
+    void setReadyNotifier(const std::function<void()>& notifier);
+
+    // Dependencies that already finished are ignored.
+    int add(const Task& task,
+            const QVector<int>& dependencies = QVector<int>());
+    int addMainThread(const Task& task,
+            const QVector<int>& dependencies = QVector<int>(),
+            int priority = 0);
+
+    // Runs the ready main-thread task with the highest priority, oldest
+    // first among equals.  Returns false if none was ready.
+    bool runMainThreadTask();
+    bool hasMainThreadTasks() const; // Only counts ready tasks.
+
+    // Waits until no worker task is queued or running.  Tasks that wait on
+    // main-thread tasks are not waited for.
+    bool waitForWorkers(int msecs = -1);
+
+    // Drops every task that has not started and waits for running ones.
+    void cancel();
+
+    int workerCount() const;
+    Stats stats() const;
+
+private:
+    struct Node
+    {
+        Task task;
+        bool mainThread = false;
+        int priority = 0;
+        int waiting = 0;
+        QVector<int> dependents;
+    };
+
+    struct Worker
+    {
+        QMutex mutex;
+        std::deque<std::pair<int, Task>> queue;
+    };
+
+    int addNode(const Task& task, const QVector<int>& dependencies,
+            bool mainThread, int priority);
+    void complete(int id, int worker);
+    void schedule(std::vector<std::pair<int, Task>>& tasks, int worker);
+    bool takeTask(int worker, std::pair<int, Task> *item_p);
+    void workerLoop(int index);
+
+    // ==== Graph ====
+    mutable QMutex m_mutex;
+    QHash<int, Node> m_nodes;
+    int m_nextId;
+    std::map<std::pair<int, int>, Task> m_mainReady;
+    std::function<void()> m_notifier;
+
+    // ==== Workers ====
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    std::atomic<int> m_nextWorker;
+
+    QMutex m_idleMutex;
+    QWaitCondition m_wake;
+    QWaitCondition m_idle;
+    int m_queued;
+    int m_running;
+    bool m_stopping;
+
+    std::atomic<int> m_tasksRun;
+    std::atomic<int> m_steals;
+};
@@ -0,0 +1,127 @@
+#include "TextureAtlas.h"
+
+#include <algorithm>
+
+//=============================================================================
+TextureAtlas::TextureAtlas(int padding) :
+        m_padding(qMax(padding, 1))
+{
+}
+
+//=============================================================================
+int TextureAtlas::add(const QImage& image)
+{
+    m_images.append(image.convertToFormat(QImage::Format_ARGB32));
+    return m_images.count() - 1;
+}
+
+//=============================================================================
+bool TextureAtlas::build()
+{
+    if(m_images.isEmpty()) return false;
+
+    qint64 area = 0;
+    for(const auto& image : m_images) {
+        area += qint64(image.width() + 2*m_padding) *
+                (image.height() + 2*m_padding);
+    }
+
+    // Try square-ish power-of-two sizes, smallest first.
+    int width = 16;
+    while((qint64)width * width < area) width *= 2;
+    for(int height = width / 2; width <= MAX_SIZE; ) {
+        if(height >= 1 && pack(width, height)) return true;
+        if(height < width) {
+            height *= 2;
+        } else {
+            width *= 2;
+            height = width / 2;
+        }
+    }
+    return false;
+}
+
+//=============================================================================
+QImage TextureAtlas::image() const
+{
+    return m_atlas;
+}
+
+//=============================================================================
+QRectF TextureAtlas::textureRect(int index) const
+{
+    if(m_atlas.isNull() || index < 0 || index >= m_rects.count()) {
+        return QRectF();
+    }
+    const QRect rect = m_rects.at(index);
+    const qreal w = m_atlas.width();
+    const qreal h = m_atlas.height();
+    return QRectF(rect.x() / w, rect.y() / h, rect.width() / w,
+            rect.height() / h);
+}
+
+//=============================================================================
+int TextureAtlas::maxMipLevel() const
+{
+    // A gutter of 2^n texels still separates the images at mip level n.
+    int level = 0;
+    while((2 << level) <= m_padding) ++level;
+    return level;
+}
+
+//=============================================================================
+bool TextureAtlas::pack(int width, int height)
+{
+    // ==== Shelf packing, tallest images first ====
+    QList<int> order;
+    for(int i = 0; i < m_images.count(); ++i) order.append(i);
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return m_images.at(a).height() > m_images.at(b).height();
+    });
+
+    QList<QRect> rects;
+    for(int i = 0; i < m_images.count(); ++i) rects.append(QRect());
+
+    int x = 0;
+    int y = 0;
+    int shelfHeight = 0;
+    for(int i : order) {
+        const int w = m_images.at(i).width() + 2*m_padding;
+        const int h = m_images.at(i).height() + 2*m_padding;
+        if(w > width) return false;
+        if(x + w > width) {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+        if(y + h > height) return false;
+        rects[i] = QRect(x + m_padding, y + m_padding,
+                m_images.at(i).width(), m_images.at(i).height());
+        x += w;
+        shelfHeight = qMax(shelfHeight, h);
+    }
+
+    // ==== Copy images, clamping into the gutters ====
+    m_atlas = QImage(width, height, QImage::Format_ARGB32);
+    m_atlas.fill(Qt::transparent);
+    for(int i = 0; i < m_images.count(); ++i) {
+        const QImage& image = m_images.at(i);
+        const QRect& rect = rects.at(i);
+        if(image.isNull()) continue;
+
+        for(int dy = -m_padding; dy < image.height() + m_padding; ++dy) {
+            const int sy = qBound(0, dy, image.height() - 1);
+            auto source_p = reinterpret_cast<const QRgb *>(
+                    image.constScanLine(sy));
+            auto target_p = reinterpret_cast<QRgb *>(
+                    m_atlas.scanLine(rect.y() + dy));
+            for(int dx = -m_padding; dx < image.width() + m_padding; ++dx) {
+                const int sx = qBound(0, dx, image.width() - 1);
+                target_p[rect.x() + dx] = source_p[sx];
+            }
+        }
+    }
+
+    m_rects = rects;
+    return true;
+}
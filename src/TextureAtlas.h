@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QImage>
+#include <QList>
+#include <QRect>
+#include <QRectF>
+
+//=============================================================================
+// Packs small images into one power-of-two image.  Every image is surrounded
+// by a gutter of repeated edge texels, so filtering and the first few mip
+// levels never bleed neighbouring images into each other.
+class TextureAtlas
+{
+public:
+    static constexpr int DEFAULT_PADDING = 8;
+    static constexpr int MAX_SIZE = 4096;
+
+    TextureAtlas(int padding = DEFAULT_PADDING);
+
+    int add(const QImage& image);
+    bool build();
+
+    QImage image() const;
+    QRectF textureRect(int index) const;
+    int maxMipLevel() const;
+
+private:
+    bool pack(int width, int height);
+
+    int m_padding;
+    QList<QImage> m_images;
+    QList<QRect> m_rects;
+    QImage m_atlas;
+};
@@ -0,0 +1,167 @@
+#include "TextureResidency.h"
+
+#include <QtGlobal>
+#include <cmath>
+
+namespace {
+    // Keeps boxes that touch the camera from dividing by zero; they simply
+    // want the full-size image.
+    constexpr float MIN_DEPTH = 1e-4f;
+
+    //=========================================================================
+    qint64 levelBytes(int width, int height, int level)
+    {
+        for(int i = 0; i < level; ++i) {
+            width = qMax(width / 2, 1);
+            height = qMax(height / 2, 1);
+        }
+        return (qint64)width * height * 4;
+    }
+
+    //=========================================================================
+    float triangleArea(const float *a_p, const float *b_p, const float *c_p)
+    {
+        const float u[3] = {
+            b_p[0] - a_p[0], b_p[1] - a_p[1], b_p[2] - a_p[2]
+        };
+        const float v[3] = {
+            c_p[0] - a_p[0], c_p[1] - a_p[1], c_p[2] - a_p[2]
+        };
+        const float x = u[1] * v[2] - u[2] * v[1];
+        const float y = u[2] * v[0] - u[0] * v[2];
+        const float z = u[0] * v[1] - u[1] * v[0];
+        return 0.5f * std::sqrt(x * x + y * y + z * z);
+    }
+
+    //=========================================================================
+    float textureArea(const float *a_p, const float *b_p, const float *c_p)
+    {
+        return 0.5f * std::fabs((b_p[0] - a_p[0]) * (c_p[1] - a_p[1]) -
+                (b_p[1] - a_p[1]) * (c_p[0] - a_p[0]));
+    }
+}
+
+//=============================================================================
+float TextureResidency::uvDensity(const float *vertices_p, int vertexCount,
+        int stride, int textureCoordOffset)
+{
+    double surface = 0.0;
+    double texture = 0.0;
+    for(int v = 0; v + 2 < vertexCount; v += 3) {
+        const float *a_p = vertices_p + v * stride;
+        const float *b_p = a_p + stride;
+        const float *c_p = b_p + stride;
+        surface += triangleArea(a_p, b_p, c_p);
+        texture += textureArea(a_p + textureCoordOffset,
+                b_p + textureCoordOffset, c_p + textureCoordOffset);
+    }
+    if(surface <= 0.0) return 0.0f;
+    return (float)std::sqrt(texture / surface);
+}
+
+//=============================================================================
+float TextureResidency::pixelsPerUnit(const float *modelView_p,
+        const float *projection_p, const float *min_p, const float *max_p,
+        int viewportHeight)
+{
+    const float *m_p = modelView_p;
+    const float scale = std::sqrt(m_p[0] * m_p[0] + m_p[1] * m_p[1] +
+            m_p[2] * m_p[2]);
+    const float pixels = scale * projection_p[5] * viewportHeight * 0.5f;
+
+    // Orthographic projections do not shrink with distance.
+    if(projection_p[11] == 0.0f) return pixels;
+
+    float nearest = 0.0f;
+    for(int corner = 0; corner < 8; ++corner) {
+        const float x = (corner & 1) ? max_p[0] : min_p[0];
+        const float y = (corner & 2) ? max_p[1] : min_p[1];
+        const float z = (corner & 4) ? max_p[2] : min_p[2];
+        const float depth = -(m_p[2] * x + m_p[6] * y + m_p[10] * z +
+                m_p[14]);
+        nearest = corner == 0 ? depth : qMin(nearest, depth);
+    }
+    return pixels / qMax(nearest, MIN_DEPTH);
+}
+
+//=============================================================================
+int TextureResidency::desiredLevel(int width, int height, int levelCount,
+        float uvDensity, float pixelsPerUnit)
+{
+    const int coarsest = qMax(levelCount - 1, 0);
+    if(uvDensity <= 0.0f || pixelsPerUnit <= 0.0f) return coarsest;
+
+    // Each level halves the texels per unit; take the largest level that
+    // still has at least one texel per pixel.
+    const float texelsPerUnit =
+            uvDensity * std::sqrt((float)width * (float)height);
+    const float level = std::floor(std::log2(texelsPerUnit / pixelsPerUnit));
+    if(!(level > 0.0f)) return 0;
+    return qMin((int)level, coarsest);
+}
+
+//=============================================================================
+int TextureResidency::minimumLevel(int width, int height, int levelCount)
+{
+    int level = 0;
+    while(level < levelCount - 1 && qMax(width, height) > RESIDENT_SIZE) {
+        width = qMax(width / 2, 1);
+        height = qMax(height / 2, 1);
+        ++level;
+    }
+    return level;
+}
+
+//=============================================================================
+qint64 TextureResidency::chainBytes(int width, int height, int levelCount,
+        int top)
+{
+    qint64 bytes = 0;
+    for(int level = qMax(top, 0); level < levelCount; ++level) {
+        bytes += levelBytes(width, height, level);
+    }
+    return bytes;
+}
+
+//=============================================================================
+// Greedy: the texture whose resident level is furthest from the one it
+// wants gets the next finer level, as long as that level fits.
+QVector<int> TextureResidency::plan(const QVector<Request>& requests,
+        qint64 budget)
+{
+    QVector<int> levels(requests.count());
+    QVector<int> targets(requests.count());
+    qint64 used = 0;
+    for(int i = 0; i < requests.count(); ++i) {
+        const Request& request = requests[i];
+        levels[i] = minimumLevel(request.width, request.height,
+                request.levelCount);
+        targets[i] = qBound(0, request.desiredLevel, levels[i]);
+        used += chainBytes(request.width, request.height,
+                request.levelCount, levels[i]);
+    }
+
+    while(true) {
+        int best = -1;
+        for(int i = 0; i < requests.count(); ++i) {
+            if(levels[i] <= targets[i]) continue;
+            if(best < 0 || levels[i] - targets[i] >
+                    levels[best] - targets[best]) {
+                best = i;
+            }
+        }
+        if(best < 0) break;
+
+        const Request& request = requests[best];
+        const qint64 bytes =
+                levelBytes(request.width, request.height, levels[best] - 1);
+        if(used + bytes > budget) {
+            // Smaller textures may still fit.
+            targets[best] = levels[best];
+            continue;
+        }
+        used += bytes;
+        --levels[best];
+    }
+    return levels;
+}
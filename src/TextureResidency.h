@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QVector>
+
+//=============================================================================
+// Decides how much of each texture's mip chain should be on the GPU.  A
+// texture wants the level whose texels are about the size of a screen pixel
+// where it is drawn, which follows from how densely its texture coordinates
+// cover the surface and how large that surface is on screen.  When the
+// wanted levels do not fit the budget, the textures that are furthest from
+// theirs are refined first.
+//
+// Levels are counted from the full-size image, so a larger level number is
+// a smaller image.  Matrices are column-major, like QMatrix4x4::constData().
+namespace TextureResidency
+{
+    // Textures are never dropped below the level where they fit in this
+    // many texels on a side, so something is always there to draw.
+    constexpr int RESIDENT_SIZE = 64;
+
+    struct Request
+    {
+        int width;
+        int height;
+        int levelCount;
+        int desiredLevel;
+    };
+
+    // The square root of the texture area over the surface area of a
+    // triangle list, that is texture coordinate units per object unit.
+    float uvDensity(const float *vertices_p, int vertexCount, int stride,
+            int textureCoordOffset);
+
+    // Screen pixels per object unit at the nearest corner of a box.
+    float pixelsPerUnit(const float *modelView_p, const float *projection_p,
+            const float *min_p, const float *max_p, int viewportHeight);
+
+    int desiredLevel(int width, int height, int levelCount, float uvDensity,
+            float pixelsPerUnit);
+    int minimumLevel(int width, int height, int levelCount);
+
+    // The bytes of an RGBA8 chain from level top down to levelCount - 1.
+    qint64 chainBytes(int width, int height, int levelCount, int top);
+
+    // The level to make resident for each request.  Every texture gets at
+    // least its minimum level, even past the budget.
+    QVector<int> plan(const QVector<Request>& requests, qint64 budget);
+}
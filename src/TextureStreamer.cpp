@@ -0,0 +1,305 @@
+#include "TextureStreamer.h"
+
+#include <QOpenGLContext>
+#include <QVector>
+#include <algorithm>
+
+#include "Profiler.h"
+#include "TextureResidency.h"
+
+namespace {
+    // Not in the GLES 2 headers.
+    constexpr GLenum TEXTURE_MAX_LEVEL = 0x813D;
+
+    struct Refinement
+    {
+        int id;
+        int target;
+        int gap;
+    };
+
+    //=========================================================================
+    // The current context's functions; any context of the share group will
+    // do, since the names are shared.
+    QOpenGLFunctions *glFunctions()
+    {
+        return QOpenGLContext::currentContext()->functions();
+    }
+
+    //=========================================================================
+    // GLES 2 has no GL_TEXTURE_MAX_LEVEL.
+    bool hasMaxLevel()
+    {
+        const QOpenGLContext *context_p = QOpenGLContext::currentContext();
+        return !context_p->isOpenGLES() ||
+                context_p->format().majorVersion() >= 3;
+    }
+}
+
+//=============================================================================
+TextureStreamer::TextureStreamer(qint64 budget) :
+        m_nextId(0),
+        m_nextView(0),
+        m_budget(budget),
+        m_residentBytes(0)
+{
+}
+
+//=============================================================================
+TextureStreamer::~TextureStreamer()
+{
+    // The textures belong to a share group that is gone by now; release()
+    // should have been called while one of its contexts was current.
+}
+
+//=============================================================================
+int TextureStreamer::add(const QSharedPointer<const MipChain>& chain_p,
+        float uvDensity, bool clampToEdge, int maxLevel,
+        const QByteArray& key)
+{
+    if(!chain_p || chain_p->isEmpty()) return -1;
+
+    auto shared = m_keys.find(key);
+    if(!key.isEmpty() && shared != m_keys.end()) {
+        ++m_entries[*shared].users;
+        return *shared;
+    }
+
+    Entry entry;
+    entry.chain_p = chain_p;
+    entry.uvDensity = uvDensity;
+    entry.clampToEdge = clampToEdge;
+    entry.maxLevel = maxLevel;
+    entry.key = key;
+
+    const MipChain::Level& base = chain_p->level(0);
+    upload(&entry, TextureResidency::minimumLevel(
+            base.width, base.height, chain_p->levelCount()));
+
+    const int id = m_nextId++;
+    (void)m_entries.insert(id, entry);
+    if(!key.isEmpty()) (void)m_keys.insert(key, id);
+    m_stats.textures = m_entries.count();
+    m_stats.residentBytes = m_residentBytes;
+    return id;
+}
+
+//=============================================================================
+void TextureStreamer::remove(int id)
+{
+    auto entry = m_entries.find(id);
+    if(entry == m_entries.end() || --entry->users > 0) return;
+
+    m_residentBytes -= residentBytes(*entry);
+    glFunctions()->glDeleteTextures(1, &entry->texture);
+    if(!entry->key.isEmpty()) (void)m_keys.remove(entry->key);
+    (void)m_entries.erase(entry);
+    m_stats.textures = m_entries.count();
+    m_stats.residentBytes = m_residentBytes;
+}
+
+//=============================================================================
+void TextureStreamer::release()
+{
+    for(auto& entry : m_entries) {
+        glFunctions()->glDeleteTextures(1, &entry.texture);
+    }
+    m_entries.clear();
+    m_keys.clear();
+    m_views.clear();
+    m_requests.clear();
+    m_residentBytes = 0;
+    m_stats = Stats();
+}
+
+//=============================================================================
+int TextureStreamer::addView()
+{
+    const int view = m_nextView++;
+    (void)m_views.insert(view, Requests());
+    return view;
+}
+
+//=============================================================================
+void TextureStreamer::removeView(int view)
+{
+    (void)m_views.remove(view);
+}
+
+//=============================================================================
+GLuint TextureStreamer::texture(int id) const
+{
+    auto entry = m_entries.find(id);
+    return entry == m_entries.end() ? 0 : entry->texture;
+}
+
+//=============================================================================
+int TextureStreamer::residentLevel(int id) const
+{
+    auto entry = m_entries.find(id);
+    return entry == m_entries.end() ? -1 : entry->top;
+}
+
+//=============================================================================
+void TextureStreamer::request(int id, float pixelsPerUnit)
+{
+    if(!m_entries.contains(id)) return;
+    float& request = m_requests[id];
+    request = qMax(request, pixelsPerUnit);
+}
+
+//=============================================================================
+// Evictions run first so the room they make is there for refinements.  A
+// texture is only evicted when it is two levels past its plan, or when the
+// budget was lowered, so one that sits on a level boundary does not flip
+// back and forth.  A view's requests hold until its next update, so views
+// that repaint in turn do not evict each other's textures.
+void TextureStreamer::update(int view)
+{
+    m_views[view] = m_requests;
+    m_requests.clear();
+
+    QVector<int> ids;
+    QVector<TextureResidency::Request> requests;
+    ids.reserve(m_entries.count());
+    requests.reserve(m_entries.count());
+    for(auto entry = m_entries.cbegin(); entry != m_entries.cend(); ++entry) {
+        const MipChain& chain = *entry->chain_p;
+        const MipChain::Level& base = chain.level(0);
+        const int coarsest = chain.levelCount() - 1;
+        float pixelsPerUnit = 0.0f;
+        for(const auto& viewRequests : m_views) {
+            pixelsPerUnit = qMax(pixelsPerUnit,
+                    viewRequests.value(entry.key(), 0.0f));
+        }
+        ids.append(entry.key());
+        requests.append({ base.width, base.height, chain.levelCount(),
+                pixelsPerUnit > 0.0f ?
+                TextureResidency::desiredLevel(base.width, base.height,
+                        chain.levelCount(), entry->uvDensity,
+                        pixelsPerUnit) : coarsest });
+    }
+    const QVector<int> targets = TextureResidency::plan(requests, m_budget);
+
+    m_stats = Stats();
+    QVector<Refinement> refinements;
+    for(int i = 0; i < ids.count(); ++i) {
+        Entry& entry = m_entries[ids[i]];
+        const TextureResidency::Request& request = requests[i];
+        const int target = targets[i];
+        m_stats.wantedBytes += TextureResidency::chainBytes(
+                request.width, request.height, request.levelCount, target);
+
+        if(target >= entry.top + 2 ||
+                (target > entry.top && m_residentBytes > m_budget)) {
+            upload(&entry, target);
+            ++m_stats.evictions;
+        } else if(target < entry.top) {
+            refinements.append({ ids[i], target, entry.top - target });
+        }
+    }
+
+    // One level per texture per frame, furthest behind first.  The first
+    // upload always goes ahead so that a level larger than the per-frame
+    // limit still arrives.
+    std::stable_sort(refinements.begin(), refinements.end(),
+            [](const Refinement& a, const Refinement& b) {
+        return a.gap > b.gap;
+    });
+    qint64 uploaded = 0;
+    for(const auto& refinement : refinements) {
+        Entry& entry = m_entries[refinement.id];
+        const qint64 bytes = entry.chain_p->bytes(entry.top - 1);
+        if(m_stats.uploads > 0 &&
+                uploaded + bytes > UPLOAD_BYTES_PER_FRAME) {
+            ++m_stats.streaming;
+            continue;
+        }
+        upload(&entry, entry.top - 1);
+        uploaded += bytes;
+        ++m_stats.uploads;
+        if(entry.top > refinement.target) ++m_stats.streaming;
+    }
+
+    m_stats.textures = m_entries.count();
+    m_stats.residentBytes = m_residentBytes;
+}
+
+//=============================================================================
+bool TextureStreamer::isStreaming() const
+{
+    return m_stats.streaming > 0;
+}
+
+//=============================================================================
+void TextureStreamer::setBudget(qint64 bytes)
+{
+    m_budget = bytes;
+}
+
+//=============================================================================
+qint64 TextureStreamer::budget() const
+{
+    return m_budget;
+}
+
+//=============================================================================
+const TextureStreamer::Stats& TextureStreamer::stats() const
+{
+    return m_stats;
+}
+
+//=============================================================================
+qint64 TextureStreamer::chainBytes() const
+{
+    qint64 bytes = 0;
+    for(const auto& entry : m_entries) {
+        bytes += entry.chain_p->bytes();
+    }
+    return bytes;
+}
+
+//=============================================================================
+// Replaces the texture with one that holds levels top and below.  A new
+// texture is made rather than changing the base level of the old one, which
+// GLES 2 cannot do.
+void TextureStreamer::upload(Entry *entry_p, int top)
+{
+    ScopedTimer timer("texture upload");
+    const MipChain& chain = *entry_p->chain_p;
+    const int levels = chain.levelCount() - top;
+
+    QOpenGLFunctions *gl_p = glFunctions();
+    GLuint texture = 0;
+    gl_p->glGenTextures(1, &texture);
+    gl_p->glBindTexture(GL_TEXTURE_2D, texture);
+    for(int level = 0; level < levels; ++level) {
+        const MipChain::Level& mip = chain.level(top + level);
+        gl_p->glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, mip.width,
+                mip.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                mip.pixels.constData());
+    }
+    gl_p->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+            GL_LINEAR_MIPMAP_LINEAR);
+    gl_p->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    const GLint wrap = entry_p->clampToEdge ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+    gl_p->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+    gl_p->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+    if(entry_p->maxLevel >= 0 && hasMaxLevel()) {
+        gl_p->glTexParameteri(GL_TEXTURE_2D, TEXTURE_MAX_LEVEL,
+                qMax(entry_p->maxLevel - top, 0));
+    }
+    gl_p->glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_residentBytes -= residentBytes(*entry_p);
+    gl_p->glDeleteTextures(1, &entry_p->texture);
+    entry_p->texture = texture;
+    entry_p->top = top;
+    m_residentBytes += residentBytes(*entry_p);
+}
+
+//=============================================================================
+qint64 TextureStreamer::residentBytes(const Entry& entry) const
+{
+    return entry.texture ? entry.chain_p->bytes(entry.top) : 0;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QOpenGLFunctions>
+#include <QSharedPointer>
+
+#include "MipChain.h"
+
+//=============================================================================
+// Keeps part of each texture's mip chain on the GPU.  Textures start with
+// only their small levels resident.  Every frame the renderer reports how
+// many screen pixels an object unit covers where each texture is drawn;
+// update() then plans the levels that fit the budget with TextureResidency
+// and moves every texture one level closer to its plan, within a per-frame
+// upload limit.  Textures that are not drawn fall back to their small
+// levels.  The full chains stay on the CPU, so levels can be evicted and
+// streamed in again without touching the disk.
+//
+// Widgets in one share group draw with the same streamer (see
+// GpuResources).  Each is a view that reports its own draws; a texture gets
+// the levels the view that shows it largest needs.  Textures added under a
+// key that is already in use are the same texture, with one more user.
+// The streamer keeps plain texture names rather than QOpenGLTexture
+// objects, which hold on to the context that made them: any context of the
+// group can bind, replace or delete a name, so closing the view that
+// uploaded a texture leaves it intact for the others.
+class TextureStreamer
+{
+public:
+    struct Stats
+    {
+        int textures = 0;
+        int streaming = 0;
+        int uploads = 0;
+        int evictions = 0;
+        qint64 residentBytes = 0;
+        qint64 wantedBytes = 0;
+    };
+
+    static constexpr qint64 DEFAULT_BUDGET = 128 * 1024 * 1024;
+    static constexpr qint64 UPLOAD_BYTES_PER_FRAME = 8 * 1024 * 1024;
+
+    TextureStreamer(qint64 budget = DEFAULT_BUDGET);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // Needs a current context, like every call below that uploads.
+    // Levels finer than maxLevel are resident but never sampled.
+    int add(const QSharedPointer<const MipChain>& chain_p, float uvDensity,
+            bool clampToEdge = false, int maxLevel = -1,
+            const QByteArray& key = QByteArray());
+    void remove(int id);
+    void release();
+
+    int addView();
+    void removeView(int view);
+
+    // Zero for unknown ids.
+    GLuint texture(int id) const;
+    int residentLevel(int id) const;
+
+    // May be called several times a frame; the finest request wins.  The
+    // requests made since the last update belong to the view updating.
+    void request(int id, float pixelsPerUnit);
+    void update(int view);
+    bool isStreaming() const;
+
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+
+    const Stats& stats() const;
+    qint64 chainBytes() const;
+
+private:
+    struct Entry
+    {
+        QSharedPointer<const MipChain> chain_p;
+        float uvDensity = 0.0f;
+        bool clampToEdge = false;
+        int maxLevel = -1;
+        GLuint texture = 0;
+        int top = 0;
+        QByteArray key;
+        int users = 1;
+    };
+
+    typedef QHash<int, float> Requests;
+
+    void upload(Entry *entry_p, int top);
+    qint64 residentBytes(const Entry& entry) const;
+
+    QHash<int, Entry> m_entries;
+    QHash<QByteArray, int> m_keys;
+    QHash<int, Requests> m_views;
+    Requests m_requests;
+    int m_nextId;
+    int m_nextView;
+    qint64 m_budget;
+    qint64 m_residentBytes;
+    Stats m_stats;
+};
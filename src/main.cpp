@@ -1,6 +1,8 @@
 #include "MainWindow.h"
 
 int main(int argc, char **argv) {
+    // Lets every GlWidget share GPU resources, whatever window it is in.
+    QApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
     QApplication app(argc, argv);
     MainWindow win;
     win.show();
@@ -0,0 +1,11 @@
+uniform sampler2D uColor;
+uniform sampler2D uDepth;
+
+varying vec2 vTextureCoord;
+
+void main() {
+    vec4 color = texture2D(uColor, vTextureCoord);
+    if(color.a == 0.0) discard;
+    gl_FragColor = color;
+    gl_FragDepth = texture2D(uDepth, vTextureCoord).r;
+}
@@ -0,0 +1,8 @@
+attribute vec2 aPosition;
+
+varying vec2 vTextureCoord;
+
+void main() {
+    gl_Position = vec4(aPosition, 0.0, 1.0);
+    vTextureCoord = 0.5 * aPosition + 0.5;
+}
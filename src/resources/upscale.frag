@@ -0,0 +1,28 @@
+uniform sampler2D uColor;
+uniform sampler2D uDepth;
+uniform vec2 uTexelSize;
+uniform float uSharpness;
+
+varying vec2 vTextureCoord;
+
+void main() {
+    vec4 color = texture2D(uColor, vTextureCoord);
+    if(color.a == 0.0) discard;
+
+    // Unsharp mask against the four neighbours in the scaled image, which
+    // brings back some of the edge contrast the bilinear filter takes away.
+    // Colors are premultiplied, so they must stay below alpha.
+    if(uSharpness > 0.0) {
+        vec2 dx = vec2(uTexelSize.x, 0.0);
+        vec2 dy = vec2(0.0, uTexelSize.y);
+        vec3 blur = 0.25 * (texture2D(uColor, vTextureCoord - dx) +
+                texture2D(uColor, vTextureCoord + dx) +
+                texture2D(uColor, vTextureCoord - dy) +
+                texture2D(uColor, vTextureCoord + dy)).rgb;
+        color.rgb = clamp(color.rgb + uSharpness * (color.rgb - blur),
+                0.0, color.a);
+    }
+
+    gl_FragColor = color;
+    gl_FragDepth = texture2D(uDepth, vTextureCoord).r;
+}
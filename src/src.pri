@@ -1,3 +1,33 @@
+HEADERS += $$PWD/GlCapture.h
+HEADERS += $$PWD/MemoryLedger.h
+HEADERS += $$PWD/MipChain.h
 HEADERS += $$PWD/Ply/PlyModel.h
+HEADERS += $$PWD/Ply/PlyWriter.h
+HEADERS += $$PWD/ResolutionController.h
+HEADERS += $$PWD/ResourceTable.h
+HEADERS += $$PWD/Scene/BufferDiff.h
+HEADERS += $$PWD/Scene/Bvh.h
+HEADERS += $$PWD/Scene/ClusterFile.h
+HEADERS += $$PWD/Scene/ClusterWriter.h
+HEADERS += $$PWD/Scene/OcclusionCuller.h
+HEADERS += $$PWD/Scene/OffsetAllocator.h
+HEADERS += $$PWD/Scene/PointOctree.h
+HEADERS += $$PWD/TaskGraph.h
+HEADERS += $$PWD/TextureResidency.h
 
+SOURCES += $$PWD/GlCapture.cpp
+SOURCES += $$PWD/MemoryLedger.cpp
+SOURCES += $$PWD/MipChain.cpp
 SOURCES += $$PWD/Ply/PlyModel.cpp
+SOURCES += $$PWD/Ply/PlyWriter.cpp
+SOURCES += $$PWD/ResolutionController.cpp
+SOURCES += $$PWD/ResourceTable.cpp
+SOURCES += $$PWD/Scene/BufferDiff.cpp
+SOURCES += $$PWD/Scene/Bvh.cpp
+SOURCES += $$PWD/Scene/ClusterFile.cpp
+SOURCES += $$PWD/Scene/ClusterWriter.cpp
+SOURCES += $$PWD/Scene/OcclusionCuller.cpp
+SOURCES += $$PWD/Scene/OffsetAllocator.cpp
+SOURCES += $$PWD/Scene/PointOctree.cpp
+SOURCES += $$PWD/TaskGraph.cpp
+SOURCES += $$PWD/TextureResidency.cpp
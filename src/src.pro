@@ -2,6 +2,7 @@ TEMPLATE = app
 TARGET = gl-lnl
 CONFIG += c++14
 QT += widgets
+QT += concurrent
 
 include(src.pri)
 
@@ -9,11 +10,58 @@ RESOURCES += resources/resources.qrc
 
 FORMS += MainWindow.ui
 
+# The built-in ornaments are converted into BakedOrnaments.h by ../bake, so
+# startup uploads them without parsing arrow.ply or building the grid.  The
+# tool runs on the build machine, so a cross build cannot use the one it
+# builds for the target: build gl-lnl-bake for the host first and pass it
+# as qmake BAKE=/path/to/gl-lnl-bake, which also leaves ../bake unbuilt.
+isEmpty(BAKE) {
+    BAKE = $$OUT_PWD/../bake/gl-lnl-bake
+    win32: BAKE = $${BAKE}.exe
+}
+BAKE_INPUTS = resources/arrow.ply
+BAKE_INPUTS += resources/grid-texture.png
+BAKE_INPUTS += resources/arrow-texture.png
+
+bake.input = BAKE_INPUTS
+bake.output = BakedOrnaments.h
+bake.commands = $$shell_path($$BAKE) ${QMAKE_FILE_OUT} ${QMAKE_FILE_IN}
+bake.depends = $$BAKE
+bake.CONFIG += combine no_link target_predeps
+QMAKE_EXTRA_COMPILERS += bake
+INCLUDEPATH += $$OUT_PWD
+
+HEADERS += ClusterCache.h
+HEADERS += FrameCapture.h
+HEADERS += GlRecorder.h
+HEADERS += GpuResources.h
 HEADERS += GlWidget.h
 HEADERS += MainWindow.h
 HEADERS += ModelTools.h
+HEADERS += Profiler.h
+HEADERS += RenderLayer.h
+HEADERS += Scene/GeometryArena.h
+HEADERS += Scene/Scene.h
+HEADERS += ShaderCache.h
+HEADERS += ShaderCompiler.h
+HEADERS += StreamingBuffer.h
+HEADERS += TextureAtlas.h
+HEADERS += TextureStreamer.h
 
+SOURCES += ClusterCache.cpp
+SOURCES += FrameCapture.cpp
+SOURCES += GlRecorder.cpp
+SOURCES += GpuResources.cpp
 SOURCES += GlWidget.cpp
 SOURCES += main.cpp
 SOURCES += MainWindow.cpp
 SOURCES += ModelTools.cpp
+SOURCES += Profiler.cpp
+SOURCES += RenderLayer.cpp
+SOURCES += Scene/GeometryArena.cpp
+SOURCES += Scene/Scene.cpp
+SOURCES += ShaderCache.cpp
+SOURCES += ShaderCompiler.cpp
+SOURCES += StreamingBuffer.cpp
+SOURCES += TextureAtlas.cpp
+SOURCES += TextureStreamer.cpp
@@ -0,0 +1,129 @@
+#include "GlCaptureTest.h"
+
+#include <QBuffer>
+#include <QtTest>
+#include <limits>
+
+#include "GlCapture.h"
+
+using GlCapture::Command;
+using GlCapture::Op;
+
+namespace {
+    //=========================================================================
+    QByteArray writeAll(const QList<Command>& commands)
+    {
+        QByteArray bytes;
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::WriteOnly);
+
+        GlCapture::Writer writer;
+        writer.begin(&buffer);
+        for(const auto& command : commands) writer.write(command);
+        writer.end();
+        return bytes;
+    }
+
+    //=========================================================================
+    QList<Command> readAll(QByteArray bytes, bool *error_p)
+    {
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::ReadOnly);
+
+        QList<Command> commands;
+        GlCapture::Reader reader;
+        if(!reader.begin(&buffer)) {
+            *error_p = true;
+            return commands;
+        }
+        Command command;
+        while(reader.next(&command)) commands.append(command);
+        *error_p = reader.hasError();
+        return commands;
+    }
+}
+
+//=============================================================================
+void GlCaptureTest::roundTripKeepsEveryArgument()
+{
+    Command program;
+    program.op = Op::PROGRAM;
+    program.ints << 3 << 1 << 0 << 2;
+    program.strings << "void main() {}" << "void main() {}"
+            << "aPosition" << "uModel";
+
+    Command uniform;
+    uniform.op = Op::UNIFORM;
+    uniform.ints << 2 << 0x8B5C;
+    for(int i = 0; i < 16; ++i) uniform.floats << i * -0.5f;
+
+    Command data;
+    data.op = Op::BUFFER_SUB_DATA;
+    data.ints << 0x8892 << std::numeric_limits<qint64>::max()
+            << std::numeric_limits<qint64>::min() << -1;
+    data.data = QByteArray("\0\1\2\3\xff", 5);
+
+    bool error = true;
+    const QList<Command> commands =
+            readAll(writeAll({ program, uniform, data }), &error);
+    QVERIFY(!error);
+    QCOMPARE(commands.count(), 3);
+
+    QVERIFY(commands[0].op == Op::PROGRAM);
+    QCOMPARE(commands[0].ints, program.ints);
+    QCOMPARE(commands[0].strings, program.strings);
+
+    QVERIFY(commands[1].op == Op::UNIFORM);
+    QCOMPARE(commands[1].ints, uniform.ints);
+    QCOMPARE(commands[1].floats, uniform.floats);
+
+    QVERIFY(commands[2].op == Op::BUFFER_SUB_DATA);
+    QCOMPARE(commands[2].ints, data.ints);
+    QCOMPARE(commands[2].data, data.data);
+}
+
+//=============================================================================
+void GlCaptureTest::smallCommandsStayCompact()
+{
+    const int headerBytes = writeAll({}).size();
+
+    Command draw;
+    draw.op = Op::DRAW_ARRAYS;
+    draw.ints << 0x0004 << 0 << 36;
+
+    // Opcode, four counts and three one-byte varints.
+    QCOMPARE(writeAll({ draw }).size() - headerBytes, 8);
+}
+
+//=============================================================================
+void GlCaptureTest::emptyCaptureEndsCleanly()
+{
+    bool error = true;
+    QVERIFY(readAll(writeAll({}), &error).isEmpty());
+    QVERIFY(!error);
+}
+
+//=============================================================================
+void GlCaptureTest::rejectsForeignFiles()
+{
+    bool error = false;
+    QVERIFY(readAll("ply\nformat ascii 1.0\n", &error).isEmpty());
+    QVERIFY(error);
+}
+
+//=============================================================================
+void GlCaptureTest::truncatedCaptureIsAnError()
+{
+    Command data;
+    data.op = Op::BUFFER_DATA;
+    data.ints << 0x8892 << 64 << 0x88E4;
+    data.data = QByteArray(64, 'x');
+
+    QByteArray bytes = writeAll({ data, data });
+    bytes.chop(10);
+
+    bool error = false;
+    const QList<Command> commands = readAll(bytes, &error);
+    QCOMPARE(commands.count(), 1);
+    QVERIFY(error);
+}
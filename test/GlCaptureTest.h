@@ -0,0 +1,13 @@
+#include <QObject>
+
+class GlCaptureTest : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void roundTripKeepsEveryArgument();
+    void smallCommandsStayCompact();
+    void emptyCaptureEndsCleanly();
+    void rejectsForeignFiles();
+    void truncatedCaptureIsAnError();
+};
@@ -0,0 +1,58 @@
+#include "MemoryLedgerTest.h"
+
+#include <QtTest>
+
+#include "MemoryLedger.h"
+
+//=============================================================================
+void MemoryLedgerTest::setReplacesEntry()
+{
+    MemoryLedger ledger;
+    ledger.set("model/vbo", 0, 100);
+    ledger.set("model/vbo", 0, 40);
+    QCOMPARE(ledger.entries().count(), 1);
+    QCOMPARE(ledger.gpuBytes(), qint64(40));
+}
+
+//=============================================================================
+void MemoryLedgerTest::totalsSkipTransientEntries()
+{
+    MemoryLedger ledger;
+    ledger.set("model/ply", 1000, 0, true);
+    ledger.set("model/vertices", 300, 0);
+    QCOMPARE(ledger.cpuBytes(), qint64(300));
+    QCOMPARE(ledger.entry("model/ply").cpuBytes, qint64(1000));
+}
+
+//=============================================================================
+void MemoryLedgerTest::groupsMatchWholeNameSegments()
+{
+    MemoryLedger ledger;
+    ledger.set("model/vbo", 0, 10);
+    ledger.set("models/vbo", 0, 20);
+    ledger.set("model", 5, 0);
+    QCOMPARE(ledger.gpuBytes("model"), qint64(10));
+    QCOMPARE(ledger.cpuBytes("model"), qint64(5));
+    QCOMPARE(ledger.entries("model").count(), 2);
+}
+
+//=============================================================================
+void MemoryLedgerTest::removeGroupLeavesOtherGroups()
+{
+    MemoryLedger ledger;
+    ledger.set("model/vbo", 0, 10);
+    ledger.set("model/texture", 0, 20);
+    ledger.set("ornaments/vbo", 0, 30);
+    ledger.removeGroup("model");
+    QCOMPARE(ledger.entries().count(), 1);
+    QCOMPARE(ledger.gpuBytes(), qint64(30));
+}
+
+//=============================================================================
+void MemoryLedgerTest::textureBytesIncludesMipChain()
+{
+    QCOMPARE(MemoryLedger::textureBytes(4, 4, 1), qint64(64));
+    QCOMPARE(MemoryLedger::textureBytes(4, 4, 3), qint64(64 + 16 + 4));
+    QCOMPARE(MemoryLedger::textureBytes(4, 1, 3), qint64(16 + 8 + 4));
+    QCOMPARE(MemoryLedger::textureBytes(2, 2, 10), qint64(16 + 4));
+}
@@ -0,0 +1,13 @@
+#include <QObject>
+
+class MemoryLedgerTest : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void setReplacesEntry();
+    void totalsSkipTransientEntries();
+    void groupsMatchWholeNameSegments();
+    void removeGroupLeavesOtherGroups();
+    void textureBytesIncludesMipChain();
+};
@@ -0,0 +1,147 @@
+#include "MipChainTest.h"
+
+#include <QtTest>
+#include <random>
+
+#include "MipChain.h"
+
+namespace {
+    //=========================================================================
+    // One level down with the same rounding as MipChain, texel by texel.
+    QByteArray referenceLevel(const MipChain::Level& fine, int width,
+            int height)
+    {
+        const uchar *pixels_p =
+                reinterpret_cast<const uchar *>(fine.pixels.constData());
+        QByteArray coarse(width * height * 4, 0);
+        for(int y = 0; y < height; ++y) {
+            const int y0 = qMin(2 * y, fine.height - 1);
+            const int y1 = qMin(2 * y + 1, fine.height - 1);
+            for(int x = 0; x < width; ++x) {
+                const int x0 = qMin(2 * x, fine.width - 1);
+                const int x1 = qMin(2 * x + 1, fine.width - 1);
+                for(int c = 0; c < 4; ++c) {
+                    const int sum =
+                            pixels_p[(y0 * fine.width + x0) * 4 + c] +
+                            pixels_p[(y0 * fine.width + x1) * 4 + c] +
+                            pixels_p[(y1 * fine.width + x0) * 4 + c] +
+                            pixels_p[(y1 * fine.width + x1) * 4 + c];
+                    coarse[(y * width + x) * 4 + c] = (char)((sum + 2) >> 2);
+                }
+            }
+        }
+        return coarse;
+    }
+
+    //=========================================================================
+    uchar texel(const MipChain::Level& level, int x, int y, int c)
+    {
+        return (uchar)level.pixels[(y * level.width + x) * 4 + c];
+    }
+}
+
+//=============================================================================
+void MipChainTest::levelCountReachesOneTexel()
+{
+    QCOMPARE(MipChain::fullLevelCount(1, 1), 1);
+    QCOMPARE(MipChain::fullLevelCount(256, 256), 9);
+    QCOMPARE(MipChain::fullLevelCount(256, 16), 9);
+    QCOMPARE(MipChain::fullLevelCount(300, 7), 9);
+
+    const QByteArray pixels(16 * 4 * 4, 0);
+    MipChain chain;
+    chain.build(reinterpret_cast<const uchar *>(pixels.constData()), 16, 4,
+            16 * 4);
+    QCOMPARE(chain.levelCount(), 5);
+    QCOMPARE(chain.level(2).width, 4);
+    QCOMPARE(chain.level(2).height, 1);
+    QCOMPARE(chain.level(4).width, 1);
+    QCOMPARE(chain.level(4).height, 1);
+
+    MipChain empty;
+    empty.build(nullptr, 0, 0, 0);
+    QVERIFY(empty.isEmpty());
+}
+
+//=============================================================================
+void MipChainTest::boxFilterAveragesQuads()
+{
+    // 2x2 RGBA texels; each channel's average rounds to nearest.
+    const uchar pixels[] = {
+        0, 10, 255, 1,    4, 20, 255, 2,
+        8, 30, 0, 3,      12, 41, 0, 4
+    };
+    MipChain chain;
+    chain.build(pixels, 2, 2, 8);
+    QCOMPARE(chain.levelCount(), 2);
+    const MipChain::Level& level = chain.level(1);
+    QCOMPARE(texel(level, 0, 0, 0), (uchar)6);
+    QCOMPARE(texel(level, 0, 0, 1), (uchar)25);
+    QCOMPARE(texel(level, 0, 0, 2), (uchar)128);
+    QCOMPARE(texel(level, 0, 0, 3), (uchar)3);
+}
+
+//=============================================================================
+void MipChainTest::oddSizesDropLastRowAndColumn()
+{
+    QByteArray pixels(3 * 3 * 4, 0);
+    for(int i = 0; i < 3; ++i) {
+        pixels[(i * 3 + 2) * 4] = (char)255;
+        pixels[(2 * 3 + i) * 4] = (char)255;
+    }
+    MipChain chain;
+    chain.build(reinterpret_cast<const uchar *>(pixels.constData()), 3, 3,
+            3 * 4);
+    QCOMPARE(chain.level(1).width, 1);
+    QCOMPARE(chain.level(1).height, 1);
+    QCOMPARE(texel(chain.level(1), 0, 0, 0), (uchar)0);
+}
+
+//=============================================================================
+void MipChainTest::paddedRowsAreSkipped()
+{
+    constexpr int bytesPerLine = 2 * 4 + 8;
+    QByteArray pixels(2 * bytesPerLine, (char)200);
+    for(int y = 0; y < 2; ++y) {
+        for(int i = 0; i < 2 * 4; ++i) pixels[y * bytesPerLine + i] = 100;
+    }
+    MipChain chain;
+    chain.build(reinterpret_cast<const uchar *>(pixels.constData()), 2, 2,
+            bytesPerLine);
+    QCOMPARE(chain.level(0).pixels, QByteArray(2 * 2 * 4, 100));
+    QCOMPARE(texel(chain.level(1), 0, 0, 2), (uchar)100);
+}
+
+//=============================================================================
+// Big enough for the row bands to run on the thread pool, and odd enough
+// that the vector loop leaves a remainder.
+void MipChainTest::largeImageMatchesReference()
+{
+    constexpr int width = 517;
+    constexpr int height = 300;
+    std::mt19937 random(7);
+    QByteArray pixels(width * height * 4, 0);
+    for(auto& value : pixels) value = (char)(random() & 0xff);
+
+    MipChain chain;
+    chain.build(reinterpret_cast<const uchar *>(pixels.constData()), width,
+            height, width * 4);
+    QCOMPARE(chain.levelCount(), MipChain::fullLevelCount(width, height));
+    for(int i = 1; i < chain.levelCount(); ++i) {
+        const MipChain::Level& level = chain.level(i);
+        QCOMPARE(level.pixels, referenceLevel(chain.level(i - 1),
+                level.width, level.height));
+    }
+}
+
+//=============================================================================
+void MipChainTest::bytesCountFromLevel()
+{
+    const QByteArray pixels(8 * 8 * 4, 0);
+    MipChain chain;
+    chain.build(reinterpret_cast<const uchar *>(pixels.constData()), 8, 8,
+            8 * 4);
+    QCOMPARE(chain.bytes(), (qint64)(64 + 16 + 4 + 1) * 4);
+    QCOMPARE(chain.bytes(2), (qint64)(4 + 1) * 4);
+    QCOMPARE(chain.bytes(4), (qint64)0);
+}
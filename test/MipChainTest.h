@@ -0,0 +1,14 @@
+#include <QObject>
+
+class MipChainTest : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void levelCountReachesOneTexel();
+    void boxFilterAveragesQuads();
+    void oddSizesDropLastRowAndColumn();
+    void paddedRowsAreSkipped();
+    void largeImageMatchesReference();
+    void bytesCountFromLevel();
+};
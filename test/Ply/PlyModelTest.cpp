@@ -250,3 +250,39 @@ void PlyModelTest::parserReadsListPropertyValues()
     QCOMPARE(list.value(2), 0.5);
     QCOMPARE(list.count(), 3);
 }
+
+//=============================================================================
+void PlyModelTest::memoryBytesGrowsWithInstances()
+{
+    QTextStream small(
+        "ply\n"
+        "format ascii 1.0\n"
+        "element vertex 1\n"
+        "property float x\n"
+        "element face 1\n"
+        "property list uchar int verts\n"
+        "end_header\n"
+        "0\n"
+        "3 0 0 0\n"
+    );
+    QTextStream large(
+        "ply\n"
+        "format ascii 1.0\n"
+        "element vertex 3\n"
+        "property float x\n"
+        "element face 2\n"
+        "property list uchar int verts\n"
+        "end_header\n"
+        "0\n"
+        "1\n"
+        "2\n"
+        "3 0 1 2\n"
+        "3 2 1 0\n"
+    );
+    const PlyModel smallModel = PlyModel::parse(small);
+    const PlyModel largeModel = PlyModel::parse(large);
+
+    QCOMPARE(PlyModel().memoryBytes(), qint64(0));
+    QVERIFY(smallModel.memoryBytes() > 0);
+    QVERIFY(largeModel.memoryBytes() > smallModel.memoryBytes());
+}
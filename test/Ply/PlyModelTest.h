@@ -22,4 +22,5 @@ private slots:
     void parserReturnsInvalidIfListIsTooShort();
     void parserReadsScalarPropertyValues();
     void parserReadsListPropertyValues();
+    void memoryBytesGrowsWithInstances();
 };
@@ -0,0 +1,160 @@
+#include "PlyWriterTest.h"
+
+#include <QBuffer>
+#include <QtTest>
+
+#include "Ply/PlyModel.h"
+#include "Ply/PlyWriter.h"
+
+namespace {
+    //=========================================================================
+    QByteArray writeModel(const PlyModel& model, PlyWriter::Encoding encoding,
+            int chunkSize = PlyWriter::DEFAULT_CHUNK_SIZE)
+    {
+        QByteArray bytes;
+        QBuffer buffer(&bytes);
+        if(!buffer.open(QIODevice::WriteOnly)) return QByteArray();
+        PlyWriter writer(chunkSize);
+        if(!writer.write(model, buffer, encoding)) return QByteArray();
+        return bytes;
+    }
+}
+
+//=============================================================================
+void PlyWriterTest::asciiOutputMatchesParsedInput()
+{
+    const QByteArray input =
+        "ply\n"
+        "format ascii 1.0\n"
+        "comment made by hand\n"
+        "element vertex 2\n"
+        "property float y\n"
+        "property float x\n"
+        "element face 1\n"
+        "property list uchar int vertex_indices\n"
+        "property uchar flags\n"
+        "end_header\n"
+        "0.5 -1\n"
+        "0.1 2.25\n"
+        "3 0 1 0 7\n";
+    QTextStream stream(input);
+    const PlyModel model = PlyModel::parse(stream);
+    QVERIFY(model.isValid());
+
+    QCOMPARE(writeModel(model, PlyWriter::Encoding::ASCII), input);
+}
+
+//=============================================================================
+void PlyWriterTest::asciiNumbersRoundTrip()
+{
+    const QList<double> values = {
+        0.1 + 0.2, 1.0 / 3.0, -1e-7, 1e20, 123456789.0
+    };
+    PlyModel model;
+    model.addElement("vertex", values.count());
+    QVERIFY(model.addScalarProperty("vertex", "x", "double", values));
+
+    const QByteArray bytes = writeModel(model, PlyWriter::Encoding::ASCII);
+    QTextStream stream(bytes);
+    const PlyModel parsed = PlyModel::parse(stream);
+    QVERIFY(parsed.isValid());
+    for(int i = 0; i < values.count(); ++i) {
+        QCOMPARE(parsed.scalarValue("vertex", i, "x"), values.at(i));
+    }
+
+    // Shortest form, not a fixed 17 digits.
+    QVERIFY(bytes.contains("\n0.30000000000000004\n"));
+    QVERIFY(bytes.contains("\n123456789\n"));
+}
+
+//=============================================================================
+void PlyWriterTest::binaryOutputUsesPropertyTypes()
+{
+    PlyModel model;
+    model.addElement("vertex", 1);
+    QVERIFY(model.addScalarProperty("vertex", "x", "float", { 1.5 }));
+    QVERIFY(model.addScalarProperty("vertex", "flags", "uchar", { 200 }));
+    model.addElement("face", 1);
+    QVERIFY(model.addListProperty("face", "vertex_indices", "uchar", "int",
+            { { 0, 1, 258 } }));
+
+    const QByteArray header =
+        "ply\n"
+        "format binary_little_endian 1.0\n"
+        "element vertex 1\n"
+        "property float x\n"
+        "property uchar flags\n"
+        "element face 1\n"
+        "property list uchar int vertex_indices\n"
+        "end_header\n";
+    const QByteArray body = QByteArray::fromHex(
+        "0000c03f" "c8"
+        "03" "00000000" "01000000" "02010000");
+
+    QCOMPARE(writeModel(model, PlyWriter::Encoding::BINARY_LITTLE_ENDIAN),
+            header + body);
+}
+
+//=============================================================================
+void PlyWriterTest::binaryClampsOutOfRangeIntegers()
+{
+    PlyModel model;
+    model.addElement("vertex", 2);
+    QVERIFY(model.addScalarProperty("vertex", "a", "uchar", { 300, -5 }));
+    QVERIFY(model.addScalarProperty("vertex", "b", "short", { 1e9, -1e9 }));
+    QVERIFY(model.addScalarProperty("vertex", "c", "int", { 1e12, -1e12 }));
+
+    const QByteArray bytes =
+            writeModel(model, PlyWriter::Encoding::BINARY_LITTLE_ENDIAN);
+    const QByteArray body = QByteArray::fromHex(
+        "ff" "ff7f" "ffffff7f"
+        "00" "0080" "00000080");
+    QVERIFY(bytes.endsWith(body));
+}
+
+//=============================================================================
+void PlyWriterTest::binaryRejectsUnknownTypes()
+{
+    PlyModel model;
+    model.addElement("vertex", 1);
+    QVERIFY(model.addScalarProperty("vertex", "x", "real", { 1.0 }));
+
+    QVERIFY(writeModel(model,
+            PlyWriter::Encoding::BINARY_LITTLE_ENDIAN).isEmpty());
+    QVERIFY(!writeModel(model, PlyWriter::Encoding::ASCII).isEmpty());
+}
+
+//=============================================================================
+void PlyWriterTest::chunkSizeDoesNotChangeOutput()
+{
+    QList<double> xs;
+    QList<QList<double>> faces;
+    for(int i = 0; i < 1000; ++i) {
+        xs.append(i * 0.25);
+        faces.append({ (double)i, (double)(i + 1), (double)(i + 2) });
+    }
+    PlyModel model;
+    model.addElement("vertex", xs.count());
+    QVERIFY(model.addScalarProperty("vertex", "x", "float", xs));
+    model.addElement("face", faces.count());
+    QVERIFY(model.addListProperty("face", "vertex_indices", "uchar", "int",
+            faces));
+
+    for(auto encoding : { PlyWriter::Encoding::ASCII,
+            PlyWriter::Encoding::BINARY_LITTLE_ENDIAN }) {
+        const QByteArray large = writeModel(model, encoding);
+        QVERIFY(!large.isEmpty());
+        QCOMPARE(writeModel(model, encoding, 256), large);
+    }
+}
+
+//=============================================================================
+void PlyWriterTest::addPropertyRejectsWrongValueCount()
+{
+    PlyModel model;
+    model.addElement("vertex", 2);
+    QVERIFY(!model.addScalarProperty("vertex", "x", "float", { 1.0 }));
+    QVERIFY(!model.addScalarProperty("face", "x", "float", { 1.0, 2.0 }));
+    QVERIFY(!model.addListProperty("vertex", "l", "uchar", "int", {}));
+    QVERIFY(model.propertyNames("vertex").isEmpty());
+}
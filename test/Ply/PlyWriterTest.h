@@ -0,0 +1,15 @@
+#include <QObject>
+
+class PlyWriterTest : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void asciiOutputMatchesParsedInput();
+    void asciiNumbersRoundTrip();
+    void binaryOutputUsesPropertyTypes();
+    void binaryClampsOutOfRangeIntegers();
+    void binaryRejectsUnknownTypes();
+    void chunkSizeDoesNotChangeOutput();
+    void addPropertyRejectsWrongValueCount();
+};
@@ -0,0 +1,133 @@
+#include "ResolutionControllerTest.h"
+
+#include <QtTest>
+#include <cmath>
+
+#include "ResolutionController.h"
+
+namespace {
+    //=========================================================================
+    // Feeds the same frame time until the scale changes or count frames
+    // have gone by.  Returns the number of frames fed.
+    int feed(ResolutionController& controller, float ms, int count)
+    {
+        for(int i = 0; i < count; ++i) {
+            if(controller.addFrame(ms)) return i + 1;
+        }
+        return count;
+    }
+
+    //=========================================================================
+    bool closeTo(float a, float b)
+    {
+        return std::fabs(a - b) < 1e-4f;
+    }
+}
+
+//=============================================================================
+void ResolutionControllerTest::startsAtFullScale()
+{
+    ResolutionController controller(10.0f);
+    QCOMPARE(controller.scale(), 1.0f);
+    QCOMPARE(controller.budget(), 10.0f);
+    QVERIFY(!controller.addFrame(0.0f));
+}
+
+//=============================================================================
+void ResolutionControllerTest::slowFramesLowerTheScale()
+{
+    // 10% over the budget wants sqrt(1 / 1.1) = 0.953 of the pixels per
+    // side, which rounds down to the next step.
+    ResolutionController controller(10.0f);
+    QCOMPARE(feed(controller, 11.0f, 100),
+            ResolutionController::SETTLE_FRAMES);
+    QVERIFY(closeTo(controller.scale(), 0.95f));
+}
+
+//=============================================================================
+void ResolutionControllerTest::changesAreLimited()
+{
+    ResolutionController controller(10.0f);
+    (void)feed(controller, 100.0f, 100);
+    QVERIFY(closeTo(controller.scale(),
+            1.0f - ResolutionController::MAX_CHANGE));
+}
+
+//=============================================================================
+void ResolutionControllerTest::scaleStaysInRange()
+{
+    ResolutionController controller(10.0f);
+    for(int i = 0; i < 1000; ++i) (void)controller.addFrame(100.0f);
+    QVERIFY(closeTo(controller.scale(), ResolutionController::MIN_SCALE));
+
+    for(int i = 0; i < 1000; ++i) (void)controller.addFrame(1.0f);
+    QVERIFY(closeTo(controller.scale(), ResolutionController::MAX_SCALE));
+}
+
+//=============================================================================
+void ResolutionControllerTest::fastFramesRaiseTheScale()
+{
+    ResolutionController controller(10.0f);
+    for(int i = 0; i < 1000; ++i) (void)controller.addFrame(100.0f);
+
+    // At half scale, 2 ms frames leave room for twice the pixels per side.
+    // The average has to come down first, and no change goes further up
+    // than MAX_CHANGE.
+    QVERIFY(feed(controller, 2.0f, 100) < 100);
+    QVERIFY(controller.scale() > 0.5f);
+    QVERIFY(controller.scale() <
+            0.5f + ResolutionController::MAX_CHANGE + 1e-4f);
+}
+
+//=============================================================================
+void ResolutionControllerTest::framesAfterAChangeAreIgnored()
+{
+    ResolutionController controller(10.0f);
+    QVERIFY(feed(controller, 11.0f, 100) < 100);
+    const float scale = controller.scale();
+
+    // A wild frame right after the change is dropped.
+    for(int i = 0; i < ResolutionController::SETTLE_FRAMES; ++i) {
+        QVERIFY(!controller.addFrame(1000.0f));
+    }
+    QCOMPARE(controller.scale(), scale);
+}
+
+//=============================================================================
+void ResolutionControllerTest::probesUpwardInsideBudget()
+{
+    ResolutionController controller(10.0f);
+    (void)feed(controller, 11.0f, 100);
+    QVERIFY(closeTo(controller.scale(), 0.95f));
+
+    // Just inside the budget: nothing to gain from the estimate, but the
+    // scale is tried one step higher after a while.
+    const int frames = feed(controller, 9.5f, 1000);
+    QVERIFY(frames > ResolutionController::PROBE_FRAMES);
+    QVERIFY(frames < 1000);
+    QVERIFY(closeTo(controller.scale(), 1.0f));
+}
+
+//=============================================================================
+// Frame time made of a fixed part and a part that grows with the pixel
+// count.  The scale should settle on the largest step that fits, leaving
+// only the occasional probe one step above it.
+void ResolutionControllerTest::convergesOnFillRateBoundLoad()
+{
+    ResolutionController controller(16.0f);
+    auto frameMs = [](float scale) {
+        return 4.0f + 30.0f * scale * scale;
+    };
+    for(int i = 0; i < 1000; ++i) {
+        (void)controller.addFrame(frameMs(controller.scale()));
+    }
+
+    int overBudget = 0;
+    for(int i = 0; i < 1000; ++i) {
+        const float scale = controller.scale();
+        QVERIFY(scale > 0.6f - 1e-4f && scale < 0.65f + 1e-4f);
+        if(frameMs(scale) > 16.0f) ++overBudget;
+        (void)controller.addFrame(frameMs(scale));
+    }
+    QVERIFY(overBudget < 100);
+}
@@ -0,0 +1,16 @@
+#include <QObject>
+
+class ResolutionControllerTest : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void startsAtFullScale();
+    void slowFramesLowerTheScale();
+    void changesAreLimited();
+    void scaleStaysInRange();
+    void fastFramesRaiseTheScale();
+    void framesAfterAChangeAreIgnored();
+    void probesUpwardInsideBudget();
+    void convergesOnFillRateBoundLoad();
+};
@@ -0,0 +1,89 @@
+#include "ResourceTableTest.h"
+
+#include <QtTest>
+
+#include "ResourceTable.h"
+
+//=============================================================================
+void ResourceTableTest::acquireFindsSharedResource()
+{
+    ResourceTable table;
+    QCOMPARE(table.acquire("mesh"), quintptr(0));
+    QCOMPARE(table.add("mesh", 7, 100), quintptr(7));
+    QCOMPARE(table.acquire("mesh"), quintptr(7));
+    QCOMPARE(table.users(7), 2);
+    QCOMPARE(table.acquire("other"), quintptr(0));
+}
+
+//=============================================================================
+void ResourceTableTest::addOfTakenKeyReturnsExisting()
+{
+    ResourceTable table;
+    (void)table.add("mesh", 7, 100);
+
+    // The caller frees its own copy and uses the shared one.
+    QCOMPARE(table.add("mesh", 9, 100), quintptr(7));
+    QCOMPARE(table.users(7), 2);
+    QVERIFY(!table.contains(9));
+}
+
+//=============================================================================
+void ResourceTableTest::lastReleaseFreesResource()
+{
+    ResourceTable table;
+    (void)table.add("mesh", 7, 100);
+    (void)table.acquire("mesh");
+
+    QVERIFY(!table.release(7));
+    QVERIFY(table.contains(7));
+    QVERIFY(table.release(7));
+    QVERIFY(!table.contains(7));
+    QVERIFY(table.isEmpty());
+
+    // The key can be shared again afterwards.
+    QCOMPARE(table.acquire("mesh"), quintptr(0));
+    QCOMPARE(table.add("mesh", 8, 100), quintptr(8));
+}
+
+//=============================================================================
+void ResourceTableTest::unknownHandlesAreFreed()
+{
+    ResourceTable table;
+    (void)table.add("mesh", 7, 100);
+    QVERIFY(table.release(3));
+    QVERIFY(table.detach(3));
+    QCOMPARE(table.users(7), 1);
+}
+
+//=============================================================================
+void ResourceTableTest::detachLeavesOtherUsersAlone()
+{
+    ResourceTable table;
+    (void)table.add("mesh", 7, 100);
+    (void)table.acquire("mesh");
+
+    // Someone else still draws it, so it may not be changed.
+    QVERIFY(!table.detach(7));
+    QCOMPARE(table.users(7), 1);
+    QCOMPARE(table.acquire("mesh"), quintptr(7));
+    QVERIFY(!table.release(7));
+
+    // Its one user may, and it is no longer shared under the old key.
+    QVERIFY(table.detach(7));
+    QVERIFY(!table.contains(7));
+    QCOMPARE(table.acquire("mesh"), quintptr(0));
+}
+
+//=============================================================================
+void ResourceTableTest::statsCountEachResourceOnce()
+{
+    ResourceTable table;
+    (void)table.add("mesh", 7, 100);
+    (void)table.add("mesh", 9, 100);
+    (void)table.add("texture", 8, 40);
+
+    const ResourceTable::Stats stats = table.stats();
+    QCOMPARE(stats.resources, 2);
+    QCOMPARE(stats.references, 3);
+    QCOMPARE(stats.bytes, qint64(140));
+}
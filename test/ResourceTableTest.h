@@ -0,0 +1,14 @@
+#include <QObject>
+
+class ResourceTableTest : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void acquireFindsSharedResource();
+    void addOfTakenKeyReturnsExisting();
+    void lastReleaseFreesResource();
+    void unknownHandlesAreFreed();
+    void detachLeavesOtherUsersAlone();
+    void statsCountEachResourceOnce();
+};
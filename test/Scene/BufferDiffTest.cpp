@@ -0,0 +1,100 @@
+#include "BufferDiffTest.h"
+
+#include <QtTest>
+
+#include "Scene/BufferDiff.h"
+
+namespace {
+    constexpr int VALUES = 3;
+
+    //=========================================================================
+    QVector<float> makeVertices(int count)
+    {
+        QVector<float> vertices;
+        for(int i = 0; i < count * VALUES; ++i) vertices.append(i);
+        return vertices;
+    }
+
+    //=========================================================================
+    QVector<BufferDiff::Range> diff(const QVector<float>& previous,
+            const QVector<float>& current, int mergeGap)
+    {
+        return BufferDiff::changedRanges(previous.constData(),
+                previous.count() / VALUES, current.constData(),
+                current.count() / VALUES, VALUES, mergeGap);
+    }
+}
+
+//=============================================================================
+void BufferDiffTest::identicalArraysHaveNoRanges()
+{
+    const QVector<float> vertices = makeVertices(100);
+    QVERIFY(diff(vertices, vertices, 4).isEmpty());
+}
+
+//=============================================================================
+void BufferDiffTest::singleChangedVertex()
+{
+    const QVector<float> previous = makeVertices(100);
+    QVector<float> current = previous;
+    current[42 * VALUES + 1] = -1.0f;
+
+    const auto ranges = diff(previous, current, 4);
+    QCOMPARE(ranges.count(), 1);
+    QCOMPARE(ranges[0].first, 42);
+    QCOMPARE(ranges[0].count, 1);
+}
+
+//=============================================================================
+void BufferDiffTest::nearbyChangesAreMerged()
+{
+    const QVector<float> previous = makeVertices(100);
+    QVector<float> current = previous;
+    current[10 * VALUES] = -1.0f;
+    current[13 * VALUES] = -1.0f;
+
+    const auto ranges = diff(previous, current, 4);
+    QCOMPARE(ranges.count(), 1);
+    QCOMPARE(ranges[0].first, 10);
+    QCOMPARE(ranges[0].count, 4);
+}
+
+//=============================================================================
+void BufferDiffTest::distantChangesStaySeparate()
+{
+    const QVector<float> previous = makeVertices(100);
+    QVector<float> current = previous;
+    current[10 * VALUES] = -1.0f;
+    current[50 * VALUES] = -1.0f;
+
+    const auto ranges = diff(previous, current, 4);
+    QCOMPARE(ranges.count(), 2);
+    QCOMPARE(ranges[0].first, 10);
+    QCOMPARE(ranges[1].first, 50);
+    QCOMPARE(BufferDiff::vertexCount(ranges), 2);
+}
+
+//=============================================================================
+void BufferDiffTest::grownArrayIncludesTail()
+{
+    const QVector<float> previous = makeVertices(100);
+    const QVector<float> current = makeVertices(120);
+
+    const auto ranges = diff(previous, current, 4);
+    QCOMPARE(ranges.count(), 1);
+    QCOMPARE(ranges[0].first, 100);
+    QCOMPARE(ranges[0].count, 20);
+}
+
+//=============================================================================
+void BufferDiffTest::shrunkArrayIgnoresRemovedVertices()
+{
+    const QVector<float> previous = makeVertices(100);
+    QVector<float> current = makeVertices(80);
+    current[5 * VALUES] = -1.0f;
+
+    const auto ranges = diff(previous, current, 4);
+    QCOMPARE(ranges.count(), 1);
+    QCOMPARE(ranges[0].first, 5);
+    QCOMPARE(ranges[0].count, 1);
+}
@@ -0,0 +1,14 @@
+#include <QObject>
+
+class BufferDiffTest : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void identicalArraysHaveNoRanges();
+    void singleChangedVertex();
+    void nearbyChangesAreMerged();
+    void distantChangesStaySeparate();
+    void grownArrayIncludesTail();
+    void shrunkArrayIgnoresRemovedVertices();
+};
@@ -0,0 +1,207 @@
+#include "BvhTest.h"
+
+#include <QRandomGenerator>
+#include <QtTest>
+#include <cmath>
+
+#include "Scene/Bvh.h"
+
+namespace {
+
+//=============================================================================
+// A flat grid of size x size quads at height z, two triangles per quad.
+QVector<float> makeGrid(int size, float z)
+{
+    QVector<float> vertices;
+    auto add = [&vertices, z](float x, float y) {
+        vertices << x << y << z;
+    };
+    for(int j = 0; j < size; ++j) {
+        for(int i = 0; i < size; ++i) {
+            add(i, j);
+            add(i + 1, j);
+            add(i + 1, j + 1);
+            add(i, j);
+            add(i + 1, j + 1);
+            add(i, j + 1);
+        }
+    }
+    return vertices;
+}
+
+//=============================================================================
+// Plain double precision Moller-Trumbore, the reference the BVH is checked
+// against.
+bool intersectTriangle(const float *p, const float *origin_p,
+        const float *direction_p, double *distance_p)
+{
+    double e1[3];
+    double e2[3];
+    double s[3];
+    double d[3];
+    for(int i = 0; i < 3; ++i) {
+        e1[i] = (double)p[3 + i] - p[i];
+        e2[i] = (double)p[6 + i] - p[i];
+        s[i] = (double)origin_p[i] - p[i];
+        d[i] = direction_p[i];
+    }
+    const double h[3] = {
+        d[1]*e2[2] - d[2]*e2[1],
+        d[2]*e2[0] - d[0]*e2[2],
+        d[0]*e2[1] - d[1]*e2[0]
+    };
+    const double a = e1[0]*h[0] + e1[1]*h[1] + e1[2]*h[2];
+    if(std::abs(a) < 1e-12) return false;
+
+    const double u = (s[0]*h[0] + s[1]*h[1] + s[2]*h[2]) / a;
+    if(u < 0.0 || u > 1.0) return false;
+    const double q[3] = {
+        s[1]*e1[2] - s[2]*e1[1],
+        s[2]*e1[0] - s[0]*e1[2],
+        s[0]*e1[1] - s[1]*e1[0]
+    };
+    const double v = (d[0]*q[0] + d[1]*q[1] + d[2]*q[2]) / a;
+    if(v < 0.0 || u + v > 1.0) return false;
+
+    *distance_p = (e2[0]*q[0] + e2[1]*q[1] + e2[2]*q[2]) / a;
+    return *distance_p > 0.0;
+}
+
+} // namespace
+
+//=============================================================================
+void BvhTest::emptyBvhMisses()
+{
+    Bvh bvh;
+    bvh.build(nullptr, 0, 3);
+    QVERIFY(bvh.isEmpty());
+
+    const float origin[3] = { 0.0f, 0.0f, 1.0f };
+    const float direction[3] = { 0.0f, 0.0f, -1.0f };
+    QVERIFY(!bvh.intersect(origin, direction).isValid());
+}
+
+//=============================================================================
+void BvhTest::rayHitsSingleTriangle()
+{
+    const float vertices[] = {
+        0.0f, 0.0f, 0.0f,  1.0f, 0.0f, 0.0f,  0.0f, 1.0f, 0.0f
+    };
+    Bvh bvh;
+    bvh.build(vertices, 3, 3);
+    QCOMPARE(bvh.triangleCount(), 1);
+
+    const float origin[3] = { 0.25f, 0.25f, 2.0f };
+    const float direction[3] = { 0.0f, 0.0f, -1.0f };
+    const Bvh::Hit hit = bvh.intersect(origin, direction);
+    QVERIFY(hit.isValid());
+    QCOMPARE(hit.triangle, 0);
+    QCOMPARE(hit.distance, 2.0f);
+    QCOMPARE(hit.u, 0.25f);
+    QCOMPARE(hit.v, 0.25f);
+}
+
+//=============================================================================
+void BvhTest::rayMissesOutsideTriangle()
+{
+    const float vertices[] = {
+        0.0f, 0.0f, 0.0f,  1.0f, 0.0f, 0.0f,  0.0f, 1.0f, 0.0f
+    };
+    Bvh bvh;
+    bvh.build(vertices, 3, 3);
+
+    const float origin[3] = { 0.75f, 0.75f, 2.0f };
+    const float direction[3] = { 0.0f, 0.0f, -1.0f };
+    QVERIFY(!bvh.intersect(origin, direction).isValid());
+}
+
+//=============================================================================
+void BvhTest::nearestTriangleWins()
+{
+    QVector<float> vertices = makeGrid(4, 0.0f);
+    const int upperFirst = vertices.count() / 9;
+    vertices += makeGrid(4, 1.0f);
+
+    Bvh bvh;
+    bvh.build(vertices.constData(), vertices.count() / 3, 3);
+
+    const float origin[3] = { 1.3f, 2.6f, 5.0f };
+    const float direction[3] = { 0.0f, 0.0f, -1.0f };
+    const Bvh::Hit hit = bvh.intersect(origin, direction);
+    QVERIFY(hit.isValid());
+    QVERIFY(hit.triangle >= upperFirst);
+    QCOMPARE(hit.distance, 4.0f);
+}
+
+//=============================================================================
+void BvhTest::matchesBruteForce()
+{
+    // A bumpy grid and triangles at random angles above and below it.
+    QRandomGenerator generator(1234);
+    auto random = [&generator](float min, float max) {
+        return min + (float)generator.generateDouble() * (max - min);
+    };
+    const int size = 16;
+    QVector<float> vertices = makeGrid(size, 0.0f);
+    for(int i = 0; i < vertices.count(); i += 3) {
+        vertices[i + 2] = 0.3f * std::sin(vertices[i] * 1.7f) *
+                std::cos(vertices[i + 1] * 1.3f);
+    }
+    for(int t = 0; t < 200; ++t) {
+        for(int corner = 0; corner < 3; ++corner) {
+            vertices << random(0.0f, size) << random(0.0f, size)
+                    << random(-2.0f, 2.0f);
+        }
+    }
+    const int triangleCount = vertices.count() / 9;
+
+    Bvh bvh;
+    bvh.build(vertices.constData(), vertices.count() / 3, 3);
+    QCOMPARE(bvh.triangleCount(), triangleCount);
+    QVERIFY(bvh.nodeCount() > 1);
+
+    // Rays start anywhere around the mesh and point anywhere, so some miss
+    // everything.
+    int hits = 0;
+    int misses = 0;
+    for(int r = 0; r < 2000; ++r) {
+        const float origin[3] = {
+            random(-4.0f, size + 4.0f), random(-4.0f, size + 4.0f),
+            random(-4.0f, 6.0f)
+        };
+        const float direction[3] = {
+            random(-1.0f, 1.0f), random(-1.0f, 1.0f), random(-1.0f, 1.0f)
+        };
+
+        int expected = -1;
+        double nearest = 0.0;
+        for(int t = 0; t < triangleCount; ++t) {
+            double distance = 0.0;
+            if(intersectTriangle(vertices.constData() + t * 9, origin,
+                    direction, &distance) &&
+                    (expected < 0 || distance < nearest)) {
+                expected = t;
+                nearest = distance;
+            }
+        }
+
+        const Bvh::Hit hit = bvh.intersect(origin, direction);
+        QCOMPARE(hit.isValid(), expected >= 0);
+        if(expected < 0) {
+            ++misses;
+            continue;
+        }
+        ++hits;
+
+        // Triangles sharing the hit point may win either way.
+        QVERIFY(std::abs(hit.distance - nearest) < 1e-4 * (1.0 + nearest));
+        if(hit.triangle != expected) {
+            double distance = 0.0;
+            QVERIFY(intersectTriangle(vertices.constData() +
+                    hit.triangle * 9, origin, direction, &distance));
+            QVERIFY(std::abs(distance - nearest) < 1e-4 * (1.0 + nearest));
+        }
+    }
+    QVERIFY(hits > 0);
+    QVERIFY(misses > 0);
+}
@@ -0,0 +1,13 @@
+#include <QObject>
+
+class BvhTest : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void emptyBvhMisses();
+    void rayHitsSingleTriangle();
+    void rayMissesOutsideTriangle();
+    void nearestTriangleWins();
+    void matchesBruteForce();
+};
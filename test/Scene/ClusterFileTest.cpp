@@ -0,0 +1,160 @@
+#include "ClusterFileTest.h"
+
+#include <QFile>
+#include <QTemporaryFile>
+#include <QtTest>
+#include <algorithm>
+
+#include "Scene/ClusterFile.h"
+
+namespace {
+    constexpr int STRIDE = 4;
+
+    //=========================================================================
+    // A flat size x size grid, two triangles per cell.  The fourth value is
+    // the triangle's original index so every triangle can be tracked.
+    QVector<float> makeGrid(int size)
+    {
+        QVector<float> vertices;
+        int triangle = 0;
+        auto add = [&vertices, &triangle](float x, float y) {
+            vertices << x << y << 0.0f << (float)triangle;
+        };
+        for(int j = 0; j < size; ++j) {
+            for(int i = 0; i < size; ++i) {
+                add(i, j);
+                add(i + 1, j);
+                add(i + 1, j + 1);
+                ++triangle;
+                add(i, j);
+                add(i + 1, j + 1);
+                add(i, j + 1);
+                ++triangle;
+            }
+        }
+        return vertices;
+    }
+
+    //=========================================================================
+    bool writeFile(QTemporaryFile& file, const QVector<float>& vertices,
+            int clusterTriangles)
+    {
+        if(!file.open()) return false;
+        const bool written = ClusterFile::write(file, vertices.constData(),
+                vertices.count() / STRIDE, STRIDE, clusterTriangles);
+        file.close();
+        return written;
+    }
+}
+
+//=============================================================================
+void ClusterFileTest::roundTripKeepsEveryTriangle()
+{
+    const QVector<float> vertices = makeGrid(8);
+    QTemporaryFile temp;
+    QVERIFY(writeFile(temp, vertices, 10));
+
+    ClusterFile file;
+    QVERIFY(file.open(temp.fileName()));
+    QCOMPARE(file.valuesPerVertex(), STRIDE);
+    QCOMPARE(file.clusterCount(), 13);
+    QCOMPARE(file.vertexCount(), qint64(vertices.count() / STRIDE));
+
+    QVector<int> seen(vertices.count() / STRIDE / 3, 0);
+    for(int c = 0; c < file.clusterCount(); ++c) {
+        const QVector<float> cluster = file.read(c);
+        QCOMPARE(cluster.count(), file.cluster(c).vertexCount * STRIDE);
+        for(int v = 0; v < cluster.count() / STRIDE; v += 3) {
+            const int triangle = (int)cluster[v * STRIDE + 3];
+            ++seen[triangle];
+
+            // Corners keep their order and values.
+            for(int i = 0; i < 3 * STRIDE; ++i) {
+                QCOMPARE(cluster[v * STRIDE + i],
+                        vertices[triangle * 3 * STRIDE + i]);
+            }
+        }
+    }
+    for(int count : seen) QCOMPARE(count, 1);
+}
+
+//=============================================================================
+void ClusterFileTest::boundsContainClusterVertices()
+{
+    const QVector<float> vertices = makeGrid(6);
+    QTemporaryFile temp;
+    QVERIFY(writeFile(temp, vertices, 7));
+
+    ClusterFile file;
+    QVERIFY(file.open(temp.fileName()));
+    for(int c = 0; c < file.clusterCount(); ++c) {
+        const ClusterFile::Cluster& cluster = file.cluster(c);
+        const QVector<float> data = file.read(c);
+        for(int v = 0; v < cluster.vertexCount; ++v) {
+            for(int i = 0; i < 3; ++i) {
+                QVERIFY(data[v * STRIDE + i] >= cluster.min[i]);
+                QVERIFY(data[v * STRIDE + i] <= cluster.max[i]);
+            }
+        }
+    }
+}
+
+//=============================================================================
+void ClusterFileTest::clustersAreSpatiallyCoherent()
+{
+    // 32 triangles are 16 cells; along a Morton curve that is a 4 x 4 block
+    // rather than a row strip.
+    const QVector<float> vertices = makeGrid(16);
+    QTemporaryFile temp;
+    QVERIFY(writeFile(temp, vertices, 32));
+
+    ClusterFile file;
+    QVERIFY(file.open(temp.fileName()));
+    QCOMPARE(file.clusterCount(), 16);
+    for(int c = 0; c < file.clusterCount(); ++c) {
+        const ClusterFile::Cluster& cluster = file.cluster(c);
+        QVERIFY(cluster.max[0] - cluster.min[0] <= 4.0f);
+        QVERIFY(cluster.max[1] - cluster.min[1] <= 4.0f);
+    }
+}
+
+//=============================================================================
+void ClusterFileTest::emptyMeshHasNoClusters()
+{
+    QTemporaryFile temp;
+    QVERIFY(writeFile(temp, QVector<float>(), 10));
+
+    ClusterFile file;
+    QVERIFY(file.open(temp.fileName()));
+    QCOMPARE(file.clusterCount(), 0);
+    QCOMPARE(file.vertexCount(), qint64(0));
+    QVERIFY(file.read(0).isEmpty());
+}
+
+//=============================================================================
+void ClusterFileTest::rejectsPartialTriangles()
+{
+    const QVector<float> vertices(4 * STRIDE, 0.0f);
+    QTemporaryFile temp;
+    QVERIFY(!writeFile(temp, vertices, 10));
+}
+
+//=============================================================================
+void ClusterFileTest::rejectsCorruptFiles()
+{
+    QTemporaryFile garbage;
+    QVERIFY(garbage.open());
+    (void)garbage.write("not a cluster file at all");
+    garbage.close();
+
+    ClusterFile file;
+    QVERIFY(!file.open(garbage.fileName()));
+    QVERIFY(!file.isOpen());
+
+    // A valid header whose data has been cut off.
+    QTemporaryFile truncated;
+    QVERIFY(writeFile(truncated, makeGrid(4), 8));
+    const QString path = truncated.fileName();
+    QVERIFY(QFile::resize(path, QFile(path).size() - 16));
+    QVERIFY(!file.open(path));
+}
@@ -0,0 +1,14 @@
+#include <QObject>
+
+class ClusterFileTest : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void roundTripKeepsEveryTriangle();
+    void boundsContainClusterVertices();
+    void clustersAreSpatiallyCoherent();
+    void emptyMeshHasNoClusters();
+    void rejectsPartialTriangles();
+    void rejectsCorruptFiles();
+};
@@ -0,0 +1,87 @@
+#include "ClusterWriterTest.h"
+
+#include <QBuffer>
+#include <QRandomGenerator>
+#include <QTemporaryFile>
+#include <QtTest>
+
+#include "Scene/ClusterFile.h"
+#include "Scene/ClusterWriter.h"
+
+namespace {
+    constexpr int STRIDE = 4;
+
+    //=========================================================================
+    // Scattered triangles with many repeated centroids, so the merge has
+    // ties to break.  The fourth value is the triangle's index.
+    QVector<float> makeTriangles(int count)
+    {
+        QRandomGenerator generator(99);
+        QVector<float> vertices;
+        for(int t = 0; t < count; ++t) {
+            const float x = (float)(generator.generateDouble() * 8.0);
+            const float y = t % 5 == 0 ? 1.0f :
+                    (float)(generator.generateDouble() * 8.0);
+            for(int corner = 0; corner < 3; ++corner) {
+                vertices << x + (corner == 1 ? 0.5f : 0.0f)
+                         << y + (corner == 2 ? 0.5f : 0.0f)
+                         << (float)(t % 3) << (float)t;
+            }
+        }
+        return vertices;
+    }
+}
+
+//=============================================================================
+// Batches and runs of awkward sizes, so that neither lines up with the
+// clusters.
+void ClusterWriterTest::matchesClusterFileWrite()
+{
+    const QVector<float> vertices = makeTriangles(500);
+    const int vertexCount = vertices.count() / STRIDE;
+
+    QBuffer expected;
+    QVERIFY(expected.open(QIODevice::WriteOnly));
+    QVERIFY(ClusterFile::write(expected, vertices.constData(), vertexCount,
+            STRIDE, 16));
+
+    ClusterWriter writer(STRIDE, 16, 37);
+    for(int first = 0; first < vertexCount; first += 3 * 23) {
+        const int count = qMin(3 * 23, vertexCount - first);
+        QVERIFY(writer.addTriangles(vertices.constData() + first * STRIDE,
+                count));
+    }
+    QCOMPARE(writer.triangleCount(), qint64(500));
+
+    QBuffer written;
+    QVERIFY(written.open(QIODevice::WriteOnly));
+    QVERIFY(writer.write(written));
+    QCOMPARE(written.data(), expected.data());
+}
+
+//=============================================================================
+void ClusterWriterTest::emptyMeshHasNoClusters()
+{
+    QTemporaryFile temp;
+    QVERIFY(temp.open());
+    ClusterWriter writer(STRIDE);
+    QVERIFY(writer.write(temp));
+    temp.close();
+
+    ClusterFile file;
+    QVERIFY(file.open(temp.fileName()));
+    QCOMPARE(file.clusterCount(), 0);
+}
+
+//=============================================================================
+void ClusterWriterTest::rejectsPartialTriangles()
+{
+    const QVector<float> vertices = makeTriangles(2);
+    ClusterWriter writer(STRIDE);
+    QVERIFY(!writer.addTriangles(vertices.constData(), 4));
+    QVERIFY(!writer.addTriangles(vertices.constData(), 3));
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    QVERIFY(!writer.write(buffer));
+}
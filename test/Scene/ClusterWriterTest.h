@@ -0,0 +1,11 @@
+#include <QObject>
+
+class ClusterWriterTest : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void matchesClusterFileWrite();
+    void emptyMeshHasNoClusters();
+    void rejectsPartialTriangles();
+};
@@ -0,0 +1,276 @@
+#include "OcclusionCullerTest.h"
+
+#include <QtTest>
+#include <cmath>
+
+#include "Scene/OcclusionCuller.h"
+
+namespace {
+
+// Clip space is object space: x and y span the screen, z maps to depth.
+const float IDENTITY[16] = {
+    1.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f
+};
+
+//=============================================================================
+// A square from (x0, y0) to (x1, y1) at depth z, as two triangles.
+QVector<float> makeQuad(float x0, float y0, float x1, float y1, float z)
+{
+    return {
+        x0, y0, z,  x1, y0, z,  x1, y1, z,
+        x0, y0, z,  x1, y1, z,  x0, y1, z
+    };
+}
+
+//=============================================================================
+// Column-major, like QMatrix4x4::constData(); the camera looks down -z.
+void perspective(float fovY, float aspect, float nearPlane, float farPlane,
+        float *m_p)
+{
+    const float f = 1.0f / std::tan(fovY * 0.5f);
+    for(int i = 0; i < 16; ++i) m_p[i] = 0.0f;
+    m_p[0] = f / aspect;
+    m_p[5] = f;
+    m_p[10] = (farPlane + nearPlane) / (nearPlane - farPlane);
+    m_p[11] = -1.0f;
+    m_p[14] = 2.0f * farPlane * nearPlane / (nearPlane - farPlane);
+}
+
+//=============================================================================
+void drawQuad(OcclusionCuller& culler, const float *matrix_p,
+        const QVector<float>& quad)
+{
+    culler.drawOccluder(matrix_p, quad.constData(), quad.count() / 9);
+}
+
+} // namespace
+
+//=============================================================================
+void OcclusionCullerTest::widthIsRoundedToGroups()
+{
+    OcclusionCuller culler(30, 20);
+    QCOMPARE(culler.width(), 32);
+    QCOMPARE(culler.height(), 20);
+    QCOMPARE(culler.depth(31, 19), 1.0f);
+}
+
+//=============================================================================
+void OcclusionCullerTest::emptyBufferHidesNothing()
+{
+    OcclusionCuller culler(64, 64);
+    culler.clear();
+    culler.buildHierarchy();
+
+    const float min[3] = { -0.2f, -0.2f, 0.9f };
+    const float max[3] = { 0.2f, 0.2f, 0.95f };
+    QVERIFY(culler.isVisible(IDENTITY, min, max));
+    QCOMPARE(culler.stats().culled, 0);
+}
+
+//=============================================================================
+void OcclusionCullerTest::occluderHidesBoxBehind()
+{
+    OcclusionCuller culler(64, 64);
+    culler.clear();
+    drawQuad(culler, IDENTITY, makeQuad(-0.5f, -0.5f, 0.5f, 0.5f, 0.0f));
+    culler.buildHierarchy();
+
+    // z = 0 lands halfway into the depth range.
+    QCOMPARE(culler.depth(32, 32), 0.5f);
+    QCOMPARE(culler.depth(2, 2), 1.0f);
+
+    const float min[3] = { -0.2f, -0.2f, 0.5f };
+    const float max[3] = { 0.2f, 0.2f, 0.6f };
+    QVERIFY(!culler.isVisible(IDENTITY, min, max));
+    QCOMPARE(culler.stats().occluders, 1);
+    QCOMPARE(culler.stats().triangles, 2);
+    QCOMPARE(culler.stats().tested, 1);
+    QCOMPARE(culler.stats().culled, 1);
+}
+
+//=============================================================================
+void OcclusionCullerTest::boxInFrontStaysVisible()
+{
+    OcclusionCuller culler(64, 64);
+    culler.clear();
+    drawQuad(culler, IDENTITY, makeQuad(-0.5f, -0.5f, 0.5f, 0.5f, 0.0f));
+    culler.buildHierarchy();
+
+    const float min[3] = { -0.2f, -0.2f, -0.6f };
+    const float max[3] = { 0.2f, 0.2f, -0.5f };
+    QVERIFY(culler.isVisible(IDENTITY, min, max));
+
+    // A box that straddles the occluder is not hidden by it either.
+    const float straddleMin[3] = { -0.2f, -0.2f, -0.1f };
+    const float straddleMax[3] = { 0.2f, 0.2f, 0.1f };
+    QVERIFY(culler.isVisible(IDENTITY, straddleMin, straddleMax));
+}
+
+//=============================================================================
+void OcclusionCullerTest::partlyCoveredBoxStaysVisible()
+{
+    OcclusionCuller culler(64, 64);
+    culler.clear();
+    drawQuad(culler, IDENTITY, makeQuad(-0.5f, -0.5f, 0.5f, 0.5f, 0.0f));
+    culler.buildHierarchy();
+
+    const float min[3] = { 0.3f, 0.3f, 0.5f };
+    const float max[3] = { 0.8f, 0.8f, 0.6f };
+    QVERIFY(culler.isVisible(IDENTITY, min, max));
+}
+
+//=============================================================================
+void OcclusionCullerTest::bothWindingsOcclude()
+{
+    const QVector<float> quad = makeQuad(-0.5f, -0.5f, 0.5f, 0.5f, 0.0f);
+    QVector<float> reversed;
+    for(int t = 0; t < 2; ++t) {
+        for(int corner = 2; corner >= 0; --corner) {
+            for(int i = 0; i < 3; ++i) {
+                reversed.append(quad[t * 9 + corner * 3 + i]);
+            }
+        }
+    }
+
+    OcclusionCuller culler(64, 64);
+    culler.clear();
+    drawQuad(culler, IDENTITY, reversed);
+    culler.buildHierarchy();
+
+    const float min[3] = { -0.2f, -0.2f, 0.5f };
+    const float max[3] = { 0.2f, 0.2f, 0.6f };
+    QVERIFY(!culler.isVisible(IDENTITY, min, max));
+}
+
+//=============================================================================
+void OcclusionCullerTest::boxesOffScreenAreHidden()
+{
+    OcclusionCuller culler(64, 64);
+    culler.clear();
+    culler.buildHierarchy();
+
+    const float min[3] = { 1.5f, -0.2f, 0.0f };
+    const float max[3] = { 2.0f, 0.2f, 0.1f };
+    QVERIFY(!culler.isVisible(IDENTITY, min, max));
+
+    const float farMin[3] = { -0.2f, -0.2f, 1.5f };
+    const float farMax[3] = { 0.2f, 0.2f, 2.0f };
+    QVERIFY(!culler.isVisible(IDENTITY, farMin, farMax));
+}
+
+//=============================================================================
+void OcclusionCullerTest::boxesAtTheNearPlaneStayVisible()
+{
+    float matrix[16];
+    perspective(1.0f, 1.0f, 0.1f, 100.0f, matrix);
+
+    OcclusionCuller culler(64, 64);
+    culler.clear();
+    drawQuad(culler, matrix, makeQuad(-5.0f, -5.0f, 5.0f, 5.0f, -2.0f));
+    culler.buildHierarchy();
+
+    // Reaches behind the camera, so its projection cannot be trusted.
+    const float min[3] = { -0.1f, -0.1f, -5.0f };
+    const float max[3] = { 0.1f, 0.1f, 1.0f };
+    QVERIFY(culler.isVisible(matrix, min, max));
+    QCOMPARE(culler.screenCoverage(matrix, min, max), 1.0f);
+
+    // Occluders that reach in front of the near plane are not drawn.
+    culler.clear();
+    drawQuad(culler, matrix, makeQuad(-5.0f, -5.0f, 5.0f, 5.0f, 1.0f));
+    QCOMPARE(culler.stats().triangles, 0);
+}
+
+//=============================================================================
+void OcclusionCullerTest::hierarchyKeepsFarthestDepth()
+{
+    OcclusionCuller culler(8, 8);
+    culler.clear();
+    drawQuad(culler, IDENTITY, makeQuad(-1.0f, -1.0f, 0.0f, 1.0f, -0.5f));
+    drawQuad(culler, IDENTITY, makeQuad(0.0f, -1.0f, 1.0f, 1.0f, 0.5f));
+    culler.buildHierarchy();
+
+    QCOMPARE(culler.levelCount(), 4);
+    QCOMPARE(culler.depth(0, 0), 0.25f);
+    QCOMPARE(culler.depth(7, 7), 0.75f);
+    QCOMPARE(culler.depth(0, 0, 2), 0.25f);
+    QCOMPARE(culler.depth(1, 1, 2), 0.75f);
+    QCOMPARE(culler.depth(0, 0, 3), 0.75f);
+}
+
+//=============================================================================
+void OcclusionCullerTest::perspectiveOcclusion()
+{
+    float matrix[16];
+    perspective(1.0f, 2.0f, 0.1f, 100.0f, matrix);
+
+    OcclusionCuller culler(128, 64);
+    culler.clear();
+    drawQuad(culler, matrix, makeQuad(-2.0f, -2.0f, 2.0f, 2.0f, -5.0f));
+    culler.buildHierarchy();
+
+    // Behind the wall and smaller on screen than it.
+    const float hiddenMin[3] = { -3.0f, -3.0f, -20.0f };
+    const float hiddenMax[3] = { 3.0f, 3.0f, -15.0f };
+    QVERIFY(!culler.isVisible(matrix, hiddenMin, hiddenMax));
+
+    // Behind the wall but wide enough to show past its side.
+    const float wideMin[3] = { -20.0f, -1.0f, -20.0f };
+    const float wideMax[3] = { 20.0f, 1.0f, -15.0f };
+    QVERIFY(culler.isVisible(matrix, wideMin, wideMax));
+
+    // In front of the wall.
+    const float frontMin[3] = { -0.5f, -0.5f, -3.0f };
+    const float frontMax[3] = { 0.5f, 0.5f, -2.0f };
+    QVERIFY(culler.isVisible(matrix, frontMin, frontMax));
+}
+
+//=============================================================================
+void OcclusionCullerTest::coverageOfScreenRectangle()
+{
+    OcclusionCuller culler(64, 64);
+    const float fullMin[3] = { -2.0f, -2.0f, 0.0f };
+    const float fullMax[3] = { 2.0f, 2.0f, 0.5f };
+    QCOMPARE(culler.screenCoverage(IDENTITY, fullMin, fullMax), 1.0f);
+
+    const float quarterMin[3] = { 0.0f, 0.0f, 0.0f };
+    const float quarterMax[3] = { 1.0f, 1.0f, 0.5f };
+    QCOMPARE(culler.screenCoverage(IDENTITY, quarterMin, quarterMax), 0.25f);
+
+    const float offMin[3] = { 1.5f, 0.0f, 0.0f };
+    const float offMax[3] = { 2.0f, 1.0f, 0.5f };
+    QCOMPARE(culler.screenCoverage(IDENTITY, offMin, offMax), 0.0f);
+}
+
+//=============================================================================
+void OcclusionCullerTest::simplifyKeepsLargestTriangles()
+{
+    // Stride 4 with a padding value, like a real vertex layout.
+    QVector<float> vertices;
+    auto addTriangle = [&vertices](float size, float z) {
+        vertices << 0.0f << 0.0f << z << -1.0f;
+        vertices << size << 0.0f << z << -1.0f;
+        vertices << 0.0f << size << z << -1.0f;
+    };
+    addTriangle(1.0f, 0.0f);
+    addTriangle(4.0f, 1.0f);
+    addTriangle(0.0f, 2.0f);
+    addTriangle(2.0f, 3.0f);
+    addTriangle(3.0f, 4.0f);
+
+    const QVector<float> occluder = OcclusionCuller::simplifyOccluder(
+            vertices.constData(), vertices.count() / 4, 4, 2);
+    QCOMPARE(occluder.count(), 2 * 9);
+    QCOMPARE(occluder[2], 1.0f);
+    QCOMPARE(occluder[3], 4.0f);
+    QCOMPARE(occluder[11], 4.0f);
+    QCOMPARE(occluder[12], 3.0f);
+
+    // Degenerate triangles are dropped even when there is room for them.
+    const QVector<float> all = OcclusionCuller::simplifyOccluder(
+            vertices.constData(), vertices.count() / 4, 4, 10);
+    QCOMPARE(all.count(), 4 * 9);
+}
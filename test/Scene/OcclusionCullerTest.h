@@ -0,0 +1,20 @@
+#include <QObject>
+
+class OcclusionCullerTest : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void widthIsRoundedToGroups();
+    void emptyBufferHidesNothing();
+    void occluderHidesBoxBehind();
+    void boxInFrontStaysVisible();
+    void partlyCoveredBoxStaysVisible();
+    void bothWindingsOcclude();
+    void boxesOffScreenAreHidden();
+    void boxesAtTheNearPlaneStayVisible();
+    void hierarchyKeepsFarthestDepth();
+    void perspectiveOcclusion();
+    void coverageOfScreenRectangle();
+    void simplifyKeepsLargestTriangles();
+};
@@ -0,0 +1,100 @@
+#include "OffsetAllocatorTest.h"
+
+#include <QtTest>
+
+#include "Scene/OffsetAllocator.h"
+
+//=============================================================================
+void OffsetAllocatorTest::allocationsDoNotOverlap()
+{
+    OffsetAllocator allocator(100);
+    const quint32 a = allocator.allocate(10);
+    const quint32 b = allocator.allocate(20);
+    const quint32 c = allocator.allocate(30);
+    QVERIFY(a != OffsetAllocator::INVALID);
+    QVERIFY(b != OffsetAllocator::INVALID);
+    QVERIFY(c != OffsetAllocator::INVALID);
+    QVERIFY(a + 10 <= b || b + 20 <= a);
+    QVERIFY(b + 20 <= c || c + 30 <= b);
+    QVERIFY(a + 10 <= c || c + 30 <= a);
+}
+
+//=============================================================================
+void OffsetAllocatorTest::allocateFailsWhenFull()
+{
+    OffsetAllocator allocator(100);
+    QCOMPARE(allocator.allocate(100), 0u);
+    QCOMPARE(allocator.allocate(1), OffsetAllocator::INVALID);
+}
+
+//=============================================================================
+void OffsetAllocatorTest::allocateFailsForZeroSize()
+{
+    OffsetAllocator allocator(100);
+    QCOMPARE(allocator.allocate(0), OffsetAllocator::INVALID);
+}
+
+//=============================================================================
+void OffsetAllocatorTest::freeReturnsFalseForUnknownOffset()
+{
+    OffsetAllocator allocator(100);
+    (void)allocator.allocate(10);
+    QVERIFY(!allocator.free(5));
+    QVERIFY(allocator.free(0));
+    QVERIFY(!allocator.free(0));
+}
+
+//=============================================================================
+void OffsetAllocatorTest::freedSpaceIsReused()
+{
+    OffsetAllocator allocator(100);
+    const quint32 a = allocator.allocate(50);
+    (void)allocator.allocate(50);
+    QVERIFY(allocator.free(a));
+    QCOMPARE(allocator.allocate(50), a);
+}
+
+//=============================================================================
+void OffsetAllocatorTest::freeMergesNeighbouringBlocks()
+{
+    OffsetAllocator allocator(100);
+    const quint32 a = allocator.allocate(25);
+    const quint32 b = allocator.allocate(25);
+    const quint32 c = allocator.allocate(25);
+    const quint32 d = allocator.allocate(25);
+    QVERIFY(allocator.free(a));
+    QVERIFY(allocator.free(c));
+    QCOMPARE(allocator.freeBlockCount(), 2);
+    QVERIFY(allocator.free(b));
+    QCOMPARE(allocator.freeBlockCount(), 1);
+    QCOMPARE(allocator.largestFreeBlock(), 75u);
+    QVERIFY(allocator.free(d));
+    QCOMPARE(allocator.freeBlockCount(), 1);
+    QCOMPARE(allocator.largestFreeBlock(), 100u);
+}
+
+//=============================================================================
+void OffsetAllocatorTest::allocatePrefersBestFit()
+{
+    OffsetAllocator allocator(100);
+    const quint32 a = allocator.allocate(40);
+    (void)allocator.allocate(10);
+    const quint32 c = allocator.allocate(15);
+    (void)allocator.allocate(35);
+    QVERIFY(allocator.free(a));
+    QVERIFY(allocator.free(c));
+    QCOMPARE(allocator.allocate(12), c);
+}
+
+//=============================================================================
+void OffsetAllocatorTest::usedTracksLiveAllocations()
+{
+    OffsetAllocator allocator(100);
+    const quint32 a = allocator.allocate(30);
+    (void)allocator.allocate(20);
+    QCOMPARE(allocator.used(), 50u);
+    QCOMPARE(allocator.allocationCount(), 2);
+    QVERIFY(allocator.free(a));
+    QCOMPARE(allocator.used(), 20u);
+    QCOMPARE(allocator.allocationCount(), 1);
+}
@@ -0,0 +1,16 @@
+#include <QObject>
+
+class OffsetAllocatorTest : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void allocationsDoNotOverlap();
+    void allocateFailsWhenFull();
+    void allocateFailsForZeroSize();
+    void freeReturnsFalseForUnknownOffset();
+    void freedSpaceIsReused();
+    void freeMergesNeighbouringBlocks();
+    void allocatePrefersBestFit();
+    void usedTracksLiveAllocations();
+};
@@ -0,0 +1,151 @@
+#include "PointOctreeTest.h"
+
+#include <QSet>
+#include <QtTest>
+
+#include "Scene/PointOctree.h"
+
+namespace {
+    constexpr int STRIDE = 4;
+
+    //=========================================================================
+    // Points in a 10 unit cube; the fourth value is the point's original
+    // index so reordering can be checked.
+    QVector<float> makePoints(int count)
+    {
+        quint32 state = 12345;
+        auto random = [&state]() {
+            state = state * 1664525u + 1013904223u;
+            return (state >> 8) / (float)(1 << 24) * 10.0f;
+        };
+
+        QVector<float> points;
+        for(int i = 0; i < count; ++i) {
+            points << random() << random() << random() << (float)i;
+        }
+        return points;
+    }
+
+    //=========================================================================
+    PointOctree::View viewFrom(float z)
+    {
+        PointOctree::View view;
+        view.eye[0] = 5.0f;
+        view.eye[1] = 5.0f;
+        view.eye[2] = z;
+        view.pixelsPerUnit = 500.0f;
+        view.perspective = true;
+        return view;
+    }
+}
+
+//=============================================================================
+void PointOctreeTest::emptyInputBuildsNothing()
+{
+    PointOctree octree;
+    octree.build(nullptr, 0, STRIDE);
+    QVERIFY(octree.isEmpty());
+    QVERIFY(octree.select(viewFrom(20.0f), 100, 1.0f).isEmpty());
+}
+
+//=============================================================================
+void PointOctreeTest::reorderKeepsEveryPoint()
+{
+    const QVector<float> points = makePoints(20000);
+    PointOctree octree(500);
+    octree.build(points.constData(), 20000, STRIDE);
+    QCOMPARE(octree.pointCount(), 20000);
+    QVERIFY(octree.nodeCount() > 1);
+
+    QSet<int> ids;
+    const QVector<float>& vertices = octree.vertices();
+    for(int i = 0; i < octree.pointCount(); ++i) {
+        ids.insert((int)vertices[i * STRIDE + 3]);
+    }
+    QCOMPARE(ids.count(), 20000);
+}
+
+//=============================================================================
+void PointOctreeTest::subtreesAreContiguousAndContained()
+{
+    const QVector<float> points = makePoints(20000);
+    PointOctree octree(500);
+    octree.build(points.constData(), 20000, STRIDE);
+
+    const QVector<float>& vertices = octree.vertices();
+    for(int n = 0; n < octree.nodeCount(); ++n) {
+        const PointOctree::Node& node = octree.node(n);
+        QVERIFY(node.first + node.count <= node.subtreeEnd);
+        for(int child : node.children) {
+            if(child < 0) continue;
+            const PointOctree::Node& c = octree.node(child);
+            QVERIFY(c.first >= node.first + node.count);
+            QVERIFY(c.subtreeEnd <= node.subtreeEnd);
+        }
+        for(int p = node.first; p < node.subtreeEnd; ++p) {
+            for(int i = 0; i < 3; ++i) {
+                const float x = vertices[p * STRIDE + i];
+                QVERIFY(x >= node.center[i] - node.halfSize - 1e-4f);
+                QVERIFY(x <= node.center[i] + node.halfSize + 1e-4f);
+            }
+        }
+    }
+}
+
+//=============================================================================
+void PointOctreeTest::distantViewSelectsOnlyRoot()
+{
+    const QVector<float> points = makePoints(20000);
+    PointOctree octree(500);
+    octree.build(points.constData(), 20000, STRIDE);
+
+    int selected = 0;
+    const auto ranges =
+            octree.select(viewFrom(5000.0f), 1000000, 1.0f, &selected);
+    QCOMPARE(ranges.count(), 1);
+    QCOMPARE(selected, octree.node(0).count);
+}
+
+//=============================================================================
+void PointOctreeTest::closeViewSelectsEverything()
+{
+    const QVector<float> points = makePoints(20000);
+    PointOctree octree(500);
+    octree.build(points.constData(), 20000, STRIDE);
+
+    int selected = 0;
+    const auto ranges =
+            octree.select(viewFrom(11.0f), 1000000, 1.0f, &selected);
+    QCOMPARE(selected, 20000);
+    QCOMPARE(ranges.count(), 1);
+    QCOMPARE(ranges.first().first, 0);
+    QCOMPARE(ranges.first().count, 20000);
+}
+
+//=============================================================================
+void PointOctreeTest::selectionRespectsBudget()
+{
+    const QVector<float> points = makePoints(20000);
+    PointOctree octree(500);
+    octree.build(points.constData(), 20000, STRIDE);
+
+    int selected = 0;
+    const auto ranges =
+            octree.select(viewFrom(11.0f), 5000, 1.0f, &selected);
+    QVERIFY(selected <= 5000);
+    QVERIFY(selected > octree.node(0).count);
+
+    int total = 0;
+    for(const auto& range : ranges) total += range.count;
+    QCOMPARE(total, selected);
+}
+
+//=============================================================================
+void PointOctreeTest::coincidentPointsTerminate()
+{
+    const QVector<float> points(3000 * STRIDE, 1.0f);
+    PointOctree octree(10);
+    octree.build(points.constData(), 3000, STRIDE);
+    QCOMPARE(octree.pointCount(), 3000);
+    QVERIFY(octree.nodeCount() <= PointOctree::MAX_DEPTH + 1);
+}
@@ -0,0 +1,15 @@
+#include <QObject>
+
+class PointOctreeTest : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void emptyInputBuildsNothing();
+    void reorderKeepsEveryPoint();
+    void subtreesAreContiguousAndContained();
+    void distantViewSelectsOnlyRoot();
+    void closeViewSelectsEverything();
+    void selectionRespectsBudget();
+    void coincidentPointsTerminate();
+};
@@ -0,0 +1,159 @@
+#include "TaskGraphTest.h"
+
+#include <QSemaphore>
+#include <QThread>
+#include <QtTest>
+#include <atomic>
+
+#include "TaskGraph.h"
+
+//=============================================================================
+void TaskGraphTest::runsEveryTask()
+{
+    TaskGraph graph(4);
+    std::atomic<int> count(0);
+    for(int i = 0; i < 1000; ++i) {
+        (void)graph.add([&count]() { ++count; });
+    }
+    QVERIFY(graph.waitForWorkers(10000));
+    QCOMPARE(count.load(), 1000);
+    QCOMPARE(graph.stats().tasksRun, 1000);
+}
+
+//=============================================================================
+void TaskGraphTest::dependenciesFinishFirst()
+{
+    TaskGraph graph(4);
+    constexpr int LENGTH = 50;
+    std::atomic<int> finished(0);
+    std::atomic<bool> outOfOrder(false);
+
+    int previous = -1;
+    for(int i = 0; i < LENGTH; ++i) {
+        const auto task = [&finished, &outOfOrder, i]() {
+            if(finished.load() != i) outOfOrder = true;
+            ++finished;
+        };
+        previous = previous < 0 ? graph.add(task) :
+                graph.add(task, { previous });
+    }
+    QVERIFY(graph.waitForWorkers(10000));
+    QCOMPARE(finished.load(), LENGTH);
+    QVERIFY(!outOfOrder);
+}
+
+//=============================================================================
+void TaskGraphTest::diamondWaitsForBothParents()
+{
+    TaskGraph graph(4);
+    std::atomic<int> parents(0);
+    std::atomic<int> seen(-1);
+
+    const int root = graph.add([]() { QThread::msleep(5); });
+    const int left = graph.add([&parents]() {
+        QThread::msleep(10);
+        ++parents;
+    }, { root });
+    const int right = graph.add([&parents]() { ++parents; }, { root });
+    (void)graph.add([&parents, &seen]() { seen = parents.load(); },
+            { left, right });
+
+    QVERIFY(graph.waitForWorkers(10000));
+    QCOMPARE(seen.load(), 2);
+}
+
+//=============================================================================
+void TaskGraphTest::finishedDependenciesAreIgnored()
+{
+    TaskGraph graph(2);
+    std::atomic<int> count(0);
+    const int first = graph.add([&count]() { ++count; });
+    QVERIFY(graph.waitForWorkers(10000));
+
+    (void)graph.add([&count]() { ++count; }, { first });
+    QVERIFY(graph.waitForWorkers(10000));
+    QCOMPARE(count.load(), 2);
+}
+
+//=============================================================================
+void TaskGraphTest::mainThreadTasksRunInPriorityOrder()
+{
+    TaskGraph graph(2);
+    QThread *const thread_p = QThread::currentThread();
+    QVector<int> order;
+    bool otherThread = false;
+    for(int priority : { 1, 3, 2, 3 }) {
+        (void)graph.addMainThread(
+                [&order, &otherThread, thread_p, priority]() {
+            if(QThread::currentThread() != thread_p) otherThread = true;
+            order.append(priority);
+        }, {}, priority);
+    }
+
+    QVERIFY(graph.hasMainThreadTasks());
+    while(graph.runMainThreadTask()) {}
+    QCOMPARE(order, QVector<int>({ 3, 3, 2, 1 }));
+    QVERIFY(!otherThread);
+    QVERIFY(!graph.hasMainThreadTasks());
+}
+
+//=============================================================================
+void TaskGraphTest::mainThreadTasksJoinTheGraph()
+{
+    TaskGraph graph(2);
+    std::atomic<int> value(0);
+    std::atomic<int> notified(0);
+    graph.setReadyNotifier([&notified]() { ++notified; });
+
+    const int produce = graph.add([&value]() { value = 1; });
+    const int upload = graph.addMainThread([&value]() {
+        if(value == 1) value = 2;
+    }, { produce });
+    (void)graph.add([&value]() { if(value == 2) value = 3; }, { upload });
+
+    QVERIFY(graph.waitForWorkers(10000));
+    QCOMPARE(notified.load(), 1);
+    QVERIFY(graph.runMainThreadTask());
+    QVERIFY(!graph.runMainThreadTask());
+    QVERIFY(graph.waitForWorkers(10000));
+    QCOMPARE(value.load(), 3);
+}
+
+//=============================================================================
+void TaskGraphTest::idleWorkersStealQueuedTasks()
+{
+    // The children all land on the queue of the worker that ran the root,
+    // so the other workers only get them by stealing.  The root holds out
+    // until every child is added, or they would not wait for it.
+    TaskGraph graph(4);
+    std::atomic<int> count(0);
+    QSemaphore childrenAdded;
+    const int root = graph.add([&childrenAdded]() {
+        childrenAdded.acquire();
+    });
+    for(int i = 0; i < 32; ++i) {
+        (void)graph.add([&count]() {
+            QThread::msleep(2);
+            ++count;
+        }, { root });
+    }
+    childrenAdded.release();
+    QVERIFY(graph.waitForWorkers(10000));
+    QCOMPARE(count.load(), 32);
+    QVERIFY(graph.stats().steals > 0);
+}
+
+//=============================================================================
+void TaskGraphTest::cancelDropsPendingTasks()
+{
+    TaskGraph graph(2);
+    std::atomic<int> count(0);
+    const int upload = graph.addMainThread([&count]() { ++count; });
+    (void)graph.add([&count]() { ++count; }, { upload });
+
+    graph.cancel();
+    QVERIFY(!graph.hasMainThreadTasks());
+    QVERIFY(!graph.runMainThreadTask());
+    QVERIFY(graph.waitForWorkers(10000));
+    QCOMPARE(count.load(), 0);
+}
@@ -0,0 +1,16 @@
+#include <QObject>
+
+class TaskGraphTest : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void runsEveryTask();
+    void dependenciesFinishFirst();
+    void diamondWaitsForBothParents();
+    void finishedDependenciesAreIgnored();
+    void mainThreadTasksRunInPriorityOrder();
+    void mainThreadTasksJoinTheGraph();
+    void idleWorkersStealQueuedTasks();
+    void cancelDropsPendingTasks();
+};
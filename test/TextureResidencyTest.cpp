@@ -0,0 +1,204 @@
+#include "TextureResidencyTest.h"
+
+#include <QtTest>
+#include <cmath>
+
+#include "TextureResidency.h"
+
+namespace {
+    // Position then texture coordinate.
+    constexpr int STRIDE = 5;
+
+    const float IDENTITY[16] = {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+
+    //=========================================================================
+    // A size x size square in the xy plane with texture coordinates
+    // running from 0 to uvSize.
+    QVector<float> makeQuad(float size, float uvSize)
+    {
+        return {
+            0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+            size, 0.0f, 0.0f, uvSize, 0.0f,
+            size, size, 0.0f, uvSize, uvSize,
+            0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+            size, size, 0.0f, uvSize, uvSize,
+            0.0f, size, 0.0f, 0.0f, uvSize
+        };
+    }
+
+    //=========================================================================
+    // Column-major; the camera looks down -z.
+    void perspective(float fovY, float *m_p)
+    {
+        const float f = 1.0f / std::tan(fovY * 0.5f);
+        for(int i = 0; i < 16; ++i) m_p[i] = 0.0f;
+        m_p[0] = f;
+        m_p[5] = f;
+        m_p[10] = -1.0f;
+        m_p[11] = -1.0f;
+        m_p[14] = -0.2f;
+    }
+
+    //=========================================================================
+    void translation(float z, float *m_p)
+    {
+        for(int i = 0; i < 16; ++i) m_p[i] = IDENTITY[i];
+        m_p[14] = z;
+    }
+
+    //=========================================================================
+    float density(const QVector<float>& vertices)
+    {
+        return TextureResidency::uvDensity(vertices.constData(),
+                vertices.count() / STRIDE, STRIDE, 3);
+    }
+}
+
+//=============================================================================
+void TextureResidencyTest::uvDensityOfUnitQuad()
+{
+    QCOMPARE(density(makeQuad(1.0f, 1.0f)), 1.0f);
+    QCOMPARE(density(QVector<float>()), 0.0f);
+}
+
+//=============================================================================
+void TextureResidencyTest::uvDensityScalesWithMesh()
+{
+    QCOMPARE(density(makeQuad(4.0f, 1.0f)), 0.25f);
+    QCOMPARE(density(makeQuad(1.0f, 2.0f)), 2.0f);
+}
+
+//=============================================================================
+void TextureResidencyTest::pixelsPerUnitFallsWithDistance()
+{
+    float projection[16];
+    perspective(2.0f * std::atan(1.0f), projection); // 90 degrees.
+    const float min[3] = { -1.0f, -1.0f, -1.0f };
+    const float max[3] = { 1.0f, 1.0f, 1.0f };
+
+    float nearView[16];
+    float farView[16];
+    translation(-3.0f, nearView);
+    translation(-9.0f, farView);
+    const float nearPixels = TextureResidency::pixelsPerUnit(
+            nearView, projection, min, max, 400);
+    const float farPixels = TextureResidency::pixelsPerUnit(
+            farView, projection, min, max, 400);
+
+    // The nearest faces are 2 and 8 units away.
+    QVERIFY(qAbs(nearPixels - 100.0f) < 1e-3f);
+    QVERIFY(qAbs(farPixels - 25.0f) < 1e-3f);
+
+    // Boxes around the camera want the full-size image.
+    float inside[16];
+    translation(0.0f, inside);
+    QVERIFY(TextureResidency::pixelsPerUnit(
+            inside, projection, min, max, 400) > 1e6f);
+}
+
+//=============================================================================
+void TextureResidencyTest::orthographicIgnoresDistance()
+{
+    float projection[16];
+    for(int i = 0; i < 16; ++i) projection[i] = IDENTITY[i];
+    projection[0] = 0.1f;
+    projection[5] = 0.1f;
+    const float min[3] = { 0.0f, 0.0f, -50.0f };
+    const float max[3] = { 1.0f, 1.0f, -40.0f };
+
+    float modelView[16];
+    translation(-10.0f, modelView);
+    QCOMPARE(TextureResidency::pixelsPerUnit(
+            modelView, projection, min, max, 200), 10.0f);
+
+    // Scaling the model scales its pixels.
+    modelView[0] = 2.0f;
+    modelView[5] = 2.0f;
+    modelView[10] = 2.0f;
+    QCOMPARE(TextureResidency::pixelsPerUnit(
+            modelView, projection, min, max, 200), 20.0f);
+}
+
+//=============================================================================
+void TextureResidencyTest::desiredLevelMatchesTexelsToPixels()
+{
+    // 1024 texels across one unit.
+    QCOMPARE(TextureResidency::desiredLevel(1024, 1024, 11, 1.0f, 1024.0f),
+            0);
+    QCOMPARE(TextureResidency::desiredLevel(1024, 1024, 11, 1.0f, 256.0f),
+            2);
+    QCOMPARE(TextureResidency::desiredLevel(1024, 1024, 11, 1.0f, 300.0f),
+            1);
+    QCOMPARE(TextureResidency::desiredLevel(1024, 1024, 11, 1.0f, 4096.0f),
+            0);
+    QCOMPARE(TextureResidency::desiredLevel(1024, 1024, 11, 1.0f, 0.01f),
+            10);
+    QCOMPARE(TextureResidency::desiredLevel(1024, 1024, 11, 0.0f, 100.0f),
+            10);
+}
+
+//=============================================================================
+void TextureResidencyTest::minimumLevelFitsResidentSize()
+{
+    QCOMPARE(TextureResidency::RESIDENT_SIZE, 64);
+    QCOMPARE(TextureResidency::minimumLevel(1024, 1024, 11), 4);
+    QCOMPARE(TextureResidency::minimumLevel(1024, 256, 11), 4);
+    QCOMPARE(TextureResidency::minimumLevel(64, 64, 7), 0);
+    QCOMPARE(TextureResidency::minimumLevel(1024, 1024, 3), 2);
+}
+
+//=============================================================================
+void TextureResidencyTest::chainBytesFromTop()
+{
+    QCOMPARE(TextureResidency::chainBytes(4, 4, 3, 0),
+            (qint64)(16 + 4 + 1) * 4);
+    QCOMPARE(TextureResidency::chainBytes(4, 4, 3, 1), (qint64)(4 + 1) * 4);
+    QCOMPARE(TextureResidency::chainBytes(8, 2, 4, 2), (qint64)(2 + 1) * 4);
+}
+
+//=============================================================================
+void TextureResidencyTest::planFitsEverythingUnderBudget()
+{
+    const QVector<TextureResidency::Request> requests = {
+        { 1024, 1024, 11, 0 },
+        { 512, 512, 10, 3 }
+    };
+    const QVector<int> levels = TextureResidency::plan(requests,
+            TextureResidency::chainBytes(1024, 1024, 11, 0) +
+            TextureResidency::chainBytes(512, 512, 10, 3));
+    QCOMPARE(levels, QVector<int>({ 0, 3 }));
+}
+
+//=============================================================================
+void TextureResidencyTest::planRefinesFurthestFirst()
+{
+    const QVector<TextureResidency::Request> requests = {
+        { 1024, 1024, 11, 2 },
+        { 1024, 1024, 11, 0 }
+    };
+
+    // Room for both at level 2 but not for either at level 1.
+    const qint64 budget = 2 * TextureResidency::chainBytes(1024, 1024, 11, 2);
+    QCOMPARE(TextureResidency::plan(requests, budget),
+            QVector<int>({ 2, 2 }));
+
+    // With a little more, the texture that wants level 0 gets level 1.
+    const qint64 more = budget + 512 * 512 * 4;
+    QCOMPARE(TextureResidency::plan(requests, more),
+            QVector<int>({ 2, 1 }));
+}
+
+//=============================================================================
+void TextureResidencyTest::planKeepsMinimumPastBudget()
+{
+    const QVector<TextureResidency::Request> requests = {
+        { 1024, 1024, 11, 0 },
+        { 256, 256, 9, 8 }
+    };
+    QCOMPARE(TextureResidency::plan(requests, 0), QVector<int>({ 4, 2 }));
+}
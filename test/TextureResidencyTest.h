@@ -0,0 +1,18 @@
+#include <QObject>
+
+class TextureResidencyTest : public QObject
+{
+    Q_OBJECT;
+
+private slots:
+    void uvDensityOfUnitQuad();
+    void uvDensityScalesWithMesh();
+    void pixelsPerUnitFallsWithDistance();
+    void orthographicIgnoresDistance();
+    void desiredLevelMatchesTexelsToPixels();
+    void minimumLevelFitsResidentSize();
+    void chainBytesFromTop();
+    void planFitsEverythingUnderBudget();
+    void planRefinesFurthestFirst();
+    void planKeepsMinimumPastBudget();
+};
@@ -1,6 +1,21 @@
 #include <QTest>
 
+#include "GlCaptureTest.h"
+#include "MemoryLedgerTest.h"
+#include "MipChainTest.h"
 #include "Ply/PlyModelTest.h"
+#include "Ply/PlyWriterTest.h"
+#include "ResolutionControllerTest.h"
+#include "ResourceTableTest.h"
+#include "Scene/BufferDiffTest.h"
+#include "Scene/BvhTest.h"
+#include "Scene/ClusterFileTest.h"
+#include "Scene/ClusterWriterTest.h"
+#include "Scene/OcclusionCullerTest.h"
+#include "Scene/OffsetAllocatorTest.h"
+#include "Scene/PointOctreeTest.h"
+#include "TaskGraphTest.h"
+#include "TextureResidencyTest.h"
 
 int main()
 {
@@ -10,7 +25,22 @@ int main()
         delete test_p;
     };
 
+    runTest(new GlCaptureTest());
+    runTest(new MemoryLedgerTest());
+    runTest(new MipChainTest());
     runTest(new PlyModelTest());
+    runTest(new PlyWriterTest());
+    runTest(new ResolutionControllerTest());
+    runTest(new ResourceTableTest());
+    runTest(new BufferDiffTest());
+    runTest(new BvhTest());
+    runTest(new ClusterFileTest());
+    runTest(new ClusterWriterTest());
+    runTest(new OcclusionCullerTest());
+    runTest(new OffsetAllocatorTest());
+    runTest(new PointOctreeTest());
+    runTest(new TaskGraphTest());
+    runTest(new TextureResidencyTest());
 
     return result;
 }
@@ -3,12 +3,43 @@ TARGET = gl-lnl-test
 CONFIG += c++14
 CONFIG += testcase
 QT -= gui
+QT += concurrent
 QT += testlib
 
 include(../src/src.pri)
 INCLUDEPATH += ../src
 
+HEADERS += GlCaptureTest.h
+HEADERS += MemoryLedgerTest.h
+HEADERS += MipChainTest.h
 HEADERS += Ply/PlyModelTest.h
+HEADERS += Ply/PlyWriterTest.h
+HEADERS += ResolutionControllerTest.h
+HEADERS += ResourceTableTest.h
+HEADERS += Scene/BufferDiffTest.h
+HEADERS += Scene/BvhTest.h
+HEADERS += Scene/ClusterFileTest.h
+HEADERS += Scene/ClusterWriterTest.h
+HEADERS += Scene/OcclusionCullerTest.h
+HEADERS += Scene/OffsetAllocatorTest.h
+HEADERS += Scene/PointOctreeTest.h
+HEADERS += TaskGraphTest.h
+HEADERS += TextureResidencyTest.h
 
 SOURCES += main.cpp
+SOURCES += GlCaptureTest.cpp
+SOURCES += MemoryLedgerTest.cpp
+SOURCES += MipChainTest.cpp
 SOURCES += Ply/PlyModelTest.cpp
+SOURCES += Ply/PlyWriterTest.cpp
+SOURCES += ResolutionControllerTest.cpp
+SOURCES += ResourceTableTest.cpp
+SOURCES += Scene/BufferDiffTest.cpp
+SOURCES += Scene/BvhTest.cpp
+SOURCES += Scene/ClusterFileTest.cpp
+SOURCES += Scene/ClusterWriterTest.cpp
+SOURCES += Scene/OcclusionCullerTest.cpp
+SOURCES += Scene/OffsetAllocatorTest.cpp
+SOURCES += Scene/PointOctreeTest.cpp
+SOURCES += TaskGraphTest.cpp
+SOURCES += TextureResidencyTest.cpp